@@ -20,6 +20,7 @@ extern "C" {
 #include "./key/key.h"
 #include "./led/led.h"
 #include "msg_protocol.h"
+#include "msg_schema.h"
 #include "./keyboard/keyboard.h"
 
 void bsp_init(void);
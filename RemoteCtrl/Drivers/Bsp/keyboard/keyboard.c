@@ -20,8 +20,14 @@
  */
 
 #include "keyboard.h"
-#include "core_delay.h"
 
+#include <stdbool.h>
+
+static uint8_t stable_key;     /* 确认后的按键 */
+static uint8_t last_key;       /* 上一次扫描读到的按键 */
+static uint8_t same_scans;     /* `last_key`连续读到的次数 */
+static bool change_pending;    /* 读到与`stable_key`不同的按键, 还没有确认 */
+static uint32_t change_cycles; /* 开始变化时的DWT周期计数 */
 
 /**
  * @brief  Reads the specified GPIO input data port.
@@ -66,11 +72,11 @@ void keyboard_init(void) {
 }
 
 /**
- * @brief 矩阵键盘扫描
+ * @brief 读取一次矩阵键盘, 不消抖
  *
- * @return uint8_t 按下的按键, 1-16
+ * @return 按下的按键, 1-16, 没有按键或多个按键按下时返回0
  */
-uint8_t keyboard_scan(void) {
+static uint8_t keyboard_read(void) {
     uint8_t col_bits = 0x00, row_bits = 0x00;
 
     /* 列置高电平, 行置低电平 */
@@ -84,15 +90,6 @@ uint8_t keyboard_scan(void) {
         /* 无按键按下, 返回 */
         return 0;
     }
-
-    delay_ms(15); /* 消抖 */
-    row_bits =
-        (uint8_t)((GPIO_ReadInputData(KEYBOARD_GPIO_PORT) & 0x03c0) >> 2);
-
-    if (row_bits == 0x00) {
-        /* 说明上一次IO变化是抖动, 返回 */
-        return 0;
-    }
     /* 多按键按下, 为避免鬼影, 产生误操作, 不做处理 */
     if (!(row_bits == 0x10 || row_bits == 0x20 || row_bits == 0x40 ||
           row_bits == 0x80)) {
@@ -119,3 +116,45 @@ uint8_t keyboard_scan(void) {
 
     return (4 * (row_num - 1) + col_num);
 }
+
+/**
+ * @brief 矩阵键盘扫描, 连续`KEYBOARD_DEBOUNCE_SCANS`次读到相同的按键才确认
+ *
+ * @return uint8_t 确认后按下的按键, 1-16, 没有按键时返回0
+ * @note 每1ms调用一次, 不阻塞. 按下与松开都要确认, 期间返回原来的按键
+ */
+uint8_t keyboard_scan(void) {
+    uint8_t key = keyboard_read();
+
+    if (key != last_key) {
+        last_key = key;
+        same_scans = 0;
+    }
+    if (same_scans < KEYBOARD_DEBOUNCE_SCANS) {
+        ++same_scans;
+    }
+
+    /* 从第一次读到变化算起, 抖动期间不重新计时 */
+    if ((key != stable_key) && (!change_pending)) {
+        change_pending = true;
+        change_cycles = DWT->CYCCNT;
+    }
+
+    if (same_scans >= KEYBOARD_DEBOUNCE_SCANS) {
+        /* 确认变化, 或者读回原来的按键, 说明是干扰 */
+        stable_key = key;
+        change_pending = false;
+    }
+
+    return stable_key;
+}
+
+/**
+ * @brief 获取最近一次按键变化开始时的DWT周期计数
+ *
+ * @return 第一次读到变化(按下或松开)时的`DWT->CYCCNT`, 含消抖时间,
+ *         用于测量按键到发送的延迟. 需要先开启DWT周期计数器
+ */
+uint32_t keyboard_change_cycles(void) {
+    return change_cycles;
+}
@@ -28,7 +28,12 @@
 /* 行的IO, 6,7,8,9 */
 #define ROW_KEY_IO GPIO_PIN_6 | GPIO_PIN_7 | GPIO_PIN_8 | GPIO_PIN_9
 
+#ifndef KEYBOARD_DEBOUNCE_SCANS
+#define KEYBOARD_DEBOUNCE_SCANS 5 /* 消抖: 连续几次扫描(间隔1ms)相同才确认 */
+#endif /* KEYBOARD_DEBOUNCE_SCANS */
+
 void keyboard_init(void);
 uint8_t keyboard_scan(void);
+uint32_t keyboard_change_cycles(void);
 
 #endif /* __KEY_BOARD_H */
\ No newline at end of file
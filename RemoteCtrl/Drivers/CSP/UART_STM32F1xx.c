@@ -26,23 +26,28 @@ static char uart_buffer[256];
  * @brief Send buf of UART.
  */
 typedef struct {
-    uint8_t *send_buf; /*!< Send data buf.                                  */
-    uint32_t head_ptr; /*!< Pointer of send buf to control the length of DMA
-                            transfer.                                       */
-    size_t buf_size;   /*!< The size of buffer. Prevent overflow.           */
+    uint8_t *send_buf;          /*!< Send data buf, used as two halves.     */
+    uint32_t head_ptr;          /*!< Length of data in the filling half.    */
+    size_t buf_size;            /*!< The size of buffer. Prevent overflow.  */
+    uint32_t fill;              /*!< Index of the filling half, 0 or 1.     */
+    volatile uint32_t busy;     /*!< DMA is transmitting the other half.    */
+    volatile uint32_t pending;  /*!< Send is requested while DMA is busy.   */
+    volatile uint32_t reserved; /*!< The filling half is reserved to write
+                                     in place, do not switch it.            */
 } uart_tx_buf_t;
 
 /**
  * @brief Receive fifo of UART.
  */
 typedef struct {
-    ring_fifo_t *rx_fifo; /*!< Receive fifo.                 */
-    uint8_t *rx_fifo_buf; /*!< The storage area of fifo.     */
-    uint8_t *recv_buf;    /*!< Data buf of DMA to transfer.  */
-    uint32_t head_ptr;    /*!< Pointer of receive buf to
-                               control the DMA receive.      */
-    uint32_t buf_size;    /*!< Size of `rece_buf`.           */
-    uint32_t fifo_size;   /*!< Size of `rx_fifo_buf`.        */
+    ring_fifo_t *rx_fifo;   /*!< Receive fifo.                 */
+    ring_fifo_t rx_fifo_cb; /*!< Control block of `rx_fifo`.   */
+    uint8_t *rx_fifo_buf;   /*!< The storage area of fifo.     */
+    uint8_t *recv_buf;      /*!< Data buf of DMA to transfer.  */
+    uint32_t head_ptr;      /*!< Pointer of receive buf to
+                                 control the DMA receive.      */
+    uint32_t buf_size;      /*!< Size of `rece_buf`.           */
+    uint32_t fifo_size;     /*!< Size of `rx_fifo_buf`.        */
 } uart_rx_fifo_t;
 
 /**
@@ -57,6 +62,8 @@ typedef struct {
 static void uart_dmarx_halfdone_callback(UART_HandleTypeDef *huart);
 static void uart_dmarx_done_callback(UART_HandleTypeDef *huart);
 void uart_dmarx_idle_callback(UART_HandleTypeDef *huart);
+static void uart_dmatx_reset(UART_HandleTypeDef *huart);
+static void uart_dmatx_done_callback(UART_HandleTypeDef *huart);
 
 /**
  * @}
@@ -183,8 +190,9 @@ uint8_t usart1_init(uint32_t baud_rate) {
         return UART_INIT_MEM_FAIL;
     }
 
-    usart1_rx_fifo.rx_fifo = ring_fifo_init(
-        usart1_rx_fifo.rx_fifo_buf, usart1_rx_fifo.fifo_size, RF_TYPE_STREAM);
+    usart1_rx_fifo.rx_fifo = ring_fifo_init_static(
+        &usart1_rx_fifo.rx_fifo_cb, usart1_rx_fifo.rx_fifo_buf,
+        usart1_rx_fifo.fifo_size, RF_TYPE_STREAM);
     if (usart1_rx_fifo.rx_fifo == NULL) {
         return UART_INIT_MEM_FAIL;
     }
@@ -340,6 +348,7 @@ uint8_t usart1_deinit(void) {
 #if USART1_TX_DMA
     HAL_DMA_Abort(&usart1_dmatx_handle);
     CSP_FREE(usart1_tx_buf.send_buf);
+    uart_dmatx_reset(&usart1_handle);
 
     if (HAL_DMA_DeInit(&usart1_dmatx_handle) != HAL_OK) {
         return UART_DEINIT_DMA_FAIL;
@@ -485,8 +494,9 @@ uint8_t usart2_init(uint32_t baud_rate) {
         return UART_INIT_MEM_FAIL;
     }
 
-    usart2_rx_fifo.rx_fifo = ring_fifo_init(
-        usart2_rx_fifo.rx_fifo_buf, usart2_rx_fifo.fifo_size, RF_TYPE_STREAM);
+    usart2_rx_fifo.rx_fifo = ring_fifo_init_static(
+        &usart2_rx_fifo.rx_fifo_cb, usart2_rx_fifo.rx_fifo_buf,
+        usart2_rx_fifo.fifo_size, RF_TYPE_STREAM);
     if (usart2_rx_fifo.rx_fifo == NULL) {
         return UART_INIT_MEM_FAIL;
     }
@@ -642,6 +652,7 @@ uint8_t usart2_deinit(void) {
 #if USART2_TX_DMA
     HAL_DMA_Abort(&usart2_dmatx_handle);
     CSP_FREE(usart2_tx_buf.send_buf);
+    uart_dmatx_reset(&usart2_handle);
 
     if (HAL_DMA_DeInit(&usart2_dmatx_handle) != HAL_OK) {
         return UART_DEINIT_DMA_FAIL;
@@ -789,8 +800,9 @@ uint8_t usart3_init(uint32_t baud_rate) {
         return UART_INIT_MEM_FAIL;
     }
 
-    usart3_rx_fifo.rx_fifo = ring_fifo_init(
-        usart3_rx_fifo.rx_fifo_buf, usart3_rx_fifo.fifo_size, RF_TYPE_STREAM);
+    usart3_rx_fifo.rx_fifo = ring_fifo_init_static(
+        &usart3_rx_fifo.rx_fifo_cb, usart3_rx_fifo.rx_fifo_buf,
+        usart3_rx_fifo.fifo_size, RF_TYPE_STREAM);
     if (usart3_rx_fifo.rx_fifo == NULL) {
         return UART_INIT_MEM_FAIL;
     }
@@ -945,6 +957,7 @@ uint8_t usart3_deinit(void) {
 #if USART3_TX_DMA
     HAL_DMA_Abort(&usart3_dmatx_handle);
     CSP_FREE(usart3_tx_buf.send_buf);
+    uart_dmatx_reset(&usart3_handle);
 
     if (HAL_DMA_DeInit(&usart3_dmatx_handle) != HAL_OK) {
         return UART_DEINIT_DMA_FAIL;
@@ -1070,8 +1083,9 @@ uint8_t uart4_init(uint32_t baud_rate) {
         return UART_INIT_MEM_FAIL;
     }
 
-    uart4_rx_fifo.rx_fifo = ring_fifo_init(
-        uart4_rx_fifo.rx_fifo_buf, uart4_rx_fifo.fifo_size, RF_TYPE_STREAM);
+    uart4_rx_fifo.rx_fifo = ring_fifo_init_static(
+        &uart4_rx_fifo.rx_fifo_cb, uart4_rx_fifo.rx_fifo_buf,
+        uart4_rx_fifo.fifo_size, RF_TYPE_STREAM);
     if (uart4_rx_fifo.rx_fifo == NULL) {
         return UART_INIT_MEM_FAIL;
     }
@@ -1218,6 +1232,7 @@ uint8_t uart4_deinit(void) {
 #if UART4_TX_DMA
     HAL_DMA_Abort(&uart4_dmatx_handle);
     CSP_FREE(uart4_tx_buf.send_buf);
+    uart_dmatx_reset(&uart4_handle);
 
     if (HAL_DMA_DeInit(&uart4_dmatx_handle) != HAL_OK) {
         return UART_DEINIT_DMA_FAIL;
@@ -1792,6 +1807,67 @@ static inline uart_tx_buf_t *uart_tx_identify(UART_HandleTypeDef *huart) {
     return NULL;
 }
 
+/**
+ * @brief Get the start address of the filling half.
+ *
+ * @param send_tx_buf The send buf of UART.
+ * @return The start address.
+ */
+static inline uint8_t *uart_dmatx_fill_buf(uart_tx_buf_t *send_tx_buf) {
+    return send_tx_buf->send_buf +
+           send_tx_buf->fill * (send_tx_buf->buf_size / 2);
+}
+
+/**
+ * @brief Start the DMA to transmit the filling half, and switch to fill the
+ *        other half.
+ *
+ * @param huart The handle of UART.
+ * @param send_tx_buf The send buf of UART.
+ * @return The length which is started to transmit.
+ * @note Must be called with interrupts disabled, and the DMA is not busy.
+ */
+static uint32_t uart_dmatx_start(UART_HandleTypeDef *huart,
+                                 uart_tx_buf_t *send_tx_buf) {
+    uint32_t len = send_tx_buf->head_ptr;
+
+    if (len == 0) {
+        send_tx_buf->pending = 0;
+        return 0;
+    }
+
+    if (HAL_UART_Transmit_DMA(huart, uart_dmatx_fill_buf(send_tx_buf),
+                              (uint16_t)len) != HAL_OK) {
+        /* The UART is transmitting by other code, retry when it completes. */
+        send_tx_buf->pending = 1;
+        return 0;
+    }
+
+    send_tx_buf->busy = 1;
+    send_tx_buf->pending = 0;
+    send_tx_buf->fill ^= 1;
+    send_tx_buf->head_ptr = 0;
+    return len;
+}
+
+/**
+ * @brief Reset the state of the send buf, when the DMA is aborted.
+ *
+ * @param huart The handle of UART.
+ */
+static void uart_dmatx_reset(UART_HandleTypeDef *huart) {
+    uart_tx_buf_t *send_tx_buf = uart_tx_identify(huart);
+    if (send_tx_buf == NULL) {
+        return;
+    }
+
+    send_tx_buf->head_ptr = 0;
+    send_tx_buf->fill = 0;
+    send_tx_buf->busy = 0;
+    send_tx_buf->pending = 0;
+    send_tx_buf->reserved = 0;
+}
+
 /**
  * @brief Write the transmit data to the buffer.
  *
@@ -1799,6 +1875,8 @@ static inline uart_tx_buf_t *uart_tx_identify(UART_HandleTypeDef *huart) {
  * @param data The data will be write.
  * @param len The data length will be written.
  * @return The length that be written.
+ * @note The data is written into the half which is not transmitting, so it
+ *       never waits for the DMA.
  */
 uint32_t uart_dmatx_write(UART_HandleTypeDef *huart, const void *data,
                           size_t len) {
@@ -1811,29 +1889,38 @@ uint32_t uart_dmatx_write(UART_HandleTypeDef *huart, const void *data,
         return 0;
     }
 
-    /* Get the remain length of buffer. */
-    uint32_t buf_remain = send_tx_buf->buf_size - send_tx_buf->head_ptr;
+    /* The transmit complete interrupt may switch the halves, so copy with
+     * interrupts disabled. The copy is no longer than half of the buffer. */
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    /* Get the remain length of the filling half. */
+    uint32_t buf_remain =
+        (uint32_t)(send_tx_buf->buf_size / 2) - send_tx_buf->head_ptr;
 
     /* Prevent overflow. */
     if (buf_remain < len) {
-        memcpy(send_tx_buf->send_buf + send_tx_buf->head_ptr, data, buf_remain);
-        send_tx_buf->head_ptr += buf_remain;
-        return buf_remain;
-    } else {
-        memcpy(send_tx_buf->send_buf + send_tx_buf->head_ptr, data, len);
-        send_tx_buf->head_ptr += len;
-        return len;
+        len = buf_remain;
     }
+
+    memcpy(uart_dmatx_fill_buf(send_tx_buf) + send_tx_buf->head_ptr, data,
+           len);
+    send_tx_buf->head_ptr += len;
+
+    __set_PRIMASK(primask);
+    return len;
 }
 
 /**
  * @brief Transmit the data in the buf.
  *
  * @param huart The handle of UART.
- * @return The length which is succeed transmitted.
+ * @return The length which is started or queued to transmit.
  * @note If you want transmit data, using `uart_dmatx_write` before.
  *       If you have huge continous data to transmit, we recommand use
  *       `HAL_UART_Transmit_DMA()`.
+ * @note It never waits. If the DMA is transmitting the other half, the data
+ *       is started in the transmit complete interrupt.
  */
 uint32_t uart_dmatx_send(UART_HandleTypeDef *huart) {
     uart_tx_buf_t *send_tx_buf = uart_tx_identify(huart);
@@ -1845,20 +1932,41 @@ uint32_t uart_dmatx_send(UART_HandleTypeDef *huart) {
         return 0;
     }
 
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
     uint32_t len = send_tx_buf->head_ptr;
-    if (len == 0) {
-        return 0;
+    if ((send_tx_buf->busy != 0) || (send_tx_buf->reserved != 0)) {
+        /* Start it after the current transfer or the commit. */
+        send_tx_buf->pending = (len != 0);
+    } else {
+        len = uart_dmatx_start(huart, send_tx_buf);
     }
 
-    /* Wait for last transfer end. */
-    while (__HAL_UART_GET_FLAG(huart, UART_FLAG_TC) == RESET)
-        ;
-
-    HAL_UART_Transmit_DMA(huart, send_tx_buf->send_buf, (uint16_t)len);
-    send_tx_buf->head_ptr = 0;
+    __set_PRIMASK(primask);
     return len;
 }
 
+/**
+ * @brief UART DMA transmit complete, start the half which is requested to
+ *        send during the transfer.
+ *
+ * @param huart The handle of UART.
+ */
+static void uart_dmatx_done_callback(UART_HandleTypeDef *huart) {
+    uart_tx_buf_t *send_tx_buf = uart_tx_identify(huart);
+    if (send_tx_buf == NULL) {
+        return;
+    }
+
+    /* Only one transfer at a time, if this buf was busy it is done now. */
+    send_tx_buf->busy = 0;
+
+    if ((send_tx_buf->pending != 0) && (send_tx_buf->reserved == 0)) {
+        uart_dmatx_start(huart, send_tx_buf);
+    }
+}
+
 /**
  * @brief Resize the send buf of UART.
  *
@@ -1868,7 +1976,7 @@ uint32_t uart_dmatx_send(UART_HandleTypeDef *huart) {
  * @retval - 0: Succeess
  * @retval - 1: This uart not enable DMA Tx.
  * @retval - 2: No free memory to allocate.
- * @retval - 3: This uart is busy now.
+ * @retval - 3: This uart is busy now, or there are data not transmitted.
  * @retval - 4: Parameter error, size can't be 0.
  */
 uint8_t uart_dmatx_resize_buf(UART_HandleTypeDef *huart, uint32_t size) {
@@ -1881,9 +1989,10 @@ uint8_t uart_dmatx_resize_buf(UART_HandleTypeDef *huart, uint32_t size) {
         return 1;
     }
 
-    if ((huart->gState) & (HAL_UART_STATE_BUSY_TX | HAL_UART_STATE_BUSY) &
-        ~HAL_UART_STATE_READY) {
-        /* The UART is busy. */
+    if (((huart->gState) & (HAL_UART_STATE_BUSY_TX | HAL_UART_STATE_BUSY) &
+         ~HAL_UART_STATE_READY) ||
+        (send_tx_buf->busy != 0) || (send_tx_buf->head_ptr != 0)) {
+        /* The UART is busy, or there are data not transmitted. */
         return 3;
     }
 
@@ -1901,6 +2010,7 @@ uint8_t uart_dmatx_resize_buf(UART_HandleTypeDef *huart, uint32_t size) {
 
     send_tx_buf->send_buf = new_ptr;
     send_tx_buf->buf_size = size;
+    send_tx_buf->fill = 0;
 
     return 0;
 }
@@ -1921,6 +2031,107 @@ uint32_t uart_damtx_get_buf_szie(UART_HandleTypeDef *huart) {
     return uart_tx_buf->buf_size;
 }
 
+/**
+ * @}
+ */
+
+/*****************************************************************************
+ * @defgroup Public UART baud rate functions.
+ * @{
+ */
+
+/**
+ * @brief Check whether the UART can run at the baud rate.
+ *
+ * @param huart The handle of UART.
+ * @param baud_rate Baud rate.
+ * @return Check result:
+ * @retval - 0: `UART_BAUD_OK`:   Supported.
+ * @retval - 2: `UART_BAUD_FAIL`: The baud rate is higher than PCLK / 16, or
+ *                                the error is more than `UART_BAUD_MAX_ERROR`.
+ * @note PCLK is divided by an integer number of 1/16 bit times, so the actual
+ *       baud rate is PCLK / round(PCLK / baud).
+ */
+uint8_t uart_check_baud_rate(UART_HandleTypeDef *huart, uint32_t baud_rate) {
+    if ((huart == NULL) || (baud_rate == 0)) {
+        return UART_BAUD_FAIL;
+    }
+
+    /* Only USART1 is on APB2. */
+    uint32_t pclk = (huart->Instance == USART1) ? HAL_RCC_GetPCLK2Freq()
+                                                : HAL_RCC_GetPCLK1Freq();
+    uint32_t div = (pclk + baud_rate / 2U) / baud_rate;
+    if (div < 16U) {
+        return UART_BAUD_FAIL;
+    }
+
+    uint32_t actual = pclk / div;
+    uint32_t error =
+        (actual > baud_rate) ? (actual - baud_rate) : (baud_rate - actual);
+    if ((uint64_t)error * 1000U > (uint64_t)baud_rate * UART_BAUD_MAX_ERROR) {
+        return UART_BAUD_FAIL;
+    }
+
+    return UART_BAUD_OK;
+}
+
+/**
+ * @brief Change the baud rate of UART in place.
+ *
+ * @param huart The handle of UART.
+ * @param baud_rate Baud rate.
+ * @return Change result:
+ * @retval - 0: `UART_BAUD_OK`:   Success.
+ * @retval - 1: `UART_BAUD_BUSY`: Transmitting, try again later.
+ * @retval - 2: `UART_BAUD_FAIL`: UART is not init, or the baud rate is not
+ *                                supported, see `uart_check_baud_rate`.
+ * @note The data in the receive fifo and the transmit buffer is kept. The
+ *       receive DMA is restarted from the start of `recv_buf`, the bytes
+ *       arriving during the change are lost.
+ */
+uint8_t uart_set_baud_rate(UART_HandleTypeDef *huart, uint32_t baud_rate) {
+    if ((uart_check_baud_rate(huart, baud_rate) != UART_BAUD_OK) ||
+        (huart->gState == HAL_UART_STATE_RESET)) {
+        return UART_BAUD_FAIL;
+    }
+
+    /* The last byte on the line must finish at the old baud rate. */
+    if ((huart->gState != HAL_UART_STATE_READY) ||
+        (__HAL_UART_GET_FLAG(huart, UART_FLAG_TC) == RESET)) {
+        return UART_BAUD_BUSY;
+    }
+
+    /* The UART and DMA interrupts also move the receive pointer. Nothing
+     * here waits for a tick, so keep the interrupts disabled. */
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uart_rx_fifo_t *uart_rx_fifo = uart_rx_identify(huart);
+    if ((uart_rx_fifo != NULL) && (huart->hdmarx != NULL)) {
+        HAL_UART_AbortReceive(huart);
+
+        /* Take the data received at the old baud rate. */
+        uart_dmarx_idle_callback(huart);
+        uart_rx_fifo->head_ptr = 0;
+    } else {
+        uart_rx_fifo = NULL;
+    }
+
+    huart->Init.BaudRate = baud_rate;
+    uint8_t res =
+        (HAL_UART_Init(huart) == HAL_OK) ? UART_BAUD_OK : UART_BAUD_FAIL;
+
+    if (uart_rx_fifo != NULL) {
+        __HAL_UART_ENABLE_IT(huart, UART_IT_IDLE);
+        __HAL_UART_CLEAR_IDLEFLAG(huart);
+        HAL_UART_Receive_DMA(huart, uart_rx_fifo->recv_buf,
+                             uart_rx_fifo->buf_size);
+    }
+
+    __set_PRIMASK(primask);
+    return res;
+}
+
 /**
  * @}
  */
@@ -1967,6 +2178,15 @@ void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) {
         } break;
     }
 
+    /* The TX DMA error ends the transfer without the complete callback,
+     * release the send buf or it stays busy and never sends again. */
+    if ((error_code & HAL_UART_ERROR_DMA) && (huart->hdmatx != NULL) &&
+        (huart->hdmatx->ErrorCode != HAL_DMA_ERROR_NONE)) {
+        HAL_DMA_Abort(huart->hdmatx);
+        huart->hdmatx->ErrorCode = HAL_DMA_ERROR_NONE;
+        uart_dmatx_done_callback(huart);
+    }
+
     if (NULL != huart->hdmarx) {
         while (
             HAL_UART_Receive_DMA(huart, huart->pRxBuffPtr, huart->RxXferSize)) {
@@ -2008,6 +2228,17 @@ void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef *huart) {
     }
 }
 
+/**
+ * @brief Tx Transfer completed callbacks.
+ *
+ * @param huart The handle of UART.
+ */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
+    if (huart->hdmatx != NULL) {
+        uart_dmatx_done_callback(huart);
+    }
+}
+
 #endif /* USE_HAL_UART_REGISTER_CALLBACKS == 0 */
 
 /**
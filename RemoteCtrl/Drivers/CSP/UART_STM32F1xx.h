@@ -35,6 +35,13 @@ extern "C" {
 #define UART_DEINIT_DMA_FAIL 2
 #define UART_NO_INIT         3
 
+#define UART_BAUD_OK         0
+#define UART_BAUD_BUSY       1
+#define UART_BAUD_FAIL       2
+
+/* Max error of the actual baud rate, in 0.1%. */
+#define UART_BAUD_MAX_ERROR  10
+
 /**
  * @}
  */
@@ -171,6 +178,8 @@ uint8_t uart5_deinit(void);
 
 int uart_printf(UART_HandleTypeDef *huart, const char *__format, ...);
 int uart_scanf(UART_HandleTypeDef *huart, const char *__format, ...);
+uint8_t uart_check_baud_rate(UART_HandleTypeDef *huart, uint32_t baud_rate);
+uint8_t uart_set_baud_rate(UART_HandleTypeDef *huart, uint32_t baud_rate);
 
 uint32_t uart_dmarx_read(UART_HandleTypeDef *huart, void *buf, size_t len);
 uint8_t uart_dmarx_resize_fifo(UART_HandleTypeDef *huart, uint32_t buf_size,
@@ -31,6 +31,12 @@
  *      (##) `message_polling_data`仅支持DMA接收, 如果是串口接收需要自行编写回调
  *           函数与接收逻辑
  *      (##) 调用`message_remove_polling_handle`删除要轮询的串口
+ * (#) 波特率协商
+ *      (##) 默认不编译, 与主控板一起把`MSG_BAUD_ENABLE`置1后才能使用
+ *      (##) 以`MSG_BAUD_BASE_RATE`初始化串口并添加到轮询链表后, 调用
+ *           `message_baud_enable`应答主控板的协商, 本端只做应答方
+ *      (##) 切换期间暂停发送, 每种含义只保留最新的一帧, 切换后按新速率发出
+ *      (##) `message_polling_data`需要定时调用(没有数据时也要), 用于处理超时
  ******************************************************************************
  *    Date    | version |   Author    | Version Info
  * -----------+---------+-------------+----------------------------------------
@@ -42,7 +48,10 @@
 
 #include <CSP_Config.h>
 
+#include <stdbool.h>
+
 #define MSG_MAX_DATA_LENGTH          16 /* 最大数据长度, 超出长度会造成缓冲区溢出 */
+#define MSG_POLLING_READ_SIZE        32 /* 轮询时单次从接收FIFO读取的字节数 */
 /* 如果是数组, 可以调用此宏定义获取长度; 堆分配的内存勿用!! */
 #define MSG_GET_DATA_ARRAY_LENGTH(X) (sizeof(X))
 
@@ -52,10 +61,53 @@
 #error Max data length must be less than 250.
 #endif /* MSG_MAX_DATA_LENGTH */
 
+/**
+ * 帧格式版本, 收发双方必须一致
+ * 1: | 含义/类型 | 长度 | 数据 | 0xFF |
+ * 2: | 0xA5 0x5A | 版本/保留 | 序号 | 含义/类型 | 长度 | 数据 | CRC16 |
+ *    CRC16高字节在前, 从版本字节算到数据末尾, 算法为CRC-16/CCITT-FALSE
+ * 3: | COBS(| 版本/保留 | 序号 | 含义/类型 | 长度 | 数据 | CRC16 |) | 0x00 |
+ *    内容与版本2相同, 去掉同步字后做COBS编码, 帧内不会出现0x00,
+ *    接收方遇到0x00就是帧边界, 出错后最多丢失当前一帧
+ */
+#define MSG_FRAME_VERSION 2
+
+#if (MSG_FRAME_VERSION == 1)
+#define MSG_FRAME_HEAD_SIZE 2 /* 数据区之前的字节数 */
+#define MSG_FRAME_TAIL_SIZE 1 /* 数据区之后的字节数 */
+#elif (MSG_FRAME_VERSION == 2)
+#define MSG_FRAME_SYNC_0    0xA5 /* 同步字第一个字节 */
+#define MSG_FRAME_SYNC_1    0x5A /* 同步字第二个字节 */
+#define MSG_FRAME_HEAD_SIZE 6    /* 数据区之前的字节数 */
+#define MSG_FRAME_TAIL_SIZE 2    /* 数据区之后的字节数 */
+#elif (MSG_FRAME_VERSION == 3)
+#define MSG_FRAME_HEAD_SIZE 5 /* 数据区之前的字节数, 含COBS编码字节 */
+#define MSG_FRAME_TAIL_SIZE 3 /* 数据区之后的字节数, 含0x00分隔符 */
+#else /* MSG_FRAME_VERSION */
+#error Invalid message frame version.
+#endif /* MSG_FRAME_VERSION */
+
+/* 一帧除数据区以外的字节数 */
+#define MSG_FRAME_OVERHEAD    (MSG_FRAME_HEAD_SIZE + MSG_FRAME_TAIL_SIZE)
+
 #define MSG_NO_DATA           0x00 /* 没有收到消息 */
 #define MSG_DATA_OVER         0xFF /* 数据长度溢出 */
-#define MSG_DATA_LENGTH_ERROR 0xFE /* 实际接收长度与消息中的长度不一 */
-#define MSG_DATA_VERIFY_ERROR 0xFD /* 接收校验错误(最后一个字节不是0xFF) */
+#define MSG_DATA_LENGTH_ERROR 0xFE /* 实际接收长度与消息中的长度不一(已弃用) */
+#define MSG_DATA_VERIFY_ERROR 0xFD /* 接收校验错误(帧尾不是0xFF或CRC错误) */
+
+/**
+ * 波特率协商, 参数与主控板一致
+ * 帧数据区: | 波特率(uint32, 小端) | 测试图样(仅探测帧) |, 帧头的类型位是操作码
+ */
+#ifndef MSG_BAUD_ENABLE
+#define MSG_BAUD_ENABLE          0      /* 是否编译波特率协商, 与主控板一致 */
+#endif /* MSG_BAUD_ENABLE */
+#define MSG_BAUD_MEAN            0x0C   /* 波特率协商帧使用的含义编号, 不能在message_mean_t中使用 */
+#define MSG_BAUD_BASE_RATE       115200 /* 上电与回退时的波特率 */
+#define MSG_BAUD_TIMEOUT_MS      50     /* 切换的超时时间 */
+#define MSG_BAUD_KEEPALIVE_MS    100    /* 检查接收错误的周期 */
+#define MSG_BAUD_LINK_TIMEOUT_MS 500    /* 超过这个时间没有收到协商帧就回退 */
+#define MSG_BAUD_ERROR_LIMIT     8      /* 一个检查周期内允许的接收错误数 */
 
 /**
  * @brief 数据含义
@@ -106,4 +158,8 @@ void message_remove_polling_handle(UART_HandleTypeDef *uart_handle);
 
 uint8_t message_polling_data(void);
 
+#if (MSG_BAUD_ENABLE == 1)
+bool message_baud_enable(UART_HandleTypeDef *huart, uint32_t max_baud_rate);
+#endif /* MSG_BAUD_ENABLE == 1 */
+
 #endif /* __MSG_PROTOCOL_H */
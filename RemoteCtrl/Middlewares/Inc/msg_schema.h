@@ -0,0 +1,151 @@
+/**
+ * @file    msg_schema.h
+ * @author  Deadline039
+ * @brief   消息数据结构表
+ * @version 1.0
+ * @date    2026-10-16
+ * @note    run_point与RemoteCtrl使用同一份文件, 修改后两边同步
+ *
+ *****************************************************************************
+ *                             ##### 如何使用 ####
+ * (#) 在`MSG_SCHEMA_TABLE`中添加一行, 并编写对应的字段表, 例如:
+ *     X(REMOTE, remote, MSG_DATA_UINT8, MSG_REMOTE_FIELDS)
+ *     第一项与`message_mean_t`中`MSG_`后的名称相同
+ *
+ * (#) 每一行会生成:
+ *     `msg_remote_t`          紧凑结构体, 与帧数据区内容一一对应
+ *     `MSG_REMOTE_SIZE`       数据区长度
+ *     `msg_remote_encode()`   把结构体写入缓冲区
+ *     `msg_remote_send()`     调用`message_send_data`发送
+ *     `msg_remote_decode()`   检查长度与类型, 返回数据区的结构体视图
+ *
+ * (#) 多字节字段按小端存放, 收发双方都是Cortex-M, 不做字节序转换
+ *****************************************************************************
+ */
+
+#ifndef __MSG_SCHEMA_H
+#define __MSG_SCHEMA_H
+
+#include "msg_protocol.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+/**
+ * @brief 消息结构表
+ *        X(名称大写, 名称小写, 数据类型, 字段表)
+ */
+#define MSG_SCHEMA_TABLE(X)                                                    \
+    X(REMOTE, remote, MSG_DATA_UINT8, MSG_REMOTE_FIELDS)
+
+/* 遥控器帧是否附带延迟跟踪字段, 遥控器与主控必须一致 */
+#define MSG_REMOTE_TRACE 0
+
+/**
+ * 遥控器状态变化时立即发送, 不变时按此周期(ms)发送心跳帧,
+ * 主控超过`MSG_REMOTE_LINK_TIMEOUT_MS`没有收到任何一帧视为断开
+ */
+#define MSG_REMOTE_HEARTBEAT_MS    100
+#define MSG_REMOTE_LINK_TIMEOUT_MS (3 * MSG_REMOTE_HEARTBEAT_MS)
+
+/**
+ * @brief 遥控器数据字段表
+ *        F(C类型, 字段名)
+ */
+#define MSG_REMOTE_FIELDS(F)                                                   \
+    F(uint8_t, key)     /* 按下的按键, 0表示没有按键 */                        \
+    F(uint8_t, left_x)  /* 左摇杆X */                                          \
+    F(uint8_t, left_y)  /* 左摇杆Y */                                          \
+    F(uint8_t, right_x) /* 右摇杆X */                                          \
+    F(uint8_t, right_y) /* 右摇杆Y */                                          \
+    MSG_REMOTE_TRACE_FIELDS(F)
+
+#if (MSG_REMOTE_TRACE == 1)
+/**
+ * @brief 遥控器延迟跟踪字段
+ *        trace_seq 每发送一帧加1
+ *        trace_us  交给串口发送前的耗时(us). 按键变化的帧从第一次扫描到
+ *                  按下(松开)算起, 包括消抖时间; 其他帧从本次扫描开始算起
+ */
+#define MSG_REMOTE_TRACE_FIELDS(F) F(uint8_t, trace_seq) F(uint16_t, trace_us)
+#else /* MSG_REMOTE_TRACE == 1 */
+#define MSG_REMOTE_TRACE_FIELDS(F)
+#endif /* MSG_REMOTE_TRACE == 1 */
+
+/** 生成结构体与长度 **********************************************************/
+
+#define MSG_SCHEMA_FIELD_MEMBER(ctype, name) ctype name;
+#define MSG_SCHEMA_FIELD_SIZE(ctype, name)   +sizeof(ctype)
+
+#define MSG_SCHEMA_STRUCT(upper, lower, type, fields)                          \
+    typedef __PACKED_STRUCT {                                                  \
+        fields(MSG_SCHEMA_FIELD_MEMBER)                                        \
+    }                                                                          \
+    msg_##lower##_t;                                                           \
+                                                                               \
+    enum { MSG_##upper##_SIZE = 0 fields(MSG_SCHEMA_FIELD_SIZE) };             \
+                                                                               \
+    _Static_assert(sizeof(msg_##lower##_t) == MSG_##upper##_SIZE,              \
+                   "msg_" #lower "_t must be packed.");                        \
+    _Static_assert(MSG_##upper##_SIZE <= MSG_MAX_DATA_LENGTH,                  \
+                   "msg_" #lower "_t exceeds MSG_MAX_DATA_LENGTH.");
+
+MSG_SCHEMA_TABLE(MSG_SCHEMA_STRUCT)
+
+/** 生成编解码函数 ************************************************************/
+
+/**
+ * msg_xxx_encode: 把结构体写入缓冲区, 返回写入的长度
+ * msg_xxx_send:   以结构表中的含义与类型发送
+ * msg_xxx_decode: 检查长度与类型, 返回数据区的结构体视图, 不符时返回`NULL`
+ *                 结构体是紧凑的, 可以直接指向接收缓冲区, 不逐字段解析
+ */
+#define MSG_SCHEMA_CODEC(upper, lower, type, fields)                           \
+    static inline uint8_t msg_##lower##_encode(const msg_##lower##_t *msg,     \
+                                               uint8_t *buf) {                 \
+        memcpy(buf, msg, MSG_##upper##_SIZE);                                  \
+        return MSG_##upper##_SIZE;                                             \
+    }                                                                          \
+                                                                               \
+    static inline void msg_##lower##_send(const msg_##lower##_t *msg) {        \
+        message_send_data(MSG_##upper, type, (void *)msg, MSG_##upper##_SIZE); \
+    }                                                                          \
+                                                                               \
+    static inline const msg_##lower##_t *msg_##lower##_decode(                 \
+        uint8_t msg_length, message_type_t msg_type, const void *msg_data) {   \
+        if ((msg_length != MSG_##upper##_SIZE) || (msg_type != type) ||        \
+            (msg_data == NULL)) {                                              \
+            return NULL;                                                       \
+        }                                                                      \
+        return (const msg_##lower##_t *)msg_data;                              \
+    }
+
+MSG_SCHEMA_TABLE(MSG_SCHEMA_CODEC)
+
+/** 按含义检查长度 ************************************************************/
+
+#define MSG_SCHEMA_CHECK_CASE(upper, lower, type, fields)                      \
+    case MSG_##upper:                                                          \
+        return (msg_length == MSG_##upper##_SIZE) && (msg_type == type);
+
+/**
+ * @brief 检查某种含义的消息长度与类型是否与结构表一致
+ *
+ * @param msg_mean 数据含义
+ * @param msg_length 消息帧长度
+ * @param msg_type 数据类型
+ * @return 是否一致, 不在结构表中的含义不做检查, 返回`true`
+ */
+static inline bool message_schema_check(message_mean_t msg_mean,
+                                        uint8_t msg_length,
+                                        message_type_t msg_type) {
+    switch (msg_mean) {
+        MSG_SCHEMA_TABLE(MSG_SCHEMA_CHECK_CASE)
+
+        default: {
+            return true;
+        }
+    }
+}
+
+#endif /* __MSG_SCHEMA_H */
@@ -8,9 +8,11 @@
  */
 
 #include "msg_protocol.h"
-#include "string.h"
 #include "UART_STM32F1xx.h"
+#include "crc16.h"
+#include "string.h"
 
+#include <stdbool.h>
 
 /**
  * @brief 回调函数指针
@@ -45,6 +47,121 @@ void message_register_send_handle(message_mean_t msg_mean,
     p_send_handle[msg_mean] = msg_send_handle;
 }
 
+#if (MSG_FRAME_VERSION >= 2)
+/**
+ * @brief 每种数据含义的发送序号, 含义占4位, 包括波特率协商帧
+ */
+static uint8_t tx_sequence[16] = {0};
+#endif /* MSG_FRAME_VERSION >= 2 */
+
+#if (MSG_FRAME_VERSION == 3)
+/**
+ * @brief 原地COBS编码
+ *
+ * @param[in,out] buf 第0字节留给编码字节, 之后是`len`字节原始数据
+ * @param len 原始数据长度, 必须小于254, 这样不需要插入额外的编码字节
+ * @note 编码后每个0x00被替换为到下一个0x00(或末尾)的距离,
+ *       第0字节为到第一个0x00的距离
+ */
+static inline void message_cobs_encode(uint8_t *buf, size_t len) {
+    uint8_t *code = buf;
+    uint8_t distance = 1;
+
+    for (size_t i = 1; i <= len; ++i) {
+        if (buf[i] == 0x00) {
+            *code = distance;
+            code = &buf[i];
+            distance = 1;
+        } else {
+            ++distance;
+        }
+    }
+    *code = distance;
+}
+#endif /* MSG_FRAME_VERSION == 3 */
+
+/**
+ * @brief 按帧格式填充一帧数据
+ *
+ * @param[out] frame 帧缓冲区, 长度至少为`data_len + MSG_FRAME_OVERHEAD`
+ * @param data_mean 数据含义(`message_mean_t`或`MSG_BAUD_MEAN`)
+ * @param data_type 数据类型
+ * @param data 数据内容
+ * @param data_len 数据长度
+ */
+static inline void message_fill_frame(uint8_t *frame, uint8_t data_mean,
+                                      message_type_t data_type,
+                                      const void *data, size_t data_len) {
+#if (MSG_FRAME_VERSION == 2)
+    /* 同步字 */
+    frame[0] = MSG_FRAME_SYNC_0;
+    frame[1] = MSG_FRAME_SYNC_1;
+    /* 高四位标记帧格式版本, 低四位保留 */
+    frame[2] = (uint8_t)(MSG_FRAME_VERSION << 4);
+    /* 发送序号 */
+    frame[3] = tx_sequence[data_mean]++;
+    /* 以下与版本1相同, 指针后移四个字节 */
+    frame += 4;
+#elif (MSG_FRAME_VERSION == 3)
+    /* 第0字节留给COBS编码字节, 其余与版本2相同, 只是没有同步字 */
+    frame[1] = (uint8_t)(MSG_FRAME_VERSION << 4);
+    frame[2] = tx_sequence[data_mean]++;
+    frame += 3;
+#endif /* MSG_FRAME_VERSION == 2 */
+
+    /* 第一个字节, 高四位标记含义, 低四位标记数据类型 */
+    frame[0] = (uint8_t)(data_mean << 4) | data_type;
+    /* 第二个字节, 标记数据长度 */
+    frame[1] = (uint8_t)data_len;
+    /* 数据区 */
+    memcpy(frame + 2, data, data_len);
+
+#if (MSG_FRAME_VERSION >= 2)
+    /* 从版本字节到数据末尾计算CRC, 高字节在前 */
+    uint16_t crc = crc16_calc(frame - 2, data_len + 4);
+    frame[data_len + 2] = (uint8_t)(crc >> 8);
+    frame[data_len + 3] = (uint8_t)crc;
+#else  /* MSG_FRAME_VERSION >= 2 */
+    /* 最后一个字节, 标记数据末尾 */
+    frame[data_len + 2] = 0xFF;
+#endif /* MSG_FRAME_VERSION >= 2 */
+
+#if (MSG_FRAME_VERSION == 3)
+    /* 从版本字节到CRC原地编码, 最后补上分隔符 */
+    message_cobs_encode(frame - 3, data_len + 6);
+    frame[data_len + 4] = 0x00;
+#endif /* MSG_FRAME_VERSION == 3 */
+}
+
+/**
+ * @brief 发送组好的一帧
+ *
+ * @param send_handle 发送串口句柄
+ * @param frame 帧缓冲区
+ * @param frame_len 帧长度
+ */
+static void message_send_frame(UART_HandleTypeDef *send_handle,
+                               const uint8_t *frame, size_t frame_len) {
+    if (send_handle->hdmatx != NULL) {
+        uart_dmatx_write(send_handle, frame, frame_len);
+        uart_dmatx_send(send_handle);
+    } else {
+        HAL_UART_Transmit(send_handle, (uint8_t *)frame, frame_len, 0xFFFF);
+    }
+}
+
+#if (MSG_BAUD_ENABLE == 1)
+
+static bool message_baud_paused(UART_HandleTypeDef *huart);
+
+/* 暂停发送期间每种含义保留的最新一帧 */
+static uint8_t msg_held_frame[MSG_MEAN_LENGTH_RESERVE]
+                            [MSG_MAX_DATA_LENGTH + MSG_FRAME_OVERHEAD];
+/* 保留的帧长度, 0表示没有 */
+static uint8_t msg_held_len[MSG_MEAN_LENGTH_RESERVE] = {0};
+
+#endif /* MSG_BAUD_ENABLE == 1 */
+
 /**
  * @brief 填充并发送数据, 支持多种类型
  *
@@ -52,6 +169,7 @@ void message_register_send_handle(message_mean_t msg_mean,
  * @param data_type 数据类型
  * @param data 数据内容
  * @param data_len 数据长度(字节数), 使用`MSG_GET_DATA_ARRAY_LENGTH`宏获取即可
+ * @note 切换波特率期间不发送, 只保留最新的一帧, 切换完成后再发出
  */
 void message_send_data(message_mean_t data_mean, message_type_t data_type,
                        void *data, size_t data_len) {
@@ -65,32 +183,116 @@ void message_send_data(message_mean_t data_mean, message_type_t data_type,
         return;
     }
 
-    uint8_t *data_buf = (uint8_t *)malloc(data_len + 3); /* 发送数据的字节流 */
-
-    /* 复制数据到字节流, 前面空出两个字节用来标记数据 */
-    memcpy((data_buf + 2), data, data_len);
-    /* 第一个字节, 高四位标记含义, 低四位标记数据类型 */
-    *data_buf = (uint8_t)(data_mean << 4) | data_type;
-    /* 第二个字节, 标记数据长度 */
-    *(data_buf + 1) = (uint8_t)data_len;
-    /* 最后一个字节, 标记数据末尾 */
-    *(data_buf + data_len + 2) = 0xFF;
-
-    if (p_send_handle[data_mean]->hdmatx != NULL) {
-        uart_dmatx_write(p_send_handle[data_mean], data_buf, data_len + 3);
-        uart_dmatx_send(p_send_handle[data_mean]);
-    } else {
-        HAL_UART_Transmit(p_send_handle[data_mean], data_buf, data_len + 3,
-                          0xFFFF);
+#if (MSG_BAUD_ENABLE == 1)
+    if (message_baud_paused(p_send_handle[data_mean])) {
+        /* 遥控数据是状态量, 新帧覆盖旧帧 */
+        message_fill_frame(msg_held_frame[data_mean], data_mean, data_type,
+                           data, data_len);
+        msg_held_len[data_mean] = (uint8_t)(data_len + MSG_FRAME_OVERHEAD);
+        return;
     }
-    free(data_buf);
+#endif /* MSG_BAUD_ENABLE == 1 */
+
+    /* 在栈上组帧, 不使用堆内存 */
+    uint8_t data_buf[MSG_MAX_DATA_LENGTH + MSG_FRAME_OVERHEAD];
+    message_fill_frame(data_buf, data_mean, data_type, data, data_len);
+    message_send_frame(p_send_handle[data_mean], data_buf,
+                       data_len + MSG_FRAME_OVERHEAD);
 }
 
+/**
+ * @brief 帧解析状态
+ */
+typedef enum {
+#if (MSG_FRAME_VERSION == 3)
+    MSG_PARSE_COBS,    /*!< 接收COBS编码的帧 */
+    MSG_PARSE_DISCARD  /*!< 帧过长, 丢弃到下一个0x00 */
+#else                  /* MSG_FRAME_VERSION == 3 */
+#if (MSG_FRAME_VERSION == 2)
+    MSG_PARSE_SYNC_0,  /*!< 等待同步字第一个字节 */
+    MSG_PARSE_SYNC_1,  /*!< 等待同步字第二个字节 */
+    MSG_PARSE_VERSION, /*!< 等待版本字节 */
+    MSG_PARSE_SEQ,     /*!< 等待序号 */
+#endif                 /* MSG_FRAME_VERSION == 2 */
+    MSG_PARSE_HEAD,    /*!< 等待帧头(含义与类型) */
+    MSG_PARSE_LENGTH,  /*!< 等待长度字节 */
+    MSG_PARSE_DATA,    /*!< 接收数据区 */
+#if (MSG_FRAME_VERSION == 2)
+    MSG_PARSE_CRC_0,   /*!< 等待CRC高字节 */
+    MSG_PARSE_CRC_1    /*!< 等待CRC低字节 */
+#else                  /* MSG_FRAME_VERSION == 2 */
+    MSG_PARSE_TAIL,    /*!< 等待帧尾0xFF */
+    MSG_PARSE_RESYNC   /*!< 出错后丢弃数据, 直到收到0xFF再重新同步 */
+#endif                 /* MSG_FRAME_VERSION == 2 */
+#endif                 /* MSG_FRAME_VERSION == 3 */
+} msg_parse_state_t;
+
+#if (MSG_FRAME_VERSION == 1)
+#define MSG_PARSE_START      MSG_PARSE_HEAD   /* 解析起始状态 */
+#define MSG_PARSE_FRAME_SIZE (MSG_MAX_DATA_LENGTH + 2)
+#elif (MSG_FRAME_VERSION == 2)
+#define MSG_PARSE_START      MSG_PARSE_SYNC_0 /* 解析起始状态 */
+#define MSG_PARSE_FRAME_SIZE (MSG_MAX_DATA_LENGTH + 2)
+#else /* MSG_FRAME_VERSION */
+#define MSG_PARSE_START      MSG_PARSE_COBS   /* 解析起始状态 */
+/* 版本3保存解码后的版本, 序号与CRC */
+#define MSG_PARSE_FRAME_SIZE (MSG_MAX_DATA_LENGTH + 6)
+#endif /* MSG_FRAME_VERSION */
+
+/**
+ * @brief 字节流帧解析器, 跨多次读取保存未收完的帧
+ */
+typedef struct {
+    msg_parse_state_t state;                /*!< 解析状态 */
+    uint8_t index;                          /*!< 当前帧已收到的字节数 */
+    uint8_t frame[MSG_PARSE_FRAME_SIZE];    /*!< 帧头, 长度与数据区 */
+#if (MSG_FRAME_VERSION == 2)
+    uint8_t seq;                            /*!< 当前帧的序号 */
+    uint16_t crc;                           /*!< 已收到部分的CRC */
+    uint16_t crc_recv;                      /*!< 帧中携带的CRC */
+#elif (MSG_FRAME_VERSION == 3)
+    uint8_t code;                           /*!< 当前COBS块剩余字节数 */
+    bool zero_pending;                      /*!< 当前块结束后要补0x00 */
+#endif                                      /* MSG_FRAME_VERSION */
+} msg_parser_t;
+
+#if (MSG_BAUD_ENABLE == 1)
+
+/**
+ * @brief 波特率协商状态, 本端只做应答方
+ */
+typedef enum {
+    MSG_BAUD_IDLE,      /*!< 没有进行中的切换 */
+    MSG_BAUD_SWITCHING, /*!< 已暂停发送, 等待发送完成后切换 */
+    MSG_BAUD_PROBING    /*!< 已切换, 等待新速率下的探测帧 */
+} msg_baud_state_t;
+
+/**
+ * @brief 一个串口的波特率协商状态
+ */
+typedef struct {
+    bool enabled;           /*!< 是否开启协商 */
+    msg_baud_state_t state; /*!< 协商状态 */
+    uint32_t max;           /*!< 本端允许的最高波特率 */
+    uint32_t target;        /*!< 正在切换的波特率 */
+    uint32_t deadline;      /*!< 当前状态的超时时刻 */
+    uint32_t last_rx;       /*!< 最后一次收到协商帧的时刻 */
+    uint32_t last_check;    /*!< 最后一次检查错误计数的时刻 */
+    uint32_t errors;        /*!< 接收错误总数 */
+    uint32_t checked;       /*!< 上次检查时的接收错误总数 */
+} msg_baud_t;
+
+#endif /* MSG_BAUD_ENABLE == 1 */
+
 /**
  * @brief 消息轮询节点链表
  */
 typedef struct polling_list_node {
     UART_HandleTypeDef *huart;      /*!< 串口句柄 */
+    msg_parser_t parser;            /*!< 该串口的帧解析器 */
+#if (MSG_BAUD_ENABLE == 1)
+    msg_baud_t baud;                /*!< 波特率协商状态 */
+#endif /* MSG_BAUD_ENABLE == 1 */
     struct polling_list_node *next; /*!< 链表下一个节点 */
 } polling_list_node_t;
 
@@ -124,6 +326,15 @@ void message_add_polling_handle(UART_HandleTypeDef *uart_handle) {
     }
 
     new_node->huart = uart_handle;
+    new_node->parser.state = MSG_PARSE_START;
+    new_node->parser.index = 0;
+#if (MSG_FRAME_VERSION == 3)
+    new_node->parser.code = 0;
+    new_node->parser.zero_pending = false;
+#endif /* MSG_FRAME_VERSION == 3 */
+#if (MSG_BAUD_ENABLE == 1)
+    new_node->baud.enabled = false;
+#endif /* MSG_BAUD_ENABLE == 1 */
     new_node->next = p_polling_list_head;
     p_polling_list_head = new_node;
 }
@@ -160,63 +371,626 @@ void message_remove_polling_handle(UART_HandleTypeDef *uart_handle) {
 }
 
 /**
- * @brief 轮询数据, 并调用相应的函数
+ * @brief 帧头的含义是否有效
+ *
+ * @param head 帧头(含义与类型)
+ * @return 是否有效
+ */
+static inline bool message_head_valid(uint8_t head) {
+    return ((head >> 4) < MSG_MEAN_LENGTH_RESERVE) ||
+           ((MSG_BAUD_ENABLE == 1) && ((head >> 4) == MSG_BAUD_MEAN));
+}
+
+/**
+ * @brief 分发一帧完整且校验通过的数据
+ *
+ * @param[in] frame 帧缓冲区
+ * @note 波特率协商帧在`message_polling_data`中处理
+ */
+static void message_dispatch_frame(uint8_t *frame) {
+    if ((frame[0] >> 4) >= MSG_MEAN_LENGTH_RESERVE) {
+        return;
+    }
+
+    if (p_receive_callback[(frame[0] >> 4)] != NULL) {
+        p_receive_callback[(frame[0] >> 4)](frame[1], frame[0] & 0x0F,
+                                            frame + 2);
+    }
+}
+
+#if (MSG_FRAME_VERSION == 2)
+
+/**
+ * @brief 向解析器送入一个字节, 收完一帧时调用相应的回调函数
  *
+ * @param parser 解析器
+ * @param byte 收到的字节
  * @return 长度或者状态标记
- *  @retval `0-MSG_NO_DATA` - 没有收到数据, 或者没有接收的串口句柄
+ *  @retval `0-MSG_NO_DATA` - 帧未收完, 或正在搜索同步字
  *  @retval `255-MSG_DATA_OVER` - 长度溢出
- *  @retval `254-MSG_DATA_ERROR` - 校验错误, 末尾没有收到0xFF
- *  @retval 1~250 - 本次收到的有效数据
- * @note 事先在message_mean_t定义数据类型, 并注册相应的回调函数.
- *       这个函数挂在一个while循环或者定时器中一直轮询就可以,
- *       不要改动这个函数的任何内容
+ *  @retval `253-MSG_DATA_VERIFY_ERROR` - CRC校验错误
+ *  @retval 1~250 - 收完一帧, 返回数据长度
  */
-uint8_t message_polling_data(void) {
-    /* 轮询链表的指针 */
-    static polling_list_node_t *current_node = NULL;
+static uint8_t message_parse_byte(msg_parser_t *parser, uint8_t byte) {
+    switch (parser->state) {
+        case MSG_PARSE_SYNC_0: {
+            if (byte == MSG_FRAME_SYNC_0) {
+                parser->state = MSG_PARSE_SYNC_1;
+            }
+        } break;
+
+        case MSG_PARSE_SYNC_1: {
+            if (byte == MSG_FRAME_SYNC_1) {
+                parser->state = MSG_PARSE_VERSION;
+            } else if (byte != MSG_FRAME_SYNC_0) {
+                parser->state = MSG_PARSE_SYNC_0;
+            }
+        } break;
+
+        case MSG_PARSE_VERSION: {
+            if ((byte >> 4) != MSG_FRAME_VERSION) {
+                parser->state = (byte == MSG_FRAME_SYNC_0) ? MSG_PARSE_SYNC_1
+                                                           : MSG_PARSE_SYNC_0;
+                return MSG_NO_DATA;
+            }
+            parser->crc = crc16_update_byte(CRC16_INIT, byte);
+            parser->state = MSG_PARSE_SEQ;
+        } break;
+
+        case MSG_PARSE_SEQ: {
+            parser->seq = byte;
+            parser->crc = crc16_update_byte(parser->crc, byte);
+            parser->state = MSG_PARSE_HEAD;
+        } break;
+
+        case MSG_PARSE_HEAD: {
+            if (!message_head_valid(byte)) {
+                /* 消息下标越界, 重新搜索同步字 */
+                parser->state = MSG_PARSE_SYNC_0;
+                return MSG_NO_DATA;
+            }
+            parser->frame[0] = byte;
+            parser->crc = crc16_update_byte(parser->crc, byte);
+            parser->state = MSG_PARSE_LENGTH;
+        } break;
+
+        case MSG_PARSE_LENGTH: {
+            if ((byte == 0) || (byte > MSG_MAX_DATA_LENGTH)) {
+                /* 数据长度超过最大长度, 为避免异常内存操作, 丢弃这一帧 */
+                parser->state = MSG_PARSE_SYNC_0;
+                return MSG_DATA_OVER;
+            }
+            parser->frame[1] = byte;
+            parser->crc = crc16_update_byte(parser->crc, byte);
+            parser->index = 2;
+            parser->state = MSG_PARSE_DATA;
+        } break;
+
+        case MSG_PARSE_DATA: {
+            parser->frame[parser->index++] = byte;
+            parser->crc = crc16_update_byte(parser->crc, byte);
+            if (parser->index == parser->frame[1] + 2) {
+                parser->state = MSG_PARSE_CRC_0;
+            }
+        } break;
+
+        case MSG_PARSE_CRC_0: {
+            parser->crc_recv = (uint16_t)(byte << 8);
+            parser->state = MSG_PARSE_CRC_1;
+        } break;
+
+        default: { /* MSG_PARSE_CRC_1 */
+            parser->crc_recv |= byte;
+            parser->state = MSG_PARSE_SYNC_0;
+            if (parser->crc_recv != parser->crc) {
+                /* CRC校验错误 */
+                return MSG_DATA_VERIFY_ERROR;
+            }
+            message_dispatch_frame(parser->frame);
+            return parser->frame[1];
+        }
+    }
 
-    if (current_node == NULL) {
-        current_node = p_polling_list_head;
+    return MSG_NO_DATA;
+}
+
+#elif (MSG_FRAME_VERSION == 3)
+
+/**
+ * @brief 收到分隔符, 检查解码后的一帧并分发
+ *
+ * @param parser 解析器
+ * @return 长度或者状态标记, 同`message_parse_byte`
+ */
+static uint8_t message_parse_cobs_end(msg_parser_t *parser) {
+    uint8_t *frame = parser->frame;
+    uint8_t len = parser->index;
+
+    if (parser->code != 0) {
+        /* 最后一块没有收完, 编码字节被破坏, 解码结果不可信 */
+        return MSG_DATA_VERIFY_ERROR;
+    }
+
+    if (len == 0) {
+        /* 连续的分隔符, 不是帧 */
         return MSG_NO_DATA;
     }
 
-    /* 数据数组 */
-    uint8_t data_buf[MSG_MAX_DATA_LENGTH + 3];
+    /* | 版本/保留 | 序号 | 含义/类型 | 长度 | 数据 | CRC16 | */
+    if ((len < 7) || ((frame[0] >> 4) != MSG_FRAME_VERSION) ||
+        (!message_head_valid(frame[2])) || (frame[3] == 0) ||
+        (frame[3] > MSG_MAX_DATA_LENGTH) || (frame[3] + 6 != len)) {
+        return MSG_DATA_VERIFY_ERROR;
+    }
 
-    uint32_t data_len =
-        uart_dmarx_read(current_node->huart, data_buf, sizeof(data_buf));
+    uint16_t crc_recv = (uint16_t)(frame[len - 2] << 8) | frame[len - 1];
+    if (crc16_calc(frame, len - 2) != crc_recv) {
+        return MSG_DATA_VERIFY_ERROR;
+    }
 
-    current_node = current_node->next;
+    message_dispatch_frame(frame + 2);
+    return frame[3];
+}
+
+/**
+ * @brief 向解析器送入一个字节, 收完一帧时调用相应的回调函数
+ *
+ * @param parser 解析器
+ * @param byte 收到的字节
+ * @return 长度或者状态标记
+ *  @retval `0-MSG_NO_DATA` - 帧未收完
+ *  @retval `255-MSG_DATA_OVER` - 帧过长, 已丢弃
+ *  @retval `253-MSG_DATA_VERIFY_ERROR` - 格式或CRC校验错误
+ *  @retval 1~250 - 收完一帧, 返回数据长度
+ * @note 每个字节只处理一次, 遇到0x00即结束当前帧, 不需要回溯
+ */
+static uint8_t message_parse_byte(msg_parser_t *parser, uint8_t byte) {
+    if (byte == 0x00) {
+        /* 分隔符, 无论当前状态如何都从下一个字节开始新的一帧 */
+        uint8_t res = (parser->state == MSG_PARSE_COBS)
+                          ? message_parse_cobs_end(parser)
+                          : MSG_NO_DATA;
+        parser->state = MSG_PARSE_COBS;
+        parser->index = 0;
+        parser->code = 0;
+        parser->zero_pending = false;
+        return res;
+    }
 
-    /* 无数据 */
-    if (data_len == 0) {
+    if (parser->state == MSG_PARSE_DISCARD) {
         return MSG_NO_DATA;
     }
 
-    uint8_t msg_len = *(data_buf + 1);
+    if (parser->code == 0) {
+        /* 编码字节, 上一块不是满块时先补上被替换掉的0x00 */
+        if (parser->zero_pending) {
+            if (parser->index >= MSG_PARSE_FRAME_SIZE) {
+                parser->state = MSG_PARSE_DISCARD;
+                return MSG_DATA_OVER;
+            }
+            parser->frame[parser->index++] = 0x00;
+        }
+        parser->code = byte - 1;
+        parser->zero_pending = (byte != 0xFF);
+        return MSG_NO_DATA;
+    }
 
-    /* 数据长度超过最大长度, 为避免异常内存操作, 直接返回 */
-    if (msg_len > MSG_MAX_DATA_LENGTH) {
+    if (parser->index >= MSG_PARSE_FRAME_SIZE) {
+        parser->state = MSG_PARSE_DISCARD;
         return MSG_DATA_OVER;
     }
+    parser->frame[parser->index++] = byte;
+    --parser->code;
 
-    /* 数据帧中定义的长度与实际接收到的长度不一致 */
-    if (data_len != (msg_len + 3)) {
-        return MSG_DATA_LENGTH_ERROR;
+    return MSG_NO_DATA;
+}
+
+#else /* MSG_FRAME_VERSION */
+
+/**
+ * @brief 向解析器送入一个字节, 收完一帧时调用相应的回调函数
+ *
+ * @param parser 解析器
+ * @param byte 收到的字节
+ * @return 长度或者状态标记
+ *  @retval `0-MSG_NO_DATA` - 帧未收完, 或正在重新同步
+ *  @retval `255-MSG_DATA_OVER` - 长度溢出
+ *  @retval `253-MSG_DATA_VERIFY_ERROR` - 校验错误, 末尾没有收到0xFF
+ *  @retval 1~250 - 收完一帧, 返回数据长度
+ */
+static uint8_t message_parse_byte(msg_parser_t *parser, uint8_t byte) {
+    switch (parser->state) {
+        case MSG_PARSE_HEAD: {
+            if (!message_head_valid(byte)) {
+                /* 消息下标越界, 丢弃到下一个帧尾 */
+                parser->state = (byte == 0xFF) ? MSG_PARSE_HEAD
+                                               : MSG_PARSE_RESYNC;
+                return MSG_NO_DATA;
+            }
+            parser->frame[0] = byte;
+            parser->state = MSG_PARSE_LENGTH;
+        } break;
+
+        case MSG_PARSE_LENGTH: {
+            if ((byte == 0) || (byte > MSG_MAX_DATA_LENGTH)) {
+                /* 数据长度超过最大长度, 为避免异常内存操作, 丢弃这一帧 */
+                parser->state = (byte == 0xFF) ? MSG_PARSE_HEAD
+                                               : MSG_PARSE_RESYNC;
+                return MSG_DATA_OVER;
+            }
+            parser->frame[1] = byte;
+            parser->index = 2;
+            parser->state = MSG_PARSE_DATA;
+        } break;
+
+        case MSG_PARSE_DATA: {
+            parser->frame[parser->index++] = byte;
+            if (parser->index == parser->frame[1] + 2) {
+                parser->state = MSG_PARSE_TAIL;
+            }
+        } break;
+
+        case MSG_PARSE_TAIL: {
+            if (byte != 0xFF) {
+                /* 校验字节错误, 最后一位不是0xFF */
+                parser->state = MSG_PARSE_RESYNC;
+                return MSG_DATA_VERIFY_ERROR;
+            }
+            parser->state = MSG_PARSE_HEAD;
+            message_dispatch_frame(parser->frame);
+            return parser->frame[1];
+        }
+
+        default: { /* MSG_PARSE_RESYNC */
+            if (byte == 0xFF) {
+                parser->state = MSG_PARSE_HEAD;
+            }
+        } break;
     }
 
-    /* 校验字节错误, 最后一位不是0xFF */
-    if (*(data_buf + msg_len + 2) != 0xFF) {
-        return MSG_DATA_VERIFY_ERROR;
+    return MSG_NO_DATA;
+}
+
+#endif /* MSG_FRAME_VERSION */
+
+/**
+ * @brief 获取解析器中收完的一帧, 格式为| 含义/类型 | 长度 | 数据 |
+ *
+ * @param parser 解析器
+ * @return 帧缓冲区
+ */
+static inline uint8_t *message_parser_frame(msg_parser_t *parser) {
+#if (MSG_FRAME_VERSION == 3)
+    /* 跳过版本与序号 */
+    return parser->frame + 2;
+#else  /* MSG_FRAME_VERSION == 3 */
+    return parser->frame;
+#endif /* MSG_FRAME_VERSION == 3 */
+}
+
+#if (MSG_BAUD_ENABLE == 1)
+
+#define MSG_BAUD_PROPOSE   0x00U /* 提议, 波特率为提议的速率 */
+#define MSG_BAUD_ACCEPT    0x01U /* 接受, 双方准备切换 */
+#define MSG_BAUD_REJECT    0x02U /* 拒绝, 波特率为本端能接受的最高速率 */
+#define MSG_BAUD_PROBE     0x03U /* 探测, 带测试图样 */
+#define MSG_BAUD_PROBE_ACK 0x04U /* 探测回复 */
+#define MSG_BAUD_FALLBACK  0x05U /* 回到基础速率 */
+
+/* 协商的候选波特率, 从高到低, 与主控板一致 */
+static const uint32_t msg_baud_rates[] = {
+    4500000, 3000000, 2250000, 1500000, 921600, 460800, 230400,
+    MSG_BAUD_BASE_RATE};
+
+#define MSG_BAUD_RATE_NUM (sizeof(msg_baud_rates) / sizeof(msg_baud_rates[0]))
+
+/**
+ * @brief 查找轮询节点
+ *
+ * @param huart 串口句柄
+ * @return 轮询节点, 没有时返回`NULL`
+ */
+static polling_list_node_t *message_polling_find(UART_HandleTypeDef *huart) {
+    polling_list_node_t *node = p_polling_list_head;
+    while ((node != NULL) && (node->huart != huart)) {
+        node = node->next;
+    }
+
+    return node;
+}
+
+/**
+ * @brief 串口是否因为切换波特率暂停发送
+ *
+ * @param huart 串口句柄
+ * @return 是否暂停
+ */
+static bool message_baud_paused(UART_HandleTypeDef *huart) {
+    polling_list_node_t *node = message_polling_find(huart);
+
+    return (node != NULL) && (node->baud.enabled) &&
+           (node->baud.state != MSG_BAUD_IDLE);
+}
+
+/**
+ * @brief 恢复发送, 发出暂停期间保留的帧
+ *
+ * @param node 轮询节点
+ */
+static void message_baud_resume(polling_list_node_t *node) {
+    node->baud.state = MSG_BAUD_IDLE;
+
+    for (uint32_t i = 0; i < MSG_MEAN_LENGTH_RESERVE; ++i) {
+        if ((msg_held_len[i] != 0) && (p_send_handle[i] == node->huart)) {
+            message_send_frame(node->huart, msg_held_frame[i],
+                               msg_held_len[i]);
+            msg_held_len[i] = 0;
+        }
+    }
+}
+
+/**
+ * @brief 发送一帧协商帧, 不受暂停影响
+ *
+ * @param node 轮询节点
+ * @param op 操作码
+ * @param baud_rate 波特率
+ */
+static void message_baud_send(polling_list_node_t *node, uint8_t op,
+                              uint32_t baud_rate) {
+    uint8_t data[4] = {(uint8_t)baud_rate, (uint8_t)(baud_rate >> 8),
+                       (uint8_t)(baud_rate >> 16), (uint8_t)(baud_rate >> 24)};
+    uint8_t data_buf[sizeof(data) + MSG_FRAME_OVERHEAD];
+
+    message_fill_frame(data_buf, MSG_BAUD_MEAN, (message_type_t)op, data,
+                       sizeof(data));
+    message_send_frame(node->huart, data_buf, sizeof(data_buf));
+}
+
+/**
+ * @brief 查找本端支持的最高候选波特率
+ *
+ * @param node 轮询节点
+ * @param limit 不超过的波特率
+ * @return 不超过`limit`与上限, 且串口时钟能准确分频的最高候选波特率
+ */
+static uint32_t message_baud_best(polling_list_node_t *node, uint32_t limit) {
+    for (uint32_t i = 0; i < MSG_BAUD_RATE_NUM; ++i) {
+        if ((msg_baud_rates[i] <= limit) &&
+            (msg_baud_rates[i] <= node->baud.max) &&
+            (uart_check_baud_rate(node->huart, msg_baud_rates[i]) ==
+             UART_BAUD_OK)) {
+            return msg_baud_rates[i];
+        }
+    }
+
+    return MSG_BAUD_BASE_RATE;
+}
+
+/**
+ * @brief 暂停发送, 等发送完成后切换波特率
+ *
+ * @param node 轮询节点
+ * @param baud_rate 切换到的波特率
+ * @param now 当前时刻
+ */
+static void message_baud_switch(polling_list_node_t *node, uint32_t baud_rate,
+                                uint32_t now) {
+    node->baud.target = baud_rate;
+    node->baud.deadline = now + MSG_BAUD_TIMEOUT_MS;
+    node->baud.state = MSG_BAUD_SWITCHING;
+}
+
+/**
+ * @brief 开启串口的波特率协商, 本端作为应答方
+ *
+ * @param huart 串口句柄, 需要先以`MSG_BAUD_BASE_RATE`初始化并添加到轮询链表
+ * @param max_baud_rate 本端允许的最高波特率
+ * @return 是否开启成功, 该串口不在轮询链表中时返回`false`
+ */
+bool message_baud_enable(UART_HandleTypeDef *huart, uint32_t max_baud_rate) {
+    polling_list_node_t *node = message_polling_find(huart);
+    if ((huart == NULL) || (node == NULL)) {
+        return false;
+    }
+
+    memset(&node->baud, 0, sizeof(msg_baud_t));
+    node->baud.max = max_baud_rate;
+    node->baud.last_rx = HAL_GetTick();
+    node->baud.enabled = true;
+    return true;
+}
+
+/**
+ * @brief 处理一帧协商帧
+ *
+ * @param node 收到该帧的轮询节点
+ * @param[in] frame 帧缓冲区
+ */
+static void message_baud_receive(polling_list_node_t *node,
+                                 const uint8_t *frame) {
+    msg_baud_t *baud = &node->baud;
+
+    if ((!baud->enabled) || (frame[1] < 4)) {
+        return;
     }
 
-    if ((data_buf[0] >> 4) >= MSG_MEAN_LENGTH_RESERVE) {
-        /* 消息下标越界 */
-        return 0;
+    uint8_t op = frame[0] & 0x0F;
+    const uint8_t *data = frame + 2;
+    uint32_t rate = (uint32_t)data[0] | ((uint32_t)data[1] << 8) |
+                    ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+    uint32_t now = HAL_GetTick();
+
+    baud->last_rx = now;
+
+    switch (op) {
+        case MSG_BAUD_PROPOSE: {
+            if ((baud->state != MSG_BAUD_IDLE) ||
+                (rate <= MSG_BAUD_BASE_RATE)) {
+                break;
+            }
+
+            uint32_t best = message_baud_best(node, rate);
+            if (best != rate) {
+                message_baud_send(node, MSG_BAUD_REJECT, best);
+                break;
+            }
+
+            /* 接受帧发完后才会切换 */
+            message_baud_send(node, MSG_BAUD_ACCEPT, rate);
+            message_baud_switch(node, rate, now);
+        } break;
+
+        case MSG_BAUD_PROBE: {
+            if (baud->state == MSG_BAUD_PROBING) {
+                /* 主控板已经在新速率下发送, 可以恢复发送了 */
+                baud->checked = baud->errors;
+                baud->last_check = now;
+                message_baud_resume(node);
+            }
+            if (baud->state == MSG_BAUD_IDLE) {
+                message_baud_send(node, MSG_BAUD_PROBE_ACK,
+                                  node->huart->Init.BaudRate);
+            }
+        } break;
+
+        case MSG_BAUD_FALLBACK: {
+            if ((node->huart->Init.BaudRate != MSG_BAUD_BASE_RATE) ||
+                (baud->state != MSG_BAUD_IDLE)) {
+                message_baud_switch(node, MSG_BAUD_BASE_RATE, now);
+            }
+        } break;
+
+        default: {
+        } break;
     }
+}
 
-    p_receive_callback[(data_buf[0] >> 4)](msg_len, data_buf[0] & 0x0F,
-                                           data_buf + 2);
+/**
+ * @brief 波特率协商的超时处理, 每次轮询时调用
+ *
+ * @param node 轮询节点
+ */
+static void message_baud_poll(polling_list_node_t *node) {
+    msg_baud_t *baud = &node->baud;
 
-    return (uint8_t)msg_len; /* 返回消息长度 */
+    if (!baud->enabled) {
+        return;
+    }
+
+    uint32_t now = HAL_GetTick();
+
+    switch (baud->state) {
+        case MSG_BAUD_SWITCHING: {
+            uint8_t res = uart_set_baud_rate(node->huart, baud->target);
+            if ((res == UART_BAUD_BUSY) &&
+                ((int32_t)(now - baud->deadline) < 0)) {
+                break;
+            }
+
+            if ((res != UART_BAUD_OK) ||
+                (baud->target == MSG_BAUD_BASE_RATE)) {
+                /* 切换失败时主控板收不到探测回复, 会超时回退 */
+                message_baud_resume(node);
+                break;
+            }
+
+            /* 收到第一个探测帧时主控板一定已经切换, 在那之前保持暂停 */
+            baud->deadline = now + MSG_BAUD_LINK_TIMEOUT_MS;
+            baud->state = MSG_BAUD_PROBING;
+        } break;
+
+        case MSG_BAUD_PROBING: {
+            if ((int32_t)(now - baud->deadline) >= 0) {
+                message_baud_send(node, MSG_BAUD_FALLBACK, MSG_BAUD_BASE_RATE);
+                message_baud_switch(node, MSG_BAUD_BASE_RATE, now);
+            }
+        } break;
+
+        default: { /* MSG_BAUD_IDLE */
+            if (node->huart->Init.BaudRate == MSG_BAUD_BASE_RATE) {
+                break;
+            }
+
+            if ((now - baud->last_rx >= MSG_BAUD_LINK_TIMEOUT_MS) ||
+                ((now - baud->last_check >= MSG_BAUD_KEEPALIVE_MS) &&
+                 (baud->errors - baud->checked > MSG_BAUD_ERROR_LIMIT))) {
+                /* 主控板失联或误码突增, 回到基础速率 */
+                message_baud_send(node, MSG_BAUD_FALLBACK, MSG_BAUD_BASE_RATE);
+                message_baud_switch(node, MSG_BAUD_BASE_RATE, now);
+                break;
+            }
+
+            if (now - baud->last_check >= MSG_BAUD_KEEPALIVE_MS) {
+                baud->checked = baud->errors;
+                baud->last_check = now;
+            }
+        } break;
+    }
+}
+
+#endif /* MSG_BAUD_ENABLE == 1 */
+
+/**
+ * @brief 轮询数据, 并调用相应的函数
+ *
+ * @return 长度或者状态标记
+ *  @retval `0-MSG_NO_DATA` - 没有收到完整的帧, 或者没有接收的串口句柄
+ *  @retval `255-MSG_DATA_OVER` - 长度溢出
+ *  @retval `253-MSG_DATA_VERIFY_ERROR` - 校验错误, 末尾没有收到0xFF
+ *  @retval 1~250 - 本次收到的最后一帧的数据长度
+ * @note 事先在message_mean_t定义数据类型, 并注册相应的回调函数.
+ *       这个函数挂在一个while循环或者定时器中一直轮询就可以,
+ *       不要改动这个函数的任何内容
+ * @note 接收按字节流解析, 一次DMA空闲中断收到的多帧会全部处理, 被拆成多次
+ *       接收的帧会保留到下次调用继续拼接; 出错后丢弃数据直到下一个0xFF
+ * @note 波特率协商帧与超时也在这里处理
+ */
+uint8_t message_polling_data(void) {
+    /* 轮询链表的指针 */
+    static polling_list_node_t *current_node = NULL;
+
+    if (current_node == NULL) {
+        current_node = p_polling_list_head;
+        if (current_node == NULL) {
+            return MSG_NO_DATA;
+        }
+    }
+
+    polling_list_node_t *node = current_node;
+    current_node = current_node->next;
+
+    /* 数据数组 */
+    uint8_t data_buf[MSG_POLLING_READ_SIZE];
+    uint32_t data_len;
+    uint8_t res = MSG_NO_DATA;
+
+    do {
+        data_len = uart_dmarx_read(node->huart, data_buf, sizeof(data_buf));
+
+        for (uint32_t i = 0; i < data_len; ++i) {
+            uint8_t parse_res = message_parse_byte(&node->parser, data_buf[i]);
+            if (parse_res != MSG_NO_DATA) {
+                res = parse_res;
+            }
+
+#if (MSG_BAUD_ENABLE == 1)
+            if ((parse_res == MSG_DATA_OVER) ||
+                (parse_res == MSG_DATA_VERIFY_ERROR)) {
+                ++node->baud.errors;
+            } else if (parse_res != MSG_NO_DATA) {
+                uint8_t *frame = message_parser_frame(&node->parser);
+                if ((frame[0] >> 4) == MSG_BAUD_MEAN) {
+                    message_baud_receive(node, frame);
+                }
+            }
+#endif /* MSG_BAUD_ENABLE == 1 */
+        }
+    } while (data_len == sizeof(data_buf));
+
+#if (MSG_BAUD_ENABLE == 1)
+    message_baud_poll(node);
+#endif /* MSG_BAUD_ENABLE == 1 */
+
+    return res;
 }
@@ -8,18 +8,7 @@
 
 #include "includes.h"
 
-
-/**
- * @brief 遥控器下标数组下标
- */
-enum {
-    ARRAY_KEY = 0x00U,
-    ARRAY_LEFT_X,
-    ARRAY_LEFT_Y,
-    ARRAY_RIGHT_X,
-    ARRAY_RIGHT_Y,
-};
-
+#define REMOTE_SCAN_PERIOD_MS 1 /* 按键扫描周期 */
 
 /**
  * @brief The program entrance.
@@ -28,16 +17,58 @@ enum {
  */
 int main(void) {
     bsp_init();
-    uint8_t remote_data[5] = {0};
+    msg_remote_t remote_data = {0};
+    msg_remote_t last_sent = {0};
+    uint32_t last_send_tick = HAL_GetTick();
     message_register_send_handle(MSG_REMOTE, &usart1_handle);
+#if (MSG_BAUD_ENABLE == 1)
+    /* 应答主控板的波特率协商, 需要轮询接收 */
+    message_add_polling_handle(&usart1_handle);
+    message_baud_enable(&usart1_handle, 4500000);
+#endif /* MSG_BAUD_ENABLE == 1 */
+#if (MSG_REMOTE_TRACE == 1)
+    /* 开启DWT周期计数器, 测量按键到发送的耗时 */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif /* MSG_REMOTE_TRACE == 1 */
     while (1)
     {
         LED0_ON();
-        remote_data[0] = keyboard_scan();
+#if (MSG_BAUD_ENABLE == 1)
+        message_polling_data();
+#endif /* MSG_BAUD_ENABLE == 1 */
+#if (MSG_REMOTE_TRACE == 1)
+        uint32_t scan_cycles = DWT->CYCCNT;
+#endif /* MSG_REMOTE_TRACE == 1 */
+        remote_data.key = keyboard_scan();
         //uart_printf(&usart1_handle,"%d\n",remote_data);
-        message_send_data(MSG_REMOTE, MSG_DATA_UINT8, remote_data,
-                          MSG_GET_DATA_ARRAY_LENGTH(remote_data));
-        delay_ms(50);
+
+        /* 状态变化时立即发送, 不变时只按心跳周期发送 */
+        if ((remote_data.key == last_sent.key) &&
+            (remote_data.left_x == last_sent.left_x) &&
+            (remote_data.left_y == last_sent.left_y) &&
+            (remote_data.right_x == last_sent.right_x) &&
+            (remote_data.right_y == last_sent.right_y) &&
+            (HAL_GetTick() - last_send_tick < MSG_REMOTE_HEARTBEAT_MS)) {
+            delay_ms(REMOTE_SCAN_PERIOD_MS);
+            continue;
+        }
+#if (MSG_REMOTE_TRACE == 1)
+        if (remote_data.key != last_sent.key) {
+            /* 按键变化从第一次扫描到按下(松开)算起, 包括消抖时间 */
+            scan_cycles = keyboard_change_cycles();
+        }
+        uint32_t scan_us =
+            (DWT->CYCCNT - scan_cycles) / (SystemCoreClock / 1000000U);
+        remote_data.trace_seq++;
+        remote_data.trace_us =
+            (scan_us > UINT16_MAX) ? UINT16_MAX : (uint16_t)scan_us;
+#endif /* MSG_REMOTE_TRACE == 1 */
+        msg_remote_send(&remote_data);
+        last_sent = remote_data;
+        last_send_tick = HAL_GetTick();
+        delay_ms(REMOTE_SCAN_PERIOD_MS);
     }
     
 }
\ No newline at end of file
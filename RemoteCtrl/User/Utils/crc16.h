@@ -0,0 +1,43 @@
+/**
+ * @file    crc16.h
+ * @author  Deadline039
+ * @brief   CRC-16/CCITT-FALSE 查表计算
+ * @version 1.0
+ * @date    2026-10-16
+ * @note    多项式0x1021, 初值0xFFFF, 不反转, 结果不异或.
+ *          STM32的CRC外设只支持CRC-32, 所以这里使用查表法.
+ */
+
+#ifndef __CRC16_H
+#define __CRC16_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CRC16_INIT 0xFFFFU /* CRC计算初值 */
+
+extern const uint16_t crc16_table[256];
+
+/**
+ * @brief 向CRC中累加一个字节
+ *
+ * @param crc 当前CRC值
+ * @param byte 要累加的字节
+ * @return 新的CRC值
+ */
+static inline uint16_t crc16_update_byte(uint16_t crc, uint8_t byte) {
+    return (uint16_t)(crc << 8) ^ crc16_table[(uint8_t)(crc >> 8) ^ byte];
+}
+
+uint16_t crc16_update(uint16_t crc, const void *data, size_t len);
+uint16_t crc16_calc(const void *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __CRC16_H */
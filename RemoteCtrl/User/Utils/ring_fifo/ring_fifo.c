@@ -29,6 +29,24 @@ static inline uint32_t pow2gt(uint32_t x) {
     return x + 1;
 }
 
+/**
+ * @brief    初始化控制块
+ * @param[in]    ring    控制块
+ * @param[in]    size    缓冲区长度, 2的幂次方
+ * @param[in]    type    fifo类型
+ */
+static void ring_fifo_setup(ring_fifo_t *ring, uint32_t size,
+                            enum ring_fifo_type type) {
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    ring->head_cache = ring->tail_cache = 0;
+    ring->size = size;
+    ring->mask = size - 1;
+    ring->type = type;
+    ring->policy = RF_POLICY_DROP_NEW;
+    atomic_init(&ring->dropped, 0);
+}
+
 ring_fifo_t *ring_fifo_init(void *buf, uint32_t size,
                             enum ring_fifo_type type) {
     ring_fifo_t *ring;
@@ -60,11 +78,25 @@ ring_fifo_t *ring_fifo_init(void *buf, uint32_t size,
         ring->buf = buf;
         ring->is_dynamic = 0;
     }
+    ring->is_static = 0;
 
-    ring->head = ring->tail = 0;
-    ring->size = size;
-    ring->mask = size - 1;
-    ring->type = type;
+    ring_fifo_setup(ring, size, type);
+
+    return ring;
+}
+
+ring_fifo_t *ring_fifo_init_static(ring_fifo_t *ring, void *buf, uint32_t size,
+                                   enum ring_fifo_type type) {
+    if ((NULL == ring) || (NULL == buf) || (0 == is_pow_of_2(size)) ||
+        (size > fifo_max_depth)) {
+        return NULL;
+    }
+
+    ring->buf = buf;
+    ring->is_dynamic = 0;
+    ring->is_static = 1;
+
+    ring_fifo_setup(ring, size, type);
 
     return ring;
 }
@@ -75,7 +107,131 @@ void ring_fifo_destroy(ring_fifo_t *ring) {
         ring->buf = NULL;
     }
 
-    free(ring);
+    if (0 == ring->is_static) {
+        free(ring);
+    }
+}
+
+/**
+ * @brief    生产者获取未使用空间, 缓存的消费者指针不够时才重新读取
+ * @param[in]    ring    环形缓冲区句柄
+ * @param[in]    tail    生产者指针
+ * @param[in]    need    需要的空间(byte)
+ * @retval   未使用空间(byte)
+ */
+static inline uint32_t ring_fifo_unused(ring_fifo_t *ring, uint32_t tail,
+                                        uint32_t need) {
+    uint32_t unused = ring->size - (tail - ring->head_cache);
+
+    if (unused < need) {
+        /* acquire: 消费者读完数据后才会发布head, 之后才能覆盖这段空间 */
+        ring->head_cache =
+            atomic_load_explicit(&ring->head, memory_order_acquire);
+        unused = ring->size - (tail - ring->head_cache);
+    }
+
+    return unused;
+}
+
+/**
+ * @brief    消费者获取可读取数据量, 缓存的生产者指针不够时才重新读取
+ * @param[in]    ring    环形缓冲区句柄
+ * @param[in]    head    消费者指针
+ * @param[in]    need    需要的数据量(byte)
+ * @retval   可读取数据量(byte)
+ */
+static inline uint32_t ring_fifo_used(ring_fifo_t *ring, uint32_t head,
+                                      uint32_t need) {
+    uint32_t used = ring->tail_cache - head;
+
+    /* 覆盖模式下head可能被生产者推到缓存的tail之后 */
+    if ((used < need) || (used > ring->size)) {
+        /* acquire: 生产者写完数据后才会发布tail */
+        ring->tail_cache =
+            atomic_load_explicit(&ring->tail, memory_order_acquire);
+        used = ring->tail_cache - head;
+    }
+
+    /* 生产者不检查空间直接发布(如DMA直接写入缓冲区)时会越过消费者,
+     * 未读的数据已被覆盖, 全部丢弃后从最新位置开始读 */
+    if ((used > ring->size) && (RF_POLICY_DROP_NEW == ring->policy)) {
+        atomic_fetch_add_explicit(&ring->dropped, used, memory_order_relaxed);
+        atomic_store_explicit(&ring->head, ring->tail_cache,
+                              memory_order_release);
+        used = 0;
+    }
+
+    return used;
+}
+
+/**
+ * @brief    读取帧模式下某一帧的帧长
+ * @param[in]    ring        环形缓冲区句柄
+ * @param[in]    pos         帧起始指针
+ * @param[out]   frame_off   帧长占用的字节数, 包括回绕时跳过的字节
+ * @retval   帧长(byte)
+ */
+static inline uint32_t ring_fifo_frame_len(ring_fifo_t *ring, uint32_t pos,
+                                           uint32_t *frame_off) {
+    uint8_t *hdr = ring->buf;
+    uint32_t rlen, skip;
+
+    if (RF_TYPE_FRAME_VARINT == ring->type) {
+        rlen = hdr[pos & ring->mask];
+        *frame_off = 1;
+        if (0 != (rlen & 0x80)) {
+            rlen = (rlen & 0x7F) | ((uint32_t)hdr[(pos + 1) & ring->mask] << 7);
+            *frame_off = 2;
+        }
+        return rlen;
+    }
+
+    *frame_off = sizeof(uint32_t);
+    skip = 0;
+    if (ring->size - (pos & ring->mask) < *frame_off) {
+        skip = ring->size - (pos & ring->mask);
+        /* 跳过尾部[1, frame_off - 1]字节 */
+        *frame_off += skip;
+    }
+
+    /* 帧长不一定4字节对齐, 用memcpy读取, 编译器会生成非对齐安全的访问 */
+    memcpy(&rlen, hdr + ((pos + skip) & ring->mask), sizeof(rlen));
+    return rlen;
+}
+
+/**
+ * @brief    覆盖模式下移动消费者指针, 丢弃最旧的数据直到空间足够
+ * @param[in]    ring    环形缓冲区句柄
+ * @param[in]    tail    生产者指针
+ * @param[in]    need    需要的空间(byte), 不超过缓冲区大小
+ * @note     帧模式按整帧丢弃. 与消费者用CAS竞争`head`, 谁先成功谁有效
+ */
+static void ring_fifo_evict(ring_fifo_t *ring, uint32_t tail, uint32_t need) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint32_t next, frame_off, dropped;
+
+    while (ring->size - (tail - head) < need) {
+        if (RF_TYPE_STREAM == ring->type) {
+            next = tail + need - ring->size;
+            dropped = next - head;
+        } else {
+            /* [head, tail)只有生产者会改写, 这里读到的帧长一定有效 */
+            next = head + ring_fifo_frame_len(ring, head, &frame_off);
+            next += frame_off;
+            dropped = 1;
+        }
+
+        /* 失败时head被更新为消费者刚发布的值, 重新计算 */
+        if (atomic_compare_exchange_weak_explicit(&ring->head, &head, next,
+                                                  memory_order_acq_rel,
+                                                  memory_order_acquire)) {
+            head = next;
+            atomic_fetch_add_explicit(&ring->dropped, dropped,
+                                      memory_order_relaxed);
+        }
+    }
+
+    ring->head_cache = head;
 }
 
 uint32_t ring_fifo_write(ring_fifo_t *ring, const void *buf, uint32_t len) {
@@ -83,32 +239,77 @@ uint32_t ring_fifo_write(ring_fifo_t *ring, const void *buf, uint32_t len) {
     uint32_t unused;
     uint32_t off, l;
     uint32_t frame_off, skip;
+    uint32_t overwrite = (RF_POLICY_OVERWRITE == ring->policy);
+    /* 只有生产者修改tail, 读自己的指针不需要同步 */
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint8_t *hdr = ring->buf;
 
-    unused = ring->size - (ring->tail - ring->head);
     switch (ring->type) {
+        case RF_TYPE_FRAME_VARINT:
+            frame_off = (len < 0x80) ? 1 : 2;
+            wlen = len;
+            /* 如果不能存下此帧，丢弃 */
+            if ((0 == len) || (len > RF_VARINT_MAX_FRAME) ||
+                (len + frame_off > ring->size)) {
+                goto drop_frame;
+            }
+            unused = ring_fifo_unused(ring, tail, len + frame_off);
+            if (len + frame_off > unused) {
+                if (0 == overwrite) {
+                    goto drop_frame;
+                }
+                ring_fifo_evict(ring, tail, len + frame_off);
+            }
+            /* 写入帧长, 低7位在前, 最高位表示后面还有一个字节 */
+            if (1 == frame_off) {
+                hdr[tail & ring->mask] = (uint8_t)len;
+            } else {
+                hdr[tail & ring->mask] = (uint8_t)(0x80 | (len & 0x7F));
+                hdr[(tail + 1) & ring->mask] = (uint8_t)(len >> 7);
+            }
+            break;
         case RF_TYPE_FRAME:
             frame_off = sizeof(uint32_t);
             skip = 0;
-            if (ring->size - (ring->tail & ring->mask) < frame_off) {
-                skip = ring->size - (ring->tail & ring->mask);
+            if (ring->size - (tail & ring->mask) < frame_off) {
+                skip = ring->size - (tail & ring->mask);
                 /* 跳过尾部[1, frame_off - 1]字节 */
                 frame_off += skip;
             }
+            wlen = len;
             /* 如果不能存下此帧，丢弃 */
-            if (len + frame_off > unused) {
-                return 0;
+            if ((0 == wlen) || (len + frame_off > ring->size)) {
+                goto drop_frame;
             }
-            wlen = len;
-            if (0 == wlen) {
-                return 0;
+            unused = ring_fifo_unused(ring, tail, len + frame_off);
+            if (len + frame_off > unused) {
+                if (0 == overwrite) {
+                    goto drop_frame;
+                }
+                ring_fifo_evict(ring, tail, len + frame_off);
             }
             /* 写入帧长 */
-            *(uint32_t *)((uint8_t *)ring->buf +
-                          ((ring->tail + skip) & ring->mask)) = wlen;
+            memcpy(hdr + ((tail + skip) & ring->mask), &wlen, sizeof(wlen));
             break;
         default: /* RF_TYPE_STREAM */
             frame_off = 0;
+            if ((0 != overwrite) && (len > ring->size)) {
+                /* 只保留最新的size字节 */
+                atomic_fetch_add_explicit(&ring->dropped, len - ring->size,
+                                          memory_order_relaxed);
+                buf = (const uint8_t *)buf + (len - ring->size);
+                len = ring->size;
+            }
+            unused = ring_fifo_unused(ring, tail, len);
+            if ((len > unused) && (0 != overwrite)) {
+                ring_fifo_evict(ring, tail, len);
+                unused = len;
+            }
             wlen = min(len, unused);
+            if (len != wlen) {
+                atomic_fetch_add_explicit(&ring->dropped, len - wlen,
+                                          memory_order_relaxed);
+            }
             if (0 == wlen) {
                 return 0;
             }
@@ -116,75 +317,178 @@ uint32_t ring_fifo_write(ring_fifo_t *ring, const void *buf, uint32_t len) {
     }
 
     /* 计算写入位置 */
-    off = (ring->tail + frame_off) & ring->mask;
+    off = (tail + frame_off) & ring->mask;
     l = min(wlen, ring->size - off);
     memcpy((uint8_t *)ring->buf + off, buf, l);
     memcpy(ring->buf, (uint8_t *)buf + l, wlen - l);
 
-    ring->tail += wlen + frame_off;
+    /* release: 数据与帧长写完后再发布 */
+    atomic_store_explicit(&ring->tail, tail + wlen + frame_off,
+                          memory_order_release);
 
     return wlen;
+
+drop_frame:
+    atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+    return 0;
 }
 
 uint32_t ring_fifo_read(ring_fifo_t *ring, void *buf, uint32_t len) {
     uint32_t rlen;
     uint32_t used;
     uint32_t off, l;
-    uint32_t frame_off, skip;
+    uint32_t frame_off;
+    uint32_t head;
+    uint32_t overwrite = (RF_POLICY_OVERWRITE == ring->policy);
+
+    /* 覆盖模式下生产者也会移动head, 复制完发现被覆盖就重读 */
+    for (;;) {
+        /* 只有消费者修改head时, 读自己的指针不需要同步 */
+        head = atomic_load_explicit(&ring->head, (0 != overwrite)
+                                                     ? memory_order_acquire
+                                                     : memory_order_relaxed);
+
+        switch (ring->type) {
+            case RF_TYPE_FRAME_VARINT:
+            case RF_TYPE_FRAME:
+                used = ring_fifo_used(ring, head, 1);
+                if (0 == used) {
+                    return 0;
+                }
+                /* 读取帧长, 生产者整帧发布, 有数据时帧长与数据都已写完 */
+                rlen = ring_fifo_frame_len(ring, head, &frame_off);
+                if ((frame_off > used) || (rlen > used - frame_off)) {
+                    /* 只有被覆盖时才会出现, 帧长已不可信 */
+                    continue;
+                }
+                /* 给定的缓冲区小于要读出的帧长 */
+                if (len < rlen) {
+                    if ((0 != overwrite) &&
+                        (head != atomic_load_explicit(&ring->head,
+                                                      memory_order_acquire))) {
+                        continue;
+                    }
+                    return 0;
+                }
+                break;
+            default: /* RF_TYPE_STREAM */
+                frame_off = 0;
+                used = ring_fifo_used(ring, head, len);
+                rlen = min(len, used);
+                if (0 == rlen) {
+                    return 0;
+                }
+                break;
+        }
 
-    used = ring->tail - ring->head;
-    switch (ring->type) {
-        case RF_TYPE_FRAME:
-            frame_off = sizeof(uint32_t);
-            skip = 0;
-            if (ring->size - (ring->head & ring->mask) < frame_off) {
-                skip = ring->size - (ring->head & ring->mask);
-                /* 跳过尾部[1, frame_off - 1]字节 */
-                frame_off += skip;
-            }
-            if (0 == used) {
-                return 0;
-            }
-            /* 读取帧长 */
-            rlen = *(uint32_t *)((uint8_t *)ring->buf +
-                                 ((ring->head + skip) & ring->mask));
-            /* 给定的缓冲区小于要读出的帧长 */
-            if (len < rlen) {
-                return 0;
-            }
-            break;
-        default: /* RF_TYPE_STREAM */
-            frame_off = 0;
-            rlen = min(len, used);
-            if (0 == rlen) {
-                return 0;
-            }
-            break;
+        /* 计算读取位置 */
+        off = (head + frame_off) & ring->mask;
+        l = min(rlen, ring->size - off);
+        memcpy(buf, (uint8_t *)ring->buf + off, l);
+        memcpy((uint8_t *)buf + l, ring->buf, rlen - l);
+
+        if (0 == overwrite) {
+            /* release: 数据读完后再归还空间 */
+            atomic_store_explicit(&ring->head, head + rlen + frame_off,
+                                  memory_order_release);
+            return rlen;
+        }
+
+        /* 复制期间head没有被生产者移动, 读到的数据就是完整的 */
+        if (atomic_compare_exchange_strong_explicit(
+                &ring->head, &head, head + rlen + frame_off,
+                memory_order_acq_rel, memory_order_relaxed)) {
+            return rlen;
+        }
     }
+}
 
-    /* 计算读取位置 */
-    off = (ring->head + frame_off) & ring->mask;
-    l = min(rlen, ring->size - off);
-    memcpy(buf, (uint8_t *)ring->buf + off, l);
-    memcpy((uint8_t *)buf + l, ring->buf, rlen - l);
+void ring_fifo_set_policy(ring_fifo_t *ring, enum ring_fifo_policy policy) {
+    ring->policy = policy;
+}
 
-    ring->head += rlen + frame_off;
+uint32_t ring_fifo_dropped(ring_fifo_t *ring) {
+    return atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+}
 
-    return rlen;
+/**
+ * @brief    把从指针开始的一段长度拆成两段连续内存
+ * @param[in]    ring    环形缓冲区句柄
+ * @param[in]    pos     起始指针
+ * @param[in]    len     总长度(byte)
+ * @param[out]   span    两段连续内存
+ */
+static inline void ring_fifo_split(ring_fifo_t *ring, uint32_t pos,
+                                   uint32_t len, ring_fifo_span_t span[2]) {
+    uint32_t off = pos & ring->mask;
+    uint32_t l = min(len, ring->size - off);
+
+    span[0].buf = (uint8_t *)ring->buf + off;
+    span[0].len = l;
+    span[1].buf = (uint8_t *)ring->buf;
+    span[1].len = len - l;
+}
+
+uint32_t ring_fifo_peek(ring_fifo_t *ring, ring_fifo_span_t span[2]) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t used = 0;
+
+    if ((RF_TYPE_STREAM == ring->type) &&
+        (RF_POLICY_DROP_NEW == ring->policy)) {
+        /* 总是重新读取生产者指针, 取得全部可读数据 */
+        used = ring_fifo_used(ring, head, ring->size + 1);
+    }
+    ring_fifo_split(ring, head, used, span);
+
+    return used;
+}
+
+void ring_fifo_consume(ring_fifo_t *ring, uint32_t len) {
+    if ((RF_TYPE_STREAM != ring->type) || (0 == len)) {
+        return;
+    }
+
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    atomic_store_explicit(&ring->head, head + len, memory_order_release);
+}
+
+uint32_t ring_fifo_reserve(ring_fifo_t *ring, ring_fifo_span_t span[2]) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t unused = 0;
+
+    if (RF_TYPE_STREAM == ring->type) {
+        /* 总是重新读取消费者指针, 取得全部空闲空间 */
+        unused = ring_fifo_unused(ring, tail, ring->size + 1);
+    }
+    ring_fifo_split(ring, tail, unused, span);
+
+    return unused;
+}
+
+void ring_fifo_commit(ring_fifo_t *ring, uint32_t len) {
+    if ((RF_TYPE_STREAM != ring->type) || (0 == len)) {
+        return;
+    }
+
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, tail + len, memory_order_release);
 }
 
 uint32_t ring_fifo_is_full(ring_fifo_t *ring) {
-    return ring->size == (ring->tail - ring->head);
+    return ring->size == ring_fifo_count(ring);
 }
 
 uint32_t ring_fifo_is_empty(ring_fifo_t *ring) {
-    return ring->tail == ring->head;
+    return 0 == ring_fifo_count(ring);
 }
 
 uint32_t ring_fifo_avail(ring_fifo_t *ring) {
-    return ring->size - (ring->tail - ring->head);
+    return ring->size - ring_fifo_count(ring);
 }
 
 uint32_t ring_fifo_count(ring_fifo_t *ring) {
-    return ring->tail - ring->head;
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    return tail - head;
 }
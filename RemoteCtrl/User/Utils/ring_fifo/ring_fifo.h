@@ -4,6 +4,17 @@
  * @brief   环形FIFO
  * @version 1.0
  * @date    2021-10-22
+ * @note    单生产者单消费者(SPSC)无锁:
+ *          同一时刻只能有一个上下文调用`ring_fifo_write`(例如DMA中断),
+ *          一个上下文调用`ring_fifo_read`(例如任务). 多个生产者或多个消费者
+ *          需要调用者自己加锁. 生产者发布`tail`使用release, 消费者读取`tail`
+ *          使用acquire, 保证读到的数据已经写完; `head`反之.
+ * @note     覆盖模式(`RF_POLICY_OVERWRITE`)下生产者会用CAS推进`head`丢弃
+ *           最旧的数据, 消费者复制完数据后也用CAS推进`head`, 失败说明这段
+ *           数据在复制期间被覆盖, 丢弃后重读. 因此`ring_fifo_read`总是返回
+ *           完整的帧(流模式为连续的字节), 不会返回被改写了一半的数据;
+ *           生产者不会被消费者阻塞, 消费者在生产者持续覆盖时可能重试多次.
+ *           覆盖模式下不能使用`ring_fifo_peek`.
  */
 
 #ifndef __RING_FIFO_H
@@ -13,29 +24,52 @@
 extern "C" {
 #endif
 
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdlib.h>
 
 /* ring type */
 enum ring_fifo_type {
-    RF_TYPE_FRAME,
-    RF_TYPE_STREAM
+    RF_TYPE_FRAME,       /* 帧模式, 每帧前存4字节帧长, 回绕时最多跳过3字节 */
+    RF_TYPE_STREAM,      /* 流模式 */
+    RF_TYPE_FRAME_VARINT /* 帧模式, 帧长按7位一组存1~2字节, 回绕时不跳过 */
 };
 
+/* 缓冲区满时的处理策略 */
+enum ring_fifo_policy {
+    RF_POLICY_DROP_NEW, /* 丢弃新写入的数据(默认) */
+    RF_POLICY_OVERWRITE /* 丢弃最旧的数据, 帧模式整帧丢弃 */
+};
+
+/* `RF_TYPE_FRAME_VARINT`单帧最大长度(byte) */
+#define RF_VARINT_MAX_FRAME 0x3FFF
+
 /* 环形缓冲区结构 */
 typedef struct {
-    volatile uint32_t head; /* 消费者指针 */
-    volatile uint32_t tail; /* 生产者指针 */
+    atomic_uint head; /* 消费者指针, 只有消费者写 */
+    atomic_uint tail; /* 生产者指针, 只有生产者写 */
+
+    uint32_t head_cache; /* 生产者缓存的消费者指针, 空间不足时才重新读取 */
+    uint32_t tail_cache; /* 消费者缓存的生产者指针, 数据不足时才重新读取 */
 
     uint32_t size; /* 缓冲区的大小 */
     uint32_t mask; /* 缓冲区的大小掩码 */
 
     void *buf;           /* 缓冲区指针 */
     uint32_t is_dynamic; /* 是否使用了动态内存 */
+    uint32_t is_static;  /* 控制块是否由调用者提供 */
 
-    enum ring_fifo_type type; /* fifo的类型 */
+    enum ring_fifo_type type;     /* fifo的类型 */
+    enum ring_fifo_policy policy; /* 缓冲区满时的处理策略 */
+    atomic_uint dropped;          /* 丢弃的帧数, 流模式为字节数 */
 } ring_fifo_t;
 
+/* 环形缓冲区中的一段连续内存 */
+typedef struct {
+    uint8_t *buf; /* 起始地址 */
+    uint32_t len; /* 长度(byte) */
+} ring_fifo_span_t;
+
 /**
  * @brief    初始化环形缓冲区
  * @param[in]    buf     缓冲区指针，如果为NULL，则默认使用堆内存进行分配
@@ -47,6 +81,20 @@ typedef struct {
  */
 ring_fifo_t *ring_fifo_init(void *buf, uint32_t size, enum ring_fifo_type type);
 
+/**
+ * @brief    使用调用者提供的控制块与缓冲区初始化环形缓冲区, 不使用堆内存
+ * @param[in]    ring    控制块, 可以是静态变量
+ * @param[in]    buf     缓冲区指针
+ * @param[in]    size    缓冲区长度, 必须为2的幂次方
+ * @param[in]    type    fifo类型
+ * @retval   执行结果
+ * -         NULL    ring或buf为NULL, 或size不为2的幂次方
+ * -         非NULL  初始化成功, 即ring
+ * @note     `ring_fifo_destroy`不会释放这里传入的控制块与缓冲区
+ */
+ring_fifo_t *ring_fifo_init_static(ring_fifo_t *ring, void *buf, uint32_t size,
+                                   enum ring_fifo_type type);
+
 /**
  * @brief    销毁环形缓冲区
  * @param[in]    ring    环形缓冲区句柄
@@ -60,6 +108,8 @@ void ring_fifo_destroy(ring_fifo_t *ring);
  * @param[in]    len     待写入数据长度(byte)
  * @retval   执行结果
  * -         成功写入的长度(byte)
+ * @note     帧模式下空间不足时整帧丢弃返回0,
+ *           `RF_TYPE_FRAME_VARINT`帧长超过`RF_VARINT_MAX_FRAME`也返回0
  */
 uint32_t ring_fifo_write(ring_fifo_t *ring, const void *buf, uint32_t len);
 
@@ -73,6 +123,62 @@ uint32_t ring_fifo_write(ring_fifo_t *ring, const void *buf, uint32_t len);
  */
 uint32_t ring_fifo_read(ring_fifo_t *ring, void *buf, uint32_t len);
 
+/**
+ * @brief    设置环形缓冲区满时的处理策略, 需要在开始读写前设置
+ * @param[in]    ring    环形缓冲区句柄
+ * @param[in]    policy  处理策略
+ */
+void ring_fifo_set_policy(ring_fifo_t *ring, enum ring_fifo_policy policy);
+
+/**
+ * @brief    获取丢弃计数
+ * @param[in]    ring    环形缓冲区句柄
+ * @retval   执行结果
+ * -         帧模式为丢弃的帧数, 流模式为丢弃的字节数,
+ *           包括空间不足丢弃的新数据与覆盖模式下丢弃的旧数据
+ */
+uint32_t ring_fifo_dropped(ring_fifo_t *ring);
+
+/**
+ * @brief    获取可读取的数据, 不复制也不移动消费者指针(仅流模式, 单消费者)
+ * @param[in]    ring    环形缓冲区句柄
+ * @param[out]   span    两段连续内存, 数据回绕时第二段从缓冲区起始开始,
+ *                       不回绕时第二段长度为0
+ * @retval   执行结果
+ * -         可读取的总长度(byte), 帧模式与覆盖模式返回0
+ * @note     处理完后调用`ring_fifo_consume`释放. 用`ring_fifo_write`或
+ *           `ring_fifo_reserve`写入的生产者在释放前不会覆盖这段数据,
+ *           不经`ring_fifo_reserve`直接写缓冲区再发布的生产者(如DMA直接写入)
+ *           不受消费者限制, 这段数据在处理时可能已被覆盖
+ */
+uint32_t ring_fifo_peek(ring_fifo_t *ring, ring_fifo_span_t span[2]);
+
+/**
+ * @brief    释放`ring_fifo_peek`取得的数据(仅流模式, 单消费者)
+ * @param[in]    ring    环形缓冲区句柄
+ * @param[in]    len     释放的长度(byte), 不能超过`ring_fifo_peek`的返回值
+ */
+void ring_fifo_consume(ring_fifo_t *ring, uint32_t len);
+
+/**
+ * @brief    获取可写入的空间, 由调用者直接写入(仅流模式, 单生产者)
+ * @param[in]    ring    环形缓冲区句柄
+ * @param[out]   span    两段连续内存, 空间回绕时第二段从缓冲区起始开始
+ * @retval   执行结果
+ * -         可写入的总长度(byte), 帧模式返回0
+ * @note     写完后调用`ring_fifo_commit`发布, 发布前消费者看不到这段数据
+ */
+uint32_t ring_fifo_reserve(ring_fifo_t *ring, ring_fifo_span_t span[2]);
+
+/**
+ * @brief    发布`ring_fifo_reserve`取得的空间中已写入的数据(仅流模式, 单生产者)
+ * @param[in]    ring    环形缓冲区句柄
+ * @param[in]    len     发布的长度(byte), 不能超过`ring_fifo_reserve`的返回值
+ * @note     DMA直接写入缓冲区时可以不调用`ring_fifo_reserve`直接发布,
+ *           此时越过消费者的数据由消费者整体丢弃并计入丢弃计数
+ */
+void ring_fifo_commit(ring_fifo_t *ring, uint32_t len);
+
 /**
  * @brief    环形缓冲区是否为满
  * @param[in]    ring    环形缓冲区句柄
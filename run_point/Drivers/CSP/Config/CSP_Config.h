@@ -98,7 +98,7 @@
 
 //   <o> USART1 Interrupt Priority <0-15>
 //   <i> The Interrupt Priority of USART1
-#define USART1_IT_PRIORITY        2
+#define USART1_IT_PRIORITY        5
 //   <o> USART1 Interrupt SubPriority <0-15>
 //   <i> The Interrupt SubPriority of USART1
 #define USART1_IT_SUB             3
@@ -133,7 +133,7 @@
 
 //     <o> DMA RX Interrupt Priority <0-15>
 //     <i>  The Interrupt Priority of DMA Rx
-#define USART1_RX_DMA_IT_PRIORITY 2
+#define USART1_RX_DMA_IT_PRIORITY 5
 
 //     <o> DMA RX Interrupt SubPriority <0-15>
 //     <i>  The Interrupt SubPriority of DMA Rx
@@ -280,7 +280,7 @@
 
 //   <o> USART2 Interrupt Priority <0-15>
 //   <i> The Interrupt Priority of USART2
-#define USART2_IT_PRIORITY        2
+#define USART2_IT_PRIORITY        5
 //   <o> USART2 Interrupt SubPriority <0-15>
 //   <i> The Interrupt SubPriority of USART2
 #define USART2_IT_SUB             3
@@ -315,7 +315,7 @@
 
 //     <o> DMA RX Interrupt Priority <0-15>
 //     <i>  The Interrupt Priority of DMA Rx
-#define USART2_RX_DMA_IT_PRIORITY 2
+#define USART2_RX_DMA_IT_PRIORITY 5
 
 //     <o> DMA RX Interrupt SubPriority <0-15>
 //     <i>  The Interrupt SubPriority of DMA Rx
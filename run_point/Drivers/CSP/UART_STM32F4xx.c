@@ -27,25 +27,82 @@ static char uart_buffer[256];
  * @brief Send buf of UART.
  */
 typedef struct {
-    uint8_t *send_buf; /*!< Send data buf.                                  */
-    uint32_t head_ptr; /*!< Pointer of send buf to control the length of DMA
-                            transfer.                                       */
-    size_t buf_size;   /*!< The size of buffer. Prevent overflow.           */
+    uint8_t *send_buf;          /*!< Send data buf, used as two halves.     */
+    uint32_t head_ptr;          /*!< Length of data in the filling half.    */
+    size_t buf_size;            /*!< The size of buffer. Prevent overflow.  */
+    uint32_t fill;              /*!< Index of the filling half, 0 or 1.     */
+    volatile uint32_t busy;     /*!< DMA is transmitting the other half.    */
+    volatile uint32_t pending;  /*!< Send is requested while DMA is busy.   */
+    volatile uint32_t reserved; /*!< The filling half is reserved to write
+                                     in place, do not switch it.            */
 } uart_tx_buf_t;
 
 /**
  * @brief Receive fifo of UART.
  */
 typedef struct {
-    ring_fifo_t *rx_fifo; /*!< Receive fifo.                 */
-    uint8_t *rx_fifo_buf; /*!< The storage area of fifo.     */
-    uint8_t *recv_buf;    /*!< Data buf of DMA to transfer.  */
-    uint32_t head_ptr;    /*!< Pointer of receive buf to
-                               control the DMA receive.      */
-    uint32_t buf_size;    /*!< Size of `recv_buf`.           */
-    uint32_t fifo_size;   /*!< Size of `rx_fifo_buf`.        */
+    ring_fifo_t *rx_fifo;   /*!< Receive fifo.                 */
+    ring_fifo_t rx_fifo_cb; /*!< Control block of `rx_fifo`.   */
+    uint8_t *rx_fifo_buf;   /*!< The storage area of fifo, not
+                                 used in direct mode.          */
+    uint8_t *recv_buf;      /*!< Data buf of DMA to transfer.  */
+    uint32_t head_ptr;      /*!< Pointer of receive buf to
+                                 control the DMA receive.      */
+    uint32_t buf_size;      /*!< Size of `recv_buf`.           */
+    uint32_t fifo_size;     /*!< Size of `rx_fifo_buf`.        */
+    uint32_t skip_pos;      /*!< Fifo index of the published
+                                 skipped bytes.                */
+    uint32_t skip_len;      /*!< Length of the published
+                                 skipped bytes, the reader
+                                 passes them, 0 if none.       */
 } uart_rx_fifo_t;
 
+/**
+ * @brief Pin of UART.
+ */
+typedef struct {
+    GPIO_TypeDef *port; /*!< GPIO port, NULL if the pin is not used. */
+    uint16_t pin;       /*!< GPIO pin.                               */
+    uint8_t af;         /*!< Alternate function.                     */
+} uart_pin_t;
+
+/**
+ * @brief Interrupt of UART or DMA.
+ */
+typedef struct {
+    IRQn_Type irqn;   /*!< Interrupt number.       */
+    uint8_t priority; /*!< Interrupt priority.     */
+    uint8_t sub;      /*!< Interrupt sub priority. */
+} uart_irq_t;
+
+/**
+ * @brief DMA of UART.
+ */
+typedef struct {
+    DMA_HandleTypeDef *hdma; /*!< DMA handle, NULL if DMA is not used. */
+    uart_irq_t irq;          /*!< Interrupt of DMA stream.             */
+} uart_dma_t;
+
+/**
+ * @brief Port descriptor of UART, everything `uart_port_init` needs.
+ */
+typedef struct {
+    UART_HandleTypeDef *huart;  /*!< The handle of UART.                */
+    uart_stats_t *stats;        /*!< Link statistics.                   */
+    volatile uint32_t *clk_enr; /*!< RCC clock enable register.         */
+    uint32_t clk_msk;           /*!< Clock enable bit in `clk_enr`.     */
+    uart_pin_t tx;              /*!< TX pin.                            */
+    uart_pin_t rx;              /*!< RX pin.                            */
+    uart_pin_t cts;             /*!< CTS pin.                           */
+    uart_pin_t rts;             /*!< RTS pin.                           */
+    uart_irq_t it;              /*!< Interrupt of UART.                 */
+    uint8_t it_enable;          /*!< Enable the interrupt of UART.      */
+    uart_dma_t rx_dma;          /*!< DMA Rx.                            */
+    uart_dma_t tx_dma;          /*!< DMA Tx.                            */
+    uart_rx_fifo_t *rx_fifo;    /*!< Receive fifo, NULL without DMA Rx. */
+    uart_tx_buf_t *tx_buf;      /*!< Send buf, NULL without DMA Tx.     */
+} uart_port_t;
+
 /**
  * @}
  */
@@ -55,9 +112,20 @@ typedef struct {
  * @{
  */
 
+static uint8_t uart_port_init(const uart_port_t *port, uint32_t baud_rate);
+static uint8_t uart_port_deinit(const uart_port_t *port);
+static uint8_t uart_dmarx_fifo_init(uart_rx_fifo_t *uart_rx_fifo);
+static inline void uart_dmarx_push(const uart_port_t *port,
+                                   const uint8_t *data, uint32_t len);
+static void uart_dmarx_realign(uart_rx_fifo_t *uart_rx_fifo, uint32_t size);
+static uint32_t uart_dmarx_flush(UART_HandleTypeDef *huart);
 static void uart_dmarx_halfdone_callback(UART_HandleTypeDef *huart);
 static void uart_dmarx_done_callback(UART_HandleTypeDef *huart);
 void uart_dmarx_idle_callback(UART_HandleTypeDef *huart);
+static void uart_dmatx_reset(UART_HandleTypeDef *huart);
+static void uart_dmatx_done_callback(UART_HandleTypeDef *huart);
+static void uart_dmatx_error_callback(UART_HandleTypeDef *huart);
+static void uart_dmatx_resume(UART_HandleTypeDef *huart);
 
 /**
  * @}
@@ -110,137 +178,57 @@ static uart_tx_buf_t usart1_tx_buf = {.buf_size = USART1_TX_DMA_BUF_SIZE};
 
 #endif /* USART1_TX_DMA */
 
-/**
- * @brief USART1 initialization
- *
- * @param baud_rate Baud rate.
- * @return USART1 init status.
- * @retval - 0: `UART_INIT_OK`:       Success.
- * @retval - 1: `UART_INIT_FAIL`:     UART init failed.
- * @retval - 2: `UART_INIT_DMA_FAIL`: UART DMA init failed.
- * @retval - 3: `UART_INIT_MEM_FAIL`: UART buffer memory init failed (It will
- *                                    dynamic allocate memory when using DMA).
- * @retval - 4: `UART_INITED`:        This uart is inited.
- */
-uint8_t usart1_init(uint32_t baud_rate) {
-    if (HAL_UART_GetState(&usart1_handle) != RESET) {
-        return UART_INITED;
-    }
+static uart_stats_t usart1_stats;
 
-    GPIO_InitTypeDef gpio_init_struct = {.Pull = GPIO_PULLUP,
-                                         .Speed = GPIO_SPEED_FREQ_HIGH,
-                                         .Mode = GPIO_MODE_AF_PP};
-    usart1_handle.Init.BaudRate = baud_rate;
+static const uart_port_t usart1_port = {
+    .huart = &usart1_handle,
+    .stats = &usart1_stats,
+    .clk_enr = &RCC->APB2ENR,
+    .clk_msk = RCC_APB2ENR_USART1EN,
 #if USART1_TX
-    usart1_handle.Init.Mode |= UART_MODE_TX;
-
-    CSP_GPIO_CLK_ENABLE(USART1_TX_PORT);
-    gpio_init_struct.Pin = USART1_TX_PIN;
-    gpio_init_struct.Alternate = USART1_TX_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(USART1_TX_PORT), &gpio_init_struct);
+    .tx = {CSP_GPIO_PORT(USART1_TX_PORT), USART1_TX_PIN, USART1_TX_AF},
 #endif /* USART1_TX */
-
 #if USART1_RX
-    usart1_handle.Init.Mode |= UART_MODE_RX;
-
-    CSP_GPIO_CLK_ENABLE(USART1_RX_PORT);
-    gpio_init_struct.Pin = USART1_RX_PIN;
-    gpio_init_struct.Alternate = USART1_RX_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(USART1_RX_PORT), &gpio_init_struct);
+    .rx = {CSP_GPIO_PORT(USART1_RX_PORT), USART1_RX_PIN, USART1_RX_AF},
 #endif /* USART1_RX */
-
 #if USART1_CTS
-    usart1_handle.Init.HwFlowCtl |= UART_HWCONTROL_CTS;
-
-    CSP_GPIO_CLK_ENABLE(USART1_CTS_PORT);
-    gpio_init_struct.Pin = USART1_CTS_PIN;
-    gpio_init_struct.Alternate = USART1_CTS_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(USART1_CTS_PORT), &gpio_init_struct);
-#endif /* USART1_USART1_CTS */
-
+    .cts = {CSP_GPIO_PORT(USART1_CTS_PORT), USART1_CTS_PIN, USART1_CTS_AF},
+#endif /* USART1_CTS */
 #if USART1_RTS
-    usart1_handle.Init.HwFlowCtl |= UART_HWCONTROL_RTS;
-
-    CSP_GPIO_CLK_ENABLE(USART1_RTS_PORT);
-    gpio_init_struct.Pin = USART1_RTS_PIN;
-    gpio_init_struct.Alternate = USART1_RTS_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(USART1_RTS_PORT), &gpio_init_struct);
+    .rts = {CSP_GPIO_PORT(USART1_RTS_PORT), USART1_RTS_PIN, USART1_RTS_AF},
 #endif /* USART1_RTS */
-
-    __HAL_RCC_USART1_CLK_ENABLE();
 #if USART1_IT_ENABLE
-    HAL_NVIC_EnableIRQ(USART1_IRQn);
-    HAL_NVIC_SetPriority(USART1_IRQn, USART1_IT_PRIORITY, USART1_IT_SUB);
+    .it = {USART1_IRQn, USART1_IT_PRIORITY, USART1_IT_SUB},
+    .it_enable = 1,
 #endif /* USART1_IT_ENABLE */
-
 #if USART1_RX_DMA
-    usart1_rx_fifo.head_ptr = 0;
-
-    usart1_rx_fifo.recv_buf = CSP_MALLOC(usart1_rx_fifo.buf_size);
-    if (usart1_rx_fifo.recv_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    usart1_rx_fifo.rx_fifo_buf = CSP_MALLOC(usart1_rx_fifo.fifo_size);
-    if (usart1_rx_fifo.rx_fifo_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    usart1_rx_fifo.rx_fifo = ring_fifo_init(
-        usart1_rx_fifo.rx_fifo_buf, usart1_rx_fifo.fifo_size, RF_TYPE_STREAM);
-    if (usart1_rx_fifo.rx_fifo == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    CSP_DMA_CLK_ENABLE(USART1_RX_DMA_NUMBER);
-    if (HAL_DMA_Init(&usart1_dmarx_handle) != HAL_OK) {
-        return UART_INIT_DMA_FAIL;
-    }
-
-    __HAL_LINKDMA(&usart1_handle, hdmarx, usart1_dmarx_handle);
-
-    HAL_NVIC_SetPriority(USART1_RX_DMA_IRQn, USART1_RX_DMA_IT_PRIORITY, USART1_RX_DMA_IT_SUB);
-    HAL_NVIC_EnableIRQ(USART1_RX_DMA_IRQn);
-
+    .rx_dma = {&usart1_dmarx_handle,
+               {USART1_RX_DMA_IRQn, USART1_RX_DMA_IT_PRIORITY,
+                USART1_RX_DMA_IT_SUB}},
+    .rx_fifo = &usart1_rx_fifo,
 #endif /* USART1_RX_DMA */
-
 #if USART1_TX_DMA
-    usart1_tx_buf.send_buf = CSP_MALLOC(usart1_tx_buf.buf_size);
-    if (usart1_tx_buf.send_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    CSP_DMA_CLK_ENABLE(USART1_TX_DMA_NUMBER);
-    if (HAL_DMA_Init(&usart1_dmatx_handle) != HAL_OK) {
-        return UART_INIT_DMA_FAIL;
-    }
-
-    __HAL_LINKDMA(&usart1_handle, hdmatx, usart1_dmatx_handle);
-
-    HAL_NVIC_SetPriority(USART1_TX_DMA_IRQn, USART1_TX_DMA_IT_PRIORITY, USART1_TX_DMA_IT_SUB);
-    HAL_NVIC_EnableIRQ(USART1_TX_DMA_IRQn);
-
+    .tx_dma = {&usart1_dmatx_handle,
+               {USART1_TX_DMA_IRQn, USART1_TX_DMA_IT_PRIORITY,
+                USART1_TX_DMA_IT_SUB}},
+    .tx_buf = &usart1_tx_buf,
 #endif /* USART1_TX_DMA */
+};
 
-    if (HAL_UART_Init(&usart1_handle) != HAL_OK) {
-        return UART_INIT_FAIL;
-    }
-    
-#if USART1_RX_DMA
-    __HAL_UART_ENABLE_IT(&usart1_handle, UART_IT_IDLE);
-    __HAL_UART_CLEAR_IDLEFLAG(&usart1_handle);
-
-    HAL_UART_Receive_DMA(&usart1_handle, usart1_rx_fifo.recv_buf,
-                         usart1_rx_fifo.buf_size);
-
-#if USE_HAL_UART_REGISTER_CALLBACKS
-    HAL_UART_RegisterCallback(&usart1_handle, HAL_UART_RX_HALFCOMPLETE_CB_ID,
-                              uart_dmarx_halfdone_callback);
-    HAL_UART_RegisterCallback(&usart1_handle, HAL_UART_RX_COMPLETE_CB_ID,
-                              uart_dmarx_done_callback);
-#endif /* USE_HAL_UART_REGISTER_CALLBACKS */
-#endif /* USART1_RX_DMA */
-    return UART_INIT_OK;
+/**
+ * @brief USART1 initialization
+ *
+ * @param baud_rate Baud rate.
+ * @return USART1 init status.
+ * @retval - 0: `UART_INIT_OK`:       Success.
+ * @retval - 1: `UART_INIT_FAIL`:     UART init failed.
+ * @retval - 2: `UART_INIT_DMA_FAIL`: UART DMA init failed.
+ * @retval - 3: `UART_INIT_MEM_FAIL`: UART buffer memory init failed (It will
+ *                                    dynamic allocate memory when using DMA).
+ * @retval - 4: `UART_INITED`:        This uart is inited.
+ */
+uint8_t usart1_init(uint32_t baud_rate) {
+    return uart_port_init(&usart1_port, baud_rate);
 }
 
 #if USART1_IT_ENABLE
@@ -294,71 +282,7 @@ void USART1_TX_DMA_IRQHandler(void) {
  * @retval - 3: `UART_NO_INIT`:         UART is not init.
  */
 uint8_t usart1_deinit(void) {
-    if (HAL_UART_GetState(&usart1_handle) == RESET) {
-        return UART_NO_INIT;
-    }
-
-    __HAL_RCC_USART1_CLK_DISABLE();
-
-#if USART1_TX
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(USART1_TX_PORT), USART1_TX_PIN);
-#endif /* USART1_TX */
-
-#if USART1_RX
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(USART1_RX_PORT), USART1_RX_PIN);
-#endif /* USART1_RX */
-
-#if USART1_CTS
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(USART1_CTS_PORT), USART1_CTS_PIN);
-#endif /* USART1_USART1_CTS */
-
-#if USART1_RTS
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(USART1_RTS_PORT), USART1_RTS_PIN);
-#endif /* USART1_RTS */
-
-#if USART1_IT_ENABLE
-    HAL_NVIC_DisableIRQ(USART1_IRQn);
-#endif /* USART1_IT_ENABLE */
-
-#if USART1_RX_DMA
-
-    HAL_DMA_Abort(&usart1_dmarx_handle);
-    CSP_FREE(usart1_rx_fifo.recv_buf);
-    CSP_FREE(usart1_rx_fifo.rx_fifo_buf);
-    ring_fifo_destroy(usart1_rx_fifo.rx_fifo);
-
-    if (HAL_DMA_DeInit(&usart1_dmarx_handle) != HAL_OK) {
-        return UART_DEINIT_DMA_FAIL;
-    }
-
-    HAL_NVIC_DisableIRQ(USART1_RX_DMA_IRQn);
-
-#if USE_HAL_UART_REGISTER_CALLBACKS
-    HAL_UART_UnRegisterCallback(&usart1_handle, HAL_UART_RX_HALFCOMPLETE_CB_ID);
-    HAL_UART_UnRegisterCallback(&usart1_handle, HAL_UART_RX_COMPLETE_CB_ID);
-#endif /* USE_HAL_UART_REGISTER_CALLBACKS */
-    usart1_handle.hdmarx = NULL;
-
-#endif /* USART1_RX_DMA */
-
-#if USART1_TX_DMA
-    HAL_DMA_Abort(&usart1_dmatx_handle);
-    CSP_FREE(usart1_tx_buf.send_buf);
-
-    if (HAL_DMA_DeInit(&usart1_dmatx_handle) != HAL_OK) {
-        return UART_DEINIT_DMA_FAIL;
-    }
-
-    HAL_NVIC_DisableIRQ(USART1_TX_DMA_IRQn);
-
-    usart1_handle.hdmatx = NULL;
-#endif /* USART1_TX_DMA */
-
-    if (HAL_UART_DeInit(&usart1_handle) != HAL_OK) {
-        return UART_DEINIT_FAIL;
-    }
-
-    return UART_DEINIT_OK;
+    return uart_port_deinit(&usart1_port);
 }
 
 #endif /* USART1_ENABLE */
@@ -415,137 +339,57 @@ static uart_tx_buf_t usart2_tx_buf = {.buf_size = USART2_TX_DMA_BUF_SIZE};
 
 #endif /* USART2_TX_DMA */
 
-/**
- * @brief USART2 initialization
- *
- * @param baud_rate Baud rate.
- * @return USART2 init status.
- * @retval - 0: `UART_INIT_OK`:       Success.
- * @retval - 1: `UART_INIT_FAIL`:     UART init failed.
- * @retval - 2: `UART_INIT_DMA_FAIL`: UART DMA init failed.
- * @retval - 3: `UART_INIT_MEM_FAIL`: UART buffer memory init failed (It will
- *                                    dynamic allocate memory when using DMA).
- * @retval - 4: `UART_INITED`:        This uart is inited.
- */
-uint8_t usart2_init(uint32_t baud_rate) {
-    if (HAL_UART_GetState(&usart2_handle) != RESET) {
-        return UART_INITED;
-    }
+static uart_stats_t usart2_stats;
 
-    GPIO_InitTypeDef gpio_init_struct = {.Pull = GPIO_PULLUP,
-                                         .Speed = GPIO_SPEED_FREQ_HIGH,
-                                         .Mode = GPIO_MODE_AF_PP};
-    usart2_handle.Init.BaudRate = baud_rate;
+static const uart_port_t usart2_port = {
+    .huart = &usart2_handle,
+    .stats = &usart2_stats,
+    .clk_enr = &RCC->APB1ENR,
+    .clk_msk = RCC_APB1ENR_USART2EN,
 #if USART2_TX
-    usart2_handle.Init.Mode |= UART_MODE_TX;
-
-    CSP_GPIO_CLK_ENABLE(USART2_TX_PORT);
-    gpio_init_struct.Pin = USART2_TX_PIN;
-    gpio_init_struct.Alternate = USART2_TX_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(USART2_TX_PORT), &gpio_init_struct);
+    .tx = {CSP_GPIO_PORT(USART2_TX_PORT), USART2_TX_PIN, USART2_TX_AF},
 #endif /* USART2_TX */
-
 #if USART2_RX
-    usart2_handle.Init.Mode |= UART_MODE_RX;
-
-    CSP_GPIO_CLK_ENABLE(USART2_RX_PORT);
-    gpio_init_struct.Pin = USART2_RX_PIN;
-    gpio_init_struct.Alternate = USART2_RX_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(USART2_RX_PORT), &gpio_init_struct);
+    .rx = {CSP_GPIO_PORT(USART2_RX_PORT), USART2_RX_PIN, USART2_RX_AF},
 #endif /* USART2_RX */
-
 #if USART2_CTS
-    usart2_handle.Init.HwFlowCtl |= UART_HWCONTROL_CTS;
-
-    CSP_GPIO_CLK_ENABLE(USART2_CTS_PORT);
-    gpio_init_struct.Pin = USART2_CTS_PIN;
-    gpio_init_struct.Alternate = USART2_CTS_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(USART2_CTS_PORT), &gpio_init_struct);
-#endif /* USART2_USART2_CTS */
-
+    .cts = {CSP_GPIO_PORT(USART2_CTS_PORT), USART2_CTS_PIN, USART2_CTS_AF},
+#endif /* USART2_CTS */
 #if USART2_RTS
-    usart2_handle.Init.HwFlowCtl |= UART_HWCONTROL_RTS;
-
-    CSP_GPIO_CLK_ENABLE(USART2_RTS_PORT);
-    gpio_init_struct.Pin = USART2_RTS_PIN;
-    gpio_init_struct.Alternate = USART2_RTS_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(USART2_RTS_PORT), &gpio_init_struct);
+    .rts = {CSP_GPIO_PORT(USART2_RTS_PORT), USART2_RTS_PIN, USART2_RTS_AF},
 #endif /* USART2_RTS */
-
-    __HAL_RCC_USART2_CLK_ENABLE();
 #if USART2_IT_ENABLE
-    HAL_NVIC_EnableIRQ(USART2_IRQn);
-    HAL_NVIC_SetPriority(USART2_IRQn, USART2_IT_PRIORITY, USART2_IT_SUB);
+    .it = {USART2_IRQn, USART2_IT_PRIORITY, USART2_IT_SUB},
+    .it_enable = 1,
 #endif /* USART2_IT_ENABLE */
-
 #if USART2_RX_DMA
-    usart2_rx_fifo.head_ptr = 0;
-
-    usart2_rx_fifo.recv_buf = CSP_MALLOC(usart2_rx_fifo.buf_size);
-    if (usart2_rx_fifo.recv_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    usart2_rx_fifo.rx_fifo_buf = CSP_MALLOC(usart2_rx_fifo.fifo_size);
-    if (usart2_rx_fifo.rx_fifo_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    usart2_rx_fifo.rx_fifo = ring_fifo_init(
-        usart2_rx_fifo.rx_fifo_buf, usart2_rx_fifo.fifo_size, RF_TYPE_STREAM);
-    if (usart2_rx_fifo.rx_fifo == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    CSP_DMA_CLK_ENABLE(USART2_RX_DMA_NUMBER);
-    if (HAL_DMA_Init(&usart2_dmarx_handle) != HAL_OK) {
-        return UART_INIT_DMA_FAIL;
-    }
-
-    __HAL_LINKDMA(&usart2_handle, hdmarx, usart2_dmarx_handle);
-
-    HAL_NVIC_SetPriority(USART2_RX_DMA_IRQn, USART2_RX_DMA_IT_PRIORITY, USART2_RX_DMA_IT_SUB);
-    HAL_NVIC_EnableIRQ(USART2_RX_DMA_IRQn);
-
+    .rx_dma = {&usart2_dmarx_handle,
+               {USART2_RX_DMA_IRQn, USART2_RX_DMA_IT_PRIORITY,
+                USART2_RX_DMA_IT_SUB}},
+    .rx_fifo = &usart2_rx_fifo,
 #endif /* USART2_RX_DMA */
-
 #if USART2_TX_DMA
-    usart2_tx_buf.send_buf = CSP_MALLOC(usart2_tx_buf.buf_size);
-    if (usart2_tx_buf.send_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    CSP_DMA_CLK_ENABLE(USART2_TX_DMA_NUMBER);
-    if (HAL_DMA_Init(&usart2_dmatx_handle) != HAL_OK) {
-        return UART_INIT_DMA_FAIL;
-    }
-
-    __HAL_LINKDMA(&usart2_handle, hdmatx, usart2_dmatx_handle);
-
-    HAL_NVIC_SetPriority(USART2_TX_DMA_IRQn, USART2_TX_DMA_IT_PRIORITY, USART2_TX_DMA_IT_SUB);
-    HAL_NVIC_EnableIRQ(USART2_TX_DMA_IRQn);
-
+    .tx_dma = {&usart2_dmatx_handle,
+               {USART2_TX_DMA_IRQn, USART2_TX_DMA_IT_PRIORITY,
+                USART2_TX_DMA_IT_SUB}},
+    .tx_buf = &usart2_tx_buf,
 #endif /* USART2_TX_DMA */
+};
 
-    if (HAL_UART_Init(&usart2_handle) != HAL_OK) {
-        return UART_INIT_FAIL;
-    }
-    
-#if USART2_RX_DMA
-    __HAL_UART_ENABLE_IT(&usart2_handle, UART_IT_IDLE);
-    __HAL_UART_CLEAR_IDLEFLAG(&usart2_handle);
-
-    HAL_UART_Receive_DMA(&usart2_handle, usart2_rx_fifo.recv_buf,
-                         usart2_rx_fifo.buf_size);
-
-#if USE_HAL_UART_REGISTER_CALLBACKS
-    HAL_UART_RegisterCallback(&usart2_handle, HAL_UART_RX_HALFCOMPLETE_CB_ID,
-                              uart_dmarx_halfdone_callback);
-    HAL_UART_RegisterCallback(&usart2_handle, HAL_UART_RX_COMPLETE_CB_ID,
-                              uart_dmarx_done_callback);
-#endif /* USE_HAL_UART_REGISTER_CALLBACKS */
-#endif /* USART2_RX_DMA */
-    return UART_INIT_OK;
+/**
+ * @brief USART2 initialization
+ *
+ * @param baud_rate Baud rate.
+ * @return USART2 init status.
+ * @retval - 0: `UART_INIT_OK`:       Success.
+ * @retval - 1: `UART_INIT_FAIL`:     UART init failed.
+ * @retval - 2: `UART_INIT_DMA_FAIL`: UART DMA init failed.
+ * @retval - 3: `UART_INIT_MEM_FAIL`: UART buffer memory init failed (It will
+ *                                    dynamic allocate memory when using DMA).
+ * @retval - 4: `UART_INITED`:        This uart is inited.
+ */
+uint8_t usart2_init(uint32_t baud_rate) {
+    return uart_port_init(&usart2_port, baud_rate);
 }
 
 #if USART2_IT_ENABLE
@@ -599,71 +443,7 @@ void USART2_TX_DMA_IRQHandler(void) {
  * @retval - 3: `UART_NO_INIT`:         UART is not init.
  */
 uint8_t usart2_deinit(void) {
-    if (HAL_UART_GetState(&usart2_handle) == RESET) {
-        return UART_NO_INIT;
-    }
-
-    __HAL_RCC_USART2_CLK_DISABLE();
-
-#if USART2_TX
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(USART2_TX_PORT), USART2_TX_PIN);
-#endif /* USART2_TX */
-
-#if USART2_RX
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(USART2_RX_PORT), USART2_RX_PIN);
-#endif /* USART2_RX */
-
-#if USART2_CTS
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(USART2_CTS_PORT), USART2_CTS_PIN);
-#endif /* USART2_USART2_CTS */
-
-#if USART2_RTS
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(USART2_RTS_PORT), USART2_RTS_PIN);
-#endif /* USART2_RTS */
-
-#if USART2_IT_ENABLE
-    HAL_NVIC_DisableIRQ(USART2_IRQn);
-#endif /* USART2_IT_ENABLE */
-
-#if USART2_RX_DMA
-
-    HAL_DMA_Abort(&usart2_dmarx_handle);
-    CSP_FREE(usart2_rx_fifo.recv_buf);
-    CSP_FREE(usart2_rx_fifo.rx_fifo_buf);
-    ring_fifo_destroy(usart2_rx_fifo.rx_fifo);
-
-    if (HAL_DMA_DeInit(&usart2_dmarx_handle) != HAL_OK) {
-        return UART_DEINIT_DMA_FAIL;
-    }
-
-    HAL_NVIC_DisableIRQ(USART2_RX_DMA_IRQn);
-
-#if USE_HAL_UART_REGISTER_CALLBACKS
-    HAL_UART_UnRegisterCallback(&usart2_handle, HAL_UART_RX_HALFCOMPLETE_CB_ID);
-    HAL_UART_UnRegisterCallback(&usart2_handle, HAL_UART_RX_COMPLETE_CB_ID);
-#endif /* USE_HAL_UART_REGISTER_CALLBACKS */
-    usart2_handle.hdmarx = NULL;
-
-#endif /* USART2_RX_DMA */
-
-#if USART2_TX_DMA
-    HAL_DMA_Abort(&usart2_dmatx_handle);
-    CSP_FREE(usart2_tx_buf.send_buf);
-
-    if (HAL_DMA_DeInit(&usart2_dmatx_handle) != HAL_OK) {
-        return UART_DEINIT_DMA_FAIL;
-    }
-
-    HAL_NVIC_DisableIRQ(USART2_TX_DMA_IRQn);
-
-    usart2_handle.hdmatx = NULL;
-#endif /* USART2_TX_DMA */
-
-    if (HAL_UART_DeInit(&usart2_handle) != HAL_OK) {
-        return UART_DEINIT_FAIL;
-    }
-
-    return UART_DEINIT_OK;
+    return uart_port_deinit(&usart2_port);
 }
 
 #endif /* USART2_ENABLE */
@@ -720,6 +500,43 @@ static uart_tx_buf_t usart3_tx_buf = {.buf_size = USART3_TX_DMA_BUF_SIZE};
 
 #endif /* USART3_TX_DMA */
 
+static uart_stats_t usart3_stats;
+
+static const uart_port_t usart3_port = {
+    .huart = &usart3_handle,
+    .stats = &usart3_stats,
+    .clk_enr = &RCC->APB1ENR,
+    .clk_msk = RCC_APB1ENR_USART3EN,
+#if USART3_TX
+    .tx = {CSP_GPIO_PORT(USART3_TX_PORT), USART3_TX_PIN, USART3_TX_AF},
+#endif /* USART3_TX */
+#if USART3_RX
+    .rx = {CSP_GPIO_PORT(USART3_RX_PORT), USART3_RX_PIN, USART3_RX_AF},
+#endif /* USART3_RX */
+#if USART3_CTS
+    .cts = {CSP_GPIO_PORT(USART3_CTS_PORT), USART3_CTS_PIN, USART3_CTS_AF},
+#endif /* USART3_CTS */
+#if USART3_RTS
+    .rts = {CSP_GPIO_PORT(USART3_RTS_PORT), USART3_RTS_PIN, USART3_RTS_AF},
+#endif /* USART3_RTS */
+#if USART3_IT_ENABLE
+    .it = {USART3_IRQn, USART3_IT_PRIORITY, USART3_IT_SUB},
+    .it_enable = 1,
+#endif /* USART3_IT_ENABLE */
+#if USART3_RX_DMA
+    .rx_dma = {&usart3_dmarx_handle,
+               {USART3_RX_DMA_IRQn, USART3_RX_DMA_IT_PRIORITY,
+                USART3_RX_DMA_IT_SUB}},
+    .rx_fifo = &usart3_rx_fifo,
+#endif /* USART3_RX_DMA */
+#if USART3_TX_DMA
+    .tx_dma = {&usart3_dmatx_handle,
+               {USART3_TX_DMA_IRQn, USART3_TX_DMA_IT_PRIORITY,
+                USART3_TX_DMA_IT_SUB}},
+    .tx_buf = &usart3_tx_buf,
+#endif /* USART3_TX_DMA */
+};
+
 /**
  * @brief USART3 initialization
  *
@@ -733,127 +550,10 @@ static uart_tx_buf_t usart3_tx_buf = {.buf_size = USART3_TX_DMA_BUF_SIZE};
  * @retval - 4: `UART_INITED`:        This uart is inited.
  */
 uint8_t usart3_init(uint32_t baud_rate) {
-    if (HAL_UART_GetState(&usart3_handle) != RESET) {
-        return UART_INITED;
-    }
-
-    GPIO_InitTypeDef gpio_init_struct = {.Pull = GPIO_PULLUP,
-                                         .Speed = GPIO_SPEED_FREQ_HIGH,
-                                         .Mode = GPIO_MODE_AF_PP};
-    usart3_handle.Init.BaudRate = baud_rate;
-#if USART3_TX
-    usart3_handle.Init.Mode |= UART_MODE_TX;
+    return uart_port_init(&usart3_port, baud_rate);
+}
 
-    CSP_GPIO_CLK_ENABLE(USART3_TX_PORT);
-    gpio_init_struct.Pin = USART3_TX_PIN;
-    gpio_init_struct.Alternate = USART3_TX_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(USART3_TX_PORT), &gpio_init_struct);
-#endif /* USART3_TX */
-
-#if USART3_RX
-    usart3_handle.Init.Mode |= UART_MODE_RX;
-
-    CSP_GPIO_CLK_ENABLE(USART3_RX_PORT);
-    gpio_init_struct.Pin = USART3_RX_PIN;
-    gpio_init_struct.Alternate = USART3_RX_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(USART3_RX_PORT), &gpio_init_struct);
-#endif /* USART3_RX */
-
-#if USART3_CTS
-    usart3_handle.Init.HwFlowCtl |= UART_HWCONTROL_CTS;
-
-    CSP_GPIO_CLK_ENABLE(USART3_CTS_PORT);
-    gpio_init_struct.Pin = USART3_CTS_PIN;
-    gpio_init_struct.Alternate = USART3_CTS_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(USART3_CTS_PORT), &gpio_init_struct);
-#endif /* USART3_USART3_CTS */
-
-#if USART3_RTS
-    usart3_handle.Init.HwFlowCtl |= UART_HWCONTROL_RTS;
-
-    CSP_GPIO_CLK_ENABLE(USART3_RTS_PORT);
-    gpio_init_struct.Pin = USART3_RTS_PIN;
-    gpio_init_struct.Alternate = USART3_RTS_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(USART3_RTS_PORT), &gpio_init_struct);
-#endif /* USART3_RTS */
-
-    __HAL_RCC_USART3_CLK_ENABLE();
-#if USART3_IT_ENABLE
-    HAL_NVIC_EnableIRQ(USART3_IRQn);
-    HAL_NVIC_SetPriority(USART3_IRQn, USART3_IT_PRIORITY, USART3_IT_SUB);
-#endif /* USART3_IT_ENABLE */
-
-#if USART3_RX_DMA
-    usart3_rx_fifo.head_ptr = 0;
-
-    usart3_rx_fifo.recv_buf = CSP_MALLOC(usart3_rx_fifo.buf_size);
-    if (usart3_rx_fifo.recv_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    usart3_rx_fifo.rx_fifo_buf = CSP_MALLOC(usart3_rx_fifo.fifo_size);
-    if (usart3_rx_fifo.rx_fifo_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    usart3_rx_fifo.rx_fifo = ring_fifo_init(
-        usart3_rx_fifo.rx_fifo_buf, usart3_rx_fifo.fifo_size, RF_TYPE_STREAM);
-    if (usart3_rx_fifo.rx_fifo == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    CSP_DMA_CLK_ENABLE(USART3_RX_DMA_NUMBER);
-    if (HAL_DMA_Init(&usart3_dmarx_handle) != HAL_OK) {
-        return UART_INIT_DMA_FAIL;
-    }
-
-    __HAL_LINKDMA(&usart3_handle, hdmarx, usart3_dmarx_handle);
-
-    HAL_NVIC_SetPriority(USART3_RX_DMA_IRQn, USART3_RX_DMA_IT_PRIORITY, USART3_RX_DMA_IT_SUB);
-    HAL_NVIC_EnableIRQ(USART3_RX_DMA_IRQn);
-
-#endif /* USART3_RX_DMA */
-
-#if USART3_TX_DMA
-    usart3_tx_buf.send_buf = CSP_MALLOC(usart3_tx_buf.buf_size);
-    if (usart3_tx_buf.send_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    CSP_DMA_CLK_ENABLE(USART3_TX_DMA_NUMBER);
-    if (HAL_DMA_Init(&usart3_dmatx_handle) != HAL_OK) {
-        return UART_INIT_DMA_FAIL;
-    }
-
-    __HAL_LINKDMA(&usart3_handle, hdmatx, usart3_dmatx_handle);
-
-    HAL_NVIC_SetPriority(USART3_TX_DMA_IRQn, USART3_TX_DMA_IT_PRIORITY, USART3_TX_DMA_IT_SUB);
-    HAL_NVIC_EnableIRQ(USART3_TX_DMA_IRQn);
-
-#endif /* USART3_TX_DMA */
-
-    if (HAL_UART_Init(&usart3_handle) != HAL_OK) {
-        return UART_INIT_FAIL;
-    }
-    
-#if USART3_RX_DMA
-    __HAL_UART_ENABLE_IT(&usart3_handle, UART_IT_IDLE);
-    __HAL_UART_CLEAR_IDLEFLAG(&usart3_handle);
-
-    HAL_UART_Receive_DMA(&usart3_handle, usart3_rx_fifo.recv_buf,
-                         usart3_rx_fifo.buf_size);
-
-#if USE_HAL_UART_REGISTER_CALLBACKS
-    HAL_UART_RegisterCallback(&usart3_handle, HAL_UART_RX_HALFCOMPLETE_CB_ID,
-                              uart_dmarx_halfdone_callback);
-    HAL_UART_RegisterCallback(&usart3_handle, HAL_UART_RX_COMPLETE_CB_ID,
-                              uart_dmarx_done_callback);
-#endif /* USE_HAL_UART_REGISTER_CALLBACKS */
-#endif /* USART3_RX_DMA */
-    return UART_INIT_OK;
-}
-
-#if USART3_IT_ENABLE
+#if USART3_IT_ENABLE
 
 /**
  * @brief USART3 ISR
@@ -904,71 +604,7 @@ void USART3_TX_DMA_IRQHandler(void) {
  * @retval - 3: `UART_NO_INIT`:         UART is not init.
  */
 uint8_t usart3_deinit(void) {
-    if (HAL_UART_GetState(&usart3_handle) == RESET) {
-        return UART_NO_INIT;
-    }
-
-    __HAL_RCC_USART3_CLK_DISABLE();
-
-#if USART3_TX
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(USART3_TX_PORT), USART3_TX_PIN);
-#endif /* USART3_TX */
-
-#if USART3_RX
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(USART3_RX_PORT), USART3_RX_PIN);
-#endif /* USART3_RX */
-
-#if USART3_CTS
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(USART3_CTS_PORT), USART3_CTS_PIN);
-#endif /* USART3_USART3_CTS */
-
-#if USART3_RTS
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(USART3_RTS_PORT), USART3_RTS_PIN);
-#endif /* USART3_RTS */
-
-#if USART3_IT_ENABLE
-    HAL_NVIC_DisableIRQ(USART3_IRQn);
-#endif /* USART3_IT_ENABLE */
-
-#if USART3_RX_DMA
-
-    HAL_DMA_Abort(&usart3_dmarx_handle);
-    CSP_FREE(usart3_rx_fifo.recv_buf);
-    CSP_FREE(usart3_rx_fifo.rx_fifo_buf);
-    ring_fifo_destroy(usart3_rx_fifo.rx_fifo);
-
-    if (HAL_DMA_DeInit(&usart3_dmarx_handle) != HAL_OK) {
-        return UART_DEINIT_DMA_FAIL;
-    }
-
-    HAL_NVIC_DisableIRQ(USART3_RX_DMA_IRQn);
-
-#if USE_HAL_UART_REGISTER_CALLBACKS
-    HAL_UART_UnRegisterCallback(&usart3_handle, HAL_UART_RX_HALFCOMPLETE_CB_ID);
-    HAL_UART_UnRegisterCallback(&usart3_handle, HAL_UART_RX_COMPLETE_CB_ID);
-#endif /* USE_HAL_UART_REGISTER_CALLBACKS */
-    usart3_handle.hdmarx = NULL;
-
-#endif /* USART3_RX_DMA */
-
-#if USART3_TX_DMA
-    HAL_DMA_Abort(&usart3_dmatx_handle);
-    CSP_FREE(usart3_tx_buf.send_buf);
-
-    if (HAL_DMA_DeInit(&usart3_dmatx_handle) != HAL_OK) {
-        return UART_DEINIT_DMA_FAIL;
-    }
-
-    HAL_NVIC_DisableIRQ(USART3_TX_DMA_IRQn);
-
-    usart3_handle.hdmatx = NULL;
-#endif /* USART3_TX_DMA */
-
-    if (HAL_UART_DeInit(&usart3_handle) != HAL_OK) {
-        return UART_DEINIT_FAIL;
-    }
-
-    return UART_DEINIT_OK;
+    return uart_port_deinit(&usart3_port);
 }
 
 #endif /* USART3_ENABLE */
@@ -1025,137 +661,57 @@ static uart_tx_buf_t uart4_tx_buf = {.buf_size = UART4_TX_DMA_BUF_SIZE};
 
 #endif /* UART4_TX_DMA */
 
-/**
- * @brief UART4 initialization
- *
- * @param baud_rate Baud rate.
- * @return UART4 init status.
- * @retval - 0: `UART_INIT_OK`:       Success.
- * @retval - 1: `UART_INIT_FAIL`:     UART init failed.
- * @retval - 2: `UART_INIT_DMA_FAIL`: UART DMA init failed.
- * @retval - 3: `UART_INIT_MEM_FAIL`: UART buffer memory init failed (It will
- *                                    dynamic allocate memory when using DMA).
- * @retval - 4: `UART_INITED`:        This uart is inited.
- */
-uint8_t uart4_init(uint32_t baud_rate) {
-    if (HAL_UART_GetState(&uart4_handle) != RESET) {
-        return UART_INITED;
-    }
+static uart_stats_t uart4_stats;
 
-    GPIO_InitTypeDef gpio_init_struct = {.Pull = GPIO_PULLUP,
-                                         .Speed = GPIO_SPEED_FREQ_HIGH,
-                                         .Mode = GPIO_MODE_AF_PP};
-    uart4_handle.Init.BaudRate = baud_rate;
+static const uart_port_t uart4_port = {
+    .huart = &uart4_handle,
+    .stats = &uart4_stats,
+    .clk_enr = &RCC->APB1ENR,
+    .clk_msk = RCC_APB1ENR_UART4EN,
 #if UART4_TX
-    uart4_handle.Init.Mode |= UART_MODE_TX;
-
-    CSP_GPIO_CLK_ENABLE(UART4_TX_PORT);
-    gpio_init_struct.Pin = UART4_TX_PIN;
-    gpio_init_struct.Alternate = UART4_TX_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(UART4_TX_PORT), &gpio_init_struct);
+    .tx = {CSP_GPIO_PORT(UART4_TX_PORT), UART4_TX_PIN, UART4_TX_AF},
 #endif /* UART4_TX */
-
 #if UART4_RX
-    uart4_handle.Init.Mode |= UART_MODE_RX;
-
-    CSP_GPIO_CLK_ENABLE(UART4_RX_PORT);
-    gpio_init_struct.Pin = UART4_RX_PIN;
-    gpio_init_struct.Alternate = UART4_RX_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(UART4_RX_PORT), &gpio_init_struct);
+    .rx = {CSP_GPIO_PORT(UART4_RX_PORT), UART4_RX_PIN, UART4_RX_AF},
 #endif /* UART4_RX */
-
 #if UART4_CTS
-    uart4_handle.Init.HwFlowCtl |= UART_HWCONTROL_CTS;
-
-    CSP_GPIO_CLK_ENABLE(UART4_CTS_PORT);
-    gpio_init_struct.Pin = UART4_CTS_PIN;
-    gpio_init_struct.Alternate = UART4_CTS_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(UART4_CTS_PORT), &gpio_init_struct);
-#endif /* UART4_UART4_CTS */
-
+    .cts = {CSP_GPIO_PORT(UART4_CTS_PORT), UART4_CTS_PIN, UART4_CTS_AF},
+#endif /* UART4_CTS */
 #if UART4_RTS
-    uart4_handle.Init.HwFlowCtl |= UART_HWCONTROL_RTS;
-
-    CSP_GPIO_CLK_ENABLE(UART4_RTS_PORT);
-    gpio_init_struct.Pin = UART4_RTS_PIN;
-    gpio_init_struct.Alternate = UART4_RTS_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(UART4_RTS_PORT), &gpio_init_struct);
+    .rts = {CSP_GPIO_PORT(UART4_RTS_PORT), UART4_RTS_PIN, UART4_RTS_AF},
 #endif /* UART4_RTS */
-
-    __HAL_RCC_UART4_CLK_ENABLE();
 #if UART4_IT_ENABLE
-    HAL_NVIC_EnableIRQ(UART4_IRQn);
-    HAL_NVIC_SetPriority(UART4_IRQn, UART4_IT_PRIORITY, UART4_IT_SUB);
+    .it = {UART4_IRQn, UART4_IT_PRIORITY, UART4_IT_SUB},
+    .it_enable = 1,
 #endif /* UART4_IT_ENABLE */
-
 #if UART4_RX_DMA
-    uart4_rx_fifo.head_ptr = 0;
-
-    uart4_rx_fifo.recv_buf = CSP_MALLOC(uart4_rx_fifo.buf_size);
-    if (uart4_rx_fifo.recv_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    uart4_rx_fifo.rx_fifo_buf = CSP_MALLOC(uart4_rx_fifo.fifo_size);
-    if (uart4_rx_fifo.rx_fifo_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    uart4_rx_fifo.rx_fifo = ring_fifo_init(
-        uart4_rx_fifo.rx_fifo_buf, uart4_rx_fifo.fifo_size, RF_TYPE_STREAM);
-    if (uart4_rx_fifo.rx_fifo == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    CSP_DMA_CLK_ENABLE(UART4_RX_DMA_NUMBER);
-    if (HAL_DMA_Init(&uart4_dmarx_handle) != HAL_OK) {
-        return UART_INIT_DMA_FAIL;
-    }
-
-    __HAL_LINKDMA(&uart4_handle, hdmarx, uart4_dmarx_handle);
-
-    HAL_NVIC_SetPriority(UART4_RX_DMA_IRQn, UART4_RX_DMA_IT_PRIORITY, UART4_RX_DMA_IT_SUB);
-    HAL_NVIC_EnableIRQ(UART4_RX_DMA_IRQn);
-
+    .rx_dma = {&uart4_dmarx_handle,
+               {UART4_RX_DMA_IRQn, UART4_RX_DMA_IT_PRIORITY,
+                UART4_RX_DMA_IT_SUB}},
+    .rx_fifo = &uart4_rx_fifo,
 #endif /* UART4_RX_DMA */
-
 #if UART4_TX_DMA
-    uart4_tx_buf.send_buf = CSP_MALLOC(uart4_tx_buf.buf_size);
-    if (uart4_tx_buf.send_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    CSP_DMA_CLK_ENABLE(UART4_TX_DMA_NUMBER);
-    if (HAL_DMA_Init(&uart4_dmatx_handle) != HAL_OK) {
-        return UART_INIT_DMA_FAIL;
-    }
-
-    __HAL_LINKDMA(&uart4_handle, hdmatx, uart4_dmatx_handle);
-
-    HAL_NVIC_SetPriority(UART4_TX_DMA_IRQn, UART4_TX_DMA_IT_PRIORITY, UART4_TX_DMA_IT_SUB);
-    HAL_NVIC_EnableIRQ(UART4_TX_DMA_IRQn);
-
+    .tx_dma = {&uart4_dmatx_handle,
+               {UART4_TX_DMA_IRQn, UART4_TX_DMA_IT_PRIORITY,
+                UART4_TX_DMA_IT_SUB}},
+    .tx_buf = &uart4_tx_buf,
 #endif /* UART4_TX_DMA */
+};
 
-    if (HAL_UART_Init(&uart4_handle) != HAL_OK) {
-        return UART_INIT_FAIL;
-    }
-    
-#if UART4_RX_DMA
-    __HAL_UART_ENABLE_IT(&uart4_handle, UART_IT_IDLE);
-    __HAL_UART_CLEAR_IDLEFLAG(&uart4_handle);
-
-    HAL_UART_Receive_DMA(&uart4_handle, uart4_rx_fifo.recv_buf,
-                         uart4_rx_fifo.buf_size);
-
-#if USE_HAL_UART_REGISTER_CALLBACKS
-    HAL_UART_RegisterCallback(&uart4_handle, HAL_UART_RX_HALFCOMPLETE_CB_ID,
-                              uart_dmarx_halfdone_callback);
-    HAL_UART_RegisterCallback(&uart4_handle, HAL_UART_RX_COMPLETE_CB_ID,
-                              uart_dmarx_done_callback);
-#endif /* USE_HAL_UART_REGISTER_CALLBACKS */
-#endif /* UART4_RX_DMA */
-    return UART_INIT_OK;
+/**
+ * @brief UART4 initialization
+ *
+ * @param baud_rate Baud rate.
+ * @return UART4 init status.
+ * @retval - 0: `UART_INIT_OK`:       Success.
+ * @retval - 1: `UART_INIT_FAIL`:     UART init failed.
+ * @retval - 2: `UART_INIT_DMA_FAIL`: UART DMA init failed.
+ * @retval - 3: `UART_INIT_MEM_FAIL`: UART buffer memory init failed (It will
+ *                                    dynamic allocate memory when using DMA).
+ * @retval - 4: `UART_INITED`:        This uart is inited.
+ */
+uint8_t uart4_init(uint32_t baud_rate) {
+    return uart_port_init(&uart4_port, baud_rate);
 }
 
 #if UART4_IT_ENABLE
@@ -1209,71 +765,7 @@ void UART4_TX_DMA_IRQHandler(void) {
  * @retval - 3: `UART_NO_INIT`:         UART is not init.
  */
 uint8_t uart4_deinit(void) {
-    if (HAL_UART_GetState(&uart4_handle) == RESET) {
-        return UART_NO_INIT;
-    }
-
-    __HAL_RCC_UART4_CLK_DISABLE();
-
-#if UART4_TX
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(UART4_TX_PORT), UART4_TX_PIN);
-#endif /* UART4_TX */
-
-#if UART4_RX
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(UART4_RX_PORT), UART4_RX_PIN);
-#endif /* UART4_RX */
-
-#if UART4_CTS
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(UART4_CTS_PORT), UART4_CTS_PIN);
-#endif /* UART4_UART4_CTS */
-
-#if UART4_RTS
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(UART4_RTS_PORT), UART4_RTS_PIN);
-#endif /* UART4_RTS */
-
-#if UART4_IT_ENABLE
-    HAL_NVIC_DisableIRQ(UART4_IRQn);
-#endif /* UART4_IT_ENABLE */
-
-#if UART4_RX_DMA
-
-    HAL_DMA_Abort(&uart4_dmarx_handle);
-    CSP_FREE(uart4_rx_fifo.recv_buf);
-    CSP_FREE(uart4_rx_fifo.rx_fifo_buf);
-    ring_fifo_destroy(uart4_rx_fifo.rx_fifo);
-
-    if (HAL_DMA_DeInit(&uart4_dmarx_handle) != HAL_OK) {
-        return UART_DEINIT_DMA_FAIL;
-    }
-
-    HAL_NVIC_DisableIRQ(UART4_RX_DMA_IRQn);
-
-#if USE_HAL_UART_REGISTER_CALLBACKS
-    HAL_UART_UnRegisterCallback(&uart4_handle, HAL_UART_RX_HALFCOMPLETE_CB_ID);
-    HAL_UART_UnRegisterCallback(&uart4_handle, HAL_UART_RX_COMPLETE_CB_ID);
-#endif /* USE_HAL_UART_REGISTER_CALLBACKS */
-    uart4_handle.hdmarx = NULL;
-
-#endif /* UART4_RX_DMA */
-
-#if UART4_TX_DMA
-    HAL_DMA_Abort(&uart4_dmatx_handle);
-    CSP_FREE(uart4_tx_buf.send_buf);
-
-    if (HAL_DMA_DeInit(&uart4_dmatx_handle) != HAL_OK) {
-        return UART_DEINIT_DMA_FAIL;
-    }
-
-    HAL_NVIC_DisableIRQ(UART4_TX_DMA_IRQn);
-
-    uart4_handle.hdmatx = NULL;
-#endif /* UART4_TX_DMA */
-
-    if (HAL_UART_DeInit(&uart4_handle) != HAL_OK) {
-        return UART_DEINIT_FAIL;
-    }
-
-    return UART_DEINIT_OK;
+    return uart_port_deinit(&uart4_port);
 }
 
 #endif /* UART4_ENABLE */
@@ -1330,6 +822,43 @@ static uart_tx_buf_t uart5_tx_buf = {.buf_size = UART5_TX_DMA_BUF_SIZE};
 
 #endif /* UART5_TX_DMA */
 
+static uart_stats_t uart5_stats;
+
+static const uart_port_t uart5_port = {
+    .huart = &uart5_handle,
+    .stats = &uart5_stats,
+    .clk_enr = &RCC->APB1ENR,
+    .clk_msk = RCC_APB1ENR_UART5EN,
+#if UART5_TX
+    .tx = {CSP_GPIO_PORT(UART5_TX_PORT), UART5_TX_PIN, UART5_TX_AF},
+#endif /* UART5_TX */
+#if UART5_RX
+    .rx = {CSP_GPIO_PORT(UART5_RX_PORT), UART5_RX_PIN, UART5_RX_AF},
+#endif /* UART5_RX */
+#if UART5_CTS
+    .cts = {CSP_GPIO_PORT(UART5_CTS_PORT), UART5_CTS_PIN, UART5_CTS_AF},
+#endif /* UART5_CTS */
+#if UART5_RTS
+    .rts = {CSP_GPIO_PORT(UART5_RTS_PORT), UART5_RTS_PIN, UART5_RTS_AF},
+#endif /* UART5_RTS */
+#if UART5_IT_ENABLE
+    .it = {UART5_IRQn, UART5_IT_PRIORITY, UART5_IT_SUB},
+    .it_enable = 1,
+#endif /* UART5_IT_ENABLE */
+#if UART5_RX_DMA
+    .rx_dma = {&uart5_dmarx_handle,
+               {UART5_RX_DMA_IRQn, UART5_RX_DMA_IT_PRIORITY,
+                UART5_RX_DMA_IT_SUB}},
+    .rx_fifo = &uart5_rx_fifo,
+#endif /* UART5_RX_DMA */
+#if UART5_TX_DMA
+    .tx_dma = {&uart5_dmatx_handle,
+               {UART5_TX_DMA_IRQn, UART5_TX_DMA_IT_PRIORITY,
+                UART5_TX_DMA_IT_SUB}},
+    .tx_buf = &uart5_tx_buf,
+#endif /* UART5_TX_DMA */
+};
+
 /**
  * @brief UART5 initialization
  *
@@ -1343,156 +872,39 @@ static uart_tx_buf_t uart5_tx_buf = {.buf_size = UART5_TX_DMA_BUF_SIZE};
  * @retval - 4: `UART_INITED`:        This uart is inited.
  */
 uint8_t uart5_init(uint32_t baud_rate) {
-    if (HAL_UART_GetState(&uart5_handle) != RESET) {
-        return UART_INITED;
-    }
-
-    GPIO_InitTypeDef gpio_init_struct = {.Pull = GPIO_PULLUP,
-                                         .Speed = GPIO_SPEED_FREQ_HIGH,
-                                         .Mode = GPIO_MODE_AF_PP};
-    uart5_handle.Init.BaudRate = baud_rate;
-#if UART5_TX
-    uart5_handle.Init.Mode |= UART_MODE_TX;
-
-    CSP_GPIO_CLK_ENABLE(UART5_TX_PORT);
-    gpio_init_struct.Pin = UART5_TX_PIN;
-    gpio_init_struct.Alternate = UART5_TX_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(UART5_TX_PORT), &gpio_init_struct);
-#endif /* UART5_TX */
-
-#if UART5_RX
-    uart5_handle.Init.Mode |= UART_MODE_RX;
-
-    CSP_GPIO_CLK_ENABLE(UART5_RX_PORT);
-    gpio_init_struct.Pin = UART5_RX_PIN;
-    gpio_init_struct.Alternate = UART5_RX_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(UART5_RX_PORT), &gpio_init_struct);
-#endif /* UART5_RX */
-
-#if UART5_CTS
-    uart5_handle.Init.HwFlowCtl |= UART_HWCONTROL_CTS;
+    return uart_port_init(&uart5_port, baud_rate);
+}
 
-    CSP_GPIO_CLK_ENABLE(UART5_CTS_PORT);
-    gpio_init_struct.Pin = UART5_CTS_PIN;
-    gpio_init_struct.Alternate = UART5_CTS_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(UART5_CTS_PORT), &gpio_init_struct);
-#endif /* UART5_UART5_CTS */
+#if UART5_IT_ENABLE
 
-#if UART5_RTS
-    uart5_handle.Init.HwFlowCtl |= UART_HWCONTROL_RTS;
+/**
+ * @brief UART5 ISR
+ *
+ */
+void UART5_IRQHandler(void) {
+    if (__HAL_UART_GET_FLAG(&uart5_handle, UART_FLAG_IDLE)) {
+        __HAL_UART_CLEAR_IDLEFLAG(&uart5_handle);
+        uart_dmarx_idle_callback(&uart5_handle);
+    }
 
-    CSP_GPIO_CLK_ENABLE(UART5_RTS_PORT);
-    gpio_init_struct.Pin = UART5_RTS_PIN;
-    gpio_init_struct.Alternate = UART5_RTS_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(UART5_RTS_PORT), &gpio_init_struct);
-#endif /* UART5_RTS */
+    HAL_UART_IRQHandler(&uart5_handle);
+}
 
-    __HAL_RCC_UART5_CLK_ENABLE();
-#if UART5_IT_ENABLE
-    HAL_NVIC_EnableIRQ(UART5_IRQn);
-    HAL_NVIC_SetPriority(UART5_IRQn, UART5_IT_PRIORITY, UART5_IT_SUB);
 #endif /* UART5_IT_ENABLE */
 
 #if UART5_RX_DMA
-    uart5_rx_fifo.head_ptr = 0;
-
-    uart5_rx_fifo.recv_buf = CSP_MALLOC(uart5_rx_fifo.buf_size);
-    if (uart5_rx_fifo.recv_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
 
-    uart5_rx_fifo.rx_fifo_buf = CSP_MALLOC(uart5_rx_fifo.fifo_size);
-    if (uart5_rx_fifo.rx_fifo_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
+/**
+ * @brief UART5 Rx DMA ISR
+ *
+ */
+void UART5_RX_DMA_IRQHandler(void) {
+    HAL_DMA_IRQHandler(&uart5_dmarx_handle);
+}
 
-    uart5_rx_fifo.rx_fifo = ring_fifo_init(
-        uart5_rx_fifo.rx_fifo_buf, uart5_rx_fifo.fifo_size, RF_TYPE_STREAM);
-    if (uart5_rx_fifo.rx_fifo == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
+#endif /* UART5_RX_DMA */
 
-    CSP_DMA_CLK_ENABLE(UART5_RX_DMA_NUMBER);
-    if (HAL_DMA_Init(&uart5_dmarx_handle) != HAL_OK) {
-        return UART_INIT_DMA_FAIL;
-    }
-
-    __HAL_LINKDMA(&uart5_handle, hdmarx, uart5_dmarx_handle);
-
-    HAL_NVIC_SetPriority(UART5_RX_DMA_IRQn, UART5_RX_DMA_IT_PRIORITY, UART5_RX_DMA_IT_SUB);
-    HAL_NVIC_EnableIRQ(UART5_RX_DMA_IRQn);
-
-#endif /* UART5_RX_DMA */
-
-#if UART5_TX_DMA
-    uart5_tx_buf.send_buf = CSP_MALLOC(uart5_tx_buf.buf_size);
-    if (uart5_tx_buf.send_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    CSP_DMA_CLK_ENABLE(UART5_TX_DMA_NUMBER);
-    if (HAL_DMA_Init(&uart5_dmatx_handle) != HAL_OK) {
-        return UART_INIT_DMA_FAIL;
-    }
-
-    __HAL_LINKDMA(&uart5_handle, hdmatx, uart5_dmatx_handle);
-
-    HAL_NVIC_SetPriority(UART5_TX_DMA_IRQn, UART5_TX_DMA_IT_PRIORITY, UART5_TX_DMA_IT_SUB);
-    HAL_NVIC_EnableIRQ(UART5_TX_DMA_IRQn);
-
-#endif /* UART5_TX_DMA */
-
-    if (HAL_UART_Init(&uart5_handle) != HAL_OK) {
-        return UART_INIT_FAIL;
-    }
-    
-#if UART5_RX_DMA
-    __HAL_UART_ENABLE_IT(&uart5_handle, UART_IT_IDLE);
-    __HAL_UART_CLEAR_IDLEFLAG(&uart5_handle);
-
-    HAL_UART_Receive_DMA(&uart5_handle, uart5_rx_fifo.recv_buf,
-                         uart5_rx_fifo.buf_size);
-
-#if USE_HAL_UART_REGISTER_CALLBACKS
-    HAL_UART_RegisterCallback(&uart5_handle, HAL_UART_RX_HALFCOMPLETE_CB_ID,
-                              uart_dmarx_halfdone_callback);
-    HAL_UART_RegisterCallback(&uart5_handle, HAL_UART_RX_COMPLETE_CB_ID,
-                              uart_dmarx_done_callback);
-#endif /* USE_HAL_UART_REGISTER_CALLBACKS */
-#endif /* UART5_RX_DMA */
-    return UART_INIT_OK;
-}
-
-#if UART5_IT_ENABLE
-
-/**
- * @brief UART5 ISR
- *
- */
-void UART5_IRQHandler(void) {
-    if (__HAL_UART_GET_FLAG(&uart5_handle, UART_FLAG_IDLE)) {
-        __HAL_UART_CLEAR_IDLEFLAG(&uart5_handle);
-        uart_dmarx_idle_callback(&uart5_handle);
-    }
-
-    HAL_UART_IRQHandler(&uart5_handle);
-}
-
-#endif /* UART5_IT_ENABLE */
-
-#if UART5_RX_DMA
-
-/**
- * @brief UART5 Rx DMA ISR
- *
- */
-void UART5_RX_DMA_IRQHandler(void) {
-    HAL_DMA_IRQHandler(&uart5_dmarx_handle);
-}
-
-#endif /* UART5_RX_DMA */
-
-#if UART5_TX_DMA
+#if UART5_TX_DMA
 
 /**
  * @brief UART5 Rx DMA ISR
@@ -1514,71 +926,7 @@ void UART5_TX_DMA_IRQHandler(void) {
  * @retval - 3: `UART_NO_INIT`:         UART is not init.
  */
 uint8_t uart5_deinit(void) {
-    if (HAL_UART_GetState(&uart5_handle) == RESET) {
-        return UART_NO_INIT;
-    }
-
-    __HAL_RCC_UART5_CLK_DISABLE();
-
-#if UART5_TX
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(UART5_TX_PORT), UART5_TX_PIN);
-#endif /* UART5_TX */
-
-#if UART5_RX
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(UART5_RX_PORT), UART5_RX_PIN);
-#endif /* UART5_RX */
-
-#if UART5_CTS
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(UART5_CTS_PORT), UART5_CTS_PIN);
-#endif /* UART5_UART5_CTS */
-
-#if UART5_RTS
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(UART5_RTS_PORT), UART5_RTS_PIN);
-#endif /* UART5_RTS */
-
-#if UART5_IT_ENABLE
-    HAL_NVIC_DisableIRQ(UART5_IRQn);
-#endif /* UART5_IT_ENABLE */
-
-#if UART5_RX_DMA
-
-    HAL_DMA_Abort(&uart5_dmarx_handle);
-    CSP_FREE(uart5_rx_fifo.recv_buf);
-    CSP_FREE(uart5_rx_fifo.rx_fifo_buf);
-    ring_fifo_destroy(uart5_rx_fifo.rx_fifo);
-
-    if (HAL_DMA_DeInit(&uart5_dmarx_handle) != HAL_OK) {
-        return UART_DEINIT_DMA_FAIL;
-    }
-
-    HAL_NVIC_DisableIRQ(UART5_RX_DMA_IRQn);
-
-#if USE_HAL_UART_REGISTER_CALLBACKS
-    HAL_UART_UnRegisterCallback(&uart5_handle, HAL_UART_RX_HALFCOMPLETE_CB_ID);
-    HAL_UART_UnRegisterCallback(&uart5_handle, HAL_UART_RX_COMPLETE_CB_ID);
-#endif /* USE_HAL_UART_REGISTER_CALLBACKS */
-    uart5_handle.hdmarx = NULL;
-
-#endif /* UART5_RX_DMA */
-
-#if UART5_TX_DMA
-    HAL_DMA_Abort(&uart5_dmatx_handle);
-    CSP_FREE(uart5_tx_buf.send_buf);
-
-    if (HAL_DMA_DeInit(&uart5_dmatx_handle) != HAL_OK) {
-        return UART_DEINIT_DMA_FAIL;
-    }
-
-    HAL_NVIC_DisableIRQ(UART5_TX_DMA_IRQn);
-
-    uart5_handle.hdmatx = NULL;
-#endif /* UART5_TX_DMA */
-
-    if (HAL_UART_DeInit(&uart5_handle) != HAL_OK) {
-        return UART_DEINIT_FAIL;
-    }
-
-    return UART_DEINIT_OK;
+    return uart_port_deinit(&uart5_port);
 }
 
 #endif /* UART5_ENABLE */
@@ -1635,137 +983,57 @@ static uart_tx_buf_t usart6_tx_buf = {.buf_size = USART6_TX_DMA_BUF_SIZE};
 
 #endif /* USART6_TX_DMA */
 
-/**
- * @brief USART6 initialization
- *
- * @param baud_rate Baud rate.
- * @return USART6 init status.
- * @retval - 0: `UART_INIT_OK`:       Success.
- * @retval - 1: `UART_INIT_FAIL`:     UART init failed.
- * @retval - 2: `UART_INIT_DMA_FAIL`: UART DMA init failed.
- * @retval - 3: `UART_INIT_MEM_FAIL`: UART buffer memory init failed (It will
- *                                    dynamic allocate memory when using DMA).
- * @retval - 4: `UART_INITED`:        This uart is inited.
- */
-uint8_t usart6_init(uint32_t baud_rate) {
-    if (HAL_UART_GetState(&usart6_handle) != RESET) {
-        return UART_INITED;
-    }
+static uart_stats_t usart6_stats;
 
-    GPIO_InitTypeDef gpio_init_struct = {.Pull = GPIO_PULLUP,
-                                         .Speed = GPIO_SPEED_FREQ_HIGH,
-                                         .Mode = GPIO_MODE_AF_PP};
-    usart6_handle.Init.BaudRate = baud_rate;
+static const uart_port_t usart6_port = {
+    .huart = &usart6_handle,
+    .stats = &usart6_stats,
+    .clk_enr = &RCC->APB2ENR,
+    .clk_msk = RCC_APB2ENR_USART6EN,
 #if USART6_TX
-    usart6_handle.Init.Mode |= UART_MODE_TX;
-
-    CSP_GPIO_CLK_ENABLE(USART6_TX_PORT);
-    gpio_init_struct.Pin = USART6_TX_PIN;
-    gpio_init_struct.Alternate = USART6_TX_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(USART6_TX_PORT), &gpio_init_struct);
+    .tx = {CSP_GPIO_PORT(USART6_TX_PORT), USART6_TX_PIN, USART6_TX_AF},
 #endif /* USART6_TX */
-
 #if USART6_RX
-    usart6_handle.Init.Mode |= UART_MODE_RX;
-
-    CSP_GPIO_CLK_ENABLE(USART6_RX_PORT);
-    gpio_init_struct.Pin = USART6_RX_PIN;
-    gpio_init_struct.Alternate = USART6_RX_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(USART6_RX_PORT), &gpio_init_struct);
+    .rx = {CSP_GPIO_PORT(USART6_RX_PORT), USART6_RX_PIN, USART6_RX_AF},
 #endif /* USART6_RX */
-
 #if USART6_CTS
-    usart6_handle.Init.HwFlowCtl |= UART_HWCONTROL_CTS;
-
-    CSP_GPIO_CLK_ENABLE(USART6_CTS_PORT);
-    gpio_init_struct.Pin = USART6_CTS_PIN;
-    gpio_init_struct.Alternate = USART6_CTS_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(USART6_CTS_PORT), &gpio_init_struct);
-#endif /* USART6_USART6_CTS */
-
+    .cts = {CSP_GPIO_PORT(USART6_CTS_PORT), USART6_CTS_PIN, USART6_CTS_AF},
+#endif /* USART6_CTS */
 #if USART6_RTS
-    usart6_handle.Init.HwFlowCtl |= UART_HWCONTROL_RTS;
-
-    CSP_GPIO_CLK_ENABLE(USART6_RTS_PORT);
-    gpio_init_struct.Pin = USART6_RTS_PIN;
-    gpio_init_struct.Alternate = USART6_RTS_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(USART6_RTS_PORT), &gpio_init_struct);
+    .rts = {CSP_GPIO_PORT(USART6_RTS_PORT), USART6_RTS_PIN, USART6_RTS_AF},
 #endif /* USART6_RTS */
-
-    __HAL_RCC_USART6_CLK_ENABLE();
 #if USART6_IT_ENABLE
-    HAL_NVIC_EnableIRQ(USART6_IRQn);
-    HAL_NVIC_SetPriority(USART6_IRQn, USART6_IT_PRIORITY, USART6_IT_SUB);
+    .it = {USART6_IRQn, USART6_IT_PRIORITY, USART6_IT_SUB},
+    .it_enable = 1,
 #endif /* USART6_IT_ENABLE */
-
 #if USART6_RX_DMA
-    usart6_rx_fifo.head_ptr = 0;
-
-    usart6_rx_fifo.recv_buf = CSP_MALLOC(usart6_rx_fifo.buf_size);
-    if (usart6_rx_fifo.recv_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    usart6_rx_fifo.rx_fifo_buf = CSP_MALLOC(usart6_rx_fifo.fifo_size);
-    if (usart6_rx_fifo.rx_fifo_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    usart6_rx_fifo.rx_fifo = ring_fifo_init(
-        usart6_rx_fifo.rx_fifo_buf, usart6_rx_fifo.fifo_size, RF_TYPE_STREAM);
-    if (usart6_rx_fifo.rx_fifo == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    CSP_DMA_CLK_ENABLE(USART6_RX_DMA_NUMBER);
-    if (HAL_DMA_Init(&usart6_dmarx_handle) != HAL_OK) {
-        return UART_INIT_DMA_FAIL;
-    }
-
-    __HAL_LINKDMA(&usart6_handle, hdmarx, usart6_dmarx_handle);
-
-    HAL_NVIC_SetPriority(USART6_RX_DMA_IRQn, USART6_RX_DMA_IT_PRIORITY, USART6_RX_DMA_IT_SUB);
-    HAL_NVIC_EnableIRQ(USART6_RX_DMA_IRQn);
-
+    .rx_dma = {&usart6_dmarx_handle,
+               {USART6_RX_DMA_IRQn, USART6_RX_DMA_IT_PRIORITY,
+                USART6_RX_DMA_IT_SUB}},
+    .rx_fifo = &usart6_rx_fifo,
 #endif /* USART6_RX_DMA */
-
 #if USART6_TX_DMA
-    usart6_tx_buf.send_buf = CSP_MALLOC(usart6_tx_buf.buf_size);
-    if (usart6_tx_buf.send_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    CSP_DMA_CLK_ENABLE(USART6_TX_DMA_NUMBER);
-    if (HAL_DMA_Init(&usart6_dmatx_handle) != HAL_OK) {
-        return UART_INIT_DMA_FAIL;
-    }
-
-    __HAL_LINKDMA(&usart6_handle, hdmatx, usart6_dmatx_handle);
-
-    HAL_NVIC_SetPriority(USART6_TX_DMA_IRQn, USART6_TX_DMA_IT_PRIORITY, USART6_TX_DMA_IT_SUB);
-    HAL_NVIC_EnableIRQ(USART6_TX_DMA_IRQn);
-
+    .tx_dma = {&usart6_dmatx_handle,
+               {USART6_TX_DMA_IRQn, USART6_TX_DMA_IT_PRIORITY,
+                USART6_TX_DMA_IT_SUB}},
+    .tx_buf = &usart6_tx_buf,
 #endif /* USART6_TX_DMA */
+};
 
-    if (HAL_UART_Init(&usart6_handle) != HAL_OK) {
-        return UART_INIT_FAIL;
-    }
-    
-#if USART6_RX_DMA
-    __HAL_UART_ENABLE_IT(&usart6_handle, UART_IT_IDLE);
-    __HAL_UART_CLEAR_IDLEFLAG(&usart6_handle);
-
-    HAL_UART_Receive_DMA(&usart6_handle, usart6_rx_fifo.recv_buf,
-                         usart6_rx_fifo.buf_size);
-
-#if USE_HAL_UART_REGISTER_CALLBACKS
-    HAL_UART_RegisterCallback(&usart6_handle, HAL_UART_RX_HALFCOMPLETE_CB_ID,
-                              uart_dmarx_halfdone_callback);
-    HAL_UART_RegisterCallback(&usart6_handle, HAL_UART_RX_COMPLETE_CB_ID,
-                              uart_dmarx_done_callback);
-#endif /* USE_HAL_UART_REGISTER_CALLBACKS */
-#endif /* USART6_RX_DMA */
-    return UART_INIT_OK;
+/**
+ * @brief USART6 initialization
+ *
+ * @param baud_rate Baud rate.
+ * @return USART6 init status.
+ * @retval - 0: `UART_INIT_OK`:       Success.
+ * @retval - 1: `UART_INIT_FAIL`:     UART init failed.
+ * @retval - 2: `UART_INIT_DMA_FAIL`: UART DMA init failed.
+ * @retval - 3: `UART_INIT_MEM_FAIL`: UART buffer memory init failed (It will
+ *                                    dynamic allocate memory when using DMA).
+ * @retval - 4: `UART_INITED`:        This uart is inited.
+ */
+uint8_t usart6_init(uint32_t baud_rate) {
+    return uart_port_init(&usart6_port, baud_rate);
 }
 
 #if USART6_IT_ENABLE
@@ -1819,71 +1087,7 @@ void USART6_TX_DMA_IRQHandler(void) {
  * @retval - 3: `UART_NO_INIT`:         UART is not init.
  */
 uint8_t usart6_deinit(void) {
-    if (HAL_UART_GetState(&usart6_handle) == RESET) {
-        return UART_NO_INIT;
-    }
-
-    __HAL_RCC_USART6_CLK_DISABLE();
-
-#if USART6_TX
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(USART6_TX_PORT), USART6_TX_PIN);
-#endif /* USART6_TX */
-
-#if USART6_RX
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(USART6_RX_PORT), USART6_RX_PIN);
-#endif /* USART6_RX */
-
-#if USART6_CTS
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(USART6_CTS_PORT), USART6_CTS_PIN);
-#endif /* USART6_USART6_CTS */
-
-#if USART6_RTS
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(USART6_RTS_PORT), USART6_RTS_PIN);
-#endif /* USART6_RTS */
-
-#if USART6_IT_ENABLE
-    HAL_NVIC_DisableIRQ(USART6_IRQn);
-#endif /* USART6_IT_ENABLE */
-
-#if USART6_RX_DMA
-
-    HAL_DMA_Abort(&usart6_dmarx_handle);
-    CSP_FREE(usart6_rx_fifo.recv_buf);
-    CSP_FREE(usart6_rx_fifo.rx_fifo_buf);
-    ring_fifo_destroy(usart6_rx_fifo.rx_fifo);
-
-    if (HAL_DMA_DeInit(&usart6_dmarx_handle) != HAL_OK) {
-        return UART_DEINIT_DMA_FAIL;
-    }
-
-    HAL_NVIC_DisableIRQ(USART6_RX_DMA_IRQn);
-
-#if USE_HAL_UART_REGISTER_CALLBACKS
-    HAL_UART_UnRegisterCallback(&usart6_handle, HAL_UART_RX_HALFCOMPLETE_CB_ID);
-    HAL_UART_UnRegisterCallback(&usart6_handle, HAL_UART_RX_COMPLETE_CB_ID);
-#endif /* USE_HAL_UART_REGISTER_CALLBACKS */
-    usart6_handle.hdmarx = NULL;
-
-#endif /* USART6_RX_DMA */
-
-#if USART6_TX_DMA
-    HAL_DMA_Abort(&usart6_dmatx_handle);
-    CSP_FREE(usart6_tx_buf.send_buf);
-
-    if (HAL_DMA_DeInit(&usart6_dmatx_handle) != HAL_OK) {
-        return UART_DEINIT_DMA_FAIL;
-    }
-
-    HAL_NVIC_DisableIRQ(USART6_TX_DMA_IRQn);
-
-    usart6_handle.hdmatx = NULL;
-#endif /* USART6_TX_DMA */
-
-    if (HAL_UART_DeInit(&usart6_handle) != HAL_OK) {
-        return UART_DEINIT_FAIL;
-    }
-
-    return UART_DEINIT_OK;
+    return uart_port_deinit(&usart6_port);
 }
 
 #endif /* USART6_ENABLE */
@@ -1940,6 +1144,37 @@ static uart_tx_buf_t uart7_tx_buf = {.buf_size = UART7_TX_DMA_BUF_SIZE};
 
 #endif /* UART7_TX_DMA */
 
+static uart_stats_t uart7_stats;
+
+static const uart_port_t uart7_port = {
+    .huart = &uart7_handle,
+    .stats = &uart7_stats,
+    .clk_enr = &RCC->APB1ENR,
+    .clk_msk = RCC_APB1ENR_UART7EN,
+#if UART7_TX
+    .tx = {CSP_GPIO_PORT(UART7_TX_PORT), UART7_TX_PIN, UART7_TX_AF},
+#endif /* UART7_TX */
+#if UART7_RX
+    .rx = {CSP_GPIO_PORT(UART7_RX_PORT), UART7_RX_PIN, UART7_RX_AF},
+#endif /* UART7_RX */
+#if UART7_IT_ENABLE
+    .it = {UART7_IRQn, UART7_IT_PRIORITY, UART7_IT_SUB},
+    .it_enable = 1,
+#endif /* UART7_IT_ENABLE */
+#if UART7_RX_DMA
+    .rx_dma = {&uart7_dmarx_handle,
+               {UART7_RX_DMA_IRQn, UART7_RX_DMA_IT_PRIORITY,
+                UART7_RX_DMA_IT_SUB}},
+    .rx_fifo = &uart7_rx_fifo,
+#endif /* UART7_RX_DMA */
+#if UART7_TX_DMA
+    .tx_dma = {&uart7_dmatx_handle,
+               {UART7_TX_DMA_IRQn, UART7_TX_DMA_IT_PRIORITY,
+                UART7_TX_DMA_IT_SUB}},
+    .tx_buf = &uart7_tx_buf,
+#endif /* UART7_TX_DMA */
+};
+
 /**
  * @brief UART7 initialization
  *
@@ -1953,134 +1188,35 @@ static uart_tx_buf_t uart7_tx_buf = {.buf_size = UART7_TX_DMA_BUF_SIZE};
  * @retval - 4: `UART_INITED`:        This uart is inited.
  */
 uint8_t uart7_init(uint32_t baud_rate) {
-    if (HAL_UART_GetState(&uart7_handle) != RESET) {
-        return UART_INITED;
-    }
-
-    GPIO_InitTypeDef gpio_init_struct = {.Pull = GPIO_PULLUP,
-                                         .Speed = GPIO_SPEED_FREQ_HIGH,
-                                         .Mode = GPIO_MODE_AF_PP};
-    uart7_handle.Init.BaudRate = baud_rate;
-#if UART7_TX
-    uart7_handle.Init.Mode |= UART_MODE_TX;
-
-    CSP_GPIO_CLK_ENABLE(UART7_TX_PORT);
-    gpio_init_struct.Pin = UART7_TX_PIN;
-    gpio_init_struct.Alternate = UART7_TX_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(UART7_TX_PORT), &gpio_init_struct);
-#endif /* UART7_TX */
-
-#if UART7_RX
-    uart7_handle.Init.Mode |= UART_MODE_RX;
-
-    CSP_GPIO_CLK_ENABLE(UART7_RX_PORT);
-    gpio_init_struct.Pin = UART7_RX_PIN;
-    gpio_init_struct.Alternate = UART7_RX_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(UART7_RX_PORT), &gpio_init_struct);
-#endif /* UART7_RX */
+    return uart_port_init(&uart7_port, baud_rate);
+}
 
-    __HAL_RCC_UART7_CLK_ENABLE();
 #if UART7_IT_ENABLE
-    HAL_NVIC_EnableIRQ(UART7_IRQn);
-    HAL_NVIC_SetPriority(UART7_IRQn, UART7_IT_PRIORITY, UART7_IT_SUB);
-#endif /* UART7_IT_ENABLE */
-
-#if UART7_RX_DMA
-    uart7_rx_fifo.head_ptr = 0;
-
-    uart7_rx_fifo.recv_buf = CSP_MALLOC(uart7_rx_fifo.buf_size);
-    if (uart7_rx_fifo.recv_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
 
-    uart7_rx_fifo.rx_fifo_buf = CSP_MALLOC(uart7_rx_fifo.fifo_size);
-    if (uart7_rx_fifo.rx_fifo_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
+/**
+ * @brief UART7 ISR
+ *
+ */
+void UART7_IRQHandler(void) {
+    if (__HAL_UART_GET_FLAG(&uart7_handle, UART_FLAG_IDLE)) {
+        __HAL_UART_CLEAR_IDLEFLAG(&uart7_handle);
+        uart_dmarx_idle_callback(&uart7_handle);
     }
 
-    uart7_rx_fifo.rx_fifo = ring_fifo_init(
-        uart7_rx_fifo.rx_fifo_buf, uart7_rx_fifo.fifo_size, RF_TYPE_STREAM);
-    if (uart7_rx_fifo.rx_fifo == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
+    HAL_UART_IRQHandler(&uart7_handle);
+}
 
-    CSP_DMA_CLK_ENABLE(UART7_RX_DMA_NUMBER);
-    if (HAL_DMA_Init(&uart7_dmarx_handle) != HAL_OK) {
-        return UART_INIT_DMA_FAIL;
-    }
+#endif /* UART7_IT_ENABLE */
 
-    __HAL_LINKDMA(&uart7_handle, hdmarx, uart7_dmarx_handle);
+#if UART7_RX_DMA
 
-    HAL_NVIC_SetPriority(UART7_RX_DMA_IRQn, UART7_RX_DMA_IT_PRIORITY, UART7_RX_DMA_IT_SUB);
-    HAL_NVIC_EnableIRQ(UART7_RX_DMA_IRQn);
-
-#endif /* UART7_RX_DMA */
-
-#if UART7_TX_DMA
-    uart7_tx_buf.send_buf = CSP_MALLOC(uart7_tx_buf.buf_size);
-    if (uart7_tx_buf.send_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    CSP_DMA_CLK_ENABLE(UART7_TX_DMA_NUMBER);
-    if (HAL_DMA_Init(&uart7_dmatx_handle) != HAL_OK) {
-        return UART_INIT_DMA_FAIL;
-    }
-
-    __HAL_LINKDMA(&uart7_handle, hdmatx, uart7_dmatx_handle);
-
-    HAL_NVIC_SetPriority(UART7_TX_DMA_IRQn, UART7_TX_DMA_IT_PRIORITY, UART7_TX_DMA_IT_SUB);
-    HAL_NVIC_EnableIRQ(UART7_TX_DMA_IRQn);
-
-#endif /* UART7_TX_DMA */
-
-    if (HAL_UART_Init(&uart7_handle) != HAL_OK) {
-        return UART_INIT_FAIL;
-    }
-    
-#if UART7_RX_DMA
-    __HAL_UART_ENABLE_IT(&uart7_handle, UART_IT_IDLE);
-    __HAL_UART_CLEAR_IDLEFLAG(&uart7_handle);
-
-    HAL_UART_Receive_DMA(&uart7_handle, uart7_rx_fifo.recv_buf,
-                         uart7_rx_fifo.buf_size);
-
-#if USE_HAL_UART_REGISTER_CALLBACKS
-    HAL_UART_RegisterCallback(&uart7_handle, HAL_UART_RX_HALFCOMPLETE_CB_ID,
-                              uart_dmarx_halfdone_callback);
-    HAL_UART_RegisterCallback(&uart7_handle, HAL_UART_RX_COMPLETE_CB_ID,
-                              uart_dmarx_done_callback);
-#endif /* USE_HAL_UART_REGISTER_CALLBACKS */
-#endif /* UART7_RX_DMA */
-    return UART_INIT_OK;
-}
-
-#if UART7_IT_ENABLE
-
-/**
- * @brief UART7 ISR
- *
- */
-void UART7_IRQHandler(void) {
-    if (__HAL_UART_GET_FLAG(&uart7_handle, UART_FLAG_IDLE)) {
-        __HAL_UART_CLEAR_IDLEFLAG(&uart7_handle);
-        uart_dmarx_idle_callback(&uart7_handle);
-    }
-
-    HAL_UART_IRQHandler(&uart7_handle);
-}
-
-#endif /* UART7_IT_ENABLE */
-
-#if UART7_RX_DMA
-
-/**
- * @brief UART7 Rx DMA ISR
- *
- */
-void UART7_RX_DMA_IRQHandler(void) {
-    HAL_DMA_IRQHandler(&uart7_dmarx_handle);
-}
+/**
+ * @brief UART7 Rx DMA ISR
+ *
+ */
+void UART7_RX_DMA_IRQHandler(void) {
+    HAL_DMA_IRQHandler(&uart7_dmarx_handle);
+}
 
 #endif /* UART7_RX_DMA */
 
@@ -2106,63 +1242,7 @@ void UART7_TX_DMA_IRQHandler(void) {
  * @retval - 3: `UART_NO_INIT`:         UART is not init.
  */
 uint8_t uart7_deinit(void) {
-    if (HAL_UART_GetState(&uart7_handle) == RESET) {
-        return UART_NO_INIT;
-    }
-
-    __HAL_RCC_UART7_CLK_DISABLE();
-
-#if UART7_TX
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(UART7_TX_PORT), UART7_TX_PIN);
-#endif /* UART7_TX */
-
-#if UART7_RX
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(UART7_RX_PORT), UART7_RX_PIN);
-#endif /* UART7_RX */
-
-#if UART7_IT_ENABLE
-    HAL_NVIC_DisableIRQ(UART7_IRQn);
-#endif /* UART7_IT_ENABLE */
-
-#if UART7_RX_DMA
-
-    HAL_DMA_Abort(&uart7_dmarx_handle);
-    CSP_FREE(uart7_rx_fifo.recv_buf);
-    CSP_FREE(uart7_rx_fifo.rx_fifo_buf);
-    ring_fifo_destroy(uart7_rx_fifo.rx_fifo);
-
-    if (HAL_DMA_DeInit(&uart7_dmarx_handle) != HAL_OK) {
-        return UART_DEINIT_DMA_FAIL;
-    }
-
-    HAL_NVIC_DisableIRQ(UART7_RX_DMA_IRQn);
-
-#if USE_HAL_UART_REGISTER_CALLBACKS
-    HAL_UART_UnRegisterCallback(&uart7_handle, HAL_UART_RX_HALFCOMPLETE_CB_ID);
-    HAL_UART_UnRegisterCallback(&uart7_handle, HAL_UART_RX_COMPLETE_CB_ID);
-#endif /* USE_HAL_UART_REGISTER_CALLBACKS */
-    uart7_handle.hdmarx = NULL;
-
-#endif /* UART7_RX_DMA */
-
-#if UART7_TX_DMA
-    HAL_DMA_Abort(&uart7_dmatx_handle);
-    CSP_FREE(uart7_tx_buf.send_buf);
-
-    if (HAL_DMA_DeInit(&uart7_dmatx_handle) != HAL_OK) {
-        return UART_DEINIT_DMA_FAIL;
-    }
-
-    HAL_NVIC_DisableIRQ(UART7_TX_DMA_IRQn);
-
-    uart7_handle.hdmatx = NULL;
-#endif /* UART7_TX_DMA */
-
-    if (HAL_UART_DeInit(&uart7_handle) != HAL_OK) {
-        return UART_DEINIT_FAIL;
-    }
-
-    return UART_DEINIT_OK;
+    return uart_port_deinit(&uart7_port);
 }
 
 #endif /* UART7_ENABLE */
@@ -2219,6 +1299,37 @@ static uart_tx_buf_t uart8_tx_buf = {.buf_size = UART8_TX_DMA_BUF_SIZE};
 
 #endif /* UART8_TX_DMA */
 
+static uart_stats_t uart8_stats;
+
+static const uart_port_t uart8_port = {
+    .huart = &uart8_handle,
+    .stats = &uart8_stats,
+    .clk_enr = &RCC->APB1ENR,
+    .clk_msk = RCC_APB1ENR_UART8EN,
+#if UART8_TX
+    .tx = {CSP_GPIO_PORT(UART8_TX_PORT), UART8_TX_PIN, UART8_TX_AF},
+#endif /* UART8_TX */
+#if UART8_RX
+    .rx = {CSP_GPIO_PORT(UART8_RX_PORT), UART8_RX_PIN, UART8_RX_AF},
+#endif /* UART8_RX */
+#if UART8_IT_ENABLE
+    .it = {UART8_IRQn, UART8_IT_PRIORITY, UART8_IT_SUB},
+    .it_enable = 1,
+#endif /* UART8_IT_ENABLE */
+#if UART8_RX_DMA
+    .rx_dma = {&uart8_dmarx_handle,
+               {UART8_RX_DMA_IRQn, UART8_RX_DMA_IT_PRIORITY,
+                UART8_RX_DMA_IT_SUB}},
+    .rx_fifo = &uart8_rx_fifo,
+#endif /* UART8_RX_DMA */
+#if UART8_TX_DMA
+    .tx_dma = {&uart8_dmatx_handle,
+               {UART8_TX_DMA_IRQn, UART8_TX_DMA_IT_PRIORITY,
+                UART8_TX_DMA_IT_SUB}},
+    .tx_buf = &uart8_tx_buf,
+#endif /* UART8_TX_DMA */
+};
+
 /**
  * @brief UART8 initialization
  *
@@ -2232,106 +1343,7 @@ static uart_tx_buf_t uart8_tx_buf = {.buf_size = UART8_TX_DMA_BUF_SIZE};
  * @retval - 4: `UART_INITED`:        This uart is inited.
  */
 uint8_t uart8_init(uint32_t baud_rate) {
-    if (HAL_UART_GetState(&uart8_handle) != RESET) {
-        return UART_INITED;
-    }
-
-    GPIO_InitTypeDef gpio_init_struct = {.Pull = GPIO_PULLUP,
-                                         .Speed = GPIO_SPEED_FREQ_HIGH,
-                                         .Mode = GPIO_MODE_AF_PP};
-    uart8_handle.Init.BaudRate = baud_rate;
-#if UART8_TX
-    uart8_handle.Init.Mode |= UART_MODE_TX;
-
-    CSP_GPIO_CLK_ENABLE(UART8_TX_PORT);
-    gpio_init_struct.Pin = UART8_TX_PIN;
-    gpio_init_struct.Alternate = UART8_TX_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(UART8_TX_PORT), &gpio_init_struct);
-#endif /* UART8_TX */
-
-#if UART8_RX
-    uart8_handle.Init.Mode |= UART_MODE_RX;
-
-    CSP_GPIO_CLK_ENABLE(UART8_RX_PORT);
-    gpio_init_struct.Pin = UART8_RX_PIN;
-    gpio_init_struct.Alternate = UART8_RX_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(UART8_RX_PORT), &gpio_init_struct);
-#endif /* UART8_RX */
-
-    __HAL_RCC_UART8_CLK_ENABLE();
-#if UART8_IT_ENABLE
-    HAL_NVIC_EnableIRQ(UART8_IRQn);
-    HAL_NVIC_SetPriority(UART8_IRQn, UART8_IT_PRIORITY, UART8_IT_SUB);
-#endif /* UART8_IT_ENABLE */
-
-#if UART8_RX_DMA
-    uart8_rx_fifo.head_ptr = 0;
-
-    uart8_rx_fifo.recv_buf = CSP_MALLOC(uart8_rx_fifo.buf_size);
-    if (uart8_rx_fifo.recv_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    uart8_rx_fifo.rx_fifo_buf = CSP_MALLOC(uart8_rx_fifo.fifo_size);
-    if (uart8_rx_fifo.rx_fifo_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    uart8_rx_fifo.rx_fifo = ring_fifo_init(
-        uart8_rx_fifo.rx_fifo_buf, uart8_rx_fifo.fifo_size, RF_TYPE_STREAM);
-    if (uart8_rx_fifo.rx_fifo == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    CSP_DMA_CLK_ENABLE(UART8_RX_DMA_NUMBER);
-    if (HAL_DMA_Init(&uart8_dmarx_handle) != HAL_OK) {
-        return UART_INIT_DMA_FAIL;
-    }
-
-    __HAL_LINKDMA(&uart8_handle, hdmarx, uart8_dmarx_handle);
-
-    HAL_NVIC_SetPriority(UART8_RX_DMA_IRQn, UART8_RX_DMA_IT_PRIORITY, UART8_RX_DMA_IT_SUB);
-    HAL_NVIC_EnableIRQ(UART8_RX_DMA_IRQn);
-
-#endif /* UART8_RX_DMA */
-
-#if UART8_TX_DMA
-    uart8_tx_buf.send_buf = CSP_MALLOC(uart8_tx_buf.buf_size);
-    if (uart8_tx_buf.send_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    CSP_DMA_CLK_ENABLE(UART8_TX_DMA_NUMBER);
-    if (HAL_DMA_Init(&uart8_dmatx_handle) != HAL_OK) {
-        return UART_INIT_DMA_FAIL;
-    }
-
-    __HAL_LINKDMA(&uart8_handle, hdmatx, uart8_dmatx_handle);
-
-    HAL_NVIC_SetPriority(UART8_TX_DMA_IRQn, UART8_TX_DMA_IT_PRIORITY, UART8_TX_DMA_IT_SUB);
-    HAL_NVIC_EnableIRQ(UART8_TX_DMA_IRQn);
-
-#endif /* UART8_TX_DMA */
-
-    if (HAL_UART_Init(&uart8_handle) != HAL_OK) {
-        return UART_INIT_FAIL;
-    }
-    
-#if UART8_RX_DMA
-    __HAL_UART_ENABLE_IT(&uart8_handle, UART_IT_IDLE);
-    __HAL_UART_CLEAR_IDLEFLAG(&uart8_handle);
-
-    HAL_UART_Receive_DMA(&uart8_handle, uart8_rx_fifo.recv_buf,
-                         uart8_rx_fifo.buf_size);
-
-#if USE_HAL_UART_REGISTER_CALLBACKS
-    HAL_UART_RegisterCallback(&uart8_handle, HAL_UART_RX_HALFCOMPLETE_CB_ID,
-                              uart_dmarx_halfdone_callback);
-    HAL_UART_RegisterCallback(&uart8_handle, HAL_UART_RX_COMPLETE_CB_ID,
-                              uart_dmarx_done_callback);
-#endif /* USE_HAL_UART_REGISTER_CALLBACKS */
-#endif /* UART8_RX_DMA */
-    return UART_INIT_OK;
+    return uart_port_init(&uart8_port, baud_rate);
 }
 
 #if UART8_IT_ENABLE
@@ -2385,63 +1397,7 @@ void UART8_TX_DMA_IRQHandler(void) {
  * @retval - 3: `UART_NO_INIT`:         UART is not init.
  */
 uint8_t uart8_deinit(void) {
-    if (HAL_UART_GetState(&uart8_handle) == RESET) {
-        return UART_NO_INIT;
-    }
-
-    __HAL_RCC_UART8_CLK_DISABLE();
-
-#if UART8_TX
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(UART8_TX_PORT), UART8_TX_PIN);
-#endif /* UART8_TX */
-
-#if UART8_RX
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(UART8_RX_PORT), UART8_RX_PIN);
-#endif /* UART8_RX */
-
-#if UART8_IT_ENABLE
-    HAL_NVIC_DisableIRQ(UART8_IRQn);
-#endif /* UART8_IT_ENABLE */
-
-#if UART8_RX_DMA
-
-    HAL_DMA_Abort(&uart8_dmarx_handle);
-    CSP_FREE(uart8_rx_fifo.recv_buf);
-    CSP_FREE(uart8_rx_fifo.rx_fifo_buf);
-    ring_fifo_destroy(uart8_rx_fifo.rx_fifo);
-
-    if (HAL_DMA_DeInit(&uart8_dmarx_handle) != HAL_OK) {
-        return UART_DEINIT_DMA_FAIL;
-    }
-
-    HAL_NVIC_DisableIRQ(UART8_RX_DMA_IRQn);
-
-#if USE_HAL_UART_REGISTER_CALLBACKS
-    HAL_UART_UnRegisterCallback(&uart8_handle, HAL_UART_RX_HALFCOMPLETE_CB_ID);
-    HAL_UART_UnRegisterCallback(&uart8_handle, HAL_UART_RX_COMPLETE_CB_ID);
-#endif /* USE_HAL_UART_REGISTER_CALLBACKS */
-    uart8_handle.hdmarx = NULL;
-
-#endif /* UART8_RX_DMA */
-
-#if UART8_TX_DMA
-    HAL_DMA_Abort(&uart8_dmatx_handle);
-    CSP_FREE(uart8_tx_buf.send_buf);
-
-    if (HAL_DMA_DeInit(&uart8_dmatx_handle) != HAL_OK) {
-        return UART_DEINIT_DMA_FAIL;
-    }
-
-    HAL_NVIC_DisableIRQ(UART8_TX_DMA_IRQn);
-
-    uart8_handle.hdmatx = NULL;
-#endif /* UART8_TX_DMA */
-
-    if (HAL_UART_DeInit(&uart8_handle) != HAL_OK) {
-        return UART_DEINIT_FAIL;
-    }
-
-    return UART_DEINIT_OK;
+    return uart_port_deinit(&uart8_port);
 }
 
 #endif /* UART8_ENABLE */
@@ -2498,6 +1454,37 @@ static uart_tx_buf_t uart9_tx_buf = {.buf_size = UART9_TX_DMA_BUF_SIZE};
 
 #endif /* UART9_TX_DMA */
 
+static uart_stats_t uart9_stats;
+
+static const uart_port_t uart9_port = {
+    .huart = &uart9_handle,
+    .stats = &uart9_stats,
+    .clk_enr = &RCC->APB2ENR,
+    .clk_msk = RCC_APB2ENR_UART9EN,
+#if UART9_TX
+    .tx = {CSP_GPIO_PORT(UART9_TX_PORT), UART9_TX_PIN, UART9_TX_AF},
+#endif /* UART9_TX */
+#if UART9_RX
+    .rx = {CSP_GPIO_PORT(UART9_RX_PORT), UART9_RX_PIN, UART9_RX_AF},
+#endif /* UART9_RX */
+#if UART9_IT_ENABLE
+    .it = {UART9_IRQn, UART9_IT_PRIORITY, UART9_IT_SUB},
+    .it_enable = 1,
+#endif /* UART9_IT_ENABLE */
+#if UART9_RX_DMA
+    .rx_dma = {&uart9_dmarx_handle,
+               {UART9_RX_DMA_IRQn, UART9_RX_DMA_IT_PRIORITY,
+                UART9_RX_DMA_IT_SUB}},
+    .rx_fifo = &uart9_rx_fifo,
+#endif /* UART9_RX_DMA */
+#if UART9_TX_DMA
+    .tx_dma = {&uart9_dmatx_handle,
+               {UART9_TX_DMA_IRQn, UART9_TX_DMA_IT_PRIORITY,
+                UART9_TX_DMA_IT_SUB}},
+    .tx_buf = &uart9_tx_buf,
+#endif /* UART9_TX_DMA */
+};
+
 /**
  * @brief UART9 initialization
  *
@@ -2511,106 +1498,7 @@ static uart_tx_buf_t uart9_tx_buf = {.buf_size = UART9_TX_DMA_BUF_SIZE};
  * @retval - 4: `UART_INITED`:        This uart is inited.
  */
 uint8_t uart9_init(uint32_t baud_rate) {
-    if (HAL_UART_GetState(&uart9_handle) != RESET) {
-        return UART_INITED;
-    }
-
-    GPIO_InitTypeDef gpio_init_struct = {.Pull = GPIO_PULLUP,
-                                         .Speed = GPIO_SPEED_FREQ_HIGH,
-                                         .Mode = GPIO_MODE_AF_PP};
-    uart9_handle.Init.BaudRate = baud_rate;
-#if UART9_TX
-    uart9_handle.Init.Mode |= UART_MODE_TX;
-
-    CSP_GPIO_CLK_ENABLE(UART9_TX_PORT);
-    gpio_init_struct.Pin = UART9_TX_PIN;
-    gpio_init_struct.Alternate = UART9_TX_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(UART9_TX_PORT), &gpio_init_struct);
-#endif /* UART9_TX */
-
-#if UART9_RX
-    uart9_handle.Init.Mode |= UART_MODE_RX;
-
-    CSP_GPIO_CLK_ENABLE(UART9_RX_PORT);
-    gpio_init_struct.Pin = UART9_RX_PIN;
-    gpio_init_struct.Alternate = UART9_RX_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(UART9_RX_PORT), &gpio_init_struct);
-#endif /* UART9_RX */
-
-    __HAL_RCC_UART9_CLK_ENABLE();
-#if UART9_IT_ENABLE
-    HAL_NVIC_EnableIRQ(UART9_IRQn);
-    HAL_NVIC_SetPriority(UART9_IRQn, UART9_IT_PRIORITY, UART9_IT_SUB);
-#endif /* UART9_IT_ENABLE */
-
-#if UART9_RX_DMA
-    uart9_rx_fifo.head_ptr = 0;
-
-    uart9_rx_fifo.recv_buf = CSP_MALLOC(uart9_rx_fifo.buf_size);
-    if (uart9_rx_fifo.recv_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    uart9_rx_fifo.rx_fifo_buf = CSP_MALLOC(uart9_rx_fifo.fifo_size);
-    if (uart9_rx_fifo.rx_fifo_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    uart9_rx_fifo.rx_fifo = ring_fifo_init(
-        uart9_rx_fifo.rx_fifo_buf, uart9_rx_fifo.fifo_size, RF_TYPE_STREAM);
-    if (uart9_rx_fifo.rx_fifo == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    CSP_DMA_CLK_ENABLE(UART9_RX_DMA_NUMBER);
-    if (HAL_DMA_Init(&uart9_dmarx_handle) != HAL_OK) {
-        return UART_INIT_DMA_FAIL;
-    }
-
-    __HAL_LINKDMA(&uart9_handle, hdmarx, uart9_dmarx_handle);
-
-    HAL_NVIC_SetPriority(UART9_RX_DMA_IRQn, UART9_RX_DMA_IT_PRIORITY, UART9_RX_DMA_IT_SUB);
-    HAL_NVIC_EnableIRQ(UART9_RX_DMA_IRQn);
-
-#endif /* UART9_RX_DMA */
-
-#if UART9_TX_DMA
-    uart9_tx_buf.send_buf = CSP_MALLOC(uart9_tx_buf.buf_size);
-    if (uart9_tx_buf.send_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    CSP_DMA_CLK_ENABLE(UART9_TX_DMA_NUMBER);
-    if (HAL_DMA_Init(&uart9_dmatx_handle) != HAL_OK) {
-        return UART_INIT_DMA_FAIL;
-    }
-
-    __HAL_LINKDMA(&uart9_handle, hdmatx, uart9_dmatx_handle);
-
-    HAL_NVIC_SetPriority(UART9_TX_DMA_IRQn, UART9_TX_DMA_IT_PRIORITY, UART9_TX_DMA_IT_SUB);
-    HAL_NVIC_EnableIRQ(UART9_TX_DMA_IRQn);
-
-#endif /* UART9_TX_DMA */
-
-    if (HAL_UART_Init(&uart9_handle) != HAL_OK) {
-        return UART_INIT_FAIL;
-    }
-    
-#if UART9_RX_DMA
-    __HAL_UART_ENABLE_IT(&uart9_handle, UART_IT_IDLE);
-    __HAL_UART_CLEAR_IDLEFLAG(&uart9_handle);
-
-    HAL_UART_Receive_DMA(&uart9_handle, uart9_rx_fifo.recv_buf,
-                         uart9_rx_fifo.buf_size);
-
-#if USE_HAL_UART_REGISTER_CALLBACKS
-    HAL_UART_RegisterCallback(&uart9_handle, HAL_UART_RX_HALFCOMPLETE_CB_ID,
-                              uart_dmarx_halfdone_callback);
-    HAL_UART_RegisterCallback(&uart9_handle, HAL_UART_RX_COMPLETE_CB_ID,
-                              uart_dmarx_done_callback);
-#endif /* USE_HAL_UART_REGISTER_CALLBACKS */
-#endif /* UART9_RX_DMA */
-    return UART_INIT_OK;
+    return uart_port_init(&uart9_port, baud_rate);
 }
 
 #if UART9_IT_ENABLE
@@ -2664,76 +1552,20 @@ void UART9_TX_DMA_IRQHandler(void) {
  * @retval - 3: `UART_NO_INIT`:         UART is not init.
  */
 uint8_t uart9_deinit(void) {
-    if (HAL_UART_GetState(&uart9_handle) == RESET) {
-        return UART_NO_INIT;
-    }
+    return uart_port_deinit(&uart9_port);
+}
 
-    __HAL_RCC_UART9_CLK_DISABLE();
+#endif /* UART9_ENABLE */
 
-#if UART9_TX
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(UART9_TX_PORT), UART9_TX_PIN);
-#endif /* UART9_TX */
+/**
+ * @}
+ */ 
 
-#if UART9_RX
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(UART9_RX_PORT), UART9_RX_PIN);
-#endif /* UART9_RX */
 
-#if UART9_IT_ENABLE
-    HAL_NVIC_DisableIRQ(UART9_IRQn);
-#endif /* UART9_IT_ENABLE */
-
-#if UART9_RX_DMA
-
-    HAL_DMA_Abort(&uart9_dmarx_handle);
-    CSP_FREE(uart9_rx_fifo.recv_buf);
-    CSP_FREE(uart9_rx_fifo.rx_fifo_buf);
-    ring_fifo_destroy(uart9_rx_fifo.rx_fifo);
-
-    if (HAL_DMA_DeInit(&uart9_dmarx_handle) != HAL_OK) {
-        return UART_DEINIT_DMA_FAIL;
-    }
-
-    HAL_NVIC_DisableIRQ(UART9_RX_DMA_IRQn);
-
-#if USE_HAL_UART_REGISTER_CALLBACKS
-    HAL_UART_UnRegisterCallback(&uart9_handle, HAL_UART_RX_HALFCOMPLETE_CB_ID);
-    HAL_UART_UnRegisterCallback(&uart9_handle, HAL_UART_RX_COMPLETE_CB_ID);
-#endif /* USE_HAL_UART_REGISTER_CALLBACKS */
-    uart9_handle.hdmarx = NULL;
-
-#endif /* UART9_RX_DMA */
-
-#if UART9_TX_DMA
-    HAL_DMA_Abort(&uart9_dmatx_handle);
-    CSP_FREE(uart9_tx_buf.send_buf);
-
-    if (HAL_DMA_DeInit(&uart9_dmatx_handle) != HAL_OK) {
-        return UART_DEINIT_DMA_FAIL;
-    }
-
-    HAL_NVIC_DisableIRQ(UART9_TX_DMA_IRQn);
-
-    uart9_handle.hdmatx = NULL;
-#endif /* UART9_TX_DMA */
-
-    if (HAL_UART_DeInit(&uart9_handle) != HAL_OK) {
-        return UART_DEINIT_FAIL;
-    }
-
-    return UART_DEINIT_OK;
-}
-
-#endif /* UART9_ENABLE */
-
-/**
- * @}
- */ 
-
-
-/*****************************************************************************
- * @defgroup UART10 Functions
- * @{
- */
+/*****************************************************************************
+ * @defgroup UART10 Functions
+ * @{
+ */
 
 #if UART10_ENABLE
 
@@ -2777,6 +1609,37 @@ static uart_tx_buf_t uart10_tx_buf = {.buf_size = UART10_TX_DMA_BUF_SIZE};
 
 #endif /* UART10_TX_DMA */
 
+static uart_stats_t uart10_stats;
+
+static const uart_port_t uart10_port = {
+    .huart = &uart10_handle,
+    .stats = &uart10_stats,
+    .clk_enr = &RCC->APB2ENR,
+    .clk_msk = RCC_APB2ENR_UART10EN,
+#if UART10_TX
+    .tx = {CSP_GPIO_PORT(UART10_TX_PORT), UART10_TX_PIN, UART10_TX_AF},
+#endif /* UART10_TX */
+#if UART10_RX
+    .rx = {CSP_GPIO_PORT(UART10_RX_PORT), UART10_RX_PIN, UART10_RX_AF},
+#endif /* UART10_RX */
+#if UART10_IT_ENABLE
+    .it = {UART10_IRQn, UART10_IT_PRIORITY, UART10_IT_SUB},
+    .it_enable = 1,
+#endif /* UART10_IT_ENABLE */
+#if UART10_RX_DMA
+    .rx_dma = {&uart10_dmarx_handle,
+               {UART10_RX_DMA_IRQn, UART10_RX_DMA_IT_PRIORITY,
+                UART10_RX_DMA_IT_SUB}},
+    .rx_fifo = &uart10_rx_fifo,
+#endif /* UART10_RX_DMA */
+#if UART10_TX_DMA
+    .tx_dma = {&uart10_dmatx_handle,
+               {UART10_TX_DMA_IRQn, UART10_TX_DMA_IT_PRIORITY,
+                UART10_TX_DMA_IT_SUB}},
+    .tx_buf = &uart10_tx_buf,
+#endif /* UART10_TX_DMA */
+};
+
 /**
  * @brief UART10 initialization
  *
@@ -2790,106 +1653,7 @@ static uart_tx_buf_t uart10_tx_buf = {.buf_size = UART10_TX_DMA_BUF_SIZE};
  * @retval - 4: `UART_INITED`:        This uart is inited.
  */
 uint8_t uart10_init(uint32_t baud_rate) {
-    if (HAL_UART_GetState(&uart10_handle) != RESET) {
-        return UART_INITED;
-    }
-
-    GPIO_InitTypeDef gpio_init_struct = {.Pull = GPIO_PULLUP,
-                                         .Speed = GPIO_SPEED_FREQ_HIGH,
-                                         .Mode = GPIO_MODE_AF_PP};
-    uart10_handle.Init.BaudRate = baud_rate;
-#if UART10_TX
-    uart10_handle.Init.Mode |= UART_MODE_TX;
-
-    CSP_GPIO_CLK_ENABLE(UART10_TX_PORT);
-    gpio_init_struct.Pin = UART10_TX_PIN;
-    gpio_init_struct.Alternate = UART10_TX_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(UART10_TX_PORT), &gpio_init_struct);
-#endif /* UART10_TX */
-
-#if UART10_RX
-    uart10_handle.Init.Mode |= UART_MODE_RX;
-
-    CSP_GPIO_CLK_ENABLE(UART10_RX_PORT);
-    gpio_init_struct.Pin = UART10_RX_PIN;
-    gpio_init_struct.Alternate = UART10_RX_AF;
-    HAL_GPIO_Init(CSP_GPIO_PORT(UART10_RX_PORT), &gpio_init_struct);
-#endif /* UART10_RX */
-
-    __HAL_RCC_UART10_CLK_ENABLE();
-#if UART10_IT_ENABLE
-    HAL_NVIC_EnableIRQ(UART10_IRQn);
-    HAL_NVIC_SetPriority(UART10_IRQn, UART10_IT_PRIORITY, UART10_IT_SUB);
-#endif /* UART10_IT_ENABLE */
-
-#if UART10_RX_DMA
-    uart10_rx_fifo.head_ptr = 0;
-
-    uart10_rx_fifo.recv_buf = CSP_MALLOC(uart10_rx_fifo.buf_size);
-    if (uart10_rx_fifo.recv_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    uart10_rx_fifo.rx_fifo_buf = CSP_MALLOC(uart10_rx_fifo.fifo_size);
-    if (uart10_rx_fifo.rx_fifo_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    uart10_rx_fifo.rx_fifo = ring_fifo_init(
-        uart10_rx_fifo.rx_fifo_buf, uart10_rx_fifo.fifo_size, RF_TYPE_STREAM);
-    if (uart10_rx_fifo.rx_fifo == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    CSP_DMA_CLK_ENABLE(UART10_RX_DMA_NUMBER);
-    if (HAL_DMA_Init(&uart10_dmarx_handle) != HAL_OK) {
-        return UART_INIT_DMA_FAIL;
-    }
-
-    __HAL_LINKDMA(&uart10_handle, hdmarx, uart10_dmarx_handle);
-
-    HAL_NVIC_SetPriority(UART10_RX_DMA_IRQn, UART10_RX_DMA_IT_PRIORITY, UART10_RX_DMA_IT_SUB);
-    HAL_NVIC_EnableIRQ(UART10_RX_DMA_IRQn);
-
-#endif /* UART10_RX_DMA */
-
-#if UART10_TX_DMA
-    uart10_tx_buf.send_buf = CSP_MALLOC(uart10_tx_buf.buf_size);
-    if (uart10_tx_buf.send_buf == NULL) {
-        return UART_INIT_MEM_FAIL;
-    }
-
-    CSP_DMA_CLK_ENABLE(UART10_TX_DMA_NUMBER);
-    if (HAL_DMA_Init(&uart10_dmatx_handle) != HAL_OK) {
-        return UART_INIT_DMA_FAIL;
-    }
-
-    __HAL_LINKDMA(&uart10_handle, hdmatx, uart10_dmatx_handle);
-
-    HAL_NVIC_SetPriority(UART10_TX_DMA_IRQn, UART10_TX_DMA_IT_PRIORITY, UART10_TX_DMA_IT_SUB);
-    HAL_NVIC_EnableIRQ(UART10_TX_DMA_IRQn);
-
-#endif /* UART10_TX_DMA */
-
-    if (HAL_UART_Init(&uart10_handle) != HAL_OK) {
-        return UART_INIT_FAIL;
-    }
-    
-#if UART10_RX_DMA
-    __HAL_UART_ENABLE_IT(&uart10_handle, UART_IT_IDLE);
-    __HAL_UART_CLEAR_IDLEFLAG(&uart10_handle);
-
-    HAL_UART_Receive_DMA(&uart10_handle, uart10_rx_fifo.recv_buf,
-                         uart10_rx_fifo.buf_size);
-
-#if USE_HAL_UART_REGISTER_CALLBACKS
-    HAL_UART_RegisterCallback(&uart10_handle, HAL_UART_RX_HALFCOMPLETE_CB_ID,
-                              uart_dmarx_halfdone_callback);
-    HAL_UART_RegisterCallback(&uart10_handle, HAL_UART_RX_COMPLETE_CB_ID,
-                              uart_dmarx_done_callback);
-#endif /* USE_HAL_UART_REGISTER_CALLBACKS */
-#endif /* UART10_RX_DMA */
-    return UART_INIT_OK;
+    return uart_port_init(&uart10_port, baud_rate);
 }
 
 #if UART10_IT_ENABLE
@@ -2943,70 +1707,315 @@ void UART10_TX_DMA_IRQHandler(void) {
  * @retval - 3: `UART_NO_INIT`:         UART is not init.
  */
 uint8_t uart10_deinit(void) {
-    if (HAL_UART_GetState(&uart10_handle) == RESET) {
-        return UART_NO_INIT;
+    return uart_port_deinit(&uart10_port);
+}
+
+#endif /* UART10_ENABLE */
+
+/**
+ * @}
+ */ 
+
+/*****************************************************************************
+ * @defgroup UART port functions.
+ * @{
+ */
+
+/* The UART instances are 0x400 apart on APB1 and APB2, bits [14:10] of the
+   base address are different for all of them (USART2~UART5: 17~20,
+   UART7/8: 30/31, USART1/6, UART9/10: 4~7), so they index the table. */
+#define UART_PORT_INDEX(base) ((((uintptr_t)(base)) >> 10) & 0x1FU)
+
+static const uart_port_t *const uart_port_table[32] = {
+#if USART1_ENABLE
+    [UART_PORT_INDEX(USART1_BASE)] = &usart1_port,
+#endif /* USART1_ENABLE */
+#if USART2_ENABLE
+    [UART_PORT_INDEX(USART2_BASE)] = &usart2_port,
+#endif /* USART2_ENABLE */
+#if USART3_ENABLE
+    [UART_PORT_INDEX(USART3_BASE)] = &usart3_port,
+#endif /* USART3_ENABLE */
+#if UART4_ENABLE
+    [UART_PORT_INDEX(UART4_BASE)] = &uart4_port,
+#endif /* UART4_ENABLE */
+#if UART5_ENABLE
+    [UART_PORT_INDEX(UART5_BASE)] = &uart5_port,
+#endif /* UART5_ENABLE */
+#if USART6_ENABLE
+    [UART_PORT_INDEX(USART6_BASE)] = &usart6_port,
+#endif /* USART6_ENABLE */
+#if UART7_ENABLE
+    [UART_PORT_INDEX(UART7_BASE)] = &uart7_port,
+#endif /* UART7_ENABLE */
+#if UART8_ENABLE
+    [UART_PORT_INDEX(UART8_BASE)] = &uart8_port,
+#endif /* UART8_ENABLE */
+#if UART9_ENABLE
+    [UART_PORT_INDEX(UART9_BASE)] = &uart9_port,
+#endif /* UART9_ENABLE */
+#if UART10_ENABLE
+    [UART_PORT_INDEX(UART10_BASE)] = &uart10_port,
+#endif /* UART10_ENABLE */
+};
+
+/**
+ * @brief Identify the UART port by handle.
+ *
+ * @param huart The handle of UART.
+ * @return The port descriptor, NULL if the UART is not enabled.
+ */
+static inline const uart_port_t *uart_port_identify(UART_HandleTypeDef *huart) {
+    const uart_port_t *port =
+        uart_port_table[UART_PORT_INDEX(huart->Instance)];
+
+    /* Other peripherals have the same index, check the instance. */
+    if ((port == NULL) || (port->huart->Instance != huart->Instance)) {
+        return NULL;
     }
 
-    __HAL_RCC_UART10_CLK_DISABLE();
+    return port;
+}
 
-#if UART10_TX
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(UART10_TX_PORT), UART10_TX_PIN);
-#endif /* UART10_TX */
+/**
+ * @brief Get the clock of UART.
+ *
+ * @param port The port descriptor of UART.
+ * @return PCLK2 for the UARTs on APB2, PCLK1 for the others.
+ */
+static inline uint32_t uart_port_pclk(const uart_port_t *port) {
+    return (port->clk_enr == &RCC->APB2ENR) ? HAL_RCC_GetPCLK2Freq()
+                                            : HAL_RCC_GetPCLK1Freq();
+}
 
-#if UART10_RX
-    HAL_GPIO_DeInit(CSP_GPIO_PORT(UART10_RX_PORT), UART10_RX_PIN);
-#endif /* UART10_RX */
+/**
+ * @brief Enable the clock of peripheral.
+ *
+ * @param enr RCC clock enable register.
+ * @param msk Clock enable bit.
+ */
+static inline void uart_port_clk_enable(volatile uint32_t *enr, uint32_t msk) {
+    __IO uint32_t tmpreg;
 
-#if UART10_IT_ENABLE
-    HAL_NVIC_DisableIRQ(UART10_IRQn);
-#endif /* UART10_IT_ENABLE */
+    SET_BIT(*enr, msk);
+    /* Delay after an RCC peripheral clock enabling. */
+    tmpreg = READ_BIT(*enr, msk);
+    UNUSED(tmpreg);
+}
 
-#if UART10_RX_DMA
+/**
+ * @brief Initialize the pin of UART.
+ *
+ * @param pin The pin of UART.
+ * @param gpio_init_struct GPIO init struct with the common settings.
+ */
+static void uart_port_pin_init(const uart_pin_t *pin,
+                               GPIO_InitTypeDef *gpio_init_struct) {
+    /* The GPIO ports are 0x400 apart, in the order of the clock enable bits. */
+    uart_port_clk_enable(&RCC->AHB1ENR,
+                         RCC_AHB1ENR_GPIOAEN
+                             << (((uintptr_t)pin->port - GPIOA_BASE) >> 10));
 
-    HAL_DMA_Abort(&uart10_dmarx_handle);
-    CSP_FREE(uart10_rx_fifo.recv_buf);
-    CSP_FREE(uart10_rx_fifo.rx_fifo_buf);
-    ring_fifo_destroy(uart10_rx_fifo.rx_fifo);
+    gpio_init_struct->Pin = pin->pin;
+    gpio_init_struct->Alternate = pin->af;
+    HAL_GPIO_Init(pin->port, gpio_init_struct);
+}
 
-    if (HAL_DMA_DeInit(&uart10_dmarx_handle) != HAL_OK) {
-        return UART_DEINIT_DMA_FAIL;
+/**
+ * @brief Initialize the DMA of UART.
+ *
+ * @param dma The DMA of UART.
+ * @return Initialize result:
+ * @retval - 0: Success.
+ * @retval - 1: DMA init failed.
+ */
+static uint8_t uart_port_dma_init(const uart_dma_t *dma) {
+    uart_port_clk_enable(&RCC->AHB1ENR,
+                         ((uintptr_t)dma->hdma->Instance >= DMA2_Stream0_BASE)
+                             ? RCC_AHB1ENR_DMA2EN
+                             : RCC_AHB1ENR_DMA1EN);
+    if (HAL_DMA_Init(dma->hdma) != HAL_OK) {
+        return 1;
     }
 
-    HAL_NVIC_DisableIRQ(UART10_RX_DMA_IRQn);
+    HAL_NVIC_SetPriority(dma->irq.irqn, dma->irq.priority, dma->irq.sub);
+    HAL_NVIC_EnableIRQ(dma->irq.irqn);
+    return 0;
+}
+
+/**
+ * @brief UART initialization by the port descriptor.
+ *
+ * @param port The port descriptor of UART.
+ * @param baud_rate Baud rate.
+ * @return UART init status, see `usart1_init`.
+ */
+static uint8_t uart_port_init(const uart_port_t *port, uint32_t baud_rate) {
+    UART_HandleTypeDef *huart = port->huart;
+
+    if (HAL_UART_GetState(huart) != RESET) {
+        return UART_INITED;
+    }
+
+    GPIO_InitTypeDef gpio_init_struct = {.Pull = GPIO_PULLUP,
+                                         .Speed = GPIO_SPEED_FREQ_HIGH,
+                                         .Mode = GPIO_MODE_AF_PP};
+    huart->Init.BaudRate = baud_rate;
+
+    if (port->tx.port != NULL) {
+        huart->Init.Mode |= UART_MODE_TX;
+        uart_port_pin_init(&port->tx, &gpio_init_struct);
+    }
+
+    if (port->rx.port != NULL) {
+        huart->Init.Mode |= UART_MODE_RX;
+        uart_port_pin_init(&port->rx, &gpio_init_struct);
+    }
+
+    if (port->cts.port != NULL) {
+        huart->Init.HwFlowCtl |= UART_HWCONTROL_CTS;
+        uart_port_pin_init(&port->cts, &gpio_init_struct);
+    }
+
+    if (port->rts.port != NULL) {
+        huart->Init.HwFlowCtl |= UART_HWCONTROL_RTS;
+        uart_port_pin_init(&port->rts, &gpio_init_struct);
+    }
+
+    uart_port_clk_enable(port->clk_enr, port->clk_msk);
+    if (port->it_enable) {
+        HAL_NVIC_EnableIRQ(port->it.irqn);
+        HAL_NVIC_SetPriority(port->it.irqn, port->it.priority, port->it.sub);
+    }
+
+    uart_rx_fifo_t *uart_rx_fifo = port->rx_fifo;
+    if (uart_rx_fifo != NULL) {
+        uart_rx_fifo->head_ptr = 0;
+        uart_rx_fifo->skip_len = 0;
+
+        uart_rx_fifo->recv_buf = CSP_MALLOC(uart_rx_fifo->buf_size);
+        if (uart_rx_fifo->recv_buf == NULL) {
+            return UART_INIT_MEM_FAIL;
+        }
+
+        if (uart_dmarx_fifo_init(uart_rx_fifo) != 0) {
+            return UART_INIT_MEM_FAIL;
+        }
+
+        if (uart_port_dma_init(&port->rx_dma) != 0) {
+            return UART_INIT_DMA_FAIL;
+        }
+
+        __HAL_LINKDMA(huart, hdmarx, *port->rx_dma.hdma);
+    }
+
+    uart_tx_buf_t *uart_tx_buf = port->tx_buf;
+    if (uart_tx_buf != NULL) {
+        uart_tx_buf->send_buf = CSP_MALLOC(uart_tx_buf->buf_size);
+        if (uart_tx_buf->send_buf == NULL) {
+            return UART_INIT_MEM_FAIL;
+        }
+
+        if (uart_port_dma_init(&port->tx_dma) != 0) {
+            return UART_INIT_DMA_FAIL;
+        }
+
+        __HAL_LINKDMA(huart, hdmatx, *port->tx_dma.hdma);
+    }
+
+    if (HAL_UART_Init(huart) != HAL_OK) {
+        return UART_INIT_FAIL;
+    }
+
+    if (uart_rx_fifo != NULL) {
+        __HAL_UART_ENABLE_IT(huart, UART_IT_IDLE);
+        __HAL_UART_CLEAR_IDLEFLAG(huart);
+
+        HAL_UART_Receive_DMA(huart, uart_rx_fifo->recv_buf,
+                             uart_rx_fifo->buf_size);
 
 #if USE_HAL_UART_REGISTER_CALLBACKS
-    HAL_UART_UnRegisterCallback(&uart10_handle, HAL_UART_RX_HALFCOMPLETE_CB_ID);
-    HAL_UART_UnRegisterCallback(&uart10_handle, HAL_UART_RX_COMPLETE_CB_ID);
+        HAL_UART_RegisterCallback(huart, HAL_UART_RX_HALFCOMPLETE_CB_ID,
+                                  uart_dmarx_halfdone_callback);
+        HAL_UART_RegisterCallback(huart, HAL_UART_RX_COMPLETE_CB_ID,
+                                  uart_dmarx_done_callback);
 #endif /* USE_HAL_UART_REGISTER_CALLBACKS */
-    uart10_handle.hdmarx = NULL;
+    }
 
-#endif /* UART10_RX_DMA */
+    return UART_INIT_OK;
+}
 
-#if UART10_TX_DMA
-    HAL_DMA_Abort(&uart10_dmatx_handle);
-    CSP_FREE(uart10_tx_buf.send_buf);
+/**
+ * @brief UART deinitialization by the port descriptor.
+ *
+ * @param port The port descriptor of UART.
+ * @return UART deinit status, see `usart1_deinit`.
+ */
+static uint8_t uart_port_deinit(const uart_port_t *port) {
+    UART_HandleTypeDef *huart = port->huart;
 
-    if (HAL_DMA_DeInit(&uart10_dmatx_handle) != HAL_OK) {
-        return UART_DEINIT_DMA_FAIL;
+    if (HAL_UART_GetState(huart) == RESET) {
+        return UART_NO_INIT;
     }
 
-    HAL_NVIC_DisableIRQ(UART10_TX_DMA_IRQn);
+    CLEAR_BIT(*port->clk_enr, port->clk_msk);
 
-    uart10_handle.hdmatx = NULL;
-#endif /* UART10_TX_DMA */
+    const uart_pin_t *pins[] = {&port->tx, &port->rx, &port->cts, &port->rts};
+    for (uint32_t i = 0; i < sizeof(pins) / sizeof(pins[0]); ++i) {
+        if (pins[i]->port != NULL) {
+            HAL_GPIO_DeInit(pins[i]->port, pins[i]->pin);
+        }
+    }
+
+    if (port->it_enable) {
+        HAL_NVIC_DisableIRQ(port->it.irqn);
+    }
+
+    uart_rx_fifo_t *uart_rx_fifo = port->rx_fifo;
+    if (uart_rx_fifo != NULL) {
+        HAL_DMA_Abort(port->rx_dma.hdma);
+        CSP_FREE(uart_rx_fifo->recv_buf);
+        CSP_FREE(uart_rx_fifo->rx_fifo_buf);
+        ring_fifo_destroy(uart_rx_fifo->rx_fifo);
+
+        if (HAL_DMA_DeInit(port->rx_dma.hdma) != HAL_OK) {
+            return UART_DEINIT_DMA_FAIL;
+        }
+
+        HAL_NVIC_DisableIRQ(port->rx_dma.irq.irqn);
+
+#if USE_HAL_UART_REGISTER_CALLBACKS
+        HAL_UART_UnRegisterCallback(huart, HAL_UART_RX_HALFCOMPLETE_CB_ID);
+        HAL_UART_UnRegisterCallback(huart, HAL_UART_RX_COMPLETE_CB_ID);
+#endif /* USE_HAL_UART_REGISTER_CALLBACKS */
+        huart->hdmarx = NULL;
+    }
+
+    uart_tx_buf_t *uart_tx_buf = port->tx_buf;
+    if (uart_tx_buf != NULL) {
+        HAL_DMA_Abort(port->tx_dma.hdma);
+        CSP_FREE(uart_tx_buf->send_buf);
+        uart_dmatx_reset(huart);
+
+        if (HAL_DMA_DeInit(port->tx_dma.hdma) != HAL_OK) {
+            return UART_DEINIT_DMA_FAIL;
+        }
 
-    if (HAL_UART_DeInit(&uart10_handle) != HAL_OK) {
+        HAL_NVIC_DisableIRQ(port->tx_dma.irq.irqn);
+
+        huart->hdmatx = NULL;
+    }
+
+    if (HAL_UART_DeInit(huart) != HAL_OK) {
         return UART_DEINIT_FAIL;
     }
 
     return UART_DEINIT_OK;
 }
 
-#endif /* UART10_ENABLE */
-
 /**
  * @}
- */ 
+ */
 
 /*****************************************************************************
  * @defgroup Public UART functions.
@@ -3086,6 +2095,154 @@ int uart_scanf(UART_HandleTypeDef *huart, const char *__format, ...) {
     return res;
 }
 
+/**
+ * @brief Get the link statistics of UART.
+ *
+ * @param huart The handle of UART.
+ * @param[out] stats The statistics.
+ * @return Get result:
+ * @retval - 0: Success.
+ * @retval - 1: This UART is not enabled.
+ * @note The counters are updated in the interrupts, each of them is read
+ *       atomically but they may not be taken at the same moment.
+ */
+uint8_t uart_get_stats(UART_HandleTypeDef *huart, uart_stats_t *stats) {
+    const uart_port_t *port = uart_port_identify(huart);
+    if ((port == NULL) || (stats == NULL)) {
+        return 1;
+    }
+
+    *stats = *port->stats;
+    if (port->rx_fifo != NULL) {
+        stats->rx_dropped = ring_fifo_dropped(port->rx_fifo->rx_fifo);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Clear the link statistics of UART.
+ *
+ * @param huart The handle of UART.
+ * @note `rx_dropped` is counted by the receive fifo and not cleared.
+ */
+void uart_clear_stats(UART_HandleTypeDef *huart) {
+    const uart_port_t *port = uart_port_identify(huart);
+    if (port == NULL) {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memset(port->stats, 0, sizeof(uart_stats_t));
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Check whether the UART can run at the baud rate.
+ *
+ * @param huart The handle of UART.
+ * @param baud_rate Baud rate.
+ * @return Check result:
+ * @retval - 0: `UART_BAUD_OK`:   Supported.
+ * @retval - 2: `UART_BAUD_FAIL`: This UART is not enabled, the baud rate is
+ *                                higher than PCLK / 8, or the error is more
+ *                                than `UART_BAUD_MAX_ERROR`.
+ * @note PCLK is divided by an integer number of 1/16 (OVER16) or 1/8 (OVER8)
+ *       bit times, so the actual baud rate is PCLK / round(PCLK / baud).
+ */
+uint8_t uart_check_baud_rate(UART_HandleTypeDef *huart, uint32_t baud_rate) {
+    const uart_port_t *port = uart_port_identify(huart);
+    if ((port == NULL) || (baud_rate == 0)) {
+        return UART_BAUD_FAIL;
+    }
+
+    uint32_t pclk = uart_port_pclk(port);
+    uint32_t div = (pclk + baud_rate / 2U) / baud_rate;
+    if (div < 8U) {
+        return UART_BAUD_FAIL;
+    }
+
+    uint32_t actual = pclk / div;
+    uint32_t error =
+        (actual > baud_rate) ? (actual - baud_rate) : (baud_rate - actual);
+    if ((uint64_t)error * 1000U > (uint64_t)baud_rate * UART_BAUD_MAX_ERROR) {
+        return UART_BAUD_FAIL;
+    }
+
+    return UART_BAUD_OK;
+}
+
+/**
+ * @brief Change the baud rate of UART in place.
+ *
+ * @param huart The handle of UART.
+ * @param baud_rate Baud rate.
+ * @return Change result:
+ * @retval - 0: `UART_BAUD_OK`:   Success.
+ * @retval - 1: `UART_BAUD_BUSY`: Transmitting, try again later.
+ * @retval - 2: `UART_BAUD_FAIL`: UART is not init, or the baud rate is not
+ *                                supported, see `uart_check_baud_rate`.
+ * @note The data in the receive fifo and the transmit buffer is kept. The
+ *       receive DMA is restarted from the start of `recv_buf`, the bytes
+ *       arriving during the change are lost. OVER8 is used when the baud rate
+ *       is higher than PCLK / 16.
+ * @note Call it in task context. The data received before the change is
+ *       pushed into the fifo without `uart_dmarx_notify_callback`, poll the
+ *       fifo after it returns.
+ */
+uint8_t uart_set_baud_rate(UART_HandleTypeDef *huart, uint32_t baud_rate) {
+    if (uart_check_baud_rate(huart, baud_rate) != UART_BAUD_OK) {
+        return UART_BAUD_FAIL;
+    }
+
+    const uart_port_t *port = uart_port_identify(huart);
+    if (huart->gState == HAL_UART_STATE_RESET) {
+        return UART_BAUD_FAIL;
+    }
+
+    /* The last byte on the line must finish at the old baud rate. */
+    if ((huart->gState != HAL_UART_STATE_READY) ||
+        (__HAL_UART_GET_FLAG(huart, UART_FLAG_TC) == RESET)) {
+        return UART_BAUD_BUSY;
+    }
+
+    /* The UART and DMA interrupts also move the receive pointer. */
+    uart_rx_fifo_t *uart_rx_fifo = port->rx_fifo;
+    if (port->it_enable) {
+        HAL_NVIC_DisableIRQ(port->it.irqn);
+    }
+    if (uart_rx_fifo != NULL) {
+        HAL_NVIC_DisableIRQ(port->rx_dma.irq.irqn);
+        HAL_UART_AbortReceive(huart);
+
+        /* Take the data received at the old baud rate. This is task
+         * context, the reader is not notified and reads it on its next poll. */
+        uart_dmarx_flush(huart);
+        uart_dmarx_realign(uart_rx_fifo, huart->RxXferSize);
+    }
+
+    huart->Init.BaudRate = baud_rate;
+    huart->Init.OverSampling = (baud_rate > uart_port_pclk(port) / 16U)
+                                   ? UART_OVERSAMPLING_8
+                                   : UART_OVERSAMPLING_16;
+    uint8_t res = (HAL_UART_Init(huart) == HAL_OK) ? UART_BAUD_OK
+                                                   : UART_BAUD_FAIL;
+
+    if (uart_rx_fifo != NULL) {
+        __HAL_UART_ENABLE_IT(huart, UART_IT_IDLE);
+        __HAL_UART_CLEAR_IDLEFLAG(huart);
+        HAL_UART_Receive_DMA(huart, uart_rx_fifo->recv_buf,
+                             uart_rx_fifo->buf_size);
+        HAL_NVIC_EnableIRQ(port->rx_dma.irq.irqn);
+    }
+    if (port->it_enable) {
+        HAL_NVIC_EnableIRQ(port->it.irqn);
+    }
+
+    return res;
+}
+
 /**
  * @}
  */
@@ -3102,85 +2259,147 @@ int uart_scanf(UART_HandleTypeDef *huart, const char *__format, ...) {
  * @return The point of UART rx fifo.
  */
 static inline uart_rx_fifo_t *uart_rx_identify(UART_HandleTypeDef *huart) {
-    switch ((uintptr_t)huart->Instance) {
+    const uart_port_t *port = uart_port_identify(huart);
 
-#if USART1_RX_DMA
-        case USART1_BASE: {
-            return &usart1_rx_fifo;
-        }
-#endif /* USART1_RX_DMA */
+    return (port == NULL) ? NULL : port->rx_fifo;
+}
 
-#if USART2_RX_DMA
-        case USART2_BASE: {
-            return &usart2_rx_fifo;
-        }
-#endif /* USART2_RX_DMA */
-#if USART3_RX_DMA
-        case USART3_BASE: {
-            return &usart3_rx_fifo;
-        }
-#endif /* USART3_RX_DMA */
+/**
+ * @brief UART receive notify callback, called in the interrupt after new data
+ *        is written to the receive fifo.
+ *
+ * @param huart The handle of UART
+ * @note This function should not be modified, when the callback is needed,
+ *       the `uart_dmarx_notify_callback` could be implemented in the user file.
+ *       It is called in interrupt context, only ISR safe functions can be used.
+ */
+__weak void uart_dmarx_notify_callback(UART_HandleTypeDef *huart) {
+    UNUSED(huart);
+}
 
-#if UART4_RX_DMA
-        case UART4_BASE: {
-            return &uart4_rx_fifo;
-        }
-#endif /* UART4_RX_DMA */
+/**
+ * @brief Initialize the receive fifo of UART, `recv_buf` must be allocated.
+ *
+ * @param uart_rx_fifo The receive fifo of UART.
+ * @return Initialize result:
+ * @retval - 0: Success.
+ * @retval - 1: Memory allocate failed, or the size is not power of 2.
+ */
+static uint8_t uart_dmarx_fifo_init(uart_rx_fifo_t *uart_rx_fifo) {
+#if UART_RX_DMA_DIRECT
+    /* The DMA writes the fifo storage directly. */
+    uart_rx_fifo->rx_fifo_buf = NULL;
+    uart_rx_fifo->rx_fifo = ring_fifo_init_static(
+        &uart_rx_fifo->rx_fifo_cb, uart_rx_fifo->recv_buf,
+        uart_rx_fifo->buf_size, RF_TYPE_STREAM);
+#else  /* UART_RX_DMA_DIRECT */
+    uart_rx_fifo->rx_fifo_buf = CSP_MALLOC(uart_rx_fifo->fifo_size);
+    if (uart_rx_fifo->rx_fifo_buf == NULL) {
+        return 1;
+    }
 
-#if UART5_RX_DMA
-        case UART5_BASE: {
-            return &uart5_rx_fifo;
-        }
-#endif /* UART5_RX_DMA */
+    uart_rx_fifo->rx_fifo = ring_fifo_init_static(
+        &uart_rx_fifo->rx_fifo_cb, uart_rx_fifo->rx_fifo_buf,
+        uart_rx_fifo->fifo_size, RF_TYPE_STREAM);
+#endif /* UART_RX_DMA_DIRECT */
 
-#if USART6_RX_DMA
-        case USART6_BASE: {
-            return &usart6_rx_fifo;
-        }
-#endif /* USART6_RX_DMA */
+    return (uart_rx_fifo->rx_fifo == NULL) ? 1 : 0;
+}
 
-#if UART7_RX_DMA
-        case UART7_BASE: {
-            return &uart7_rx_fifo;
-        }
-#endif /* UART7_RX_DMA */
+/**
+ * @brief Push the data received by DMA into the receive fifo.
+ *
+ * @param port The port descriptor of UART.
+ * @param data The received data in `recv_buf`.
+ * @param len The length of received data.
+ * @note In direct mode the data is already in the fifo storage, only the
+ *       producer index is published. If the reader falls behind more than
+ *       `buf_size`, the DMA has overwritten the unread data, the reader drops
+ *       all of it and it is counted by `ring_fifo_dropped`.
+ */
+static inline void uart_dmarx_push(const uart_port_t *port,
+                                   const uint8_t *data, uint32_t len) {
+    ring_fifo_t *rx_fifo = port->rx_fifo->rx_fifo;
+
+#if UART_RX_DMA_DIRECT
+    UNUSED(data);
+    ring_fifo_commit(rx_fifo, len);
+#else  /* UART_RX_DMA_DIRECT */
+    ring_fifo_write(rx_fifo, data, len);
+#endif /* UART_RX_DMA_DIRECT */
+
+    port->stats->rx_bytes += len;
+
+    /* More than the size means the unread data is overwritten. */
+    uint32_t used = ring_fifo_count(rx_fifo);
+    if (used > rx_fifo->size) {
+        used = rx_fifo->size;
+    }
+    if (used > port->stats->rx_high_water) {
+        port->stats->rx_high_water = used;
+    }
+}
 
-#if UART8_RX_DMA
-        case UART8_BASE: {
-            return &uart8_rx_fifo;
-        }
-#endif /* UART8_RX_DMA */
+/**
+ * @brief Align the receive index to the start of `recv_buf`, where the DMA
+ *        restarts after an error.
+ *
+ * @param uart_rx_fifo The receive fifo of UART.
+ * @param size The size of DMA transfer.
+ * @note Only the index moves, the bytes are not touched. In direct mode the
+ *       rest of this lap still holds the unread data of the last lap, it is
+ *       published as skipped bytes at once, and the reader passes it after
+ *       reading the data before it.
+ */
+static void uart_dmarx_realign(uart_rx_fifo_t *uart_rx_fifo, uint32_t size) {
+    uint32_t offset = uart_rx_fifo->head_ptr % size;
 
-#if UART9_RX_DMA
-        case UART9_BASE: {
-            return &uart9_rx_fifo;
-        }
-#endif /* UART9_RX_DMA */
+    if (offset == 0) {
+        return;
+    }
 
-#if UART10_RX_DMA
-        case UART10_BASE: {
-            return &uart10_rx_fifo;
-        }
-#endif /* UART10_RX_DMA */
+    uint32_t gap = size - offset;
+
+#if UART_RX_DMA_DIRECT
+    uint32_t pos = uart_rx_fifo->head_ptr;
 
-        default: {
-        } break;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (uart_rx_fifo->skip_len != 0) {
+        /* The reader has not passed the last skip, the data between is
+         * dropped with this one. */
+        uart_rx_fifo->skip_len = pos + gap - uart_rx_fifo->skip_pos;
+    } else {
+        uart_rx_fifo->skip_pos = pos;
+        uart_rx_fifo->skip_len = gap;
     }
+    __set_PRIMASK(primask);
+
+    /* The skip is set first, the reader never returns the skipped bytes. It
+     * is published now, a reader that has read all the data passes it before
+     * the DMA fills the next lap. */
+    ring_fifo_commit(uart_rx_fifo->rx_fifo, gap);
+#endif /* UART_RX_DMA_DIRECT */
 
-    return NULL;
+    uart_rx_fifo->head_ptr += gap;
 }
 
 /**
- * @brief UART received idle callback.
+ * @brief Push the data received by DMA so far into the receive fifo.
  *
  * @param huart The handle of UART
+ * @return The length pushed.
+ * @note It does not notify the reader, so it can be called in task context
+ *       with the UART and DMA interrupts disabled.
  */
-void uart_dmarx_idle_callback(UART_HandleTypeDef *huart) {
-    uart_rx_fifo_t *uart_rx_fifo = uart_rx_identify(huart);
-    if (uart_rx_fifo == NULL) {
-        return;
+static uint32_t uart_dmarx_flush(UART_HandleTypeDef *huart) {
+    const uart_port_t *port = uart_port_identify(huart);
+    if ((port == NULL) || (port->rx_fifo == NULL)) {
+        return 0;
     }
 
+    uart_rx_fifo_t *uart_rx_fifo = port->rx_fifo;
+
     uint32_t tail_ptr;
     uint32_t copy, offset;
 
@@ -3200,7 +2419,20 @@ void uart_dmarx_idle_callback(UART_HandleTypeDef *huart) {
     copy = tail_ptr - offset;
     uart_rx_fifo->head_ptr += copy;
 
-    ring_fifo_write(uart_rx_fifo->rx_fifo, huart->pRxBuffPtr + offset, copy);
+    uart_dmarx_push(port, huart->pRxBuffPtr + offset, copy);
+
+    return copy;
+}
+
+/**
+ * @brief UART received idle callback.
+ *
+ * @param huart The handle of UART
+ */
+void uart_dmarx_idle_callback(UART_HandleTypeDef *huart) {
+    if (uart_dmarx_flush(huart) != 0) {
+        uart_dmarx_notify_callback(huart);
+    }
 }
 
 /**
@@ -3209,11 +2441,13 @@ void uart_dmarx_idle_callback(UART_HandleTypeDef *huart) {
  * @param huart The handle of UART
  */
 void uart_dmarx_halfdone_callback(UART_HandleTypeDef *huart) {
-    uart_rx_fifo_t *uart_rx_fifo = uart_rx_identify(huart);
-    if (uart_rx_fifo == NULL) {
+    const uart_port_t *port = uart_port_identify(huart);
+    if ((port == NULL) || (port->rx_fifo == NULL)) {
         return;
     }
 
+    uart_rx_fifo_t *uart_rx_fifo = port->rx_fifo;
+
     uint32_t tail_ptr;
     uint32_t offset, copy;
 
@@ -3233,7 +2467,11 @@ void uart_dmarx_halfdone_callback(UART_HandleTypeDef *huart) {
     copy = tail_ptr - offset;
     uart_rx_fifo->head_ptr += copy;
 
-    ring_fifo_write(uart_rx_fifo->rx_fifo, huart->pRxBuffPtr + offset, copy);
+    uart_dmarx_push(port, huart->pRxBuffPtr + offset, copy);
+
+    if (copy != 0) {
+        uart_dmarx_notify_callback(huart);
+    }
 }
 
 /**
@@ -3242,11 +2480,13 @@ void uart_dmarx_halfdone_callback(UART_HandleTypeDef *huart) {
  * @param huart The handle of UART
  */
 void uart_dmarx_done_callback(UART_HandleTypeDef *huart) {
-    uart_rx_fifo_t *uart_rx_fifo = uart_rx_identify(huart);
-    if (uart_rx_fifo == NULL) {
+    const uart_port_t *port = uart_port_identify(huart);
+    if ((port == NULL) || (port->rx_fifo == NULL)) {
         return;
     }
 
+    uart_rx_fifo_t *uart_rx_fifo = port->rx_fifo;
+
     uint32_t tail_ptr;
     uint32_t offset, copy;
 
@@ -3266,7 +2506,11 @@ void uart_dmarx_done_callback(UART_HandleTypeDef *huart) {
     copy = tail_ptr - offset;
     uart_rx_fifo->head_ptr += copy;
 
-    ring_fifo_write(uart_rx_fifo->rx_fifo, huart->pRxBuffPtr + offset, copy);
+    uart_dmarx_push(port, huart->pRxBuffPtr + offset, copy);
+
+    if (copy != 0) {
+        uart_dmarx_notify_callback(huart);
+    }
 
     if (huart->hdmarx->Init.Mode != DMA_CIRCULAR) {
         /* Reopen the DMA receive. */
@@ -3277,6 +2521,63 @@ void uart_dmarx_done_callback(UART_HandleTypeDef *huart) {
     }
 }
 
+/**
+ * @brief Get the received data in the fifo, the bytes skipped by
+ *        `uart_dmarx_realign` are passed and never returned.
+ *
+ * @param uart_rx_fifo The receive fifo of UART.
+ * @param[out] span Up to two continuous regions of the received data.
+ * @return The total length that can be read.
+ */
+static uint32_t uart_dmarx_fetch(uart_rx_fifo_t *uart_rx_fifo,
+                                 ring_fifo_span_t span[2]) {
+    ring_fifo_t *rx_fifo = uart_rx_fifo->rx_fifo;
+    uint32_t len = ring_fifo_peek(rx_fifo, span);
+
+#if UART_RX_DMA_DIRECT
+    for (;;) {
+        uint32_t pass = 0;
+        uint32_t head =
+            atomic_load_explicit(&rx_fifo->head, memory_order_relaxed);
+
+        /* The skip published with the peeked data is seen here. */
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        uint32_t pos = uart_rx_fifo->skip_pos;
+        uint32_t skip = uart_rx_fifo->skip_len;
+        if (skip != 0) {
+            if (head - pos < skip) {
+                pass = pos + skip - head;
+                uart_rx_fifo->skip_len = 0;
+            } else if (pos - head < len) {
+                /* Stop before the skipped bytes. */
+                len = pos - head;
+            } else if ((int32_t)(head - pos) > 0) {
+                /* Passed when the fifo dropped the overwritten data. */
+                uart_rx_fifo->skip_len = 0;
+            }
+        }
+        __set_PRIMASK(primask);
+
+        if (pass == 0) {
+            break;
+        }
+
+        ring_fifo_consume(rx_fifo, pass);
+        len = ring_fifo_peek(rx_fifo, span);
+    }
+
+    if (span[0].len >= len) {
+        span[0].len = len;
+        span[1].len = 0;
+    } else {
+        span[1].len = len - span[0].len;
+    }
+#endif /* UART_RX_DMA_DIRECT */
+
+    return len;
+}
+
 /**
  * @brief Read from UART Receive fifo.
  *
@@ -3296,7 +2597,66 @@ uint32_t uart_dmarx_read(UART_HandleTypeDef *huart, void *buf,
         return 0;
     }
 
+#if UART_RX_DMA_DIRECT
+    ring_fifo_span_t span[2];
+    uint32_t len = uart_dmarx_fetch(uart_rx_fifo, span);
+    if (len > buf_size) {
+        len = (uint32_t)buf_size;
+    }
+
+    uint32_t first = (span[0].len < len) ? span[0].len : len;
+    memcpy(buf, span[0].buf, first);
+    if (len > first) {
+        memcpy((uint8_t *)buf + first, span[1].buf, len - first);
+    }
+    ring_fifo_consume(uart_rx_fifo->rx_fifo, len);
+
+    return len;
+#else  /* UART_RX_DMA_DIRECT */
     return ring_fifo_read(uart_rx_fifo->rx_fifo, buf, buf_size);
+#endif /* UART_RX_DMA_DIRECT */
+}
+
+/**
+ * @brief Get the received data in the UART Receive fifo without copying.
+ *
+ * @param huart The handle of UART
+ * @param[out] span Up to two continuous regions of the received data. The
+ *                  second one is used when the data wraps around the fifo.
+ * @return The total length that can be read.
+ * @note Call `uart_dmarx_consume` to release the data after processing. The
+ *       regions stay valid until then, the receive interrupt does not
+ *       overwrite them.
+ * @warning In direct mode the regions are in the DMA receive buf and the DMA
+ *          does not wait for the consume. If `buf_size` bytes arrive before
+ *          it, the regions are overwritten while being processed.
+ */
+uint32_t uart_dmarx_peek(UART_HandleTypeDef *huart, ring_fifo_span_t span[2]) {
+    uart_rx_fifo_t *uart_rx_fifo = uart_rx_identify(huart);
+
+    if (uart_rx_fifo == NULL) {
+        span[0].len = 0;
+        span[1].len = 0;
+        return 0;
+    }
+
+    return uart_dmarx_fetch(uart_rx_fifo, span);
+}
+
+/**
+ * @brief Release the data got by `uart_dmarx_peek`.
+ *
+ * @param huart The handle of UART
+ * @param len The length to release, must not exceed the peeked length.
+ */
+void uart_dmarx_consume(UART_HandleTypeDef *huart, uint32_t len) {
+    uart_rx_fifo_t *uart_rx_fifo = uart_rx_identify(huart);
+
+    if (uart_rx_fifo == NULL) {
+        return;
+    }
+
+    ring_fifo_consume(uart_rx_fifo->rx_fifo, len);
 }
 
 /**
@@ -3304,7 +2664,7 @@ uint32_t uart_dmarx_read(UART_HandleTypeDef *huart, void *buf,
  *
  * @param huart The handle of UART
  * @param buf_size New buf size
- * @param fifo_size New fifo size
+ * @param fifo_size New fifo size, not used in direct mode.
  * @return Resize message:
  * @retval - 0: Success
  * @retval - 1: This uart not enable DMA Rx.
@@ -3314,6 +2674,8 @@ uint32_t uart_dmarx_read(UART_HandleTypeDef *huart, void *buf,
  *          You should call `u(s)artx_deinit()` before call this function,
  *          than call `u(s)artx_init()` to using new size.
  *          It may allocated fail when reinitialize uart.
+ *          In direct mode `buf_size` must be power of 2, or the reinitialize
+ *          fails.
  */
 uint8_t uart_dmarx_resize_fifo(UART_HandleTypeDef *huart, uint32_t buf_size,
                                uint32_t fifo_size) {
@@ -3380,73 +2742,70 @@ uint32_t uart_dmarx_get_fifo_size(UART_HandleTypeDef *huart) {
  * @return The point of UART tx buffer.
  */
 static inline uart_tx_buf_t *uart_tx_identify(UART_HandleTypeDef *huart) {
-    switch ((uintptr_t)(huart->Instance)) {
-
-#if USART1_TX_DMA
-        case USART1_BASE: {
-            return &usart1_tx_buf;
-        }
-#endif /* USART1_TX_DMA */
-
-#if USART2_TX_DMA
-        case USART2_BASE: {
-            return &usart2_tx_buf;
-        }
-#endif /* USART2_TX_DMA */
-
-#if USART3_TX_DMA
-        case USART3_BASE: {
-            return &usart3_tx_buf;
-        }
-#endif /* USART3_TX_DMA */
-
-#if UART4_TX_DMA
-        case UART4_BASE: {
-            return &uart4_tx_buf;
-        }
-#endif /* UART4_TX_DMA */
+    const uart_port_t *port = uart_port_identify(huart);
 
-#if UART5_TX_DMA
-        case UART5_BASE: {
-            return &uart5_tx_buf;
-        }
-#endif /* UART5_TX_DMA */
+    return (port == NULL) ? NULL : port->tx_buf;
+}
 
-#if USART6_TX_DMA
-        case USART6_BASE: {
-            return &usart6_tx_buf;
-        }
-#endif /* USART6_TX_DMA */
+/**
+ * @brief Get the start address of the filling half.
+ *
+ * @param send_tx_buf The send buf of UART.
+ * @return The start address.
+ */
+static inline uint8_t *uart_dmatx_fill_buf(uart_tx_buf_t *send_tx_buf) {
+    return send_tx_buf->send_buf +
+           send_tx_buf->fill * (send_tx_buf->buf_size / 2);
+}
 
-#if UART7_TX_DMA
-        case UART7_BASE: {
-            return &uart7_tx_buf;
-        }
-#endif /* UART7_TX_DMA */
+/**
+ * @brief Start the DMA to transmit the filling half, and switch to fill the
+ *        other half.
+ *
+ * @param huart The handle of UART.
+ * @param send_tx_buf The send buf of UART.
+ * @return The length which is started to transmit.
+ * @note Must be called with interrupts disabled, and the DMA is not busy.
+ */
+static uint32_t uart_dmatx_start(UART_HandleTypeDef *huart,
+                                 uart_tx_buf_t *send_tx_buf) {
+    uint32_t len = send_tx_buf->head_ptr;
 
-#if UART8_TX_DMA
-        case UART8_BASE: {
-            return &uart8_tx_buf;
-        }
-#endif /* UART8_TX_DMA */
+    if (len == 0) {
+        send_tx_buf->pending = 0;
+        return 0;
+    }
 
-#if UART9_TX_DMA
-        case UART9_BASE: {
-            return &uart9_tx_buf;
-        }
-#endif /* UART9_TX_DMA */
+    if (HAL_UART_Transmit_DMA(huart, uart_dmatx_fill_buf(send_tx_buf),
+                              (uint16_t)len) != HAL_OK) {
+        /* The UART is transmitting by other code, retry when it completes. */
+        send_tx_buf->pending = 1;
+        return 0;
+    }
 
-#if UART10_TX_DMA
-        case UART10_BASE: {
-            return &uart10_tx_buf;
-        }
-#endif /* UART10_TX_DMA */
+    send_tx_buf->busy = 1;
+    send_tx_buf->pending = 0;
+    send_tx_buf->fill ^= 1;
+    send_tx_buf->head_ptr = 0;
+    return len;
+}
 
-        default: {
-        } break;
+/**
+ * @brief Reset the state of the send buf, when the DMA is aborted.
+ *
+ * @param huart The handle of UART.
+ */
+static void uart_dmatx_reset(UART_HandleTypeDef *huart) {
+    uart_tx_buf_t *send_tx_buf = uart_tx_identify(huart);
+    if (send_tx_buf == NULL) {
+        return;
     }
 
-    return NULL;
+    send_tx_buf->head_ptr = 0;
+    send_tx_buf->fill = 0;
+    send_tx_buf->busy = 0;
+    send_tx_buf->pending = 0;
+    send_tx_buf->reserved = 0;
 }
 
 /**
@@ -3456,6 +2815,8 @@ static inline uart_tx_buf_t *uart_tx_identify(UART_HandleTypeDef *huart) {
  * @param data The data will be write.
  * @param len The data length will be written.
  * @return The length that be written.
+ * @note The data is written into the half which is not transmitting, so it
+ *       never waits for the DMA.
  */
 uint32_t uart_dmatx_write(UART_HandleTypeDef *huart, const void *data,
                           size_t len) {
@@ -3463,34 +2824,114 @@ uint32_t uart_dmatx_write(UART_HandleTypeDef *huart, const void *data,
         return 0;
     }
 
-    uart_tx_buf_t *send_tx_buf = uart_tx_identify(huart);
-    if (send_tx_buf == NULL) {
+    const uart_port_t *port = uart_port_identify(huart);
+    if ((port == NULL) || (port->tx_buf == NULL)) {
         return 0;
     }
 
-    /* Get the remain length of buffer. */
-    uint32_t buf_remain = send_tx_buf->buf_size - send_tx_buf->head_ptr;
+    uart_tx_buf_t *send_tx_buf = port->tx_buf;
+
+    /* The transmit complete interrupt may switch the halves, so copy with
+     * interrupts disabled. The copy is no longer than half of the buffer. */
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    /* Get the remain length of the filling half. */
+    uint32_t buf_remain =
+        (uint32_t)(send_tx_buf->buf_size / 2) - send_tx_buf->head_ptr;
 
     /* Prevent overflow. */
     if (buf_remain < len) {
-        memcpy(send_tx_buf->send_buf + send_tx_buf->head_ptr, data, buf_remain);
-        send_tx_buf->head_ptr += buf_remain;
-        return buf_remain;
-    } else {
-        memcpy(send_tx_buf->send_buf + send_tx_buf->head_ptr, data, len);
-        send_tx_buf->head_ptr += len;
-        return len;
+        port->stats->tx_dropped += len - buf_remain;
+        len = buf_remain;
+    }
+
+    memcpy(uart_dmatx_fill_buf(send_tx_buf) + send_tx_buf->head_ptr, data,
+           len);
+    send_tx_buf->head_ptr += len;
+
+    __set_PRIMASK(primask);
+    return len;
+}
+
+/**
+ * @brief Reserve a continuous space in the transmit buffer, so that the caller
+ *        can fill the data in place without a temporary buffer.
+ *
+ * @param huart The handle of UART.
+ * @param len The length to reserve.
+ * @return The start address of the reserved space. `NULL` if this UART does
+ *         not enable DMA Tx or the remain space is not enough.
+ * @note Call `uart_dmatx_commit` with the length that be filled after writing,
+ *       otherwise the data will not be transmitted. The filling half is not
+ *       switched until then.
+ */
+uint8_t *uart_dmatx_reserve(UART_HandleTypeDef *huart, size_t len) {
+    if (len == 0) {
+        return NULL;
+    }
+
+    uart_tx_buf_t *send_tx_buf = uart_tx_identify(huart);
+    if (send_tx_buf == NULL) {
+        return NULL;
+    }
+
+    uint8_t *ptr = NULL;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (send_tx_buf->buf_size / 2 - send_tx_buf->head_ptr >= len) {
+        send_tx_buf->reserved = 1;
+        ptr = uart_dmatx_fill_buf(send_tx_buf) + send_tx_buf->head_ptr;
+    }
+
+    __set_PRIMASK(primask);
+    return ptr;
+}
+
+/**
+ * @brief Commit the data filled in the space which is got by
+ *        `uart_dmatx_reserve`.
+ *
+ * @param huart The handle of UART.
+ * @param len The length that be filled, must not greater than the reserved.
+ * @return The length that be committed.
+ */
+uint32_t uart_dmatx_commit(UART_HandleTypeDef *huart, size_t len) {
+    uart_tx_buf_t *send_tx_buf = uart_tx_identify(huart);
+    if (send_tx_buf == NULL) {
+        return 0;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (send_tx_buf->buf_size / 2 - send_tx_buf->head_ptr < len) {
+        len = send_tx_buf->buf_size / 2 - send_tx_buf->head_ptr;
+    }
+
+    send_tx_buf->head_ptr += len;
+    send_tx_buf->reserved = 0;
+
+    /* A send is requested during writing, start it now. */
+    if ((send_tx_buf->pending != 0) && (send_tx_buf->busy == 0)) {
+        uart_dmatx_start(huart, send_tx_buf);
     }
+
+    __set_PRIMASK(primask);
+    return len;
 }
 
 /**
  * @brief Transmit the data in the buf.
  *
  * @param huart The handle of UART.
- * @return The length which is succeed transmitted.
+ * @return The length which is started or queued to transmit.
  * @note If you want transmit data, using `uart_dmatx_write` before.
  *       If you have huge continous data to transmit, we recommand use
  *       `HAL_UART_Transmit_DMA()`.
+ * @note It never waits. If the DMA is transmitting the other half, the data
+ *       is started in the transmit complete interrupt.
  */
 uint32_t uart_dmatx_send(UART_HandleTypeDef *huart) {
     uart_tx_buf_t *send_tx_buf = uart_tx_identify(huart);
@@ -3502,20 +2943,122 @@ uint32_t uart_dmatx_send(UART_HandleTypeDef *huart) {
         return 0;
     }
 
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
     uint32_t len = send_tx_buf->head_ptr;
-    if (len == 0) {
-        return 0;
+    if ((send_tx_buf->busy != 0) || (send_tx_buf->reserved != 0)) {
+        /* Start it after the current transfer or the commit. */
+        send_tx_buf->pending = (len != 0);
+    } else {
+        len = uart_dmatx_start(huart, send_tx_buf);
     }
 
-    /* Wait for last transfer end. */
-    while (__HAL_UART_GET_FLAG(huart, UART_FLAG_TC) == RESET)
-        ;
-
-    HAL_UART_Transmit_DMA(huart, send_tx_buf->send_buf, (uint16_t)len);
-    send_tx_buf->head_ptr = 0;
+    __set_PRIMASK(primask);
     return len;
 }
 
+/**
+ * @brief Release the send buf if the finished transfer was started by it.
+ *
+ * @param send_tx_buf The send buf of UART.
+ * @param huart The handle of UART.
+ */
+static inline void uart_dmatx_release(uart_tx_buf_t *send_tx_buf,
+                                      UART_HandleTypeDef *huart) {
+    /* DMA mode leaves `pTxBuffPtr` at the start of the finished transfer,
+     * only release the send buf when the transfer was started by it. */
+    if ((send_tx_buf->busy != 0) &&
+        (huart->pTxBuffPtr >= send_tx_buf->send_buf) &&
+        (huart->pTxBuffPtr < send_tx_buf->send_buf + send_tx_buf->buf_size)) {
+        send_tx_buf->busy = 0;
+    }
+}
+
+/**
+ * @brief UART DMA transmit complete.
+ *
+ * @param huart The handle of UART.
+ * @note The TX DMA of a UART is shared by the send buf and the other users
+ *       (`HAL_UART_Transmit_DMA`, the message queue). Whoever starts a
+ *       transfer owns the line until it completes. On every completion
+ *       `uart_dmatx_cplt_callback` is called first, while `pTxBuffPtr` still
+ *       points to the finished transfer, then `uart_dmatx_resume` starts the
+ *       half which is requested to send if the line is still free.
+ */
+static void uart_dmatx_done_callback(UART_HandleTypeDef *huart) {
+    const uart_port_t *port = uart_port_identify(huart);
+    if (port == NULL) {
+        return;
+    }
+
+    /* Every DMA transfer of this UART, including `HAL_UART_Transmit_DMA`. */
+    port->stats->tx_bytes += huart->TxXferSize;
+
+    if (port->tx_buf != NULL) {
+        uart_dmatx_release(port->tx_buf, huart);
+    }
+}
+
+/**
+ * @brief UART DMA transmit error, the HAL ends the transfer without the
+ *        complete callback. The data not transmitted is dropped.
+ *
+ * @param huart The handle of UART.
+ * @note `uart_dmatx_cplt_callback` is called after it with
+ *       `HAL_UART_ERROR_DMA` still set, so the users can tell the failure and
+ *       release their transfer.
+ */
+static void uart_dmatx_error_callback(UART_HandleTypeDef *huart) {
+    /* A FIFO error does not disable the stream, stop it before the next
+     * transfer. The HAL reports `HAL_DMA_ERROR_NO_XFER` if it has stopped. */
+    HAL_DMA_Abort(huart->hdmatx);
+    huart->hdmatx->ErrorCode = HAL_DMA_ERROR_NONE;
+
+    uart_tx_buf_t *send_tx_buf = uart_tx_identify(huart);
+    if (send_tx_buf != NULL) {
+        uart_dmatx_release(send_tx_buf, huart);
+    }
+}
+
+/**
+ * @brief Start the half which is requested to send during the transfer.
+ *
+ * @param huart The handle of UART.
+ * @note If the user of `uart_dmatx_cplt_callback` has taken the line, the
+ *       half stays pending and is started on the next completion.
+ */
+static void uart_dmatx_resume(UART_HandleTypeDef *huart) {
+    uart_tx_buf_t *send_tx_buf = uart_tx_identify(huart);
+    if (send_tx_buf == NULL) {
+        return;
+    }
+
+    if ((send_tx_buf->pending != 0) && (send_tx_buf->busy == 0) &&
+        (send_tx_buf->reserved == 0)) {
+        uart_dmatx_start(huart, send_tx_buf);
+    }
+}
+
+/**
+ * @brief UART DMA transmit complete callback.
+ *
+ * @param huart The handle of UART
+ * @note This function should not be modified, when the callback is needed,
+ *       the `uart_dmatx_cplt_callback` could be implemented in the user file.
+ *       It is called in interrupt context, only ISR safe functions can be used.
+ * @note `pTxBuffPtr` points to the finished transfer, the users which start
+ *       `HAL_UART_Transmit_DMA` by themselves tell their transfer by it. They
+ *       must check the result of the start, and retry here when it failed
+ *       because the line was busy.
+ * @note It is also called after a DMA transmit error, then
+ *       `HAL_UART_GetError` has `HAL_UART_ERROR_DMA` set and the transfer
+ *       did not finish.
+ */
+__weak void uart_dmatx_cplt_callback(UART_HandleTypeDef *huart) {
+    UNUSED(huart);
+}
+
 /**
  * @brief Resize the send buf of UART.
  *
@@ -3525,7 +3068,7 @@ uint32_t uart_dmatx_send(UART_HandleTypeDef *huart) {
  * @retval - 0: Success
  * @retval - 1: This uart not enable DMA Tx.
  * @retval - 2: No free memory to allocate.
- * @retval - 3: This uart is busy now.
+ * @retval - 3: This uart is busy now, or there are data not transmitted.
  * @retval - 4: Parameter error, size can't be 0.
  */
 uint8_t uart_dmatx_resize_buf(UART_HandleTypeDef *huart, uint32_t size) {
@@ -3538,9 +3081,10 @@ uint8_t uart_dmatx_resize_buf(UART_HandleTypeDef *huart, uint32_t size) {
         return 1;
     }
 
-    if ((huart->gState) & (HAL_UART_STATE_BUSY_TX | HAL_UART_STATE_BUSY) &
-        ~HAL_UART_STATE_READY) {
-        /* The UART is busy. */
+    if (((huart->gState) & (HAL_UART_STATE_BUSY_TX | HAL_UART_STATE_BUSY) &
+         ~HAL_UART_STATE_READY) ||
+        (send_tx_buf->busy != 0) || (send_tx_buf->head_ptr != 0)) {
+        /* The UART is busy, or there are data not transmitted. */
         return 3;
     }
 
@@ -3558,6 +3102,7 @@ uint8_t uart_dmatx_resize_buf(UART_HandleTypeDef *huart, uint32_t size) {
 
     send_tx_buf->send_buf = new_ptr;
     send_tx_buf->buf_size = size;
+    send_tx_buf->fill = 0;
 
     return 0;
 }
@@ -3600,31 +3145,57 @@ void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) {
         return;
     }
 
-    switch (error_code) {
-        case HAL_UART_ERROR_PE: {
-            __HAL_UART_CLEAR_PEFLAG(huart);
-        } break;
+    /* The UART not initialized by CSP has no statistics, only clear the
+     * flags and restart the receive. */
+    const uart_port_t *port = uart_port_identify(huart);
+    if (port != NULL) {
+        uart_stats_t *stats = port->stats;
 
-        case HAL_UART_ERROR_NE: {
-            __HAL_UART_CLEAR_NEFLAG(huart);
-        } break;
+        /* Several errors may be reported at the same time. */
+        stats->pe += ((error_code & HAL_UART_ERROR_PE) != 0U);
+        stats->ne += ((error_code & HAL_UART_ERROR_NE) != 0U);
+        stats->fe += ((error_code & HAL_UART_ERROR_FE) != 0U);
+        stats->ore += ((error_code & HAL_UART_ERROR_ORE) != 0U);
+        stats->dma_errors += ((error_code & HAL_UART_ERROR_DMA) != 0U);
+    }
+
+    if (error_code & HAL_UART_ERROR_PE) {
+        __HAL_UART_CLEAR_PEFLAG(huart);
+    }
 
-        case HAL_UART_ERROR_FE: {
-            __HAL_UART_CLEAR_FEFLAG(huart);
-        } break;
+    if (error_code & HAL_UART_ERROR_NE) {
+        __HAL_UART_CLEAR_NEFLAG(huart);
+    }
 
-        case HAL_UART_ERROR_ORE: {
-            __HAL_UART_CLEAR_OREFLAG(huart);
-        } break;
+    if (error_code & HAL_UART_ERROR_FE) {
+        __HAL_UART_CLEAR_FEFLAG(huart);
+    }
 
-        case HAL_UART_ERROR_DMA: {
-        } break;
+    if (error_code & HAL_UART_ERROR_ORE) {
+        __HAL_UART_CLEAR_OREFLAG(huart);
+    }
 
-        default: {
-        } break;
+    /* The TX DMA stopped, release the line before the receive restart
+     * clears the error code. */
+    if ((error_code & HAL_UART_ERROR_DMA) && (huart->hdmatx != NULL) &&
+        (huart->hdmatx->ErrorCode != HAL_DMA_ERROR_NONE)) {
+        uart_dmatx_error_callback(huart);
+        uart_dmatx_cplt_callback(huart);
+        uart_dmatx_resume(huart);
     }
 
     if (NULL != huart->hdmarx) {
+        /* A TX DMA error ends the receive but leaves its DMA running, the
+         * restart fails to start it. */
+        HAL_UART_AbortReceive(huart);
+
+        if ((port != NULL) && (port->rx_fifo != NULL)) {
+            /* Take the data received before the error, then the DMA restarts
+             * from the start of `recv_buf`. */
+            uart_dmarx_idle_callback(huart);
+            uart_dmarx_realign(port->rx_fifo, huart->RxXferSize);
+        }
+
         while (
             HAL_UART_Receive_DMA(huart, huart->pRxBuffPtr, huart->RxXferSize)) {
             __HAL_UNLOCK(huart);
@@ -3665,6 +3236,19 @@ void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef *huart) {
     }
 }
 
+/**
+ * @brief Tx Transfer completed callbacks.
+ *
+ * @param huart The handle of UART.
+ */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
+    if (huart->hdmatx != NULL) {
+        uart_dmatx_done_callback(huart);
+        uart_dmatx_cplt_callback(huart);
+        uart_dmatx_resume(huart);
+    }
+}
+
 #endif /* USE_HAL_UART_REGISTER_CALLBACKS == 0 */
 
 /**
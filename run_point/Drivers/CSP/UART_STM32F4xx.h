@@ -12,6 +12,8 @@
 
 #include <stdarg.h>
 
+#include "./ring_fifo/ring_fifo.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -32,6 +34,49 @@ extern "C" {
 #define UART_DEINIT_DMA_FAIL 2
 #define UART_NO_INIT         3
 
+#define UART_BAUD_OK         0
+#define UART_BAUD_BUSY       1
+#define UART_BAUD_FAIL       2
+
+/* Max error of the actual baud rate, in 0.1%. */
+#define UART_BAUD_MAX_ERROR  10
+
+/* Use the circular DMA receive buf as the receive fifo directly, the DMA
+   interrupts only publish the received length without copying. The size of
+   receive buf must be power of 2, the fifo size is not used.
+   The DMA is never held back by the reader. If the reader falls more than
+   `buf_size` behind, the data being read or peeked is overwritten before it
+   is consumed, only the overwrite that is already published is detected. Off
+   by default, enable it only when the reader always keeps up. */
+#ifndef UART_RX_DMA_DIRECT
+#define UART_RX_DMA_DIRECT   0
+#endif /* UART_RX_DMA_DIRECT */
+
+/**
+ * @}
+ */
+
+/*****************************************************************************
+ * @defgroup UART Public Types.
+ * @{
+ */
+
+/**
+ * @brief Link statistics of UART.
+ */
+typedef struct {
+    uint32_t rx_bytes;      /*!< Bytes received by DMA.                      */
+    uint32_t tx_bytes;      /*!< Bytes transmitted by DMA.                   */
+    uint32_t ore;           /*!< Overrun errors.                             */
+    uint32_t fe;            /*!< Framing errors.                             */
+    uint32_t ne;            /*!< Noise errors.                               */
+    uint32_t pe;            /*!< Parity errors.                              */
+    uint32_t dma_errors;    /*!< DMA transfer errors.                        */
+    uint32_t rx_dropped;    /*!< Bytes dropped by the receive fifo.          */
+    uint32_t rx_high_water; /*!< Maximum used bytes of the receive fifo.     */
+    uint32_t tx_dropped;    /*!< Bytes not written into the full send buf.   */
+} uart_stats_t;
+
 /**
  * @}
  */
@@ -765,8 +810,15 @@ uint8_t uart10_deinit(void);
 
 int uart_printf(UART_HandleTypeDef *huart, const char *__format, ...);
 int uart_scanf(UART_HandleTypeDef *huart, const char *__format, ...);
+uint8_t uart_get_stats(UART_HandleTypeDef *huart, uart_stats_t *stats);
+void uart_clear_stats(UART_HandleTypeDef *huart);
+uint8_t uart_check_baud_rate(UART_HandleTypeDef *huart, uint32_t baud_rate);
+uint8_t uart_set_baud_rate(UART_HandleTypeDef *huart, uint32_t baud_rate);
 
 uint32_t uart_dmarx_read(UART_HandleTypeDef *huart, void *buf, size_t len);
+uint32_t uart_dmarx_peek(UART_HandleTypeDef *huart, ring_fifo_span_t span[2]);
+void uart_dmarx_consume(UART_HandleTypeDef *huart, uint32_t len);
+void uart_dmarx_notify_callback(UART_HandleTypeDef *huart);
 uint8_t uart_dmarx_resize_fifo(UART_HandleTypeDef *huart, uint32_t buf_size,
                                uint32_t fifo_size);
 uint32_t uart_dmarx_get_buf_size(UART_HandleTypeDef *huart);
@@ -774,7 +826,10 @@ uint32_t uart_dmarx_get_fifo_size(UART_HandleTypeDef *huart);
 
 uint32_t uart_dmatx_write(UART_HandleTypeDef *huart, const void *data,
                           size_t len);
+uint8_t *uart_dmatx_reserve(UART_HandleTypeDef *huart, size_t len);
+uint32_t uart_dmatx_commit(UART_HandleTypeDef *huart, size_t len);
 uint32_t uart_dmatx_send(UART_HandleTypeDef *huart);
+void uart_dmatx_cplt_callback(UART_HandleTypeDef *huart);
 uint8_t uart_dmatx_resize_buf(UART_HandleTypeDef *huart, uint32_t size);
 uint32_t uart_damtx_get_buf_szie(UART_HandleTypeDef *huart);
 
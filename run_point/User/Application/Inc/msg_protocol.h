@@ -19,6 +19,12 @@
 *      (##) `message_send_data`函数需要指定`data_mean`(也就是`message_mean_t`
 *           枚举中的类型), `data_type`(数据类型, 整数, 浮点或者字符串等),
 *           `data`(数据指针, 也就是要发送的数据), 以及`data_len`, 数据长度
+*      (##) 超过`MSG_MAX_DATA_LENGTH`的数据调用`message_send_large_data`分片
+*           发送, 同一含义同一时刻只能有一个分片传输. 发送通道放不下时返回
+*           `MSG_FRAGMENT_BUSY`, 不会等待, 由调用者稍后重试
+*      (##) 需要确认送达的消息, 两边都调用`message_reliable_enable`开启可靠
+*           传输, 再调用`message_send_reliable`发送. 丢失的帧会自动重传,
+*           接收方按顺序调用普通回调函数, 不会重复调用
 * (#) 接收
 *      (##) 调用`message_add_polling_handle`添加要轮询的串口
 *      (##) 调用`message_register_recv_callback`注册接收回调函数, 当收到消息
@@ -28,9 +34,36 @@
 *      (##) 回调函数参数形式必须是void (uint8_t, message_type_t, void*)
 *           第一个参数是消息长度, 第二个参数是数据类型(整数, 浮点或者字符串等),
 *           第三个参数是数据区内容, 无返回值
+*      (##) 分片传输重组完成后调用`message_register_recv_large_callback`注册的
+*           回调函数, 没有注册且总长度不超过255时调用普通回调函数
 *      (##) `message_polling_data`仅支持DMA接收, 如果是串口接收需要自行编写回调
 *           函数与接收逻辑
 *      (##) 调用`message_remove_polling_handle`删除要轮询的串口
+*      (##) 调用`message_get_polling_stats`查询各串口收到的帧数与错误数
+* (#) 链路统计
+*      (##) 调用`message_get_link_stats`查询轮询串口的协议层与串口驱动统计,
+*           包括收发字节数, 按原因分类的错误帧, ORE/FE/NE/PE, 接收FIFO的
+*           最高水位与丢弃字节数
+*      (##) 调用`message_register_send_handle(MSG_LINK_STATS, ...)`注册发送
+*           串口后, 软件定时器每隔`MSG_LINK_STATS_PERIOD_MS`发送一次各轮询
+*           串口的统计, 数据区为| 轮询表序号 | message_link_stats_t |,
+*           按成员顺序每个成员4字节小端, 共`MSG_LINK_STATS_LENGTH`字节,
+*           分片发送. 发送队列暂停或放不下时跳过本周期
+* (#) 波特率协商
+*      (##) 默认不编译, 两块板的`MSG_BAUD_ENABLE`都置1后才能使用
+*      (##) 双方都以`MSG_BAUD_BASE_RATE`初始化串口, 并添加到轮询表.
+*           一方调用`message_baud_enable(huart, max, true)`主动协商,
+*           另一方调用`message_baud_enable(huart, max, false)`应答
+*      (##) 主动方提议双方都支持的最高速率, 切换后用探测帧确认链路,
+*           此后定时发送探测帧. 超时或错误计数突增时双方回到基础速率,
+*           主动方降低上限后重新协商
+*      (##) 切换期间暂停发送通道, 已入队的帧在切换后按新速率发送, 不会丢失.
+*           超时也在`message_polling_data`中处理, 没有数据时轮询任务最多等待
+*           `message_baud_next_timeout`返回的时间, 没有等待中的超时时一直等待
+*      (##) 调用`message_get_baud_stats`查询当前速率与切换次数
+* (#) 转发
+*      (##) 调用`message_add_route`把一个串口收到的某种含义的帧原样转发到
+*           另一个串口, 不经过回调函数, 也不重新组帧
 ******************************************************************************
 *    Date    | Version |   Author    | Version Info
 * -----------+---------+-------------+----------------------------------------
@@ -42,7 +75,13 @@
 
 #include <bsp.h>
 
-#define MSG_MAX_DATA_LENGTH          16 /* 最大数据长度, 超出长度会造成缓冲区溢出 */
+#define MSG_MAX_DATA_LENGTH          16  /* 最大数据长度, 超出长度会造成缓冲区溢出 */
+#define MSG_POLLING_HANDLE_NUM       4   /* 可以轮询的串口数量上限 */
+#define MSG_POLLING_BUDGET           128 /* 每次轮询每个串口最多读取的字节数 */
+#define MSG_ROUTE_NUM                4   /* 串口转发表的项数 */
+#define MSG_TX_QUEUE_DEPTH           8   /* 每个优先级通道的帧数, 必须是2的幂 */
+#define MSG_TX_QUEUE_NUM             2   /* 使用DMA发送的串口数量上限 */
+#define MSG_LINK_STATS_PERIOD_MS     1000 /* 链路统计报告周期, 为0时不发送 */
 /* 如果是数组, 可以调用此宏定义获取长度; 堆分配的内存勿用!! */
 #define MSG_GET_DATA_ARRAY_LENGTH(X) (sizeof(X))
 
@@ -52,10 +91,142 @@
 #error Max data length must be less than 250.
 #endif /* MSG_MAX_DATA_LENGTH */
 
+#if (MSG_POLLING_BUDGET < 1)
+#error Polling budget must be at least 1 byte.
+#endif /* MSG_POLLING_BUDGET */
+
+#if ((MSG_TX_QUEUE_DEPTH & (MSG_TX_QUEUE_DEPTH - 1)) != 0)
+#error Transmit queue depth must be a power of 2.
+#endif /* MSG_TX_QUEUE_DEPTH */
+
+#define MSG_BATCH_MEAN       0x0F /* 打包帧使用的含义编号, 不能在message_mean_t中使用 */
+#define MSG_MAX_BATCH_LENGTH 64   /* 打包帧与分片帧数据区最大长度 */
+
+#if (MSG_MAX_BATCH_LENGTH < MSG_MAX_DATA_LENGTH + 2)
+#error Max batch length must be able to hold at least one message.
+#elif (MSG_MAX_BATCH_LENGTH >= 250)
+#error Max batch length must be less than 250.
+#endif /* MSG_MAX_BATCH_LENGTH */
+
+/**
+ * 分片帧数据区: | 含义/类型 | 传输号 | 分片序号 | 分片总数 | 分片数据 |
+ * 含义/类型是原消息的, 传输号每次分片传输加1, 接收方按含义各用一块缓冲区重组
+ */
+#define MSG_FRAGMENT_MEAN        0x0E /* 分片帧使用的含义编号, 不能在message_mean_t中使用 */
+#define MSG_MAX_FRAGMENT_LENGTH  256  /* 分片传输的最大总长度(重组缓冲区大小) */
+#define MSG_FRAGMENT_HEAD_SIZE   4    /* 分片帧数据区中分片头的字节数 */
+/* 每个分片携带的数据长度 */
+#define MSG_FRAGMENT_DATA_LENGTH (MSG_MAX_BATCH_LENGTH - MSG_FRAGMENT_HEAD_SIZE)
+
+#if (MSG_MAX_FRAGMENT_LENGTH <= MSG_MAX_DATA_LENGTH)
+#error Max fragment length must be more than max data length.
+#elif (MSG_MAX_FRAGMENT_LENGTH > 255 * MSG_FRAGMENT_DATA_LENGTH)
+#error Max fragment length must fit in 255 fragments.
+#elif (MSG_MAX_FRAGMENT_LENGTH >                                               \
+       MSG_TX_QUEUE_DEPTH * MSG_FRAGMENT_DATA_LENGTH)
+#error All fragments of a transfer must fit in one transmit lane.
+#endif /* MSG_MAX_FRAGMENT_LENGTH */
+
+/**
+ * 可靠传输帧数据区:
+ *   数据: | 含义/类型 | 序号 | 数据 |
+ *   确认: | 含义/0 | 期望的下一个序号 |
+ * 发送方最多有`MSG_RELIABLE_WINDOW`帧未确认, 超时后重传所有未确认的帧;
+ * 接收方只按顺序接收, 每收到一帧回复累计确认. 需要FreeRTOS软件定时器
+ */
+#define MSG_RELIABLE_ENABLE     1    /* 是否编译可靠传输 */
+#define MSG_RELIABLE_MEAN       0x0D /* 可靠传输帧使用的含义编号, 不能在message_mean_t中使用 */
+#define MSG_RELIABLE_WINDOW     4    /* 发送窗口, 最多未确认的帧数 */
+#define MSG_RELIABLE_TIMEOUT_MS 20   /* 重传超时时间 */
+#define MSG_RELIABLE_MAX_RETRY  10   /* 连续超时次数上限, 超过后放弃窗口内的帧 */
+/* 可靠传输一条消息的最大数据长度, 发送与接收都按它检查 */
+#define MSG_MAX_RELIABLE_LENGTH MSG_MAX_DATA_LENGTH
+
+#if (MSG_RELIABLE_WINDOW < 1) || (MSG_RELIABLE_WINDOW > 64)
+#error Reliable window must be between 1 and 64.
+#endif /* MSG_RELIABLE_WINDOW */
+
+#if (MSG_MAX_RELIABLE_LENGTH + 2 > MSG_MAX_BATCH_LENGTH)
+#error Reliable message and its header must fit in one frame.
+#endif /* MSG_MAX_RELIABLE_LENGTH */
+
+/**
+ * 波特率协商帧数据区: | 波特率(uint32, 小端) | 测试图样(仅探测帧) |
+ * 帧头的类型位是操作码. 主动方提议速率, 对方接受后双方在发送通道空闲时切换,
+ * 主动方在新速率下发送探测帧, 收到`MSG_BAUD_PROBE_NUM`次回复后确认;
+ * 之后每隔`MSG_BAUD_KEEPALIVE_MS`发送一次探测帧. 任一方超过
+ * `MSG_BAUD_LINK_TIMEOUT_MS`没有收到协商帧, 或一个周期内的接收错误超过
+ * `MSG_BAUD_ERROR_LIMIT`, 就回到`MSG_BAUD_BASE_RATE`
+ */
+#ifndef MSG_BAUD_ENABLE
+#define MSG_BAUD_ENABLE          0      /* 是否编译波特率协商, 两块板必须一致 */
+#endif /* MSG_BAUD_ENABLE */
+#define MSG_BAUD_MEAN            0x0C   /* 波特率协商帧使用的含义编号, 不能在message_mean_t中使用 */
+#define MSG_BAUD_BASE_RATE       115200 /* 上电与回退时的波特率 */
+#define MSG_BAUD_TIMEOUT_MS      50     /* 等待回复与切换的超时时间 */
+#define MSG_BAUD_PROBE_MS        10     /* 确认链路时探测帧的发送间隔 */
+#define MSG_BAUD_PROBE_NUM       3      /* 确认链路需要的探测回复数 */
+#define MSG_BAUD_KEEPALIVE_MS    100    /* 切换后探测帧的发送周期 */
+#define MSG_BAUD_LINK_TIMEOUT_MS 500    /* 超过这个时间没有收到协商帧就回退 */
+#define MSG_BAUD_ERROR_LIMIT     8      /* 一个探测周期内允许的接收错误数 */
+#define MSG_BAUD_RETRY_MS        5000   /* 失败或回退后重新协商的间隔 */
+
+#if (MSG_BAUD_TIMEOUT_MS + MSG_BAUD_PROBE_NUM * MSG_BAUD_PROBE_MS >=            \
+     MSG_BAUD_LINK_TIMEOUT_MS)
+#error Baud rate probes must finish before the link timeout.
+#endif /* MSG_BAUD_LINK_TIMEOUT_MS */
+
+/**
+ * 帧格式版本, 收发双方必须一致
+ * 1: | 含义/类型 | 长度 | 数据 | 0xFF |
+ * 2: | 0xA5 0x5A | 版本/保留 | 序号 | 含义/类型 | 长度 | 数据 | CRC16 |
+ *    CRC16高字节在前, 从版本字节算到数据末尾, 算法为CRC-16/CCITT-FALSE
+ * 3: | COBS(| 版本/保留 | 序号 | 含义/类型 | 长度 | 数据 | CRC16 |) | 0x00 |
+ *    内容与版本2相同, 去掉同步字后做COBS编码, 帧内不会出现0x00,
+ *    接收方遇到0x00就是帧边界, 出错后最多丢失当前一帧
+ * 可以在编译选项中定义, 主机测试用它测试各版本
+ */
+#ifndef MSG_FRAME_VERSION
+#define MSG_FRAME_VERSION 2
+#endif /* MSG_FRAME_VERSION */
+
+#if (MSG_FRAME_VERSION == 1)
+#define MSG_FRAME_HEAD_SIZE 2 /* 数据区之前的字节数 */
+#define MSG_FRAME_TAIL_SIZE 1 /* 数据区之后的字节数 */
+#elif (MSG_FRAME_VERSION == 2)
+#define MSG_FRAME_SYNC_0    0xA5 /* 同步字第一个字节 */
+#define MSG_FRAME_SYNC_1    0x5A /* 同步字第二个字节 */
+#define MSG_FRAME_HEAD_SIZE 6    /* 数据区之前的字节数 */
+#define MSG_FRAME_TAIL_SIZE 2    /* 数据区之后的字节数 */
+#elif (MSG_FRAME_VERSION == 3)
+#define MSG_FRAME_HEAD_SIZE 5 /* 数据区之前的字节数, 含COBS编码字节 */
+#define MSG_FRAME_TAIL_SIZE 3 /* 数据区之后的字节数, 含0x00分隔符 */
+#if (MSG_MAX_BATCH_LENGTH + 6 > 253)
+#error COBS frame must be shorter than 254 bytes, reduce the max batch length.
+#endif /* MSG_MAX_BATCH_LENGTH + 6 > 253 */
+#else /* MSG_FRAME_VERSION */
+#error Invalid message frame version.
+#endif /* MSG_FRAME_VERSION */
+
+/* 一帧除数据区以外的字节数 */
+#define MSG_FRAME_OVERHEAD    (MSG_FRAME_HEAD_SIZE + MSG_FRAME_TAIL_SIZE)
+
 #define MSG_NO_DATA           0x00 /* 没有收到消息 */
 #define MSG_DATA_OVER         0xFF /* 数据长度溢出 */
-#define MSG_DATA_LENGTH_ERROR 0xFE /* 实际接收长度与消息中的长度不一 */
-#define MSG_DATA_VERIFY_ERROR 0xFD /* 接收校验错误(最后一个字节不是0xFF) */
+#define MSG_DATA_LENGTH_ERROR 0xFE /* 实际接收长度与消息中的长度不一(已弃用) */
+#define MSG_DATA_VERIFY_ERROR 0xFD /* 接收校验错误(帧尾不是0xFF或CRC错误) */
+
+#define MSG_BATCH_OK          0 /* 添加到打包帧成功 */
+#define MSG_BATCH_FULL        1 /* 打包帧剩余空间不足 */
+#define MSG_BATCH_ERROR       2 /* 参数错误, 或与已有消息的发送串口不同 */
+
+#define MSG_FRAGMENT_OK       0 /* 分片全部入队 */
+#define MSG_FRAGMENT_ERROR    1 /* 参数错误或没有发送串口 */
+#define MSG_FRAGMENT_BUSY     2 /* 发送通道放不下全部分片, 稍后重试 */
+
+#define MSG_RELIABLE_OK       0 /* 已放入发送窗口 */
+#define MSG_RELIABLE_FULL     1 /* 发送窗口已满, 等待确认后再发送 */
+#define MSG_RELIABLE_ERROR    2 /* 参数错误, 或该含义没有开启可靠传输 */
 
 /**
  * @brief 数据含义
@@ -63,6 +234,7 @@
 typedef enum {
     MSG_REMOTE = 0x00U, /*!< 遥控器通信数据 遥控器->主板 */
     MSG_CHASSIS,        /*!< 主板底盘通信   底盘<->主板 */
+    MSG_LINK_STATS,     /*!< 链路统计报告   主板->上位机 */
 
     // MSG_DT35,               /*接收DT35信息*/
     MSG_MEAN_LENGTH_RESERVE /*!< 保留位, 用于定义数据长度 */
@@ -86,6 +258,73 @@ typedef enum {
     MSG_DATA_STRING
 } message_type_t;
 
+/**
+ * @brief 发送优先级
+ */
+typedef enum {
+    MSG_PRIORITY_HIGH = 0x00U, /*!< 控制帧, 总是先发送 */
+    MSG_PRIORITY_NORMAL,       /*!< 普通数据 */
+    MSG_PRIORITY_NUM
+} message_priority_t;
+
+/**
+ * @brief 发送通道统计
+ */
+typedef struct {
+    uint32_t depth;       /*!< 当前排队帧数 */
+    uint32_t max_depth;   /*!< 开始发送时的最大排队帧数 */
+    uint32_t sent;        /*!< 已发送帧数, 含DMA出错的帧 */
+    uint32_t failed;      /*!< DMA出错丢弃的帧数 */
+    uint32_t dropped;     /*!< 通道满丢弃的帧数 */
+    uint32_t wait_max_us; /*!< 入队到开始发送的最长等待时间 */
+    uint32_t wait_avg_us; /*!< 入队到开始发送的平均等待时间 */
+} message_tx_stats_t;
+
+/**
+ * @brief 接收统计
+ */
+typedef struct {
+    uint32_t frames;        /*!< 收到的完整帧数 */
+    uint32_t errors;        /*!< 长度溢出与校验错误次数 */
+    uint32_t overflows;     /*!< 长度溢出次数(`MSG_DATA_OVER`) */
+    uint32_t verify_errors; /*!< 校验错误次数(`MSG_DATA_VERIFY_ERROR`) */
+    uint32_t bytes;         /*!< 解析的字节数 */
+} message_polling_stats_t;
+
+/**
+ * @brief 链路统计
+ */
+typedef struct {
+    message_polling_stats_t polling; /*!< 协议层接收统计 */
+    uart_stats_t uart;               /*!< 串口驱动统计 */
+} message_link_stats_t;
+
+/* 链路统计报告的数据区长度, 成员都是uint32_t, 序号占1字节 */
+#define MSG_LINK_STATS_LENGTH (1 + sizeof(message_link_stats_t))
+
+/**
+ * @brief 可靠传输统计
+ */
+typedef struct {
+    uint32_t sent;        /*!< 首次发送的帧数 */
+    uint32_t acked;       /*!< 已确认的帧数 */
+    uint32_t retransmits; /*!< 重传的帧数 */
+    uint32_t failed;      /*!< 超过重传次数放弃的帧数 */
+    uint32_t duplicates;  /*!< 收到的重复帧数 */
+    uint32_t in_flight;   /*!< 当前未确认的帧数 */
+} message_reliable_stats_t;
+
+/**
+ * @brief 波特率协商统计
+ */
+typedef struct {
+    uint32_t baud_rate; /*!< 当前波特率 */
+    uint32_t ceiling;   /*!< 允许协商的最高波特率 */
+    uint32_t switches;  /*!< 切换并确认成功的次数 */
+    uint32_t failures;  /*!< 对方拒绝, 切换或确认失败的次数 */
+    uint32_t fallbacks; /*!< 超时或错误突增回到基础速率的次数 */
+} message_baud_stats_t;
+
 /**
  * @brief 回调函数指针定义
  *
@@ -97,16 +336,82 @@ typedef void (*msg_recv_callback_t)(uint8_t /* msg_length */,
                                     message_type_t /* msg_type */,
                                     void * /* msg_data */);
 
+/**
+ * @brief 分片传输重组完成的回调函数指针定义
+ *
+ * @param msg_length 重组后的总长度
+ * @param msg_type 数据类型
+ * @param[in] msg_data 重组缓冲区, 回调返回后会被下一次传输覆盖
+ */
+typedef void (*msg_recv_large_callback_t)(uint16_t /* msg_length */,
+                                          message_type_t /* msg_type */,
+                                          void * /* msg_data */);
+
 void message_register_recv_callback(message_mean_t msg_mean,
                                     msg_recv_callback_t msg_callback);
+void message_register_recv_large_callback(
+    message_mean_t msg_mean, msg_recv_large_callback_t msg_callback);
 void message_register_send_handle(message_mean_t msg_mean,
                                   UART_HandleTypeDef *msg_send_handle);
 void message_send_data(message_mean_t data_mean, message_type_t data_type,
                        void *data, size_t data_len);
+void message_send_data_priority(message_priority_t priority,
+                                message_mean_t data_mean,
+                                message_type_t data_type, const void *data,
+                                size_t data_len);
+uint8_t message_send_large_data(message_mean_t data_mean,
+                                message_type_t data_type, const void *data,
+                                size_t data_len);
+bool message_get_tx_stats(UART_HandleTypeDef *huart,
+                          message_priority_t priority,
+                          message_tx_stats_t *stats);
+
+/**
+ * @brief 打包帧, 把多条消息合并成一帧, 只启动一次DMA发送
+ * @note 只能打包发送串口相同的消息, 发送串口由第一条消息决定
+ */
+typedef struct {
+    UART_HandleTypeDef *send_handle;   /*!< 发送串口句柄 */
+    uint8_t length;                    /*!< 已打包的长度 */
+    uint8_t buf[MSG_MAX_BATCH_LENGTH]; /*!< 打包的消息, 每条为
+                                            | 含义/类型 | 长度 | 数据 | */
+} message_batch_t;
+
+void message_batch_init(message_batch_t *batch);
+uint8_t message_batch_add(message_batch_t *batch, message_mean_t data_mean,
+                          message_type_t data_type, const void *data,
+                          size_t data_len);
+void message_batch_send(message_batch_t *batch);
+
+#if (MSG_RELIABLE_ENABLE == 1)
+bool message_reliable_enable(message_mean_t data_mean);
+uint8_t message_send_reliable(message_priority_t priority,
+                              message_mean_t data_mean,
+                              message_type_t data_type, const void *data,
+                              size_t data_len);
+bool message_get_reliable_stats(message_mean_t data_mean,
+                                message_reliable_stats_t *stats);
+#endif /* MSG_RELIABLE_ENABLE == 1 */
+
+#if (MSG_BAUD_ENABLE == 1)
+bool message_baud_enable(UART_HandleTypeDef *huart, uint32_t max_baud_rate,
+                         bool initiator);
+bool message_get_baud_stats(UART_HandleTypeDef *huart,
+                            message_baud_stats_t *stats);
+uint32_t message_baud_next_timeout(void);
+#endif /* MSG_BAUD_ENABLE == 1 */
 
 void message_add_polling_handle(UART_HandleTypeDef *uart_handle);
 void message_remove_polling_handle(UART_HandleTypeDef *uart_handle);
+bool message_get_polling_stats(UART_HandleTypeDef *huart,
+                               message_polling_stats_t *stats);
+bool message_get_link_stats(UART_HandleTypeDef *huart,
+                            message_link_stats_t *stats);
+
+bool message_add_route(UART_HandleTypeDef *src, message_mean_t data_mean,
+                       UART_HandleTypeDef *dst, message_priority_t priority);
+void message_remove_route(UART_HandleTypeDef *src, message_mean_t data_mean);
 
-uint8_t message_polling_data(void);
+bool message_polling_data(void);
 
 #endif /* __MSG_PROTOCOL_H */
@@ -31,6 +31,8 @@
  void remote_report_task(void *pvParameters);
  void remote_register_key_callback(uint8_t key, remote_key_callback_t callback);
  void remote_unregister_key_callback(uint8_t key);
+ uint32_t remote_heartbeat_age(void);
+ bool remote_is_online(void);
  
  #endif /* __REMOTE_CTRL_H */
  
\ No newline at end of file
@@ -30,6 +30,8 @@ static enum {
 } chassis_status = STATUS_ARRIVE;
 
 static void send_chassis_status(void);
+static void send_chassis_message(chassis_message_t send_data,
+                                 message_priority_t priority);
 /* 接收到的点位 */
 static pos_point_t receive_point;
 /**
@@ -58,8 +60,6 @@ static void chassis_msg_callback(uint8_t msg_length, message_type_t msg_type,
 void main_message_process(chassis_message_t main_message,
                           uint8_t point_number) {
 
-    chassis_message_t send_data;
-
     switch (main_message) {
         case CHASSIS_GET_STATE: {
             send_chassis_status();
@@ -70,9 +70,7 @@ void main_message_process(chassis_message_t main_message,
                 /* 在跑的过程中主板复位, 可能有问题, 停止 */
                 chassis_status = STATUS_MAIN_ERROR;
             } else {
-                send_data = CHASSIS_INIT;
-                message_send_data(MSG_CHASSIS, MSG_DATA_UINT8, &send_data,
-                                  sizeof(send_data));
+                send_chassis_message(CHASSIS_INIT, MSG_PRIORITY_NORMAL);
             }
         } break;
 
@@ -90,9 +88,7 @@ void main_message_process(chassis_message_t main_message,
             // }
 
             msg_point_number = point_number;
-            send_data = CHASSIS_RECEIVED;
-            message_send_data(MSG_CHASSIS, MSG_DATA_UINT8, &send_data,
-                              sizeof(send_data));
+            send_chassis_message(CHASSIS_RECEIVED, MSG_PRIORITY_NORMAL);
 
             if (point_number <= 5) {
                 /* 归仓点 */
@@ -134,8 +130,24 @@ void send_chassis_status(void) {
             send_data = CHASSIS_ERROR;
         } break;
     }
-    message_send_data(MSG_CHASSIS, MSG_DATA_UINT8, &send_data,
-                      sizeof(send_data));
+    message_send_data_priority(MSG_PRIORITY_HIGH, MSG_CHASSIS, MSG_DATA_UINT8,
+                               &send_data, sizeof(send_data));
+}
+
+/**
+  * @brief 通过可靠传输给主板发送消息, 丢失后自动重传
+  *
+  * @param send_data 消息内容
+  * @param priority 发送优先级
+  * @note 发送窗口满时等待主板确认
+  */
+static void send_chassis_message(chassis_message_t send_data,
+                                 message_priority_t priority) {
+    while (message_send_reliable(priority, MSG_CHASSIS, MSG_DATA_UINT8,
+                                 &send_data, sizeof(send_data)) ==
+           MSG_RELIABLE_FULL) {
+        vTaskDelay(1);
+    }
 }
 
 /**
@@ -165,14 +177,11 @@ void chassis_auto_run(void *pvParameters) {
 
     /** 发送初始化完毕信息 *****************************************/
     message_register_send_handle(MSG_CHASSIS, &usart6_handle);
-    chassis_message_t send_data = CHASSIS_INIT;
-    message_send_data(MSG_CHASSIS, MSG_DATA_UINT8, &send_data,
-                      sizeof(send_data));
+    message_reliable_enable(MSG_CHASSIS);
+    send_chassis_message(CHASSIS_INIT, MSG_PRIORITY_NORMAL);
 
     bool is_arrive = false;
 
-    send_data = CHASSIS_ARRIVE; /* 到达后给主板发送消息 */
-
     while (1) {
         switch (chassis_status) {
             case STATUS_GO_POINT: {
@@ -231,9 +240,8 @@ void chassis_auto_run(void *pvParameters) {
             act_position_reset_data();
         }
 
-        send_data = CHASSIS_ARRIVE;
-        message_send_data(MSG_CHASSIS, MSG_DATA_UINT8, &send_data,
-                          sizeof(send_data));
+        /* 到达后给主板发送消息 */
+        send_chassis_message(CHASSIS_ARRIVE, MSG_PRIORITY_HIGH);
         chassis_status = STATUS_ARRIVE;
         msg_point_number = 8;
     }
@@ -8,18 +8,27 @@
  */
 
 #include "msg_protocol.h"
+#include "crc16.h"
 #include "string.h"
 
+#include <stdatomic.h>
 
-#if SYS_SUPPORT_OS
+#if (MSG_RELIABLE_ENABLE == 1) || (MSG_LINK_STATS_PERIOD_MS > 0)
 #include "FreeRTOS.h"
-#endif /* SYS_SUPPORT_OS */
+#include "timers.h"
+#endif /* MSG_RELIABLE_ENABLE == 1 || MSG_LINK_STATS_PERIOD_MS > 0 */
 
 /**
  * @brief 回调函数指针
  */
 static msg_recv_callback_t p_receive_callback[MSG_MEAN_LENGTH_RESERVE] = {NULL};
 
+/**
+ * @brief 分片传输回调函数指针
+ */
+static msg_recv_large_callback_t
+    p_receive_large_callback[MSG_MEAN_LENGTH_RESERVE] = {NULL};
+
 /**
  * @brief 串口发送句柄指针
  */
@@ -37,15 +46,545 @@ void message_register_recv_callback(message_mean_t msg_mean,
     p_receive_callback[msg_mean] = msg_callback;
 }
 
+/**
+ * @brief 注册分片传输重组完成的回调函数指针
+ *
+ * @param msg_mean 数据含义
+ * @param msg_callback 回调指针
+ * @note 不注册时, 总长度不超过255的分片传输交给普通回调函数
+ */
+void message_register_recv_large_callback(
+    message_mean_t msg_mean, msg_recv_large_callback_t msg_callback) {
+    p_receive_large_callback[msg_mean] = msg_callback;
+}
+
+/* 帧中实际可能出现的最大数据区长度 */
+#define MSG_MAX_FRAME_DATA_LENGTH                                              \
+    ((MSG_MAX_BATCH_LENGTH > MSG_MAX_DATA_LENGTH) ? MSG_MAX_BATCH_LENGTH       \
+                                                  : MSG_MAX_DATA_LENGTH)
+
+/**
+ * @brief 发送队列中的一帧
+ */
+typedef struct {
+    atomic_uint sequence; /*!< 槽位序号, 用于判断槽位空闲或已填好 */
+    uint32_t stamp;       /*!< 入队时的DWT周期数, 用于统计等待时间 */
+    uint8_t length;       /*!< 帧长度 */
+    uint8_t frame[MSG_MAX_FRAME_DATA_LENGTH + MSG_FRAME_OVERHEAD]; /*!< 帧 */
+} msg_tx_slot_t;
+
+/**
+ * @brief 一个优先级的发送通道
+ */
+typedef struct {
+    atomic_uint enqueue_pos;                /*!< 入队位置 */
+    uint32_t dequeue_pos;                   /*!< 出队位置, 持有busy才能修改 */
+    atomic_uint dropped;                    /*!< 队列满丢弃的帧数 */
+    uint32_t max_depth;                     /*!< 开始发送时的最大排队帧数 */
+    uint32_t sent;                          /*!< 已开始发送的帧数 */
+    uint32_t failed;                        /*!< DMA出错丢弃的帧数 */
+    uint32_t wait_max;                      /*!< 最长等待周期数 */
+    uint64_t wait_sum;                      /*!< 等待周期数总和 */
+    msg_tx_slot_t slot[MSG_TX_QUEUE_DEPTH]; /*!< 帧槽位 */
+} msg_tx_lane_t;
+
+#if (MSG_BAUD_ENABLE == 1)
+/* 链路控制通道, 在所有优先级之前发送, 暂停发送时也不停止 */
+#define MSG_TX_LANE_CONTROL MSG_PRIORITY_NUM
+#define MSG_TX_LANE_NUM     (MSG_PRIORITY_NUM + 1)
+#else /* MSG_BAUD_ENABLE == 1 */
+#define MSG_TX_LANE_NUM MSG_PRIORITY_NUM
+#endif /* MSG_BAUD_ENABLE == 1 */
+
+/**
+ * @brief 串口发送队列
+ * @note 多个任务可以同时入队(无锁, CAS抢占槽位), 取出与启动DMA只在持有
+ *       `busy`的一方进行: 要么是入队后启动发送的任务, 要么是发送完成中断.
+ *       DMA直接发送槽位中的帧, 发送完成后才释放槽位.
+ *       每次启动发送都从高优先级通道开始找, 所以控制帧最多等待正在发送
+ *       的一帧.
+ */
+typedef struct {
+    UART_HandleTypeDef *huart;           /*!< 发送串口 */
+    atomic_bool busy;                    /*!< 发送权, DMA发送中为true */
+    atomic_bool paused;                  /*!< 暂停发送, 切换波特率时使用 */
+    msg_tx_lane_t *active;               /*!< 正在发送的通道 */
+    msg_tx_lane_t lane[MSG_TX_LANE_NUM]; /*!< 各优先级通道 */
+} msg_tx_queue_t;
+
+static msg_tx_queue_t tx_queue[MSG_TX_QUEUE_NUM];
+
+/**
+ * @brief 查找串口的发送队列
+ *
+ * @param huart 串口句柄
+ * @return 发送队列, 没有则返回`NULL`
+ */
+static msg_tx_queue_t *message_tx_queue_find(UART_HandleTypeDef *huart) {
+    for (uint32_t i = 0; i < MSG_TX_QUEUE_NUM; ++i) {
+        if (tx_queue[i].huart == huart) {
+            return &tx_queue[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief 获取串口的发送队列, 没有则分配一个
+ *
+ * @param huart 串口句柄
+ * @return 发送队列, 没有空闲队列时返回`NULL`
+ */
+static msg_tx_queue_t *message_tx_queue_get(UART_HandleTypeDef *huart) {
+    msg_tx_queue_t *queue = message_tx_queue_find(huart);
+    if (queue != NULL) {
+        return queue;
+    }
+
+    queue = message_tx_queue_find(NULL);
+    if (queue == NULL) {
+        return NULL;
+    }
+
+    memset(queue, 0, sizeof(msg_tx_queue_t));
+    atomic_init(&queue->busy, false);
+    atomic_init(&queue->paused, false);
+    for (uint32_t i = 0; i < MSG_TX_LANE_NUM; ++i) {
+        msg_tx_lane_t *lane = &queue->lane[i];
+
+        atomic_init(&lane->enqueue_pos, 0);
+        atomic_init(&lane->dropped, 0);
+        for (uint32_t j = 0; j < MSG_TX_QUEUE_DEPTH; ++j) {
+            atomic_init(&lane->slot[j].sequence, j);
+        }
+    }
+    queue->huart = huart;
+
+    return queue;
+}
+
+#if (MSG_LINK_STATS_PERIOD_MS > 0)
+/* 定义在轮询部分, 注册`MSG_LINK_STATS`的发送串口时开启报告定时器 */
+static void message_link_stats_enable(bool enable);
+#endif /* MSG_LINK_STATS_PERIOD_MS > 0 */
+
 /**
  * @brief 注册数据发送句柄
  *
  * @param msg_mean 数据含义
  * @param msg_send_handle 发送串口句柄
+ * @note 串口使能了DMA发送时会为其分配发送队列, 请在启动发送之前注册
  */
 void message_register_send_handle(message_mean_t msg_mean,
                                 UART_HandleTypeDef *msg_send_handle) {
+    if ((msg_send_handle != NULL) && (msg_send_handle->hdmatx != NULL)) {
+        message_tx_queue_get(msg_send_handle);
+    }
     p_send_handle[msg_mean] = msg_send_handle;
+
+#if (MSG_LINK_STATS_PERIOD_MS > 0)
+    if (msg_mean == MSG_LINK_STATS) {
+        message_link_stats_enable(msg_send_handle != NULL);
+    }
+#endif /* MSG_LINK_STATS_PERIOD_MS > 0 */
+}
+
+#if (MSG_FRAME_VERSION >= 2)
+/**
+ * @brief 每种数据含义的发送序号, 含义占4位, 包括打包帧
+ */
+static atomic_uchar tx_sequence[16];
+#endif /* MSG_FRAME_VERSION >= 2 */
+
+#if (MSG_FRAME_VERSION == 3)
+/**
+ * @brief 原地COBS编码
+ *
+ * @param[in,out] buf 第0字节留给编码字节, 之后是`len`字节原始数据
+ * @param len 原始数据长度, 必须小于254, 这样不需要插入额外的编码字节
+ * @note 编码后每个0x00被替换为到下一个0x00(或末尾)的距离,
+ *       第0字节为到第一个0x00的距离
+ */
+static inline void message_cobs_encode(uint8_t *buf, size_t len) {
+    uint8_t *code = buf;
+    uint8_t distance = 1;
+
+    for (size_t i = 1; i <= len; ++i) {
+        if (buf[i] == 0x00) {
+            *code = distance;
+            code = &buf[i];
+            distance = 1;
+        } else {
+            ++distance;
+        }
+    }
+    *code = distance;
+}
+#endif /* MSG_FRAME_VERSION == 3 */
+
+/**
+ * @brief 按帧格式填充一帧数据
+ *
+ * @param[out] frame 帧缓冲区, 长度至少为`data_len + MSG_FRAME_OVERHEAD`
+ * @param data_mean 数据含义(`message_mean_t`或`MSG_BATCH_MEAN`)
+ * @param data_type 数据类型
+ * @param data 数据内容
+ * @param data_len 数据长度
+ */
+static inline void message_fill_frame(uint8_t *frame, uint8_t data_mean,
+                                      message_type_t data_type,
+                                      const void *data, size_t data_len) {
+#if (MSG_FRAME_VERSION == 2)
+    /* 同步字 */
+    frame[0] = MSG_FRAME_SYNC_0;
+    frame[1] = MSG_FRAME_SYNC_1;
+    /* 高四位标记帧格式版本, 低四位保留 */
+    frame[2] = (uint8_t)(MSG_FRAME_VERSION << 4);
+    /* 发送序号, 可能有多个任务同时发送 */
+    frame[3] = atomic_fetch_add_explicit(&tx_sequence[data_mean], 1,
+                                         memory_order_relaxed);
+    /* 以下与版本1相同, 指针后移四个字节 */
+    frame += 4;
+#elif (MSG_FRAME_VERSION == 3)
+    /* 第0字节留给COBS编码字节, 其余与版本2相同, 只是没有同步字 */
+    frame[1] = (uint8_t)(MSG_FRAME_VERSION << 4);
+    frame[2] = atomic_fetch_add_explicit(&tx_sequence[data_mean], 1,
+                                         memory_order_relaxed);
+    frame += 3;
+#endif /* MSG_FRAME_VERSION == 2 */
+
+    /* 第一个字节, 高四位标记含义, 低四位标记数据类型 */
+    frame[0] = (uint8_t)(data_mean << 4) | data_type;
+    /* 第二个字节, 标记数据长度 */
+    frame[1] = (uint8_t)data_len;
+    /* 数据区 */
+    memcpy(frame + 2, data, data_len);
+
+#if (MSG_FRAME_VERSION >= 2)
+    /* 从版本字节到数据末尾计算CRC, 高字节在前 */
+    uint16_t crc = crc16_calc(frame - 2, data_len + 4);
+    frame[data_len + 2] = (uint8_t)(crc >> 8);
+    frame[data_len + 3] = (uint8_t)crc;
+#else  /* MSG_FRAME_VERSION >= 2 */
+    /* 最后一个字节, 标记数据末尾 */
+    frame[data_len + 2] = 0xFF;
+#endif /* MSG_FRAME_VERSION >= 2 */
+
+#if (MSG_FRAME_VERSION == 3)
+    /* 从版本字节到CRC原地编码, 最后补上分隔符 */
+    message_cobs_encode(frame - 3, data_len + 6);
+    frame[data_len + 4] = 0x00;
+#endif /* MSG_FRAME_VERSION == 3 */
+}
+
+/**
+ * @brief 获取通道队首的槽位
+ *
+ * @param lane 发送通道
+ * @return 队首槽位, 还没有填好的帧时返回`NULL`
+ */
+static inline msg_tx_slot_t *message_tx_lane_head(msg_tx_lane_t *lane) {
+    msg_tx_slot_t *slot =
+        &lane->slot[lane->dequeue_pos & (MSG_TX_QUEUE_DEPTH - 1)];
+
+    if (atomic_load_explicit(&slot->sequence, memory_order_acquire) !=
+        lane->dequeue_pos + 1) {
+        return NULL;
+    }
+
+    return slot;
+}
+
+/**
+ * @brief 按优先级查找第一个有帧待发送的通道
+ *
+ * @param queue 发送队列
+ * @return 发送通道, 都没有帧或暂停时只剩普通通道有帧时返回`NULL`
+ */
+static msg_tx_lane_t *message_tx_lane_ready(msg_tx_queue_t *queue) {
+#if (MSG_BAUD_ENABLE == 1)
+    if (message_tx_lane_head(&queue->lane[MSG_TX_LANE_CONTROL]) != NULL) {
+        return &queue->lane[MSG_TX_LANE_CONTROL];
+    }
+    if (atomic_load_explicit(&queue->paused, memory_order_acquire)) {
+        return NULL;
+    }
+#endif /* MSG_BAUD_ENABLE == 1 */
+
+    for (uint32_t i = 0; i < MSG_PRIORITY_NUM; ++i) {
+        if (message_tx_lane_head(&queue->lane[i]) != NULL) {
+            return &queue->lane[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief 取得发送权后启动DMA发送优先级最高的帧
+ *
+ * @param queue 发送队列
+ * @note 任务与发送完成中断都会调用, 只有拿到`busy`的一方会启动DMA
+ */
+static void message_tx_kick(msg_tx_queue_t *queue) {
+    bool retried = false;
+
+    while (!atomic_exchange_explicit(&queue->busy, true,
+                                     memory_order_acquire)) {
+        msg_tx_lane_t *lane = message_tx_lane_ready(queue);
+
+        if (lane == NULL) {
+            atomic_store_explicit(&queue->busy, false, memory_order_release);
+
+            /* 释放发送权后再检查一次, 防止其他任务在此期间入队却没有启动发送 */
+            if (message_tx_lane_ready(queue) == NULL) {
+                return;
+            }
+            continue;
+        }
+
+        msg_tx_slot_t *slot = message_tx_lane_head(lane);
+        uint32_t depth =
+            atomic_load_explicit(&lane->enqueue_pos, memory_order_relaxed) -
+            lane->dequeue_pos;
+        uint32_t wait = DWT->CYCCNT - slot->stamp;
+
+        queue->active = lane;
+        if (HAL_UART_Transmit_DMA(queue->huart, slot->frame, slot->length) ==
+            HAL_OK) {
+            /* 发送权交给发送完成中断 */
+            ++lane->sent;
+            lane->wait_sum += wait;
+            if (wait > lane->wait_max) {
+                lane->wait_max = wait;
+            }
+            if (depth > lane->max_depth) {
+                lane->max_depth = depth;
+            }
+            return;
+        }
+
+        /* 串口被其他代码占用, 等它的发送完成中断再试. 释放发送权之前
+           它可能已经完成, 那次中断拿不到发送权, 所以串口空闲时再试一次 */
+        queue->active = NULL;
+        atomic_store_explicit(&queue->busy, false, memory_order_release);
+        if ((retried) || (queue->huart->gState != HAL_UART_STATE_READY)) {
+            return;
+        }
+        retried = true;
+    }
+}
+
+/**
+ * @brief DMA发送完成, 释放刚发送的槽位并发送下一帧
+ *
+ * @param huart 串口句柄
+ * @note 在发送完成中断中调用, 覆盖`UART_STM32F4xx.c`中的弱定义.
+ *       串口的其他发送(例如驱动的双缓冲区)完成时也会调用, 此时不释放槽位,
+ *       但同样尝试启动发送, 之前因串口被占用没有发出的帧在这里接着发送
+ * @note 发送DMA出错时驱动在错误中断中也调用这里, 此时错误码含
+ *       `HAL_UART_ERROR_DMA`. 这一帧没有完整发出, 丢弃并计入`failed`,
+ *       同样释放槽位与发送权, 否则队列再也不会发送. 需要送达的消息
+ *       用可靠传输重发
+ * @note 串口的发送DMA由双缓冲区与本队列共用, 谁启动的发送谁占用串口.
+ *       每次发送完成时驱动先调用这里, 再让双缓冲区启动待发的数据,
+ *       所以这里的`pTxBuffPtr`一定是刚完成的发送. 双缓冲区先启动会改写它,
+ *       本队列的帧就认不出来, 槽位再也不会释放
+ */
+void uart_dmatx_cplt_callback(UART_HandleTypeDef *huart) {
+    msg_tx_queue_t *queue = message_tx_queue_find(huart);
+    if (queue == NULL) {
+        return;
+    }
+
+    msg_tx_lane_t *lane = queue->active;
+    if ((lane != NULL) &&
+        atomic_load_explicit(&queue->busy, memory_order_acquire)) {
+        msg_tx_slot_t *slot =
+            &lane->slot[lane->dequeue_pos & (MSG_TX_QUEUE_DEPTH - 1)];
+
+        /* DMA发送时`pTxBuffPtr`保持为起始地址, 据此判断是不是本队列的帧 */
+        if (huart->pTxBuffPtr == slot->frame) {
+            if ((HAL_UART_GetError(huart) & HAL_UART_ERROR_DMA) != 0U) {
+                ++lane->failed;
+            }
+            atomic_store_explicit(&slot->sequence,
+                                  lane->dequeue_pos + MSG_TX_QUEUE_DEPTH,
+                                  memory_order_release);
+            ++lane->dequeue_pos;
+            queue->active = NULL;
+            atomic_store_explicit(&queue->busy, false, memory_order_release);
+        }
+    }
+
+    /* 由`busy`的交换决定谁启动发送, 正在启动的任务持有时这里直接返回 */
+    message_tx_kick(queue);
+}
+
+/**
+ * @brief 在发送通道中抢占一个空闲槽位
+ *
+ * @param lane 发送通道
+ * @param[out] pos 槽位的入队位置, 填好后传给`message_tx_slot_publish`
+ * @return 槽位, 通道满时返回`NULL`
+ */
+static msg_tx_slot_t *message_tx_slot_claim(msg_tx_lane_t *lane,
+                                            uint32_t *pos_out) {
+    msg_tx_slot_t *slot;
+    uint32_t pos =
+        atomic_load_explicit(&lane->enqueue_pos, memory_order_relaxed);
+
+    while (1) {
+        slot = &lane->slot[pos & (MSG_TX_QUEUE_DEPTH - 1)];
+        uint32_t seq =
+            atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        int32_t diff = (int32_t)(seq - pos);
+
+        if (diff == 0) {
+            /* 槽位空闲, 抢占该位置 */
+            if (atomic_compare_exchange_weak_explicit(
+                    &lane->enqueue_pos, &pos, pos + 1, memory_order_relaxed,
+                    memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            /* 通道已满 */
+            return NULL;
+        } else {
+            /* 被其他任务抢先, 重新读取入队位置 */
+            pos = atomic_load_explicit(&lane->enqueue_pos,
+                                       memory_order_relaxed);
+        }
+    }
+
+    *pos_out = pos;
+    return slot;
+}
+
+/**
+ * @brief 标记槽位已填好, 然后启动发送
+ *
+ * @param queue 发送队列
+ * @param slot 已填好帧与长度的槽位
+ * @param pos `message_tx_slot_claim`返回的入队位置
+ */
+static void message_tx_slot_publish(msg_tx_queue_t *queue,
+                                    msg_tx_slot_t *slot, uint32_t pos) {
+    slot->stamp = DWT->CYCCNT;
+    atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+
+    message_tx_kick(queue);
+}
+
+/**
+ * @brief 组帧并写入发送通道, 然后启动发送
+ *
+ * @param queue 发送队列
+ * @param priority 优先级
+ * @param data_mean 数据含义(`message_mean_t`或`MSG_BATCH_MEAN`)
+ * @param data_type 数据类型
+ * @param data 数据内容
+ * @param data_len 数据长度
+ * @return 是否入队, 通道满时返回`false`, 由调用者决定丢弃或等待
+ */
+static bool message_tx_enqueue(msg_tx_queue_t *queue,
+                               message_priority_t priority, uint8_t data_mean,
+                               message_type_t data_type, const void *data,
+                               size_t data_len) {
+    uint32_t pos;
+    msg_tx_slot_t *slot = message_tx_slot_claim(&queue->lane[priority], &pos);
+    if (slot == NULL) {
+        return false;
+    }
+
+    /* 直接在槽位中组帧, DMA也直接从槽位发送 */
+    message_fill_frame(slot->frame, data_mean, data_type, data, data_len);
+    slot->length = (uint8_t)(data_len + MSG_FRAME_OVERHEAD);
+    message_tx_slot_publish(queue, slot, pos);
+    return true;
+}
+
+/**
+ * @brief 组帧并通过指定串口发送
+ *
+ * @param send_handle 发送串口句柄
+ * @param priority 优先级
+ * @param data_mean 数据含义(`message_mean_t`, `MSG_BATCH_MEAN`
+ *                  或`MSG_FRAGMENT_MEAN`)
+ * @param data_type 数据类型
+ * @param data 数据内容
+ * @param data_len 数据长度
+ * @return 是否发送或入队, 通道满时丢弃该帧并计数, 返回`false`
+ * @note 从不等待通道腾出槽位
+ */
+static bool message_send_frame(UART_HandleTypeDef *send_handle,
+                               message_priority_t priority, uint8_t data_mean,
+                               message_type_t data_type, const void *data,
+                               size_t data_len) {
+    if (send_handle->hdmatx == NULL) {
+        /* 没有DMA, 在栈上组帧后阻塞发送 */
+        uint8_t data_buf[MSG_MAX_FRAME_DATA_LENGTH + MSG_FRAME_OVERHEAD];
+        message_fill_frame(data_buf, data_mean, data_type, data, data_len);
+        HAL_UART_Transmit(send_handle, data_buf, data_len + MSG_FRAME_OVERHEAD,
+                          0xFFFF);
+        return true;
+    }
+
+    msg_tx_queue_t *queue = message_tx_queue_get(send_handle);
+    if (queue == NULL) {
+        /* 发送队列已用完, 增大`MSG_TX_QUEUE_NUM` */
+        return false;
+    }
+
+    if (!message_tx_enqueue(queue, priority, data_mean, data_type, data,
+                            data_len)) {
+        atomic_fetch_add_explicit(&queue->lane[priority].dropped, 1,
+                                  memory_order_relaxed);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief 发送通道的空闲槽位数
+ *
+ * @param send_handle 发送串口句柄
+ * @param priority 优先级
+ * @return 空闲槽位数, 没有DMA发送的串口不经过通道, 返回`MSG_TX_QUEUE_DEPTH`
+ * @note 其他任务可能同时入队, 结果只是一个参考
+ */
+static uint32_t message_tx_lane_free(UART_HandleTypeDef *send_handle,
+                                     message_priority_t priority) {
+    if (send_handle->hdmatx == NULL) {
+        return MSG_TX_QUEUE_DEPTH;
+    }
+
+    msg_tx_queue_t *queue = message_tx_queue_get(send_handle);
+    if (queue == NULL) {
+        return 0;
+    }
+
+    msg_tx_lane_t *lane = &queue->lane[priority];
+    uint32_t depth =
+        atomic_load_explicit(&lane->enqueue_pos, memory_order_relaxed) -
+        lane->dequeue_pos;
+
+    return (depth >= MSG_TX_QUEUE_DEPTH) ? 0 : (MSG_TX_QUEUE_DEPTH - depth);
+}
+
+/**
+ * @brief 串口的发送队列是否暂停
+ *
+ * @param send_handle 发送串口句柄
+ * @return 切换波特率期间暂停时返回`true`, 没有发送队列时返回`false`
+ */
+static bool message_tx_paused(UART_HandleTypeDef *send_handle) {
+    msg_tx_queue_t *queue = message_tx_queue_find(send_handle);
+
+    return (queue != NULL) &&
+           atomic_load_explicit(&queue->paused, memory_order_acquire);
 }
 
 /**
@@ -55,189 +594,2088 @@ void message_register_send_handle(message_mean_t msg_mean,
  * @param data_type 数据类型
  * @param data 数据内容
  * @param data_len 数据长度(字节数), 使用`MSG_GET_DATA_ARRAY_LENGTH`宏获取即可
+ * @note 使用普通优先级发送
  */
 void message_send_data(message_mean_t data_mean, message_type_t data_type,
                     void *data, size_t data_len) {
+    message_send_data_priority(MSG_PRIORITY_NORMAL, data_mean, data_type, data,
+                               data_len);
+}
+
+/**
+ * @brief 按指定优先级填充并发送数据
+ *
+ * @param priority 优先级, 控制帧使用`MSG_PRIORITY_HIGH`
+ * @param data_mean 数据含义
+ * @param data_type 数据类型
+ * @param data 数据内容
+ * @param data_len 数据长度(字节数), 使用`MSG_GET_DATA_ARRAY_LENGTH`宏获取即可
+ * @note 下一次启动发送时总是先发送高优先级的帧
+ */
+void message_send_data_priority(message_priority_t priority,
+                                message_mean_t data_mean,
+                                message_type_t data_type, const void *data,
+                                size_t data_len) {
     if (data == NULL || data_len == 0) {
         return;
     }
     if (data_len > MSG_MAX_DATA_LENGTH) {
         return;
     }
+    if (priority >= MSG_PRIORITY_NUM) {
+        return;
+    }
     if (p_send_handle[data_mean] == NULL) {
         return;
     }
-#if SYS_SUPPORT_OS
-    uint8_t *data_buf =
-        (uint8_t *)pvPortMalloc(data_len + 3); /* 发送数据的字节流 */
-#else                                          /* SYS_SUPPORT_OS */
-    uint8_t *data_buf = (uint8_t *)malloc(data_len + 3); /* 发送数据的字节流 */
-#endif                                         /* SYS_SUPPORT_OS */
-
-    /* 复制数据到字节流, 前面空出两个字节用来标记数据 */
-    memcpy((data_buf + 2), data, data_len);
-    /* 第一个字节, 高四位标记含义, 低四位标记数据类型 */
-    *data_buf = (uint8_t)(data_mean << 4) | data_type;
-    /* 第二个字节, 标记数据长度 */
-    *(data_buf + 1) = (uint8_t)data_len;
-    /* 最后一个字节, 标记数据末尾 */
-    *(data_buf + data_len + 2) = 0xFF;
 
-    if (p_send_handle[data_mean]->hdmatx != NULL) {
-        uart_dmatx_write(p_send_handle[data_mean], data_buf, data_len + 3);
-        uart_dmatx_send(p_send_handle[data_mean]);
-    } else {
-        HAL_UART_Transmit(p_send_handle[data_mean], data_buf, data_len + 3,
-                        0xFFFF);
-    }
-#if SYS_SUPPORT_OS
-    vPortFree(data_buf);
-#else  /* SYS_SUPPORT_OS */
-    free(data_buf);
-#endif /* SYS_SUPPORT_OS */
+    message_send_frame(p_send_handle[data_mean], priority, data_mean,
+                       data_type, data, data_len);
 }
 
 /**
- * @brief 消息轮询节点链表
- */
-typedef struct polling_list_node {
-    UART_HandleTypeDef *huart;      /*!< 串口句柄 */
-    struct polling_list_node *next; /*!< 链表下一个节点 */
-} polling_list_node_t;
-
-/* 串口轮询链表头指针 */
-static polling_list_node_t *p_polling_list_head = NULL;
-
-/**
- * @brief 添加要轮询的串口句柄, 仅支持DMA
+ * @brief 发送超过`MSG_MAX_DATA_LENGTH`的数据, 拆成多个分片帧
  *
- * @param uart_handle 要添加的串口句柄
+ * @param data_mean 数据含义
+ * @param data_type 数据类型
+ * @param data 数据内容
+ * @param data_len 数据长度, 不能超过`MSG_MAX_FRAGMENT_LENGTH`
+ * @return 发送结果
+ *  @retval `0-MSG_FRAGMENT_OK` - 全部分片已入队
+ *  @retval `1-MSG_FRAGMENT_ERROR` - 参数错误或没有发送串口
+ *  @retval `2-MSG_FRAGMENT_BUSY` - 发送通道放不下全部分片, 稍后重试
+ * @note 不超过`MSG_MAX_DATA_LENGTH`时按普通帧发送, 没有额外开销.
+ *       不等待发送通道, 放不下时一个分片也不发送. 其他任务同时入队导致
+ *       中途放不下时也返回`MSG_FRAGMENT_BUSY`, 接收方丢弃这次不完整的传输.
+ *       同一含义同一时刻只能有一个分片传输, 否则接收方会丢弃交错的传输
  */
-void message_add_polling_handle(UART_HandleTypeDef *uart_handle) {
-    if (uart_handle == NULL) {
-        return;
+uint8_t message_send_large_data(message_mean_t data_mean,
+                                message_type_t data_type, const void *data,
+                                size_t data_len) {
+    static atomic_uchar transfer_id[MSG_MEAN_LENGTH_RESERVE];
+
+    if ((data == NULL) || (data_len == 0) ||
+        (data_len > MSG_MAX_FRAGMENT_LENGTH)) {
+        return MSG_FRAGMENT_ERROR;
+    }
+    if (p_send_handle[data_mean] == NULL) {
+        return MSG_FRAGMENT_ERROR;
     }
 
-    polling_list_node_t *node = p_polling_list_head;
-    while ((node != NULL) && (node->huart != uart_handle)) {
-        node = node->next;
+    if (data_len <= MSG_MAX_DATA_LENGTH) {
+        return message_send_frame(p_send_handle[data_mean],
+                                  MSG_PRIORITY_NORMAL, data_mean, data_type,
+                                  data, data_len)
+                   ? MSG_FRAGMENT_OK
+                   : MSG_FRAGMENT_BUSY;
     }
 
-    if (node != NULL) {
-        return; /* 句柄已存在, 不添加 */
+    uint8_t fragment[MSG_MAX_BATCH_LENGTH];
+    const uint8_t *src = (const uint8_t *)data;
+    uint8_t count = (uint8_t)((data_len + MSG_FRAGMENT_DATA_LENGTH - 1) /
+                              MSG_FRAGMENT_DATA_LENGTH);
+
+    if (message_tx_lane_free(p_send_handle[data_mean], MSG_PRIORITY_NORMAL) <
+        count) {
+        return MSG_FRAGMENT_BUSY;
     }
-#if SYS_SUPPORT_OS
-    polling_list_node_t *new_node =
-        (polling_list_node_t *)pvPortMalloc(sizeof(polling_list_node_t));
-#else  /* SYS_SUPPORT_OS */
-    polling_list_node_t *new_node =
-        (polling_list_node_t *)malloc(sizeof(polling_list_node_t));
-#endif /* SYS_SUPPORT_OS */
 
-    if (new_node == NULL) {
-        return;
+    fragment[0] = (uint8_t)(data_mean << 4) | data_type;
+    fragment[1] = atomic_fetch_add_explicit(&transfer_id[data_mean], 1,
+                                            memory_order_relaxed);
+    fragment[3] = count;
+
+    for (uint8_t index = 0; index < count; ++index) {
+        size_t len = (data_len > MSG_FRAGMENT_DATA_LENGTH)
+                         ? MSG_FRAGMENT_DATA_LENGTH
+                         : data_len;
+
+        fragment[2] = index;
+        memcpy(fragment + MSG_FRAGMENT_HEAD_SIZE, src, len);
+        if (!message_send_frame(p_send_handle[data_mean], MSG_PRIORITY_NORMAL,
+                                MSG_FRAGMENT_MEAN, MSG_DATA_UINT8, fragment,
+                                len + MSG_FRAGMENT_HEAD_SIZE)) {
+            return MSG_FRAGMENT_BUSY;
+        }
+        src += len;
+        data_len -= len;
     }
 
-    new_node->huart = uart_handle;
-    new_node->next = p_polling_list_head;
-    p_polling_list_head = new_node;
+    return MSG_FRAGMENT_OK;
 }
 
+#if (MSG_RELIABLE_ENABLE == 1)
+
+#define MSG_RELIABLE_DATA 0x00U /* 数据帧 */
+#define MSG_RELIABLE_SYNC 0x01U /* 数据帧, 接收方从该帧的序号开始接收 */
+#define MSG_RELIABLE_ACK  0x02U /* 累计确认帧 */
+
 /**
- * @brief 移除要轮询的串口句柄, 仅支持DMA
+ * @brief 可靠传输的一个含义, 发送与接收状态
+ */
+typedef struct {
+    TimerHandle_t timer; /*!< 重传定时器, `NULL`表示没有开启 */
+    uint8_t base;        /*!< 最早未确认的序号 */
+    uint8_t next;        /*!< 下一个发送的序号 */
+    uint8_t retry;       /*!< 连续超时次数 */
+    bool synced;         /*!< 是否收到过确认, 收到前最早的帧是同步帧 */
+
+    /* 发送窗口, 按序号取模存放 */
+    struct {
+        uint8_t priority;                      /*!< 发送优先级 */
+        uint8_t head;                          /*!< 含义/类型 */
+        uint8_t length;                        /*!< 数据长度 */
+        uint8_t data[MSG_MAX_RELIABLE_LENGTH]; /*!< 数据 */
+    } window[MSG_RELIABLE_WINDOW];
+
+    uint8_t expected; /*!< 接收方期望的下一个序号 */
+    bool rx_synced;   /*!< 接收方是否已同步 */
+
+    message_reliable_stats_t stats; /*!< 统计数据 */
+} msg_reliable_t;
+
+static msg_reliable_t msg_reliable[MSG_MEAN_LENGTH_RESERVE];
+
+/**
+ * @brief 发送窗口中的一帧
  *
- * @param uart_handle 要移除的串口句柄
+ * @param reliable 可靠传输状态
+ * @param mean 数据含义
+ * @param seq 序号
+ * @param retransmit 是否是重传
+ * @return 是否发送, 该帧已经被确认时返回`false`
  */
-void message_remove_polling_handle(UART_HandleTypeDef *uart_handle) {
-    if (uart_handle == NULL) {
-        return;
+static bool message_reliable_transmit(msg_reliable_t *reliable, uint8_t mean,
+                                      uint8_t seq, bool retransmit) {
+    uint8_t frame[MSG_MAX_RELIABLE_LENGTH + 2];
+    uint8_t priority;
+    uint8_t length;
+    uint8_t type;
+
+    /* 在临界区内复制, 避免窗口被确认后重新填入新的数据 */
+    taskENTER_CRITICAL();
+    if ((uint8_t)(seq - reliable->base) >=
+        (uint8_t)(reliable->next - reliable->base)) {
+        taskEXIT_CRITICAL();
+        return false;
+    }
+    uint8_t index = seq % MSG_RELIABLE_WINDOW;
+    priority = reliable->window[index].priority;
+    length = reliable->window[index].length;
+    /* 收到确认前, 最早未确认的帧作为同步帧, 接收方从它开始接收 */
+    type = ((!reliable->synced) && (seq == reliable->base)) ? MSG_RELIABLE_SYNC
+                                                              : MSG_RELIABLE_DATA;
+    frame[0] = reliable->window[index].head;
+    frame[1] = seq;
+    memcpy(frame + 2, reliable->window[index].data, length);
+    if (retransmit) {
+        ++reliable->stats.retransmits;
     }
+    taskEXIT_CRITICAL();
 
-    polling_list_node_t *current_node = p_polling_list_head;
-    polling_list_node_t *previous_node = p_polling_list_head;
+    message_send_frame(p_send_handle[mean], (message_priority_t)priority,
+                       MSG_RELIABLE_MEAN, (message_type_t)type, frame,
+                       length + 2);
+    return true;
+}
+
+/**
+ * @brief 重传定时器回调, 重传窗口内所有未确认的帧
+ *
+ * @param timer 定时器句柄, ID为数据含义
+ * @note 在定时器任务中执行, 不能阻塞
+ */
+static void message_reliable_timeout(TimerHandle_t timer) {
+    uint8_t mean = (uint8_t)(uintptr_t)pvTimerGetTimerID(timer);
+    msg_reliable_t *reliable = &msg_reliable[mean];
+    uint8_t base;
+    uint8_t outstanding;
 
-    while ((current_node != NULL) && (current_node->huart != uart_handle)) {
-        previous_node = current_node;
-        current_node = current_node->next;
+    taskENTER_CRITICAL();
+    base = reliable->base;
+    outstanding = reliable->next - reliable->base;
+    if ((outstanding != 0) && (++reliable->retry > MSG_RELIABLE_MAX_RETRY)) {
+        /* 对方一直没有确认, 放弃窗口内的帧, 下一帧重新同步 */
+        reliable->stats.failed += outstanding;
+        reliable->base = reliable->next;
+        reliable->retry = 0;
+        reliable->synced = false;
+        outstanding = 0;
     }
+    taskEXIT_CRITICAL();
 
-    if (current_node == NULL) {
-        /* 句柄不存在 */
+    if (outstanding == 0) {
         return;
     }
 
-    if (previous_node == current_node) {
-        p_polling_list_head = previous_node->next;
+    for (uint8_t i = 0; i < outstanding; ++i) {
+        if (!message_reliable_transmit(reliable, mean, base + i, true)) {
+            break;
+        }
     }
 
-    previous_node->next = current_node->next;
-#if SYS_SUPPORT_OS
-    vPortFree(current_node);
-#else  /* SYS_SUPPORT_OS */
-    free(current_node);
-#endif /* SYS_SUPPORT_OS */
+    xTimerReset(timer, 0);
 }
 
 /**
- * @brief 轮询数据, 并调用相应的函数
+ * @brief 为一种含义开启可靠传输, 收发双方都要调用
  *
- * @return 长度或者状态标记
- *  @retval `0-MSG_NO_DATA` - 没有收到数据, 或者没有接收的串口句柄
- *  @retval `255-MSG_DATA_OVER` - 长度溢出
- *  @retval `254-MSG_DATA_ERROR` - 校验错误, 末尾没有收到0xFF
- *  @retval 1~250 - 本次收到的有效数据
- * @note 事先在message_mean_t定义数据类型, 并注册相应的回调函数.
- *       这个函数挂在一个while循环或者定时器中一直轮询就可以,
- *       不要改动这个函数的任何内容
+ * @param data_mean 数据含义
+ * @return 是否开启成功, 定时器创建失败返回`false`
+ * @note 需要先注册发送串口, 接收方通过它回复确认帧
  */
-uint8_t message_polling_data(void) {
-    /* 轮询链表的指针 */
-    static polling_list_node_t *current_node = NULL;
+bool message_reliable_enable(message_mean_t data_mean) {
+    if (data_mean >= MSG_MEAN_LENGTH_RESERVE) {
+        return false;
+    }
 
-    if (current_node == NULL) {
-        current_node = p_polling_list_head;
-        return MSG_NO_DATA;
+    msg_reliable_t *reliable = &msg_reliable[data_mean];
+    if (reliable->timer != NULL) {
+        return true;
     }
 
-    /* 数据数组 */
-    uint8_t data_buf[MSG_MAX_DATA_LENGTH + 3];
+    /* 上电后从随机序号开始, 对方收到同步帧时不会误判为重复帧 */
+    reliable->base = (uint8_t)DWT->CYCCNT;
+    reliable->next = reliable->base;
+    reliable->retry = 0;
+    reliable->synced = false;
+    reliable->rx_synced = false;
 
-    uint32_t data_len =
-        uart_dmarx_read(current_node->huart, data_buf, sizeof(data_buf));
+    reliable->timer = xTimerCreate(
+        "msg_reliable", pdMS_TO_TICKS(MSG_RELIABLE_TIMEOUT_MS), pdFALSE,
+        (void *)(uintptr_t)data_mean, message_reliable_timeout);
 
-    current_node = current_node->next;
+    return (reliable->timer != NULL);
+}
 
-    /* 无数据 */
-    if (data_len == 0) {
-        return MSG_NO_DATA;
+/**
+ * @brief 可靠发送一条消息, 丢失后自动重传
+ *
+ * @param priority 优先级
+ * @param data_mean 数据含义
+ * @param data_type 数据类型
+ * @param data 数据内容
+ * @param data_len 数据长度, 不能超过`MSG_MAX_RELIABLE_LENGTH`
+ * @return 发送结果
+ *  @retval `0-MSG_RELIABLE_OK` - 已放入发送窗口
+ *  @retval `1-MSG_RELIABLE_FULL` - 发送窗口已满, 稍后重试
+ *  @retval `2-MSG_RELIABLE_ERROR` - 参数错误, 没有开启可靠传输或没有发送串口
+ */
+uint8_t message_send_reliable(message_priority_t priority,
+                              message_mean_t data_mean,
+                              message_type_t data_type, const void *data,
+                              size_t data_len) {
+    if ((data == NULL) || (data_len == 0) ||
+        (data_len > MSG_MAX_RELIABLE_LENGTH) ||
+        (priority >= MSG_PRIORITY_NUM) ||
+        (data_mean >= MSG_MEAN_LENGTH_RESERVE)) {
+        return MSG_RELIABLE_ERROR;
     }
 
-    uint8_t msg_len = *(data_buf + 1);
-
-    /* 数据长度超过最大长度, 为避免异常内存操作, 直接返回 */
-    if (msg_len > MSG_MAX_DATA_LENGTH) {
-        return MSG_DATA_OVER;
+    msg_reliable_t *reliable = &msg_reliable[data_mean];
+    if ((reliable->timer == NULL) || (p_send_handle[data_mean] == NULL)) {
+        return MSG_RELIABLE_ERROR;
     }
 
-    /* 数据帧中定义的长度与实际接收到的长度不一致 */
-    if (data_len != (msg_len + 3)) {
-        return MSG_DATA_LENGTH_ERROR;
+    taskENTER_CRITICAL();
+    uint8_t outstanding = reliable->next - reliable->base;
+    if (outstanding >= MSG_RELIABLE_WINDOW) {
+        taskEXIT_CRITICAL();
+        return MSG_RELIABLE_FULL;
     }
+    uint8_t seq = reliable->next++;
+    uint8_t index = seq % MSG_RELIABLE_WINDOW;
+    reliable->window[index].priority = priority;
+    reliable->window[index].head = (uint8_t)(data_mean << 4) | data_type;
+    reliable->window[index].length = (uint8_t)data_len;
+    memcpy(reliable->window[index].data, data, data_len);
+    ++reliable->stats.sent;
+    taskEXIT_CRITICAL();
 
-    /* 校验字节错误, 最后一位不是0xFF */
-    if (*(data_buf + msg_len + 2) != 0xFF) {
-        return MSG_DATA_VERIFY_ERROR;
+    message_reliable_transmit(reliable, data_mean, seq, false);
+
+    if (outstanding == 0) {
+        /* 窗口原本为空, 开始计时 */
+        xTimerReset(reliable->timer, 0);
     }
 
-    if ((data_buf[0] >> 4) >= MSG_MEAN_LENGTH_RESERVE) {
-        /* 消息下标越界 */
-        return 0;
+    return MSG_RELIABLE_OK;
+}
+
+/**
+ * @brief 获取一种含义的可靠传输统计
+ *
+ * @param data_mean 数据含义
+ * @param[out] stats 统计数据
+ * @return 是否获取成功, 没有开启可靠传输时返回`false`
+ */
+bool message_get_reliable_stats(message_mean_t data_mean,
+                                message_reliable_stats_t *stats) {
+    if ((stats == NULL) || (data_mean >= MSG_MEAN_LENGTH_RESERVE) ||
+        (msg_reliable[data_mean].timer == NULL)) {
+        return false;
     }
 
-    if (p_receive_callback[(data_buf[0] >> 4)] != NULL) {
-        p_receive_callback[(data_buf[0] >> 4)](msg_len, data_buf[0] & 0x0F,
-                                            data_buf + 2);
+    msg_reliable_t *reliable = &msg_reliable[data_mean];
+
+    taskENTER_CRITICAL();
+    *stats = reliable->stats;
+    stats->in_flight = (uint8_t)(reliable->next - reliable->base);
+    taskEXIT_CRITICAL();
+
+    return true;
+}
+
+/**
+ * @brief 处理累计确认, 释放已确认的帧
+ *
+ * @param reliable 可靠传输状态
+ * @param ack 对方期望的下一个序号
+ */
+static void message_reliable_ack(msg_reliable_t *reliable, uint8_t ack) {
+    bool empty;
+
+    taskENTER_CRITICAL();
+    uint8_t acked = ack - reliable->base;
+    uint8_t outstanding = reliable->next - reliable->base;
+    if ((acked == 0) || (acked > outstanding)) {
+        /* 重复或过期的确认 */
+        taskEXIT_CRITICAL();
+        return;
+    }
+    reliable->base = ack;
+    reliable->retry = 0;
+    reliable->synced = true;
+    reliable->stats.acked += acked;
+    empty = (reliable->base == reliable->next);
+    taskEXIT_CRITICAL();
+
+    if (empty) {
+        xTimerStop(reliable->timer, 0);
+    } else {
+        xTimerReset(reliable->timer, 0);
+    }
+}
+
+/**
+ * @brief 处理一帧可靠传输帧
+ *
+ * @param[in] frame 帧缓冲区
+ */
+static void message_reliable_receive(uint8_t *frame) {
+    uint8_t type = frame[0] & 0x0F;
+    uint8_t length = frame[1];
+    uint8_t *msg = frame + 2;
+    uint8_t mean = msg[0] >> 4;
+
+    /* 超过发送方上限的帧不是合法的可靠传输帧 */
+    if ((length < 2) || (length - 2 > MSG_MAX_RELIABLE_LENGTH) ||
+        (mean >= MSG_MEAN_LENGTH_RESERVE)) {
+        return;
+    }
+
+    msg_reliable_t *reliable = &msg_reliable[mean];
+    if (reliable->timer == NULL) {
+        return;
+    }
+
+    if (type == MSG_RELIABLE_ACK) {
+        message_reliable_ack(reliable, msg[1]);
+        return;
+    }
+
+    uint8_t seq = msg[1];
+    uint8_t behind = reliable->expected - seq;
+
+    if ((type == MSG_RELIABLE_SYNC) &&
+        ((!reliable->rx_synced) || (behind == 0) ||
+         (behind > MSG_RELIABLE_WINDOW))) {
+        /* 第一帧, 或对方复位后重新同步 */
+        reliable->expected = seq;
+        reliable->rx_synced = true;
+    }
+
+    if (!reliable->rx_synced) {
+        /* 还没有收到同步帧, 不知道从哪一帧开始, 等待对方超时重传 */
+        return;
+    }
+
+    if (seq == reliable->expected) {
+        ++reliable->expected;
+        if (p_receive_callback[mean] != NULL) {
+            p_receive_callback[mean](length - 2, msg[0] & 0x0F, msg + 2);
+        }
+    } else if ((uint8_t)(reliable->expected - seq) <= MSG_RELIABLE_WINDOW) {
+        /* 确认帧丢失, 对方重传了已收到的帧 */
+        ++reliable->stats.duplicates;
+    }
+
+    /* 收到乱序的帧也回复确认, 对方据此知道要从哪一帧开始重传 */
+    if (p_send_handle[mean] != NULL) {
+        uint8_t ack[2] = {(uint8_t)(mean << 4), reliable->expected};
+        message_send_frame(p_send_handle[mean], MSG_PRIORITY_HIGH,
+                           MSG_RELIABLE_MEAN, (message_type_t)MSG_RELIABLE_ACK,
+                           ack, sizeof(ack));
+    }
+}
+
+#endif /* MSG_RELIABLE_ENABLE == 1 */
+
+/**
+ * @brief 获取串口某个优先级通道的发送统计
+ *
+ * @param huart 串口句柄
+ * @param priority 优先级
+ * @param[out] stats 统计数据
+ * @return 是否获取成功, 该串口没有发送队列时返回`false`
+ * @note 等待时间用DWT周期计数器统计, 计数器在`start_task`中开启
+ */
+bool message_get_tx_stats(UART_HandleTypeDef *huart,
+                          message_priority_t priority,
+                          message_tx_stats_t *stats) {
+    if ((stats == NULL) || (priority >= MSG_PRIORITY_NUM)) {
+        return false;
+    }
+
+    msg_tx_queue_t *queue = message_tx_queue_find(huart);
+    if ((huart == NULL) || (queue == NULL)) {
+        return false;
+    }
+
+    msg_tx_lane_t *lane = &queue->lane[priority];
+    uint32_t cycles_per_us = SystemCoreClock / 1000000U;
+
+    stats->depth =
+        atomic_load_explicit(&lane->enqueue_pos, memory_order_relaxed) -
+        lane->dequeue_pos;
+    stats->max_depth = lane->max_depth;
+    stats->sent = lane->sent;
+    stats->failed = lane->failed;
+    stats->dropped = atomic_load_explicit(&lane->dropped, memory_order_relaxed);
+    stats->wait_max_us = lane->wait_max / cycles_per_us;
+    stats->wait_avg_us =
+        (lane->sent == 0)
+            ? 0
+            : (uint32_t)(lane->wait_sum / lane->sent / cycles_per_us);
+
+    return true;
+}
+
+/**
+ * @brief 初始化打包帧
+ *
+ * @param batch 打包帧
+ */
+void message_batch_init(message_batch_t *batch) {
+    if (batch == NULL) {
+        return;
+    }
+
+    batch->send_handle = NULL;
+    batch->length = 0;
+}
+
+/**
+ * @brief 向打包帧中添加一条消息
+ *
+ * @param batch 打包帧
+ * @param data_mean 数据含义
+ * @param data_type 数据类型
+ * @param data 数据内容
+ * @param data_len 数据长度(字节数), 不能超过`MSG_MAX_DATA_LENGTH`
+ * @return 添加结果
+ *  @retval `0-MSG_BATCH_OK` - 添加成功
+ *  @retval `1-MSG_BATCH_FULL` - 剩余空间不足, 先调用`message_batch_send`发送
+ *  @retval `2-MSG_BATCH_ERROR` - 参数错误, 或该含义的发送串口与打包帧不同
+ */
+uint8_t message_batch_add(message_batch_t *batch, message_mean_t data_mean,
+                          message_type_t data_type, const void *data,
+                          size_t data_len) {
+    if ((batch == NULL) || (data == NULL) || (data_len == 0) ||
+        (data_len > MSG_MAX_DATA_LENGTH)) {
+        return MSG_BATCH_ERROR;
+    }
+
+    if (p_send_handle[data_mean] == NULL) {
+        return MSG_BATCH_ERROR;
+    }
+
+    if (batch->length == 0) {
+        batch->send_handle = p_send_handle[data_mean];
+    } else if (batch->send_handle != p_send_handle[data_mean]) {
+        return MSG_BATCH_ERROR;
+    }
+
+    if (data_len + 2 > (size_t)(MSG_MAX_BATCH_LENGTH - batch->length)) {
+        return MSG_BATCH_FULL;
+    }
+
+    /* 每条消息与单帧的帧头, 长度, 数据区格式相同 */
+    uint8_t *record = batch->buf + batch->length;
+    record[0] = (uint8_t)(data_mean << 4) | data_type;
+    record[1] = (uint8_t)data_len;
+    memcpy(record + 2, data, data_len);
+    batch->length += data_len + 2;
+
+    return MSG_BATCH_OK;
+}
+
+/**
+ * @brief 把打包帧作为一帧发送, 发送后清空打包帧
+ *
+ * @param batch 打包帧
+ */
+void message_batch_send(message_batch_t *batch) {
+    if ((batch == NULL) || (batch->length == 0)) {
+        return;
+    }
+
+    message_send_frame(batch->send_handle, MSG_PRIORITY_NORMAL, MSG_BATCH_MEAN,
+                       MSG_DATA_UINT8, batch->buf, batch->length);
+    message_batch_init(batch);
+}
+
+/**
+ * @brief 帧解析状态
+ */
+typedef enum {
+#if (MSG_FRAME_VERSION == 3)
+    MSG_PARSE_COBS,    /*!< 接收COBS编码的帧 */
+    MSG_PARSE_DISCARD  /*!< 帧过长, 丢弃到下一个0x00 */
+#else                  /* MSG_FRAME_VERSION == 3 */
+#if (MSG_FRAME_VERSION == 2)
+    MSG_PARSE_SYNC_0,  /*!< 等待同步字第一个字节 */
+    MSG_PARSE_SYNC_1,  /*!< 等待同步字第二个字节 */
+    MSG_PARSE_VERSION, /*!< 等待版本字节 */
+    MSG_PARSE_SEQ,     /*!< 等待序号 */
+#endif                 /* MSG_FRAME_VERSION == 2 */
+    MSG_PARSE_HEAD,    /*!< 等待帧头(含义与类型) */
+    MSG_PARSE_LENGTH,  /*!< 等待长度字节 */
+    MSG_PARSE_DATA,    /*!< 接收数据区 */
+#if (MSG_FRAME_VERSION == 2)
+    MSG_PARSE_CRC_0,   /*!< 等待CRC高字节 */
+    MSG_PARSE_CRC_1    /*!< 等待CRC低字节 */
+#else                  /* MSG_FRAME_VERSION == 2 */
+    MSG_PARSE_TAIL,    /*!< 等待帧尾0xFF */
+    MSG_PARSE_RESYNC   /*!< 出错后丢弃数据, 直到收到0xFF再重新同步 */
+#endif                 /* MSG_FRAME_VERSION == 2 */
+#endif                 /* MSG_FRAME_VERSION == 3 */
+} msg_parse_state_t;
+
+#if (MSG_FRAME_VERSION == 1)
+#define MSG_PARSE_START      MSG_PARSE_HEAD   /* 解析起始状态 */
+#define MSG_PARSE_FRAME_SIZE (MSG_MAX_FRAME_DATA_LENGTH + 2)
+#elif (MSG_FRAME_VERSION == 2)
+#define MSG_PARSE_START      MSG_PARSE_SYNC_0 /* 解析起始状态 */
+#define MSG_PARSE_FRAME_SIZE (MSG_MAX_FRAME_DATA_LENGTH + 2)
+#else /* MSG_FRAME_VERSION */
+#define MSG_PARSE_START      MSG_PARSE_COBS   /* 解析起始状态 */
+/* 版本3保存解码后的版本, 序号与CRC */
+#define MSG_PARSE_FRAME_SIZE (MSG_MAX_FRAME_DATA_LENGTH + 6)
+#endif /* MSG_FRAME_VERSION */
+
+/**
+ * @brief 字节流帧解析器, 跨多次读取保存未收完的帧
+ */
+typedef struct {
+    msg_parse_state_t state;                /*!< 解析状态 */
+    uint8_t index;                          /*!< 当前帧已收到的字节数 */
+    uint8_t frame[MSG_PARSE_FRAME_SIZE];    /*!< 帧头, 长度与数据区 */
+#if (MSG_FRAME_VERSION == 2)
+    uint8_t version;                        /*!< 当前帧的版本字节 */
+    uint8_t seq;                            /*!< 当前帧的序号 */
+    uint16_t crc;                           /*!< 已收到部分的CRC */
+    uint16_t crc_recv;                      /*!< 帧中携带的CRC */
+#elif (MSG_FRAME_VERSION == 3)
+    uint8_t code;                           /*!< 当前COBS块剩余字节数 */
+    bool zero_pending;                      /*!< 当前块结束后要补0x00 */
+#endif                                      /* MSG_FRAME_VERSION */
+} msg_parser_t;
+
+#if (MSG_BAUD_ENABLE == 1)
+
+#define MSG_BAUD_PROPOSE   0x00U /* 提议, 波特率为提议的速率 */
+#define MSG_BAUD_ACCEPT    0x01U /* 接受, 双方准备切换 */
+#define MSG_BAUD_REJECT    0x02U /* 拒绝, 波特率为应答方能接受的最高速率 */
+#define MSG_BAUD_PROBE     0x03U /* 探测, 带测试图样 */
+#define MSG_BAUD_PROBE_ACK 0x04U /* 探测回复 */
+#define MSG_BAUD_FALLBACK  0x05U /* 回到基础速率 */
+
+/**
+ * @brief 波特率协商状态
+ */
+typedef enum {
+    MSG_BAUD_IDLE,      /*!< 没有进行中的切换 */
+    MSG_BAUD_PROPOSED,  /*!< 主动方已提议, 等待回复 */
+    MSG_BAUD_SWITCHING, /*!< 已暂停发送, 等待发送完成后切换 */
+    MSG_BAUD_PROBING    /*!< 已切换, 等待新速率下的探测帧或回复 */
+} msg_baud_state_t;
+
+/**
+ * @brief 一个串口的波特率协商状态
+ */
+typedef struct {
+    bool enabled;               /*!< 是否开启协商 */
+    bool initiator;             /*!< 是否是主动方 */
+    msg_baud_state_t state;     /*!< 协商状态 */
+    uint8_t acked;              /*!< 切换后收到的探测回复数 */
+    uint32_t target;            /*!< 正在切换的波特率 */
+    uint32_t deadline;          /*!< 当前状态的超时时刻 */
+    uint32_t last_rx;           /*!< 最后一次收到协商帧的时刻 */
+    uint32_t last_probe;        /*!< 最后一次发送探测帧的时刻 */
+    uint32_t last_check;        /*!< 最后一次检查错误计数的时刻 */
+    uint32_t next_try;          /*!< 主动方下一次提议的时刻 */
+    uint32_t errors;            /*!< 上次检查时的接收错误总数 */
+    message_baud_stats_t stats; /*!< 统计数据, 不含当前波特率 */
+} msg_baud_t;
+
+#endif /* MSG_BAUD_ENABLE == 1 */
+
+/**
+ * @brief 轮询表中的一个串口
+ */
+typedef struct {
+    UART_HandleTypeDef *huart; /*!< 串口句柄, `NULL`表示空闲 */
+    msg_parser_t parser;       /*!< 该串口的帧解析器 */
+    uint32_t frames;           /*!< 收到的完整帧数 */
+    uint32_t overflows;        /*!< 长度溢出次数 */
+    uint32_t verify_errors;    /*!< 校验错误次数 */
+    uint32_t bytes;            /*!< 解析的字节数 */
+#if (MSG_BAUD_ENABLE == 1)
+    msg_baud_t baud;           /*!< 波特率协商状态 */
+#endif /* MSG_BAUD_ENABLE == 1 */
+} msg_polling_port_t;
+
+/* 串口轮询表 */
+static msg_polling_port_t msg_polling_table[MSG_POLLING_HANDLE_NUM];
+
+/**
+ * @brief 查找串口在轮询表中的位置
+ *
+ * @param huart 串口句柄, 为`NULL`时查找空闲位置
+ * @return 轮询表项, 没有找到返回`NULL`
+ */
+static msg_polling_port_t *message_polling_find(UART_HandleTypeDef *huart) {
+    for (uint32_t i = 0; i < MSG_POLLING_HANDLE_NUM; ++i) {
+        if (msg_polling_table[i].huart == huart) {
+            return &msg_polling_table[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief 添加要轮询的串口句柄, 仅支持DMA
+ *
+ * @param uart_handle 要添加的串口句柄
+ * @note 轮询表满时不添加, 增大`MSG_POLLING_HANDLE_NUM`
+ */
+void message_add_polling_handle(UART_HandleTypeDef *uart_handle) {
+    if (uart_handle == NULL) {
+        return;
+    }
+
+    if (message_polling_find(uart_handle) != NULL) {
+        return; /* 句柄已存在, 不添加 */
+    }
+
+    msg_polling_port_t *port = message_polling_find(NULL);
+    if (port == NULL) {
+        return;
+    }
+
+    port->parser.state = MSG_PARSE_START;
+    port->parser.index = 0;
+#if (MSG_FRAME_VERSION == 3)
+    port->parser.code = 0;
+    port->parser.zero_pending = false;
+#endif /* MSG_FRAME_VERSION == 3 */
+    port->frames = 0;
+    port->overflows = 0;
+    port->verify_errors = 0;
+    port->bytes = 0;
+#if (MSG_BAUD_ENABLE == 1)
+    port->baud.enabled = false;
+#endif /* MSG_BAUD_ENABLE == 1 */
+    port->huart = uart_handle;
+}
+
+/**
+ * @brief 移除要轮询的串口句柄, 仅支持DMA
+ *
+ * @param uart_handle 要移除的串口句柄
+ */
+void message_remove_polling_handle(UART_HandleTypeDef *uart_handle) {
+    if (uart_handle == NULL) {
+        return;
+    }
+
+    msg_polling_port_t *port = message_polling_find(uart_handle);
+    if (port == NULL) {
+        /* 句柄不存在 */
+        return;
+    }
+
+    port->huart = NULL;
+}
+
+/**
+ * @brief 获取串口的接收统计
+ *
+ * @param huart 串口句柄
+ * @param[out] stats 统计数据
+ * @return 是否获取成功, 该串口不在轮询表中时返回`false`
+ */
+bool message_get_polling_stats(UART_HandleTypeDef *huart,
+                               message_polling_stats_t *stats) {
+    if ((huart == NULL) || (stats == NULL)) {
+        return false;
+    }
+
+    msg_polling_port_t *port = message_polling_find(huart);
+    if (port == NULL) {
+        return false;
+    }
+
+    stats->frames = port->frames;
+    stats->errors = port->overflows + port->verify_errors;
+    stats->overflows = port->overflows;
+    stats->verify_errors = port->verify_errors;
+    stats->bytes = port->bytes;
+    return true;
+}
+
+/**
+ * @brief 获取串口的链路统计, 包括协议层与串口驱动
+ *
+ * @param huart 串口句柄
+ * @param[out] stats 统计数据
+ * @return 是否获取成功, 该串口不在轮询表中时返回`false`
+ */
+bool message_get_link_stats(UART_HandleTypeDef *huart,
+                            message_link_stats_t *stats) {
+    if ((stats == NULL) || !message_get_polling_stats(huart, &stats->polling)) {
+        return false;
+    }
+
+    if (uart_get_stats(huart, &stats->uart) != 0) {
+        memset(&stats->uart, 0, sizeof(uart_stats_t));
+    }
+    return true;
+}
+
+#if (MSG_BAUD_ENABLE == 1)
+
+/* 协商的候选波特率, 从高到低. 72MHz, 90MHz与45MHz的串口时钟下误差都不超过
+   0.4%, 4.5Mbps在72MHz下需要16倍过采样的最小分频 */
+static const uint32_t msg_baud_rates[] = {
+    4500000, 3000000, 2250000, 1500000, 921600, 460800, 230400,
+    MSG_BAUD_BASE_RATE};
+
+#define MSG_BAUD_RATE_NUM (sizeof(msg_baud_rates) / sizeof(msg_baud_rates[0]))
+
+/* 探测帧的测试图样, 包含连续的0与1以及交替的位 */
+static const uint8_t msg_baud_pattern[] = {0x55, 0xAA, 0x00, 0xFF,
+                                           0x0F, 0xF0, 0x33, 0xCC};
+
+_Static_assert(4 + sizeof(msg_baud_pattern) <= MSG_MAX_DATA_LENGTH,
+               "Baud rate probe must fit in one message.");
+
+/**
+ * @brief 查找本端支持的最高候选波特率
+ *
+ * @param port 轮询表项
+ * @param limit 不超过的波特率
+ * @return 不超过`limit`与上限, 且串口时钟能准确分频的最高候选波特率,
+ *         没有时返回`MSG_BAUD_BASE_RATE`
+ */
+static uint32_t message_baud_best(msg_polling_port_t *port, uint32_t limit) {
+    for (uint32_t i = 0; i < MSG_BAUD_RATE_NUM; ++i) {
+        if ((msg_baud_rates[i] <= limit) &&
+            (msg_baud_rates[i] <= port->baud.stats.ceiling) &&
+            (uart_check_baud_rate(port->huart, msg_baud_rates[i]) ==
+             UART_BAUD_OK)) {
+            return msg_baud_rates[i];
+        }
+    }
+
+    return MSG_BAUD_BASE_RATE;
+}
+
+/**
+ * @brief 查找低一档的候选波特率
+ *
+ * @param baud_rate 波特率
+ * @return 低于`baud_rate`的最高候选波特率, 没有时返回`MSG_BAUD_BASE_RATE`
+ */
+static uint32_t message_baud_below(uint32_t baud_rate) {
+    for (uint32_t i = 0; i < MSG_BAUD_RATE_NUM; ++i) {
+        if (msg_baud_rates[i] < baud_rate) {
+            return msg_baud_rates[i];
+        }
+    }
+
+    return MSG_BAUD_BASE_RATE;
+}
+
+/**
+ * @brief 接收错误总数
+ *
+ * @param port 轮询表项
+ * @return 串口的ORE/FE/NE/PE与协议层的长度溢出, 校验错误之和
+ */
+static uint32_t message_baud_errors(msg_polling_port_t *port) {
+    uint32_t errors = port->overflows + port->verify_errors;
+    uart_stats_t uart;
+
+    if (uart_get_stats(port->huart, &uart) == 0) {
+        errors += uart.ore + uart.fe + uart.ne + uart.pe;
+    }
+
+    return errors;
+}
+
+/**
+ * @brief 暂停或恢复串口的普通发送通道, 链路控制通道不受影响
+ *
+ * @param port 轮询表项
+ * @param pause 是否暂停
+ * @note 暂停期间入队的帧留在通道中, 恢复后按新的波特率发送
+ */
+static void message_baud_pause(msg_polling_port_t *port, bool pause) {
+    msg_tx_queue_t *queue = message_tx_queue_find(port->huart);
+    if (queue == NULL) {
+        return;
+    }
+
+    atomic_store_explicit(&queue->paused, pause, memory_order_release);
+    if (!pause) {
+        message_tx_kick(queue);
+    }
+}
+
+/**
+ * @brief 通过链路控制通道发送一帧协商帧
+ *
+ * @param port 轮询表项
+ * @param op 操作码
+ * @param baud_rate 波特率
+ */
+static void message_baud_send(msg_polling_port_t *port, uint8_t op,
+                              uint32_t baud_rate) {
+    uint8_t data[4 + sizeof(msg_baud_pattern)];
+    size_t len = 4;
+
+    data[0] = (uint8_t)baud_rate;
+    data[1] = (uint8_t)(baud_rate >> 8);
+    data[2] = (uint8_t)(baud_rate >> 16);
+    data[3] = (uint8_t)(baud_rate >> 24);
+    if (op == MSG_BAUD_PROBE) {
+        memcpy(data + 4, msg_baud_pattern, sizeof(msg_baud_pattern));
+        len += sizeof(msg_baud_pattern);
+    }
+
+    message_send_frame(port->huart, (message_priority_t)MSG_TX_LANE_CONTROL,
+                       MSG_BAUD_MEAN, (message_type_t)op, data, len);
+}
+
+/**
+ * @brief 暂停发送, 等发送完成后切换波特率
+ *
+ * @param port 轮询表项
+ * @param baud_rate 切换到的波特率
+ * @param now 当前时刻
+ */
+static void message_baud_switch(msg_polling_port_t *port, uint32_t baud_rate,
+                                uint32_t now) {
+    port->baud.target = baud_rate;
+    port->baud.deadline = now + MSG_BAUD_TIMEOUT_MS;
+    port->baud.state = MSG_BAUD_SWITCHING;
+    message_baud_pause(port, true);
+}
+
+/**
+ * @brief 新的波特率已确认, 恢复发送
+ *
+ * @param port 轮询表项
+ * @param now 当前时刻
+ */
+static void message_baud_confirm(msg_polling_port_t *port, uint32_t now) {
+    msg_baud_t *baud = &port->baud;
+
+    ++baud->stats.switches;
+    baud->errors = message_baud_errors(port);
+    baud->last_rx = now;
+    baud->last_check = now;
+    baud->state = MSG_BAUD_IDLE;
+    message_baud_pause(port, false);
+}
+
+/**
+ * @brief 回到基础速率
+ *
+ * @param port 轮询表项
+ * @param notify 是否先通知对方, 响应对方的通知时不再通知
+ * @param now 当前时刻
+ * @note 主动方把上限降低到当前波特率的下一档, 隔`MSG_BAUD_RETRY_MS`后
+ *       重新协商
+ */
+static void message_baud_fallback(msg_polling_port_t *port, bool notify,
+                                  uint32_t now) {
+    msg_baud_t *baud = &port->baud;
+    uint32_t current = port->huart->Init.BaudRate;
+
+    if (baud->initiator) {
+        if (current != MSG_BAUD_BASE_RATE) {
+            baud->stats.ceiling = message_baud_below(current);
+        }
+        baud->next_try = now + MSG_BAUD_RETRY_MS;
+    }
+
+    if (notify) {
+        message_baud_send(port, MSG_BAUD_FALLBACK, MSG_BAUD_BASE_RATE);
+    }
+    message_baud_switch(port, MSG_BAUD_BASE_RATE, now);
+}
+
+/**
+ * @brief 开启串口的波特率协商, 链路两端都要调用
+ *
+ * @param huart 串口句柄, 需要先以`MSG_BAUD_BASE_RATE`初始化并添加到轮询表
+ * @param max_baud_rate 本端允许的最高波特率
+ * @param initiator 是否主动协商, 一条链路只能有一个主动方
+ * @return 是否开启成功, 该串口不在轮询表中或没有空闲的发送队列时返回`false`
+ * @note 协商帧直接通过该串口回复, 不需要注册发送句柄
+ */
+bool message_baud_enable(UART_HandleTypeDef *huart, uint32_t max_baud_rate,
+                         bool initiator) {
+    if (huart == NULL) {
+        return false;
+    }
+
+    msg_polling_port_t *port = message_polling_find(huart);
+    if (port == NULL) {
+        return false;
+    }
+
+    if ((huart->hdmatx != NULL) && (message_tx_queue_get(huart) == NULL)) {
+        return false;
+    }
+
+    msg_baud_t *baud = &port->baud;
+    uint32_t now = HAL_GetTick();
+
+    memset(baud, 0, sizeof(msg_baud_t));
+    baud->initiator = initiator;
+    baud->stats.ceiling = max_baud_rate;
+    baud->last_rx = now;
+    baud->next_try = now;
+    baud->enabled = true;
+    return true;
+}
+
+/**
+ * @brief 获取串口的波特率协商统计
+ *
+ * @param huart 串口句柄
+ * @param[out] stats 统计数据
+ * @return 是否获取成功, 该串口没有开启协商时返回`false`
+ */
+bool message_get_baud_stats(UART_HandleTypeDef *huart,
+                            message_baud_stats_t *stats) {
+    if ((huart == NULL) || (stats == NULL)) {
+        return false;
+    }
+
+    msg_polling_port_t *port = message_polling_find(huart);
+    if ((port == NULL) || (!port->baud.enabled)) {
+        return false;
+    }
+
+    *stats = port->baud.stats;
+    stats->baud_rate = huart->Init.BaudRate;
+    return true;
+}
+
+/**
+ * @brief 处理一帧协商帧
+ *
+ * @param port 收到该帧的轮询表项
+ * @param[in] frame 帧缓冲区
+ */
+static void message_baud_receive(msg_polling_port_t *port,
+                                 const uint8_t *frame) {
+    msg_baud_t *baud = &port->baud;
+
+    if ((!baud->enabled) || (frame[1] < 4)) {
+        return;
+    }
+
+    uint8_t op = frame[0] & 0x0F;
+    const uint8_t *data = frame + 2;
+    uint32_t rate = (uint32_t)data[0] | ((uint32_t)data[1] << 8) |
+                    ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+    uint32_t now = HAL_GetTick();
+
+    baud->last_rx = now;
+
+    switch (op) {
+        case MSG_BAUD_PROPOSE: {
+            if ((baud->initiator) || (baud->state != MSG_BAUD_IDLE) ||
+                (rate <= MSG_BAUD_BASE_RATE)) {
+                break;
+            }
+
+            uint32_t best = message_baud_best(port, rate);
+            if (best != rate) {
+                message_baud_send(port, MSG_BAUD_REJECT, best);
+                break;
+            }
+
+            /* 接受帧在控制通道中, 暂停后也会先发出去, 之后再切换 */
+            message_baud_send(port, MSG_BAUD_ACCEPT, rate);
+            message_baud_switch(port, rate, now);
+        } break;
+
+        case MSG_BAUD_ACCEPT: {
+            if ((baud->initiator) && (baud->state == MSG_BAUD_PROPOSED) &&
+                (rate == baud->target)) {
+                message_baud_switch(port, rate, now);
+            }
+        } break;
+
+        case MSG_BAUD_REJECT: {
+            if ((!baud->initiator) || (baud->state != MSG_BAUD_PROPOSED)) {
+                break;
+            }
+
+            /* 按对方能接受的速率立即重新提议 */
+            ++baud->stats.failures;
+            baud->stats.ceiling = (rate < baud->target)
+                                      ? rate
+                                      : message_baud_below(baud->target);
+            baud->next_try = now;
+            baud->state = MSG_BAUD_IDLE;
+            message_baud_pause(port, false);
+        } break;
+
+        case MSG_BAUD_PROBE: {
+            if (baud->initiator) {
+                break;
+            }
+
+            if (baud->state == MSG_BAUD_PROBING) {
+                /* 主动方已经在新速率下发送, 可以恢复发送了 */
+                message_baud_confirm(port, now);
+            }
+            if (baud->state == MSG_BAUD_IDLE) {
+                message_baud_send(port, MSG_BAUD_PROBE_ACK,
+                                  port->huart->Init.BaudRate);
+            }
+        } break;
+
+        case MSG_BAUD_PROBE_ACK: {
+            if ((baud->initiator) && (baud->state == MSG_BAUD_PROBING) &&
+                (++baud->acked >= MSG_BAUD_PROBE_NUM)) {
+                message_baud_confirm(port, now);
+            }
+        } break;
+
+        case MSG_BAUD_FALLBACK: {
+            if ((port->huart->Init.BaudRate != MSG_BAUD_BASE_RATE) ||
+                (baud->state != MSG_BAUD_IDLE)) {
+                ++baud->stats.fallbacks;
+                message_baud_fallback(port, false, now);
+            }
+        } break;
+
+        default: {
+        } break;
+    }
+}
+
+/**
+ * @brief 波特率协商的超时处理, 每次轮询时调用
+ *
+ * @param port 轮询表项
+ * @return 是否切换了波特率. 切换前收到的数据放进接收FIFO时不会唤醒读取方,
+ *         需要再轮询一次
+ */
+static bool message_baud_poll(msg_polling_port_t *port) {
+    msg_baud_t *baud = &port->baud;
+    bool switched = false;
+
+    if (!baud->enabled) {
+        return false;
+    }
+
+    uint32_t now = HAL_GetTick();
+    uint32_t current = port->huart->Init.BaudRate;
+
+    switch (baud->state) {
+        case MSG_BAUD_PROPOSED: {
+            if ((int32_t)(now - baud->deadline) < 0) {
+                break;
+            }
+
+            /* 对方没有回复, 可能没有开启协商 */
+            ++baud->stats.failures;
+            baud->next_try = now + MSG_BAUD_RETRY_MS;
+            baud->state = MSG_BAUD_IDLE;
+            message_baud_pause(port, false);
+        } break;
+
+        case MSG_BAUD_SWITCHING: {
+            uint8_t res = uart_set_baud_rate(port->huart, baud->target);
+            if ((res == UART_BAUD_BUSY) &&
+                ((int32_t)(now - baud->deadline) < 0)) {
+                break;
+            }
+
+            if (res != UART_BAUD_OK) {
+                /* 仍是原来的速率, 对方已切换的话会超时回退 */
+                ++baud->stats.failures;
+                baud->next_try = now + MSG_BAUD_RETRY_MS;
+                baud->state = MSG_BAUD_IDLE;
+                message_baud_pause(port, false);
+                break;
+            }
+
+            switched = true;
+            if (baud->target == MSG_BAUD_BASE_RATE) {
+                baud->state = MSG_BAUD_IDLE;
+                message_baud_pause(port, false);
+                break;
+            }
+
+            /* 应答方收到第一个探测帧时主动方一定已经切换, 在那之前保持暂停 */
+            baud->acked = 0;
+            baud->state = MSG_BAUD_PROBING;
+            if (baud->initiator) {
+                baud->deadline = now + MSG_BAUD_TIMEOUT_MS +
+                                 MSG_BAUD_PROBE_NUM * MSG_BAUD_PROBE_MS;
+                baud->last_probe = now;
+                message_baud_send(port, MSG_BAUD_PROBE, baud->target);
+            } else {
+                baud->deadline = now + MSG_BAUD_LINK_TIMEOUT_MS;
+            }
+        } break;
+
+        case MSG_BAUD_PROBING: {
+            if ((int32_t)(now - baud->deadline) >= 0) {
+                ++baud->stats.failures;
+                message_baud_fallback(port, true, now);
+                break;
+            }
+
+            if ((baud->initiator) &&
+                (now - baud->last_probe >= MSG_BAUD_PROBE_MS)) {
+                baud->last_probe = now;
+                message_baud_send(port, MSG_BAUD_PROBE, current);
+            }
+        } break;
+
+        default: { /* MSG_BAUD_IDLE */
+            if (current == MSG_BAUD_BASE_RATE) {
+                if ((!baud->initiator) ||
+                    ((int32_t)(now - baud->next_try) < 0)) {
+                    break;
+                }
+
+                uint32_t rate = message_baud_best(port, UINT32_MAX);
+                if (rate == MSG_BAUD_BASE_RATE) {
+                    baud->next_try = now + MSG_BAUD_RETRY_MS;
+                    break;
+                }
+
+                /* 提议期间暂停发送, 对方切换后不会收到旧速率的帧 */
+                baud->target = rate;
+                baud->deadline = now + MSG_BAUD_TIMEOUT_MS;
+                baud->state = MSG_BAUD_PROPOSED;
+                message_baud_pause(port, true);
+                message_baud_send(port, MSG_BAUD_PROPOSE, rate);
+                break;
+            }
+
+            if (now - baud->last_rx >= MSG_BAUD_LINK_TIMEOUT_MS) {
+                ++baud->stats.fallbacks;
+                message_baud_fallback(port, true, now);
+                break;
+            }
+
+            if (now - baud->last_check < MSG_BAUD_KEEPALIVE_MS) {
+                break;
+            }
+
+            uint32_t errors = message_baud_errors(port);
+            uint32_t spike = errors - baud->errors;
+            baud->errors = errors;
+            baud->last_check = now;
+            if (spike > MSG_BAUD_ERROR_LIMIT) {
+                ++baud->stats.fallbacks;
+                message_baud_fallback(port, true, now);
+                break;
+            }
+
+            if (baud->initiator) {
+                baud->last_probe = now;
+                message_baud_send(port, MSG_BAUD_PROBE, current);
+            }
+        } break;
+    }
+
+    return switched;
+}
+
+/**
+ * @brief 用一个超时时刻更新最近的超时时间
+ *
+ * @param[in,out] timeout 最近的超时时间(ms)
+ * @param due 超时时刻
+ * @param now 当前时刻
+ */
+static void message_baud_due(uint32_t *timeout, uint32_t due, uint32_t now) {
+    int32_t left = (int32_t)(due - now);
+
+    if (left <= 0) {
+        *timeout = 0;
+    } else if ((uint32_t)left < *timeout) {
+        *timeout = (uint32_t)left;
+    }
+}
+
+/**
+ * @brief 距离最近一个波特率协商超时的时间
+ *
+ * @return 毫秒数, 已经到期时返回0, 没有等待中的超时时返回`UINT32_MAX`
+ * @note 轮询任务没有数据时最多等待这么久再调用`message_polling_data`.
+ *       应答方在基础速率下, 或主动方没有开启协商时没有超时, 任务一直阻塞
+ */
+uint32_t message_baud_next_timeout(void) {
+    uint32_t now = HAL_GetTick();
+    uint32_t timeout = UINT32_MAX;
+
+    for (uint32_t i = 0; i < MSG_POLLING_HANDLE_NUM; ++i) {
+        msg_polling_port_t *port = &msg_polling_table[i];
+        msg_baud_t *baud = &port->baud;
+
+        if ((port->huart == NULL) || (!baud->enabled)) {
+            continue;
+        }
+
+        switch (baud->state) {
+            case MSG_BAUD_PROPOSED: {
+                message_baud_due(&timeout, baud->deadline, now);
+            } break;
+
+            case MSG_BAUD_SWITCHING: {
+                /* 等待发送完成, 完成中断不唤醒轮询任务, 每毫秒检查一次 */
+                message_baud_due(&timeout, now + 1, now);
+            } break;
+
+            case MSG_BAUD_PROBING: {
+                message_baud_due(&timeout, baud->deadline, now);
+                if (baud->initiator) {
+                    message_baud_due(&timeout,
+                                     baud->last_probe + MSG_BAUD_PROBE_MS, now);
+                }
+            } break;
+
+            default: { /* MSG_BAUD_IDLE */
+                if (port->huart->Init.BaudRate == MSG_BAUD_BASE_RATE) {
+                    if (baud->initiator) {
+                        message_baud_due(&timeout, baud->next_try, now);
+                    }
+                    break;
+                }
+
+                message_baud_due(&timeout,
+                                 baud->last_rx + MSG_BAUD_LINK_TIMEOUT_MS, now);
+                message_baud_due(&timeout,
+                                 baud->last_check + MSG_BAUD_KEEPALIVE_MS, now);
+            } break;
+        }
+    }
+
+    return timeout;
+}
+
+#endif /* MSG_BAUD_ENABLE == 1 */
+
+/**
+ * @brief 帧头中的含义是否有效
+ *
+ * @param head 帧头(含义与类型)
+ * @return 是否有效
+ */
+static inline bool message_head_valid(uint8_t head) {
+    return ((head >> 4) < MSG_MEAN_LENGTH_RESERVE) ||
+           ((head >> 4) == MSG_BATCH_MEAN) ||
+           ((head >> 4) == MSG_FRAGMENT_MEAN) ||
+           ((MSG_RELIABLE_ENABLE == 1) && ((head >> 4) == MSG_RELIABLE_MEAN)) ||
+           ((MSG_BAUD_ENABLE == 1) && ((head >> 4) == MSG_BAUD_MEAN));
+}
+
+/**
+ * @brief 获取该帧头允许的最大数据区长度
+ *
+ * @param head 帧头(含义与类型)
+ * @return 最大数据区长度
+ */
+static inline uint8_t message_max_length(uint8_t head) {
+    return ((head >> 4) < MSG_MEAN_LENGTH_RESERVE) ? MSG_MAX_DATA_LENGTH
+                                                   : MSG_MAX_BATCH_LENGTH;
+}
+
+/**
+ * @brief 调用一条消息的回调函数
+ *
+ * @param[in] msg 消息, 格式为| 含义/类型 | 长度 | 数据 |
+ */
+static void message_dispatch_message(uint8_t *msg) {
+    if (p_receive_callback[(msg[0] >> 4)] != NULL) {
+        p_receive_callback[(msg[0] >> 4)](msg[1], msg[0] & 0x0F, msg + 2);
+    }
+}
+
+_Static_assert(MSG_MEAN_LENGTH_RESERVE <= MSG_RELIABLE_MEAN,
+               "message_mean_t overlaps the reserved frame means.");
+#if (MSG_BAUD_ENABLE == 1)
+_Static_assert(MSG_MEAN_LENGTH_RESERVE <= MSG_BAUD_MEAN,
+               "message_mean_t overlaps the baud rate frame mean.");
+#endif /* MSG_BAUD_ENABLE == 1 */
+
+/**
+ * @brief 分片传输的重组缓冲区, 每个含义一块
+ */
+typedef struct {
+    uint8_t head;                          /*!< 原消息的含义/类型 */
+    uint8_t id;                            /*!< 传输号 */
+    uint8_t next;                          /*!< 下一个期望的分片序号 */
+    uint8_t count;                         /*!< 分片总数, 0表示没有传输 */
+    uint16_t length;                       /*!< 已收到的长度 */
+    uint8_t buf[MSG_MAX_FRAGMENT_LENGTH];  /*!< 重组缓冲区 */
+} msg_reassembly_t;
+
+static msg_reassembly_t msg_reassembly[MSG_MEAN_LENGTH_RESERVE];
+
+/**
+ * @brief 把一个分片写入重组缓冲区, 收齐后调用回调函数
+ *
+ * @param[in] fragment 分片帧数据区
+ * @param length 数据区长度
+ * @note 分片必须按顺序到达, 丢失或交错时丢弃当前传输, 等待下一个0号分片
+ */
+static void message_reassemble(const uint8_t *fragment, uint8_t length) {
+    uint8_t mean = fragment[0] >> 4;
+    uint8_t id = fragment[1];
+    uint8_t index = fragment[2];
+    uint8_t count = fragment[3];
+
+    if ((length <= MSG_FRAGMENT_HEAD_SIZE) ||
+        (mean >= MSG_MEAN_LENGTH_RESERVE) || (index >= count)) {
+        return;
+    }
+
+    uint8_t len = length - MSG_FRAGMENT_HEAD_SIZE;
+
+    msg_reassembly_t *reassembly = &msg_reassembly[mean];
+
+    if (index == 0) {
+        /* 新的传输, 覆盖未收完的旧传输 */
+        reassembly->head = fragment[0];
+        reassembly->id = id;
+        reassembly->next = 0;
+        reassembly->count = count;
+        reassembly->length = 0;
+    } else if ((reassembly->count == 0) || (reassembly->id != id) ||
+               (reassembly->next != index) || (reassembly->count != count) ||
+               (reassembly->head != fragment[0])) {
+        reassembly->count = 0;
+        return;
+    }
+
+    if (reassembly->length + len > MSG_MAX_FRAGMENT_LENGTH) {
+        reassembly->count = 0;
+        return;
+    }
+
+    memcpy(reassembly->buf + reassembly->length,
+           fragment + MSG_FRAGMENT_HEAD_SIZE, len);
+    reassembly->length += len;
+
+    if (++reassembly->next < count) {
+        return;
+    }
+
+    reassembly->count = 0;
+    if (p_receive_large_callback[mean] != NULL) {
+        p_receive_large_callback[mean](reassembly->length,
+                                       reassembly->head & 0x0F,
+                                       reassembly->buf);
+    } else if ((p_receive_callback[mean] != NULL) &&
+               (reassembly->length <= 0xFF)) {
+        p_receive_callback[mean]((uint8_t)reassembly->length,
+                                 reassembly->head & 0x0F, reassembly->buf);
+    }
+}
+
+/**
+ * @brief 分发一帧完整且校验通过的数据, 打包帧拆开后逐条分发,
+ *        分片帧交给重组缓冲区, 可靠传输帧确认后按顺序分发
+ *
+ * @param[in] frame 帧缓冲区
+ */
+static void message_dispatch_frame(uint8_t *frame) {
+    if ((frame[0] >> 4) == MSG_FRAGMENT_MEAN) {
+        message_reassemble(frame + 2, frame[1]);
+        return;
+    }
+
+#if (MSG_RELIABLE_ENABLE == 1)
+    if ((frame[0] >> 4) == MSG_RELIABLE_MEAN) {
+        message_reliable_receive(frame);
+        return;
+    }
+#endif /* MSG_RELIABLE_ENABLE == 1 */
+
+    if ((frame[0] >> 4) != MSG_BATCH_MEAN) {
+        message_dispatch_message(frame);
+        return;
+    }
+
+    uint8_t *msg = frame + 2;
+    uint8_t remain = frame[1];
+
+    while (remain >= 2) {
+        uint8_t msg_len = msg[1];
+
+        if (((msg[0] >> 4) >= MSG_MEAN_LENGTH_RESERVE) || (msg_len == 0) ||
+            (msg_len > MSG_MAX_DATA_LENGTH) || (msg_len + 2 > remain)) {
+            /* 打包内容异常, 丢弃剩余部分 */
+            return;
+        }
+
+        message_dispatch_message(msg);
+        msg += msg_len + 2;
+        remain -= msg_len + 2;
+    }
+}
+
+#if (MSG_FRAME_VERSION == 2)
+
+/**
+ * @brief 向解析器送入一个字节, 收完一帧并校验通过时返回数据长度,
+ *        由调用者转发或分发
+ *
+ * @param parser 解析器
+ * @param byte 收到的字节
+ * @return 长度或者状态标记
+ *  @retval `0-MSG_NO_DATA` - 帧未收完, 或正在搜索同步字
+ *  @retval `255-MSG_DATA_OVER` - 长度溢出
+ *  @retval `253-MSG_DATA_VERIFY_ERROR` - CRC校验错误
+ *  @retval 1~250 - 收完一帧, 返回数据长度
+ */
+static uint8_t message_parse_byte(msg_parser_t *parser, uint8_t byte) {
+    switch (parser->state) {
+        case MSG_PARSE_SYNC_0: {
+            if (byte == MSG_FRAME_SYNC_0) {
+                parser->state = MSG_PARSE_SYNC_1;
+            }
+        } break;
+
+        case MSG_PARSE_SYNC_1: {
+            if (byte == MSG_FRAME_SYNC_1) {
+                parser->state = MSG_PARSE_VERSION;
+            } else if (byte != MSG_FRAME_SYNC_0) {
+                parser->state = MSG_PARSE_SYNC_0;
+            }
+        } break;
+
+        case MSG_PARSE_VERSION: {
+            if ((byte >> 4) != MSG_FRAME_VERSION) {
+                parser->state = (byte == MSG_FRAME_SYNC_0) ? MSG_PARSE_SYNC_1
+                                                           : MSG_PARSE_SYNC_0;
+                return MSG_NO_DATA;
+            }
+            parser->version = byte;
+            parser->crc = crc16_update_byte(CRC16_INIT, byte);
+            parser->state = MSG_PARSE_SEQ;
+        } break;
+
+        case MSG_PARSE_SEQ: {
+            parser->seq = byte;
+            parser->crc = crc16_update_byte(parser->crc, byte);
+            parser->state = MSG_PARSE_HEAD;
+        } break;
+
+        case MSG_PARSE_HEAD: {
+            if (!message_head_valid(byte)) {
+                /* 消息下标越界, 重新搜索同步字 */
+                parser->state = MSG_PARSE_SYNC_0;
+                return MSG_NO_DATA;
+            }
+            parser->frame[0] = byte;
+            parser->crc = crc16_update_byte(parser->crc, byte);
+            parser->state = MSG_PARSE_LENGTH;
+        } break;
+
+        case MSG_PARSE_LENGTH: {
+            if ((byte == 0) ||
+                (byte > message_max_length(parser->frame[0]))) {
+                /* 数据长度超过最大长度, 为避免异常内存操作, 丢弃这一帧 */
+                parser->state = MSG_PARSE_SYNC_0;
+                return MSG_DATA_OVER;
+            }
+            parser->frame[1] = byte;
+            parser->crc = crc16_update_byte(parser->crc, byte);
+            parser->index = 2;
+            parser->state = MSG_PARSE_DATA;
+        } break;
+
+        case MSG_PARSE_DATA: {
+            parser->frame[parser->index++] = byte;
+            parser->crc = crc16_update_byte(parser->crc, byte);
+            if (parser->index == parser->frame[1] + 2) {
+                parser->state = MSG_PARSE_CRC_0;
+            }
+        } break;
+
+        case MSG_PARSE_CRC_0: {
+            parser->crc_recv = (uint16_t)(byte << 8);
+            parser->state = MSG_PARSE_CRC_1;
+        } break;
+
+        default: { /* MSG_PARSE_CRC_1 */
+            parser->crc_recv |= byte;
+            parser->state = MSG_PARSE_SYNC_0;
+            if (parser->crc_recv != parser->crc) {
+                /* CRC校验错误 */
+                return MSG_DATA_VERIFY_ERROR;
+            }
+            return parser->frame[1];
+        }
+    }
+
+    return MSG_NO_DATA;
+}
+
+#elif (MSG_FRAME_VERSION == 3)
+
+/**
+ * @brief 收到分隔符, 检查解码后的一帧
+ *
+ * @param parser 解析器
+ * @return 长度或者状态标记, 同`message_parse_byte`
+ */
+static uint8_t message_parse_cobs_end(msg_parser_t *parser) {
+    uint8_t *frame = parser->frame;
+    uint8_t len = parser->index;
+
+    if (parser->code != 0) {
+        /* 最后一块没有收完, 编码字节被破坏, 解码结果不可信 */
+        return MSG_DATA_VERIFY_ERROR;
+    }
+
+    if (len == 0) {
+        /* 连续的分隔符, 不是帧 */
+        return MSG_NO_DATA;
+    }
+
+    /* | 版本/保留 | 序号 | 含义/类型 | 长度 | 数据 | CRC16 | */
+    if ((len < 7) || ((frame[0] >> 4) != MSG_FRAME_VERSION) ||
+        (!message_head_valid(frame[2])) || (frame[3] == 0) ||
+        (frame[3] > message_max_length(frame[2])) || (frame[3] + 6 != len)) {
+        return MSG_DATA_VERIFY_ERROR;
+    }
+
+    uint16_t crc_recv = (uint16_t)(frame[len - 2] << 8) | frame[len - 1];
+    if (crc16_calc(frame, len - 2) != crc_recv) {
+        return MSG_DATA_VERIFY_ERROR;
+    }
+
+    return frame[3];
+}
+
+/**
+ * @brief 向解析器送入一个字节, 收完一帧并校验通过时返回数据长度,
+ *        由调用者转发或分发
+ *
+ * @param parser 解析器
+ * @param byte 收到的字节
+ * @return 长度或者状态标记
+ *  @retval `0-MSG_NO_DATA` - 帧未收完
+ *  @retval `255-MSG_DATA_OVER` - 帧过长, 已丢弃
+ *  @retval `253-MSG_DATA_VERIFY_ERROR` - 格式或CRC校验错误
+ *  @retval 1~250 - 收完一帧, 返回数据长度
+ * @note 每个字节只处理一次, 遇到0x00即结束当前帧, 不需要回溯
+ */
+static uint8_t message_parse_byte(msg_parser_t *parser, uint8_t byte) {
+    if (byte == 0x00) {
+        /* 分隔符, 无论当前状态如何都从下一个字节开始新的一帧 */
+        uint8_t res = (parser->state == MSG_PARSE_COBS)
+                          ? message_parse_cobs_end(parser)
+                          : MSG_NO_DATA;
+        parser->state = MSG_PARSE_COBS;
+        parser->index = 0;
+        parser->code = 0;
+        parser->zero_pending = false;
+        return res;
+    }
+
+    if (parser->state == MSG_PARSE_DISCARD) {
+        return MSG_NO_DATA;
+    }
+
+    if (parser->code == 0) {
+        /* 编码字节, 上一块不是满块时先补上被替换掉的0x00 */
+        if (parser->zero_pending) {
+            if (parser->index >= MSG_PARSE_FRAME_SIZE) {
+                parser->state = MSG_PARSE_DISCARD;
+                return MSG_DATA_OVER;
+            }
+            parser->frame[parser->index++] = 0x00;
+        }
+        parser->code = byte - 1;
+        parser->zero_pending = (byte != 0xFF);
+        return MSG_NO_DATA;
+    }
+
+    if (parser->index >= MSG_PARSE_FRAME_SIZE) {
+        parser->state = MSG_PARSE_DISCARD;
+        return MSG_DATA_OVER;
+    }
+    parser->frame[parser->index++] = byte;
+    --parser->code;
+
+    return MSG_NO_DATA;
+}
+
+#else /* MSG_FRAME_VERSION */
+
+/**
+ * @brief 向解析器送入一个字节, 收完一帧并校验通过时返回数据长度,
+ *        由调用者转发或分发
+ *
+ * @param parser 解析器
+ * @param byte 收到的字节
+ * @return 长度或者状态标记
+ *  @retval `0-MSG_NO_DATA` - 帧未收完, 或正在重新同步
+ *  @retval `255-MSG_DATA_OVER` - 长度溢出
+ *  @retval `253-MSG_DATA_VERIFY_ERROR` - 校验错误, 末尾没有收到0xFF
+ *  @retval 1~250 - 收完一帧, 返回数据长度
+ */
+static uint8_t message_parse_byte(msg_parser_t *parser, uint8_t byte) {
+    switch (parser->state) {
+        case MSG_PARSE_HEAD: {
+            if (!message_head_valid(byte)) {
+                /* 消息下标越界, 丢弃到下一个帧尾 */
+                parser->state = (byte == 0xFF) ? MSG_PARSE_HEAD
+                                               : MSG_PARSE_RESYNC;
+                return MSG_NO_DATA;
+            }
+            parser->frame[0] = byte;
+            parser->state = MSG_PARSE_LENGTH;
+        } break;
+
+        case MSG_PARSE_LENGTH: {
+            if ((byte == 0) ||
+                (byte > message_max_length(parser->frame[0]))) {
+                /* 数据长度超过最大长度, 为避免异常内存操作, 丢弃这一帧 */
+                parser->state = (byte == 0xFF) ? MSG_PARSE_HEAD
+                                               : MSG_PARSE_RESYNC;
+                return MSG_DATA_OVER;
+            }
+            parser->frame[1] = byte;
+            parser->index = 2;
+            parser->state = MSG_PARSE_DATA;
+        } break;
+
+        case MSG_PARSE_DATA: {
+            parser->frame[parser->index++] = byte;
+            if (parser->index == parser->frame[1] + 2) {
+                parser->state = MSG_PARSE_TAIL;
+            }
+        } break;
+
+        case MSG_PARSE_TAIL: {
+            if (byte != 0xFF) {
+                /* 校验字节错误, 最后一位不是0xFF */
+                parser->state = MSG_PARSE_RESYNC;
+                return MSG_DATA_VERIFY_ERROR;
+            }
+            parser->state = MSG_PARSE_HEAD;
+            return parser->frame[1];
+        }
+
+        default: { /* MSG_PARSE_RESYNC */
+            if (byte == 0xFF) {
+                parser->state = MSG_PARSE_HEAD;
+            }
+        } break;
+    }
+
+    return MSG_NO_DATA;
+}
+
+#endif /* MSG_FRAME_VERSION */
+
+/**
+ * @brief 获取解析器中收完的一帧, 格式为| 含义/类型 | 长度 | 数据 |
+ *
+ * @param parser 解析器
+ * @return 帧缓冲区
+ */
+static inline uint8_t *message_parser_frame(msg_parser_t *parser) {
+#if (MSG_FRAME_VERSION == 3)
+    /* 跳过版本与序号 */
+    return parser->frame + 2;
+#else  /* MSG_FRAME_VERSION == 3 */
+    return parser->frame;
+#endif /* MSG_FRAME_VERSION == 3 */
+}
+
+/**
+ * @brief 串口转发表的一项
+ */
+typedef struct {
+    UART_HandleTypeDef *src; /*!< 接收串口, `NULL`表示空闲 */
+    UART_HandleTypeDef *dst; /*!< 转发串口 */
+    uint8_t mean;            /*!< 数据含义 */
+    uint8_t priority;        /*!< 转发时的发送优先级 */
+} msg_route_t;
+
+/* 串口转发表 */
+static msg_route_t msg_route_table[MSG_ROUTE_NUM];
+
+/**
+ * @brief 查找转发表项
+ *
+ * @param src 接收串口, 为`NULL`时查找空闲位置
+ * @param mean 数据含义
+ * @return 转发表项, 没有找到返回`NULL`
+ */
+static msg_route_t *message_route_find(UART_HandleTypeDef *src, uint8_t mean) {
+    for (uint32_t i = 0; i < MSG_ROUTE_NUM; ++i) {
+        if ((msg_route_table[i].src == src) &&
+            ((src == NULL) || (msg_route_table[i].mean == mean))) {
+            return &msg_route_table[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief 添加转发: 从`src`收到的某种含义的帧原样从`dst`发出
+ *
+ * @param src 接收串口, 需要先调用`message_add_polling_handle`
+ * @param data_mean 数据含义
+ * @param dst 转发串口
+ * @param priority 转发时的发送优先级
+ * @return 是否添加成功, 转发表满或参数错误时返回`false`
+ * @note 转发的帧不再调用本机的回调函数. 该含义的分片帧与可靠传输帧
+ *       (包括确认帧)也会转发, 打包帧在本机拆开分发, 不转发
+ */
+bool message_add_route(UART_HandleTypeDef *src, message_mean_t data_mean,
+                       UART_HandleTypeDef *dst, message_priority_t priority) {
+    if ((src == NULL) || (dst == NULL) || (src == dst) ||
+        (data_mean >= MSG_MEAN_LENGTH_RESERVE) ||
+        (priority >= MSG_PRIORITY_NUM)) {
+        return false;
+    }
+
+    msg_route_t *route = message_route_find(src, data_mean);
+    if (route == NULL) {
+        route = message_route_find(NULL, 0);
+        if (route == NULL) {
+            return false;
+        }
+    }
+
+    route->dst = dst;
+    route->mean = data_mean;
+    route->priority = priority;
+    route->src = src;
+    return true;
+}
+
+/**
+ * @brief 删除转发, 之后该含义的帧恢复调用本机的回调函数
+ *
+ * @param src 接收串口
+ * @param data_mean 数据含义
+ */
+void message_remove_route(UART_HandleTypeDef *src, message_mean_t data_mean) {
+    if (src == NULL) {
+        return;
+    }
+
+    msg_route_t *route = message_route_find(src, data_mean);
+    if (route != NULL) {
+        route->src = NULL;
+    }
+}
+
+/**
+ * @brief 把解析器中收完的一帧按收到时的字节写入缓冲区
+ *
+ * @param[out] raw 缓冲区, 长度至少为数据长度加`MSG_FRAME_OVERHEAD`
+ * @param parser 解析器
+ * @note 序号与CRC保持不变, 不重新组帧
+ */
+static void message_copy_raw_frame(uint8_t *raw, msg_parser_t *parser) {
+    uint8_t *frame = message_parser_frame(parser);
+
+#if (MSG_FRAME_VERSION == 2)
+    raw[0] = MSG_FRAME_SYNC_0;
+    raw[1] = MSG_FRAME_SYNC_1;
+    raw[2] = parser->version;
+    raw[3] = parser->seq;
+    memcpy(raw + 4, frame, frame[1] + 2);
+    raw[frame[1] + 6] = (uint8_t)(parser->crc_recv >> 8);
+    raw[frame[1] + 7] = (uint8_t)parser->crc_recv;
+#elif (MSG_FRAME_VERSION == 3)
+    /* COBS编码是唯一的, 复制时原地编码即得到收到的字节 */
+    /* 收到分隔符后解析器已清零`index`, 长度按帧中的数据长度计算 */
+    memcpy(raw + 1, parser->frame, frame[1] + 6);
+    message_cobs_encode(raw, frame[1] + 6);
+    raw[frame[1] + 7] = 0x00;
+#else  /* MSG_FRAME_VERSION */
+    memcpy(raw, frame, frame[1] + 2);
+    raw[frame[1] + 2] = 0xFF;
+#endif /* MSG_FRAME_VERSION */
+}
+
+/**
+ * @brief 按转发表转发解析器中收完的一帧
+ *
+ * @param src 接收串口
+ * @param parser 解析器
+ * @return 是否已转发, 没有匹配的转发表项时返回`false`
+ * @note 帧从解析缓冲区直接复制到转发串口的发送槽位, 只复制一次.
+ *       发送通道满时丢弃并计数, 不阻塞接收
+ */
+static bool message_route_frame(UART_HandleTypeDef *src,
+                                msg_parser_t *parser) {
+    uint8_t *frame = message_parser_frame(parser);
+    uint8_t mean = frame[0] >> 4;
+
+    if ((mean == MSG_FRAGMENT_MEAN) || (mean == MSG_RELIABLE_MEAN)) {
+        /* 按数据区中原消息的含义转发 */
+        mean = frame[2] >> 4;
+    } else if (mean == MSG_BATCH_MEAN) {
+        return false;
+    }
+
+    msg_route_t *route = message_route_find(src, mean);
+    if (route == NULL) {
+        return false;
+    }
+
+    uint8_t length = frame[1] + MSG_FRAME_OVERHEAD;
+
+    if (route->dst->hdmatx == NULL) {
+        uint8_t raw[MSG_MAX_FRAME_DATA_LENGTH + MSG_FRAME_OVERHEAD];
+        message_copy_raw_frame(raw, parser);
+        HAL_UART_Transmit(route->dst, raw, length, 0xFFFF);
+        return true;
+    }
+
+    msg_tx_queue_t *queue = message_tx_queue_get(route->dst);
+    if (queue == NULL) {
+        return true;
+    }
+
+    msg_tx_lane_t *lane = &queue->lane[route->priority];
+    uint32_t pos;
+    msg_tx_slot_t *slot = message_tx_slot_claim(lane, &pos);
+    if (slot == NULL) {
+        atomic_fetch_add_explicit(&lane->dropped, 1, memory_order_relaxed);
+        return true;
+    }
+
+    message_copy_raw_frame(slot->frame, parser);
+    slot->length = length;
+    message_tx_slot_publish(queue, slot, pos);
+    return true;
+}
+
+/**
+ * @brief 读取并解析一个串口的数据, 最多读取`MSG_POLLING_BUDGET`字节
+ *
+ * @param port 轮询表项
+ * @return 接收FIFO中是否还有本次没有读取的数据
+ * @note 直接在接收FIFO的内存上解析, 解析完再释放, 不先复制到临时数组
+ */
+static bool message_polling_port(msg_polling_port_t *port) {
+    ring_fifo_span_t span[2];
+    uint32_t budget = MSG_POLLING_BUDGET;
+    uint32_t total = uart_dmarx_peek(port->huart, span);
+    uint32_t data_len = (total > budget) ? budget : total;
+
+    for (uint32_t s = 0, left = data_len; (s < 2) && (left > 0); ++s) {
+        uint32_t len = (span[s].len < left) ? span[s].len : left;
+        left -= len;
+
+        for (uint32_t i = 0; i < len; ++i) {
+            uint8_t parse_res =
+                message_parse_byte(&port->parser, span[s].buf[i]);
+            if (parse_res == MSG_DATA_OVER) {
+                ++port->overflows;
+            } else if (parse_res == MSG_DATA_VERIFY_ERROR) {
+                ++port->verify_errors;
+            } else if (parse_res != MSG_NO_DATA) {
+                uint8_t *frame = message_parser_frame(&port->parser);
+
+                ++port->frames;
+#if (MSG_BAUD_ENABLE == 1)
+                /* 协商帧只属于这条链路, 不转发 */
+                if ((frame[0] >> 4) == MSG_BAUD_MEAN) {
+                    message_baud_receive(port, frame);
+                    continue;
+                }
+#endif /* MSG_BAUD_ENABLE == 1 */
+                if (!message_route_frame(port->huart, &port->parser)) {
+                    message_dispatch_frame(frame);
+                }
+            }
+        }
+    }
+
+    uart_dmarx_consume(port->huart, data_len);
+    port->bytes += data_len;
+
+    return (total > budget);
+}
+
+#if (MSG_LINK_STATS_PERIOD_MS > 0)
+/**
+ * @brief 按小端写入4字节
+ *
+ * @param buf 写入位置
+ * @param value 数值
+ * @return 下一个写入位置
+ */
+static uint8_t *message_put_u32(uint8_t *buf, uint32_t value) {
+    buf[0] = (uint8_t)value;
+    buf[1] = (uint8_t)(value >> 8);
+    buf[2] = (uint8_t)(value >> 16);
+    buf[3] = (uint8_t)(value >> 24);
+
+    return buf + 4;
+}
+
+/**
+ * @brief 定时发送各轮询串口的链路统计
+ *
+ * @param timer 报告定时器
+ * @note 在定时器任务中运行, 不占用接收轮询. 发送队列暂停或放不下时跳过本周期
+ */
+static void message_link_stats_report(TimerHandle_t timer) {
+    UNUSED(timer);
+
+    UART_HandleTypeDef *send_handle = p_send_handle[MSG_LINK_STATS];
+    if ((send_handle == NULL) || message_tx_paused(send_handle)) {
+        return;
+    }
+
+    /* | 轮询表序号 | 协议层接收统计 | 串口驱动统计 |, 按成员顺序每个4字节 */
+    uint8_t report[MSG_LINK_STATS_LENGTH];
+    message_link_stats_t stats;
+
+    for (uint32_t i = 0; i < MSG_POLLING_HANDLE_NUM; ++i) {
+        if (!message_get_link_stats(msg_polling_table[i].huart, &stats)) {
+            continue;
+        }
+
+        uint8_t *p = report;
+        *p++ = (uint8_t)i;
+        p = message_put_u32(p, stats.polling.frames);
+        p = message_put_u32(p, stats.polling.errors);
+        p = message_put_u32(p, stats.polling.overflows);
+        p = message_put_u32(p, stats.polling.verify_errors);
+        p = message_put_u32(p, stats.polling.bytes);
+        p = message_put_u32(p, stats.uart.rx_bytes);
+        p = message_put_u32(p, stats.uart.tx_bytes);
+        p = message_put_u32(p, stats.uart.ore);
+        p = message_put_u32(p, stats.uart.fe);
+        p = message_put_u32(p, stats.uart.ne);
+        p = message_put_u32(p, stats.uart.pe);
+        p = message_put_u32(p, stats.uart.dma_errors);
+        p = message_put_u32(p, stats.uart.rx_dropped);
+        p = message_put_u32(p, stats.uart.rx_high_water);
+        p = message_put_u32(p, stats.uart.tx_dropped);
+
+        if (message_send_large_data(MSG_LINK_STATS, MSG_DATA_UINT8, report,
+                                    (size_t)(p - report)) !=
+            MSG_FRAGMENT_OK) {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief 开启或停止链路统计报告定时器
+ *
+ * @param enable 是否开启
+ */
+static void message_link_stats_enable(bool enable) {
+    static TimerHandle_t timer;
+
+    if (timer == NULL) {
+        if (!enable) {
+            return;
+        }
+        timer = xTimerCreate("msg_link_stats",
+                             pdMS_TO_TICKS(MSG_LINK_STATS_PERIOD_MS), pdTRUE,
+                             NULL, message_link_stats_report);
+        if (timer == NULL) {
+            return;
+        }
+    }
+
+    if (enable) {
+        xTimerStart(timer, 0);
+    } else {
+        xTimerStop(timer, 0);
+    }
+}
+#endif /* MSG_LINK_STATS_PERIOD_MS > 0 */
+
+/**
+ * @brief 轮询数据, 并调用相应的函数
+ *
+ * @return 是否还有未读完的数据
+ *  @retval `false` - 所有串口的接收FIFO都已读空
+ *  @retval `true` - 有串口的数据超过了本次的预算, 需要再调用一次
+ * @note 事先在message_mean_t定义数据类型, 并注册相应的回调函数.
+ *       这个函数挂在一个while循环或者定时器中一直轮询就可以,
+ *       不要改动这个函数的任何内容
+ * @note 每次调用依次处理轮询表中的所有串口, 每个串口最多读取
+ *       `MSG_POLLING_BUDGET`字节, 数据多的串口不会让其他串口等待.
+ *       接收按字节流解析, 被拆成多次接收的帧会保留到下次调用继续拼接.
+ *       各串口收到的帧数用`message_get_polling_stats`查询
+ * @note 波特率协商的超时处理也在这里进行
+ */
+bool message_polling_data(void) {
+    bool pending = false;
+
+    for (uint32_t i = 0; i < MSG_POLLING_HANDLE_NUM; ++i) {
+        if (msg_polling_table[i].huart == NULL) {
+            continue;
+        }
+
+        if (message_polling_port(&msg_polling_table[i])) {
+            pending = true;
+        }
+#if (MSG_BAUD_ENABLE == 1)
+        if (message_baud_poll(&msg_polling_table[i])) {
+            pending = true;
+        }
+#endif /* MSG_BAUD_ENABLE == 1 */
     }
 
-    return (uint8_t)msg_len; /* 返回消息长度 */
+    return pending;
 }
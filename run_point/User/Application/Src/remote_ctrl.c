@@ -8,6 +8,8 @@
 
  #include "remote_ctrl.h"
  #include "msg_protocol.h"
+ #include "msg_schema.h"
+ #include "latency_trace.h"
  #include "FreeRTOS.h"
  #include "./LED/led.h"
  #include "task.h"
@@ -21,6 +23,10 @@
  /* 底盘状态 */
  extern uint8_t g_chassis_status;
  
+ /* 最近一次收到遥控器帧的时刻, 包括心跳帧 */
+ static volatile TickType_t remote_last_tick = 0;
+ static volatile bool remote_received = false;
+ 
  /**
   * @brief 遥控器接收数据
   */
@@ -30,17 +36,6 @@
  uint8_t g_remote_right_x = 12;
  uint8_t g_remote_right_y = 12;
  
- /**
-  * @brief 遥控器下标数组下标
-  */
- enum {
-     ARRAY_KEY = 0x00U,
-     ARRAY_LEFT_X,
-     ARRAY_LEFT_Y,
-     ARRAY_RIGHT_X,
-     ARRAY_RIGHT_Y,
- };
- 
  /**
   * @brief 串口遥控器回调
   *
@@ -52,17 +47,20 @@
                               void *msg_data) {
      static uint8_t key_up = 1; /* 按键按松开标志, 避免连续调用回调函数 */
  
-     if (msg_length != 5 || msg_type != MSG_DATA_UINT8) {
+     const msg_remote_t *remote_data =
+         msg_remote_decode(msg_length, msg_type, msg_data);
+     if (remote_data == NULL) {
          return;
      }
+     remote_last_tick = xTaskGetTickCount();
+     remote_received = true;
      LED0_TOGGLE();
  
-     uint8_t *remote_data = (uint8_t *)msg_data;
-     g_remote_key = remote_data[ARRAY_KEY];
-     g_remote_left_x = remote_data[ARRAY_LEFT_X];
-     g_remote_left_y = remote_data[ARRAY_LEFT_Y];
-     g_remote_right_x = remote_data[ARRAY_RIGHT_X];
-     g_remote_right_y = remote_data[ARRAY_RIGHT_Y];
+     g_remote_key = remote_data->key;
+     g_remote_left_x = remote_data->left_x;
+     g_remote_left_y = remote_data->left_y;
+     g_remote_right_x = remote_data->right_x;
+     g_remote_right_y = remote_data->right_y;
  
      if (g_remote_key == 0) {
          key_up = 1;
@@ -71,6 +69,11 @@
  
      if (key_up && p_key_callback[g_remote_key] != NULL) {
          key_up = 0;
+ #if (MSG_REMOTE_TRACE == 1)
+         latency_trace_begin(remote_data->trace_seq, remote_data->trace_us);
+ #else  /* MSG_REMOTE_TRACE == 1 */
+         latency_trace_begin(0, 0);
+ #endif /* MSG_REMOTE_TRACE == 1 */
          p_key_callback[g_remote_key](g_remote_key);
      }
  }
@@ -99,4 +102,26 @@
      }
      p_key_callback[key] = NULL;
  }
+ 
+ /**
+  * @brief 距离上一次收到遥控器帧的时间
+  *
+  * @return 时间(ms), 从未收到时返回`UINT32_MAX`
+  * @note 遥控器状态不变时每`MSG_REMOTE_HEARTBEAT_MS`发送一次心跳帧
+  */
+ uint32_t remote_heartbeat_age(void) {
+     if (!remote_received) {
+         return UINT32_MAX;
+     }
+     return pdTICKS_TO_MS(xTaskGetTickCount() - remote_last_tick);
+ }
+ 
+ /**
+  * @brief 遥控器链路是否正常
+  *
+  * @return 是否在`MSG_REMOTE_LINK_TIMEOUT_MS`内收到过遥控器帧
+  */
+ bool remote_is_online(void) {
+     return remote_heartbeat_age() <= MSG_REMOTE_LINK_TIMEOUT_MS;
+ }
  
\ No newline at end of file
@@ -10,6 +10,8 @@
 #include "uart2_calbackl.h"
 #include "remote_ctrl.h"
 #include "dji_angle.h"
+#include "latency_trace.h"
+#include "util_bench.h"
 
 #include "shoot_machine.h"
 
@@ -17,6 +19,9 @@
 #include "semphr.h "
 
 void motor_task(uint8_t key);
+#if (LATENCY_TRACE_ENABLE == 1)
+static void latency_dump_task(uint8_t key);
+#endif /* LATENCY_TRACE_ENABLE == 1 */
 void msg_task(uint8_t msg_length, message_type_t msg_type, void *msg_data);
 /*控制摩擦轮任务与实行任务的消息队列*/
 QueueHandle_t Queue_From_Fir; // 单个变量消息队列句
@@ -55,6 +60,13 @@ void freertos_start(void) {
  */
 void start_task(void *pvParameters) {
     UNUSED(pvParameters);
+    /* 消息发送队列的等待统计与延迟跟踪都使用DWT周期计数器 */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#if (UTIL_BENCH_ENABLE == 1)
+    /* 其他任务创建前运行, 测试结果不受调度影响. 默认关闭, 正常启动不运行 */
+    util_bench_run();
+#endif /* UTIL_BENCH_ENABLE == 1 */
     taskENTER_CRITICAL();
 
     xTaskCreate(task2, "task2", 256, NULL, 2, &task2_handle);
@@ -81,22 +93,59 @@ void task1(void *pvParameters) {
     }
 }
 
+/**
+ * @brief 串口接收通知, 在DMA空闲/半满/全满中断中调用, 唤醒消息接收任务
+ *
+ * @param huart 收到数据的串口句柄
+ */
+void uart_dmarx_notify_callback(UART_HandleTypeDef *huart) {
+    BaseType_t higher_priority_task_woken = pdFALSE;
+
+    if ((huart != &usart1_handle) || (task2_handle == NULL)) {
+        return;
+    }
+
+    latency_trace_rx_stamp();
+
+    vTaskNotifyGiveFromISR(task2_handle, &higher_priority_task_woken);
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+}
+
 /**
  * @brief Task2: 指定串口接收
  *
  * @param pvParameters Start parameters.
+ * @note 没有数据时阻塞在任务通知上, 收到数据后立即处理.
+ *       开启波特率协商后最多等到下一个协商超时, 没有超时时一直阻塞
  */
 void task2(void *pvParameters) {
     UNUSED(pvParameters);
+    latency_trace_init();
     message_add_polling_handle(&usart1_handle);
+#if (MSG_BAUD_ENABLE == 1)
+    /* 与遥控板协商更高的波特率, 本板为主动方 */
+    message_baud_enable(&usart1_handle, 4500000, true);
+#endif /* MSG_BAUD_ENABLE == 1 */
     message_register_recv_callback(MSG_REMOTE, remote_receive_callback);
     remote_register_key_callback(1, motor_task);
     remote_register_key_callback(2, motor_task);//使能按键1，2，为其指定回调函数。
+#if (LATENCY_TRACE_ENABLE == 1)
+    remote_register_key_callback(18, latency_dump_task);
+#endif /* LATENCY_TRACE_ENABLE == 1 */
 
     while (1) {
-
-        message_polling_data();
-        vTaskDelay(10);
+#if (MSG_BAUD_ENABLE == 1)
+        /* 多等一个节拍, 醒来时超时一定已经到期 */
+        uint32_t timeout = message_baud_next_timeout();
+        ulTaskNotifyTake(pdTRUE, (timeout == UINT32_MAX)
+                                     ? portMAX_DELAY
+                                     : pdMS_TO_TICKS(timeout) + 1);
+#else  /* MSG_BAUD_ENABLE == 1 */
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+#endif /* MSG_BAUD_ENABLE == 1 */
+        while (message_polling_data()) {
+            /* 一次没有读完, 继续处理剩余数据 */
+        }
     }
 }
 
@@ -112,11 +161,14 @@ void task6(void *pvParameters) {
 
     while (1) {
 
-        xQueueReceive(message_queue, &set_angle, 5);
+        if (xQueueReceive(message_queue, &set_angle, 5) == pdTRUE) {
+            latency_trace_mark(TRACE_STAGE_QUEUE_RECV);
+        }
         angle_out = pid_calc(&pid_pos, set_angle, (float)m2006_1.rotor_degree);
         spd_out = pid_calc(&pid_spd, angle_out, (float)m2006_1.speed_rpm);
         dji_motor_set_current(can1_selected, DJI_MOTOR_GROUP1, spd_out, 0, 0,
                               0);
+        latency_trace_mark(TRACE_STAGE_CAN_TX);
         vTaskDelay(5);
     }
 }
@@ -136,6 +188,19 @@ void motor_task(uint8_t key) {
         set_angle = 180;
         xQueueSend(message_queue, &set_angle, 10);
     }
+    latency_trace_mark(TRACE_STAGE_MOTOR_TASK);
 
     return;
 }
+
+#if (LATENCY_TRACE_ENABLE == 1)
+/**
+  * @brief 遥控器按键18, 输出按键到电机电流指令的延迟统计
+  * 
+  * @param key 按键
+  */
+static void latency_dump_task(uint8_t key) {
+    UNUSED(key);
+    latency_trace_dump();
+}
+#endif /* LATENCY_TRACE_ENABLE == 1 */
@@ -33,16 +33,20 @@ void uart2_callback(uint8_t byte) {
 }
 
 void message_polling(void) {
-    static uint8_t dma_rx_buf[30];
-    uint32_t len = uart_dmarx_read(uart_handle, dma_rx_buf, sizeof(dma_rx_buf));
+    ring_fifo_span_t span[2];
+    uint32_t len = uart_dmarx_peek(uart_handle, span);
 
     if (len == 0) {
         return;
     }
 
-    for (size_t i = 0; i < len; i++) {
-        uart2_callback(dma_rx_buf[i]);
+    for (size_t s = 0; s < 2; s++) {
+        for (size_t i = 0; i < span[s].len; i++) {
+            uart2_callback(span[s].buf[i]);
+        }
     }
+
+    uart_dmarx_consume(uart_handle, len);
 }
 
 /**
@@ -0,0 +1,88 @@
+/**
+ * @file    CSP_Config.h
+ * @author  Deadline039
+ * @brief   串口驱动测试用的CSP配置
+ * @version 1.0
+ * @date    2026-10-17
+ * @note    只打开USART1, 收发都使用DMA, 接收缓冲区取小一些, 几十个字节就能
+ *          测到半满, 全满与回绕. 宏的含义见`Drivers/CSP/Config/CSP_Config.h`
+ */
+
+#ifndef __CSP_CONFIG_H
+#define __CSP_CONFIG_H
+
+#define USART1_ENABLE             1
+
+#define USART1_TX_ID              1
+#define USART1_TX                 1
+#define USART1_TX_PORT            A
+#define USART1_TX_PIN             GPIO_PIN_9
+
+#define USART1_RX_ID              1
+#define USART1_RX                 1
+#define USART1_RX_PORT            A
+#define USART1_RX_PIN             GPIO_PIN_10
+
+#define USART1_CTS_ID             0
+#define USART1_CTS                0
+#define USART1_RTS_ID             0
+#define USART1_RTS                0
+
+#define USART1_IT_ENABLE          1
+#define USART1_IT_PRIORITY        5
+#define USART1_IT_SUB             3
+
+#define USART1_RX_DMA             1
+#define USART1_RX_DMA_NUMBER      2
+#define USART1_RX_DMA_STREAM      2
+#define USART1_RX_DMA_CHANNEL     4
+#define USART1_RX_DMA_PRIORITY    1
+#define USART1_RX_DMA_IT_PRIORITY 5
+#define USART1_RX_DMA_IT_SUB      2
+#define USART1_RX_DMA_BUF_SIZE    32
+#define USART1_RX_DMA_FIFO_SIZE   64
+
+#define USART1_TX_DMA             1
+#define USART1_TX_DMA_NUMBER      2
+#define USART1_TX_DMA_STREAM      7
+#define USART1_TX_DMA_CHANNEL     4
+#define USART1_TX_DMA_PRIORITY    1
+#define USART1_TX_DMA_IT_PRIORITY 2
+#define USART1_TX_DMA_IT_SUB      2
+#define USART1_TX_DMA_BUF_SIZE    32
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define _CSP_GPIO_PORT(x)          GPIO##x
+#define CSP_GPIO_PORT(x)           _CSP_GPIO_PORT(x)
+
+#define _CSP_DMA_STREAM(x, y)      DMA##x##_Stream##y
+#define CSP_DMA_STREAM(x, y)       _CSP_DMA_STREAM(x, y)
+
+#define _CSP_DMA_STREAM_IRQn(x, y) DMA##x##_Stream##y##_IRQn
+#define CSP_DMA_STREAM_IRQn(x, y)  _CSP_DMA_STREAM_IRQn(x, y)
+
+#define _CSP_DMA_STREAM_IRQ(x, y)  DMA##x##_Stream##y##_IRQHandler
+#define CSP_DMA_STREAM_IRQ(x, y)   _CSP_DMA_STREAM_IRQ(x, y)
+
+#define _CSP_DMA_CHANNEL(x)        DMA_CHANNEL_##x
+#define CSP_DMA_CHANNEL(x)         _CSP_DMA_CHANNEL(x)
+
+#define CSP_DMA_PRIORITY(x)        ((x) << DMA_SxCR_PL_Pos)
+
+#define CSP_MALLOC(x)              malloc(x)
+#define CSP_FREE(x)                free(x)
+#define CSP_REALLOC(p, x)          realloc(p, x)
+#include <stdlib.h>
+
+#include "stm32f4xx_hal.h"
+
+#include "UART_STM32F4xx.h"
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __CSP_CONFIG_H */
@@ -0,0 +1,341 @@
+/**
+ * @file    stm32f4xx_hal.h
+ * @author  Deadline039
+ * @brief   串口驱动测试用的HAL替身
+ * @version 1.0
+ * @date    2026-10-17
+ * @note    只提供`UART_STM32F4xx.c`用到的类型, 寄存器与接口, 实现在
+ *          `driver_port.c`中. 状态的变化与HAL相同, DMA只模拟NDTR计数器,
+ *          收到的字节由测试按字节写入接收缓冲区
+ */
+
+#ifndef __STM32F4xx_HAL_H
+#define __STM32F4xx_HAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define __IO           volatile
+#define __weak         __attribute__((weak))
+#define UNUSED(X)      (void)(X)
+
+#define SET_BIT(REG, BIT)   ((REG) |= (BIT))
+#define CLEAR_BIT(REG, BIT) ((REG) &= ~(BIT))
+#define READ_BIT(REG, BIT)  ((REG) & (BIT))
+
+#define RESET 0U
+#define SET   1U
+
+typedef enum {
+    HAL_OK = 0x00U,
+    HAL_ERROR = 0x01U,
+    HAL_BUSY = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum { HAL_UNLOCKED = 0x00U, HAL_LOCKED = 0x01U } HAL_LockTypeDef;
+
+#define __HAL_UNLOCK(__HANDLE__) ((__HANDLE__)->Lock = HAL_UNLOCKED)
+
+/*****************************************************************************
+ * @defgroup 中断与PRIMASK
+ * @{
+ */
+
+typedef enum {
+    USART1_IRQn = 37,
+    DMA2_Stream2_IRQn = 58,
+    DMA2_Stream7_IRQn = 70
+} IRQn_Type;
+
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t primask);
+void __disable_irq(void);
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority,
+                          uint32_t SubPriority);
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn);
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn);
+
+/**
+ * @}
+ */
+
+/*****************************************************************************
+ * @defgroup 外设寄存器
+ * @{
+ */
+
+typedef struct {
+    __IO uint32_t SR;
+    __IO uint32_t DR;
+    __IO uint32_t BRR;
+    __IO uint32_t CR1;
+    __IO uint32_t CR2;
+    __IO uint32_t CR3;
+    __IO uint32_t GTPR;
+} USART_TypeDef;
+
+typedef struct {
+    __IO uint32_t CR;
+    __IO uint32_t NDTR;
+    __IO uint32_t PAR;
+    __IO uint32_t M0AR;
+    __IO uint32_t M1AR;
+    __IO uint32_t FCR;
+} DMA_Stream_TypeDef;
+
+typedef struct {
+    __IO uint32_t MODER;
+} GPIO_TypeDef;
+
+typedef struct {
+    __IO uint32_t AHB1ENR;
+    __IO uint32_t APB1ENR;
+    __IO uint32_t APB2ENR;
+} RCC_TypeDef;
+
+/* 驱动按基地址的[14:10]位查找串口, 替身寄存器放在按0x8000对齐的数组中,
+   偏移取USART1的低15位, 查表的序号与板上相同 */
+extern uint8_t host_periph[];
+extern DMA_Stream_TypeDef host_dma2_stream[8];
+extern GPIO_TypeDef host_gpio[1];
+extern RCC_TypeDef host_rcc;
+
+#define USART1_BASE          0x40011000UL
+#define USART1                                                                 \
+    ((USART_TypeDef *)(host_periph + (USART1_BASE & 0x7FFFU)))
+#define DMA2_Stream0_BASE    ((uintptr_t)&host_dma2_stream[0])
+#define DMA2_Stream2         (&host_dma2_stream[2])
+#define DMA2_Stream7         (&host_dma2_stream[7])
+#define GPIOA_BASE           ((uintptr_t)&host_gpio[0])
+#define GPIOA                (&host_gpio[0])
+#define RCC                  (&host_rcc)
+
+#define RCC_AHB1ENR_GPIOAEN  0x00000001U
+#define RCC_AHB1ENR_DMA1EN   0x00200000U
+#define RCC_AHB1ENR_DMA2EN   0x00400000U
+#define RCC_APB2ENR_USART1EN 0x00000010U
+
+uint32_t HAL_RCC_GetPCLK1Freq(void);
+uint32_t HAL_RCC_GetPCLK2Freq(void);
+
+/**
+ * @}
+ */
+
+/*****************************************************************************
+ * @defgroup GPIO
+ * @{
+ */
+
+typedef struct {
+    uint32_t Pin;
+    uint32_t Mode;
+    uint32_t Pull;
+    uint32_t Speed;
+    uint32_t Alternate;
+} GPIO_InitTypeDef;
+
+#define GPIO_PIN_9            0x0200U
+#define GPIO_PIN_10           0x0400U
+#define GPIO_MODE_AF_PP       0x00000002U
+#define GPIO_PULLUP           0x00000001U
+#define GPIO_SPEED_FREQ_HIGH  0x00000002U
+#define GPIO_AF7_USART1       0x07U
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init);
+void HAL_GPIO_DeInit(GPIO_TypeDef *GPIOx, uint32_t GPIO_Pin);
+
+/**
+ * @}
+ */
+
+/*****************************************************************************
+ * @defgroup DMA
+ * @{
+ */
+
+typedef struct {
+    uint32_t Channel;
+    uint32_t Direction;
+    uint32_t PeriphInc;
+    uint32_t MemInc;
+    uint32_t PeriphDataAlignment;
+    uint32_t MemDataAlignment;
+    uint32_t Mode;
+    uint32_t Priority;
+} DMA_InitTypeDef;
+
+typedef enum {
+    HAL_DMA_STATE_RESET = 0x00U,
+    HAL_DMA_STATE_READY = 0x01U,
+    HAL_DMA_STATE_BUSY = 0x02U
+} HAL_DMA_StateTypeDef;
+
+typedef struct {
+    DMA_Stream_TypeDef *Instance;
+    DMA_InitTypeDef Init;
+    __IO HAL_DMA_StateTypeDef State;
+    void *Parent;
+    __IO uint32_t ErrorCode;
+} DMA_HandleTypeDef;
+
+#define DMA_CHANNEL_4         0x08000000U
+#define DMA_SxCR_PL_Pos       16U
+#define DMA_PERIPH_TO_MEMORY  0x00000000U
+#define DMA_MEMORY_TO_PERIPH  0x00000040U
+#define DMA_PINC_DISABLE      0x00000000U
+#define DMA_MINC_ENABLE       0x00000400U
+#define DMA_PDATAALIGN_BYTE   0x00000000U
+#define DMA_MDATAALIGN_BYTE   0x00000000U
+#define DMA_NORMAL            0x00000000U
+#define DMA_CIRCULAR          0x00000100U
+
+#define HAL_DMA_ERROR_NONE    0x00000000U
+#define HAL_DMA_ERROR_TE      0x00000001U
+#define HAL_DMA_ERROR_FE      0x00000002U
+#define HAL_DMA_ERROR_NO_XFER 0x00000080U
+
+#define __HAL_DMA_GET_COUNTER(__HANDLE__) ((__HANDLE__)->Instance->NDTR)
+
+#define __HAL_LINKDMA(__HANDLE__, __PPP_DMA_FIELD__, __DMA_HANDLE__)           \
+    do {                                                                       \
+        (__HANDLE__)->__PPP_DMA_FIELD__ = &(__DMA_HANDLE__);                   \
+        (__DMA_HANDLE__).Parent = (__HANDLE__);                                \
+    } while (0U)
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma);
+HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef *hdma);
+HAL_StatusTypeDef HAL_DMA_Abort(DMA_HandleTypeDef *hdma);
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma);
+
+/**
+ * @}
+ */
+
+/*****************************************************************************
+ * @defgroup UART
+ * @{
+ */
+
+#define USE_HAL_UART_REGISTER_CALLBACKS 0U
+
+typedef struct {
+    uint32_t BaudRate;
+    uint32_t WordLength;
+    uint32_t StopBits;
+    uint32_t Parity;
+    uint32_t Mode;
+    uint32_t HwFlowCtl;
+    uint32_t OverSampling;
+} UART_InitTypeDef;
+
+typedef enum {
+    HAL_UART_STATE_RESET = 0x00U,
+    HAL_UART_STATE_READY = 0x20U,
+    HAL_UART_STATE_BUSY = 0x24U,
+    HAL_UART_STATE_BUSY_TX = 0x21U,
+    HAL_UART_STATE_BUSY_RX = 0x22U
+} HAL_UART_StateTypeDef;
+
+typedef struct {
+    USART_TypeDef *Instance;
+    UART_InitTypeDef Init;
+    const uint8_t *pTxBuffPtr;
+    uint16_t TxXferSize;
+    __IO uint16_t TxXferCount;
+    uint8_t *pRxBuffPtr;
+    uint16_t RxXferSize;
+    __IO uint16_t RxXferCount;
+    DMA_HandleTypeDef *hdmatx;
+    DMA_HandleTypeDef *hdmarx;
+    HAL_LockTypeDef Lock;
+    __IO HAL_UART_StateTypeDef gState;
+    __IO HAL_UART_StateTypeDef RxState;
+    __IO uint32_t ErrorCode;
+} UART_HandleTypeDef;
+
+#define UART_WORDLENGTH_8B    0x00000000U
+#define UART_STOPBITS_1       0x00000000U
+#define UART_PARITY_NONE      0x00000000U
+#define UART_MODE_RX          0x00000004U
+#define UART_MODE_TX          0x00000008U
+#define UART_HWCONTROL_RTS    0x00000100U
+#define UART_HWCONTROL_CTS    0x00000200U
+#define UART_OVERSAMPLING_16  0x00000000U
+#define UART_OVERSAMPLING_8   0x00008000U
+
+#define UART_FLAG_TC          0x00000040U
+#define UART_FLAG_IDLE        0x00000010U
+#define UART_FLAG_ORE         0x00000008U
+#define UART_FLAG_NE          0x00000004U
+#define UART_FLAG_FE          0x00000002U
+#define UART_FLAG_PE          0x00000001U
+#define UART_IT_IDLE          0x00000010U
+
+#define HAL_UART_ERROR_NONE   0x00000000U
+#define HAL_UART_ERROR_PE     0x00000001U
+#define HAL_UART_ERROR_NE     0x00000002U
+#define HAL_UART_ERROR_FE     0x00000004U
+#define HAL_UART_ERROR_ORE    0x00000008U
+#define HAL_UART_ERROR_DMA    0x00000010U
+
+#define __HAL_UART_GET_FLAG(__HANDLE__, __FLAG__)                              \
+    (((__HANDLE__)->Instance->SR & (__FLAG__)) == (__FLAG__))
+
+/* 与板上相同, 先读SR再读DR, 一次清除全部错误标志与IDLE */
+#define __HAL_UART_CLEAR_PEFLAG(__HANDLE__)                                    \
+    ((__HANDLE__)->Instance->SR &=                                             \
+     ~(UART_FLAG_PE | UART_FLAG_FE | UART_FLAG_NE | UART_FLAG_ORE |            \
+       UART_FLAG_IDLE))
+#define __HAL_UART_CLEAR_FEFLAG(__HANDLE__) \
+    __HAL_UART_CLEAR_PEFLAG(__HANDLE__)
+#define __HAL_UART_CLEAR_NEFLAG(__HANDLE__) \
+    __HAL_UART_CLEAR_PEFLAG(__HANDLE__)
+#define __HAL_UART_CLEAR_OREFLAG(__HANDLE__) \
+    __HAL_UART_CLEAR_PEFLAG(__HANDLE__)
+#define __HAL_UART_CLEAR_IDLEFLAG(__HANDLE__) \
+    __HAL_UART_CLEAR_PEFLAG(__HANDLE__)
+
+#define __HAL_UART_ENABLE_IT(__HANDLE__, __INTERRUPT__)                        \
+    ((__HANDLE__)->Instance->CR1 |= (__INTERRUPT__))
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_DeInit(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart,
+                                    const uint8_t *pData, uint16_t Size,
+                                    uint32_t Timeout);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart,
+                                        const uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart,
+                                      uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef *huart,
+                                       uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle(UART_HandleTypeDef *huart,
+                                           uint8_t *pData, uint16_t Size,
+                                           uint16_t *RxLen, uint32_t Timeout);
+void HAL_UART_IRQHandler(UART_HandleTypeDef *huart);
+HAL_UART_StateTypeDef HAL_UART_GetState(UART_HandleTypeDef *huart);
+uint32_t HAL_UART_GetError(UART_HandleTypeDef *huart);
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __STM32F4xx_HAL_H */
@@ -0,0 +1,415 @@
+/**
+ * @file    driver_port.c
+ * @author  Deadline039
+ * @brief   串口驱动测试用的HAL替身
+ * @version 1.0
+ * @date    2026-10-17
+ * @note    收发状态, 错误码与DMA流状态的变化按HAL的实现模拟, 驱动看到的与
+ *          板上相同. 发送在调用`host_uart_tx_complete`时才完成, 接收的字节
+ *          由`host_dma_receive`逐个写入, 到半满与全满时调用HAL的回调
+ */
+
+#include "test.h"
+
+#include <string.h>
+
+#define HOST_WIRE_SIZE 1024 /* 记录发送字节的缓冲区大小 */
+
+_Alignas(0x8000) uint8_t host_periph[0x8000];
+DMA_Stream_TypeDef host_dma2_stream[8];
+GPIO_TypeDef host_gpio[1];
+RCC_TypeDef host_rcc;
+
+static uint32_t host_primask;
+static bool host_irq_enabled[96];
+static uint8_t host_wire[HOST_WIRE_SIZE];
+static uint32_t host_wire_len;
+static uint32_t host_rx_lost;
+
+/*****************************************************************************
+ * @defgroup 中断与时钟
+ * @{
+ */
+
+uint32_t __get_PRIMASK(void) {
+    return host_primask;
+}
+
+void __set_PRIMASK(uint32_t primask) {
+    host_primask = primask;
+}
+
+void __disable_irq(void) {
+    host_primask = 1;
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority,
+                          uint32_t SubPriority) {
+    UNUSED(IRQn);
+    UNUSED(PreemptPriority);
+    UNUSED(SubPriority);
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn) {
+    host_irq_enabled[IRQn] = true;
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn) {
+    host_irq_enabled[IRQn] = false;
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void) {
+    return 45000000U;
+}
+
+uint32_t HAL_RCC_GetPCLK2Freq(void) {
+    return 90000000U;
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init) {
+    UNUSED(GPIOx);
+    UNUSED(GPIO_Init);
+}
+
+void HAL_GPIO_DeInit(GPIO_TypeDef *GPIOx, uint32_t GPIO_Pin) {
+    UNUSED(GPIOx);
+    UNUSED(GPIO_Pin);
+}
+
+/**
+ * @}
+ */
+
+/*****************************************************************************
+ * @defgroup DMA
+ * @{
+ */
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma) {
+    hdma->State = HAL_DMA_STATE_READY;
+    hdma->ErrorCode = HAL_DMA_ERROR_NONE;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef *hdma) {
+    hdma->State = HAL_DMA_STATE_RESET;
+    return HAL_OK;
+}
+
+/**
+ * @brief 停止DMA流, NDTR保持停止时的值
+ *
+ * @param hdma DMA句柄
+ * @return 与HAL相同, 流没有在传输时返回`HAL_ERROR`并记`HAL_DMA_ERROR_NO_XFER`
+ */
+HAL_StatusTypeDef HAL_DMA_Abort(DMA_HandleTypeDef *hdma) {
+    if (hdma->State != HAL_DMA_STATE_BUSY) {
+        hdma->ErrorCode = HAL_DMA_ERROR_NO_XFER;
+        return HAL_ERROR;
+    }
+
+    hdma->State = HAL_DMA_STATE_READY;
+    return HAL_OK;
+}
+
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma) {
+    UNUSED(hdma);
+}
+
+/**
+ * @brief 启动DMA流, 与`HAL_DMA_Start_IT`相同, 流在传输时返回`HAL_BUSY`
+ *
+ * @param hdma DMA句柄
+ * @param size 传输长度
+ * @return 启动结果
+ */
+static HAL_StatusTypeDef host_dma_start(DMA_HandleTypeDef *hdma,
+                                        uint32_t size) {
+    if (hdma->State != HAL_DMA_STATE_READY) {
+        return HAL_BUSY;
+    }
+
+    hdma->State = HAL_DMA_STATE_BUSY;
+    hdma->ErrorCode = HAL_DMA_ERROR_NONE;
+    hdma->Instance->NDTR = size;
+    return HAL_OK;
+}
+
+/**
+ * @}
+ */
+
+/*****************************************************************************
+ * @defgroup UART
+ * @{
+ */
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart) {
+    huart->Instance->SR = UART_FLAG_TC;
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    huart->gState = HAL_UART_STATE_READY;
+    huart->RxState = HAL_UART_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_DeInit(UART_HandleTypeDef *huart) {
+    huart->gState = HAL_UART_STATE_RESET;
+    huart->RxState = HAL_UART_STATE_RESET;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart,
+                                    const uint8_t *pData, uint16_t Size,
+                                    uint32_t Timeout) {
+    UNUSED(huart);
+    UNUSED(Timeout);
+    if (host_wire_len + Size <= HOST_WIRE_SIZE) {
+        memcpy(host_wire + host_wire_len, pData, Size);
+        host_wire_len += Size;
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart,
+                                        const uint8_t *pData, uint16_t Size) {
+    if (huart->gState != HAL_UART_STATE_READY) {
+        return HAL_BUSY;
+    }
+
+    huart->pTxBuffPtr = pData;
+    huart->TxXferSize = Size;
+    huart->TxXferCount = Size;
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+    host_dma_start(huart->hdmatx, Size);
+    huart->Instance->SR &= ~UART_FLAG_TC;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart,
+                                      uint8_t *pData, uint16_t Size) {
+    UNUSED(huart);
+    UNUSED(pData);
+    UNUSED(Size);
+    return HAL_OK;
+}
+
+/**
+ * @brief 启动DMA接收, 与HAL相同, 不检查DMA流的启动结果
+ *
+ * @param huart 串口句柄
+ * @param pData 接收缓冲区
+ * @param Size 缓冲区大小
+ * @return 串口在接收时返回`HAL_BUSY`
+ * @note 流还在传输时它继续从原来的位置写入, 板上也是这样
+ */
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef *huart,
+                                       uint8_t *pData, uint16_t Size) {
+    if (huart->RxState != HAL_UART_STATE_READY) {
+        return HAL_BUSY;
+    }
+
+    huart->pRxBuffPtr = pData;
+    huart->RxXferSize = Size;
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    huart->RxState = HAL_UART_STATE_BUSY_RX;
+    host_dma_start(huart->hdmarx, Size);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef *huart) {
+    if (huart->hdmarx != NULL) {
+        HAL_DMA_Abort(huart->hdmarx);
+    }
+    huart->RxXferCount = 0;
+    huart->RxState = HAL_UART_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle(UART_HandleTypeDef *huart,
+                                           uint8_t *pData, uint16_t Size,
+                                           uint16_t *RxLen, uint32_t Timeout) {
+    UNUSED(huart);
+    UNUSED(pData);
+    UNUSED(Size);
+    UNUSED(Timeout);
+    *RxLen = 0;
+    return HAL_OK;
+}
+
+void HAL_UART_IRQHandler(UART_HandleTypeDef *huart) {
+    UNUSED(huart);
+}
+
+HAL_UART_StateTypeDef HAL_UART_GetState(UART_HandleTypeDef *huart) {
+    return (HAL_UART_StateTypeDef)(huart->gState | huart->RxState);
+}
+
+uint32_t HAL_UART_GetError(UART_HandleTypeDef *huart) {
+    return huart->ErrorCode;
+}
+
+/**
+ * @}
+ */
+
+/*****************************************************************************
+ * @defgroup 测试用的操作
+ * @{
+ */
+
+/**
+ * @brief DMA接收字节, 到半满与全满时调用HAL的回调
+ *
+ * @param huart 串口句柄
+ * @param data 数据
+ * @param len 数据长度
+ * @note DMA流停止时收到的字节丢失, 计入`host_rx_lost`
+ */
+void host_dma_receive(UART_HandleTypeDef *huart, const void *data,
+                      uint32_t len) {
+    DMA_HandleTypeDef *hdma = huart->hdmarx;
+    const uint8_t *bytes = data;
+
+    for (uint32_t i = 0; i < len; ++i) {
+        if ((hdma == NULL) || (hdma->State != HAL_DMA_STATE_BUSY)) {
+            ++host_rx_lost;
+            continue;
+        }
+
+        uint32_t size = huart->RxXferSize;
+        huart->pRxBuffPtr[size - hdma->Instance->NDTR] = bytes[i];
+        --hdma->Instance->NDTR;
+
+        if (hdma->Instance->NDTR == size / 2U) {
+            HAL_UART_RxHalfCpltCallback(huart);
+        } else if (hdma->Instance->NDTR == 0) {
+            /* 循环模式下硬件立即重装NDTR, 串口保持接收状态 */
+            if (hdma->Init.Mode == DMA_CIRCULAR) {
+                hdma->Instance->NDTR = size;
+            } else {
+                hdma->State = HAL_DMA_STATE_READY;
+                huart->RxState = HAL_UART_STATE_READY;
+            }
+            HAL_UART_RxCpltCallback(huart);
+        }
+    }
+}
+
+/**
+ * @brief 线路空闲, 进入串口中断
+ *
+ * @param huart 串口句柄
+ */
+void host_uart_idle(UART_HandleTypeDef *huart) {
+    huart->Instance->SR |= UART_FLAG_IDLE;
+    USART1_IRQHandler();
+}
+
+/**
+ * @brief 接收出错, 与`HAL_UART_IRQHandler`相同, 结束接收并停止接收DMA,
+ *        再调用错误回调
+ *
+ * @param huart 串口句柄
+ * @param error_code 错误码, 可以是几个`HAL_UART_ERROR_xx`的组合
+ */
+void host_uart_rx_error(UART_HandleTypeDef *huart, uint32_t error_code) {
+    huart->Instance->SR |= error_code & (UART_FLAG_PE | UART_FLAG_NE |
+                                         UART_FLAG_FE | UART_FLAG_ORE);
+    huart->ErrorCode |= error_code;
+    huart->RxState = HAL_UART_STATE_READY;
+    HAL_DMA_Abort(huart->hdmarx);
+    HAL_UART_ErrorCallback(huart);
+}
+
+/**
+ * @brief 发送DMA传输出错, 与`UART_DMAError`相同: 结束发送与接收, 但不停止
+ *        接收DMA, 再调用错误回调
+ *
+ * @param huart 串口句柄
+ * @return 没有在发送时返回false
+ */
+bool host_uart_tx_error(UART_HandleTypeDef *huart) {
+    if (huart->gState != HAL_UART_STATE_BUSY_TX) {
+        return false;
+    }
+
+    huart->hdmatx->ErrorCode |= HAL_DMA_ERROR_TE;
+    huart->hdmatx->State = HAL_DMA_STATE_READY;
+    huart->TxXferCount = 0;
+    huart->gState = HAL_UART_STATE_READY;
+    if (huart->RxState == HAL_UART_STATE_BUSY_RX) {
+        huart->RxXferCount = 0;
+        huart->RxState = HAL_UART_STATE_READY;
+    }
+    huart->ErrorCode |= HAL_UART_ERROR_DMA;
+    HAL_UART_ErrorCallback(huart);
+    return true;
+}
+
+/**
+ * @brief 完成正在进行的DMA发送, 数据记入线路
+ *
+ * @param huart 串口句柄
+ * @return 没有在发送时返回false
+ */
+bool host_uart_tx_complete(UART_HandleTypeDef *huart) {
+    if (huart->gState != HAL_UART_STATE_BUSY_TX) {
+        return false;
+    }
+
+    if (host_wire_len + huart->TxXferSize <= HOST_WIRE_SIZE) {
+        memcpy(host_wire + host_wire_len, huart->pTxBuffPtr,
+               huart->TxXferSize);
+        host_wire_len += huart->TxXferSize;
+    }
+
+    huart->hdmatx->State = HAL_DMA_STATE_READY;
+    huart->hdmatx->Instance->NDTR = 0;
+    huart->TxXferCount = 0;
+    huart->gState = HAL_UART_STATE_READY;
+    huart->Instance->SR |= UART_FLAG_TC;
+    HAL_UART_TxCpltCallback(huart);
+    return true;
+}
+
+/**
+ * @brief 取得发出的字节
+ *
+ * @param[out] len 字节数
+ * @return 发出的字节
+ */
+const uint8_t *host_uart_wire(uint32_t *len) {
+    *len = host_wire_len;
+    return host_wire;
+}
+
+/**
+ * @brief 清空记录的发送字节
+ */
+void host_uart_wire_clear(void) {
+    host_wire_len = 0;
+}
+
+/**
+ * @brief 取得DMA流停止时丢失的接收字节数
+ *
+ * @return 字节数
+ */
+uint32_t host_uart_rx_lost(void) {
+    return host_rx_lost;
+}
+
+/**
+ * @brief 查询中断是否打开
+ *
+ * @param irqn 中断号
+ * @return 打开时返回true
+ */
+bool host_irq_is_enabled(IRQn_Type irqn) {
+    return host_irq_enabled[irqn];
+}
+
+/**
+ * @}
+ */
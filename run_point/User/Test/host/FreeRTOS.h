@@ -0,0 +1,26 @@
+/**
+ * @file    FreeRTOS.h
+ * @author  Deadline039
+ * @brief   主机测试用的FreeRTOS.h替身
+ * @version 1.0
+ * @date    2026-10-17
+ * @note    节拍为1ms, 与`HAL_GetTick`相同
+ */
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stdint.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE            ((BaseType_t)0)
+#define pdTRUE             ((BaseType_t)1)
+#define pdPASS             (pdTRUE)
+#define pdFAIL             (pdFALSE)
+#define portMAX_DELAY      ((TickType_t)0xFFFFFFFFUL)
+#define pdMS_TO_TICKS(xMs) ((TickType_t)(xMs))
+
+#endif /* INC_FREERTOS_H */
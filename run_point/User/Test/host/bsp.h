@@ -0,0 +1,122 @@
+/**
+ * @file    bsp.h
+ * @author  Deadline039
+ * @brief   主机测试用的bsp.h替身
+ * @version 1.0
+ * @date    2026-10-17
+ * @note    只提供msg_protocol用到的HAL与CSP串口驱动的类型和接口,
+ *          实现在`host_port.c`中, 串口发送的数据环回到接收FIFO
+ */
+
+#ifndef __BSP_H
+#define __BSP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ring_fifo.h"
+
+#define UNUSED(X) (void)(X)
+
+/*****************************************************************************
+ * @defgroup HAL
+ * @{
+ */
+
+typedef enum {
+    HAL_OK = 0x00U,
+    HAL_ERROR = 0x01U,
+    HAL_BUSY = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum {
+    HAL_UART_STATE_RESET = 0x00U,
+    HAL_UART_STATE_READY = 0x20U,
+    HAL_UART_STATE_BUSY_TX = 0x21U
+} HAL_UART_StateTypeDef;
+
+typedef struct {
+    uint32_t BaudRate;
+} UART_InitTypeDef;
+
+#define HAL_UART_ERROR_NONE 0x00000000U
+#define HAL_UART_ERROR_DMA  0x00000010U
+
+typedef struct {
+    UART_InitTypeDef Init;
+    const uint8_t *pTxBuffPtr; /* DMA发送时保持为起始地址, 与HAL相同 */
+    uint16_t TxXferSize;
+    void *hdmatx; /* 非NULL时msg_protocol使用发送队列 */
+    volatile HAL_UART_StateTypeDef gState;
+    volatile uint32_t ErrorCode;
+} UART_HandleTypeDef;
+
+typedef struct {
+    volatile uint32_t CYCCNT;
+} host_dwt_t;
+
+extern host_dwt_t host_dwt;
+#define DWT (&host_dwt)
+
+extern uint32_t SystemCoreClock;
+
+uint32_t HAL_GetTick(void);
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart,
+                                    const uint8_t *pData, uint16_t Size,
+                                    uint32_t Timeout);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart,
+                                        const uint8_t *pData, uint16_t Size);
+uint32_t HAL_UART_GetError(UART_HandleTypeDef *huart);
+
+/**
+ * @}
+ */
+
+/*****************************************************************************
+ * @defgroup CSP串口驱动
+ * @{
+ */
+
+#define UART_BAUD_OK   0
+#define UART_BAUD_BUSY 1
+#define UART_BAUD_FAIL 2
+
+/* 与`UART_STM32F4xx.h`中的成员一致 */
+typedef struct {
+    uint32_t rx_bytes;
+    uint32_t tx_bytes;
+    uint32_t ore;
+    uint32_t fe;
+    uint32_t ne;
+    uint32_t pe;
+    uint32_t dma_errors;
+    uint32_t rx_dropped;
+    uint32_t rx_high_water;
+    uint32_t tx_dropped;
+} uart_stats_t;
+
+uint8_t uart_get_stats(UART_HandleTypeDef *huart, uart_stats_t *stats);
+uint8_t uart_check_baud_rate(UART_HandleTypeDef *huart, uint32_t baud_rate);
+uint8_t uart_set_baud_rate(UART_HandleTypeDef *huart, uint32_t baud_rate);
+uint32_t uart_dmarx_peek(UART_HandleTypeDef *huart, ring_fifo_span_t span[2]);
+void uart_dmarx_consume(UART_HandleTypeDef *huart, uint32_t len);
+uint32_t uart_dmatx_write(UART_HandleTypeDef *huart, const void *data,
+                          size_t len);
+uint32_t uart_dmatx_send(UART_HandleTypeDef *huart);
+void uart_dmatx_cplt_callback(UART_HandleTypeDef *huart);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __BSP_H */
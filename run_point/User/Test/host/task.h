@@ -0,0 +1,22 @@
+/**
+ * @file    task.h
+ * @author  Deadline039
+ * @brief   主机测试用的FreeRTOS任务接口替身
+ * @version 1.0
+ * @date    2026-10-17
+ * @note    测试单线程运行, 定时器回调与轮询在同一线程, 临界区为空
+ */
+
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "FreeRTOS.h"
+
+#define taskENTER_CRITICAL()                                                   \
+    do {                                                                       \
+    } while (0)
+#define taskEXIT_CRITICAL()                                                    \
+    do {                                                                       \
+    } while (0)
+
+#endif /* INC_TASK_H */
@@ -0,0 +1,28 @@
+/**
+ * @file    timers.h
+ * @author  Deadline039
+ * @brief   主机测试用的FreeRTOS软件定时器替身
+ * @version 1.0
+ * @date    2026-10-17
+ * @note    定时器在`host_advance`推进时间时回调, 没有定时器任务
+ */
+
+#ifndef TIMERS_H
+#define TIMERS_H
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+typedef struct host_timer *TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t xTimer);
+
+TimerHandle_t xTimerCreate(const char *pcTimerName,
+                           TickType_t xTimerPeriodInTicks,
+                           UBaseType_t uxAutoReload, void *pvTimerID,
+                           TimerCallbackFunction_t pxCallbackFunction);
+BaseType_t xTimerStart(TimerHandle_t xTimer, TickType_t xTicksToWait);
+BaseType_t xTimerReset(TimerHandle_t xTimer, TickType_t xTicksToWait);
+BaseType_t xTimerStop(TimerHandle_t xTimer, TickType_t xTicksToWait);
+void *pvTimerGetTimerID(TimerHandle_t xTimer);
+
+#endif /* TIMERS_H */
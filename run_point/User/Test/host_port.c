@@ -0,0 +1,487 @@
+/**
+ * @file    host_port.c
+ * @author  Deadline039
+ * @brief   HAL, CSP串口驱动与FreeRTOS定时器的主机替身
+ * @version 1.0
+ * @date    2026-10-17
+ * @note    DMA发送在调用`host_flush`时才完成, 与板上一样由"发送完成中断"
+ *          调用`uart_dmatx_cplt_callback`启动下一帧
+ */
+
+#include "test.h"
+
+#include <string.h>
+#include <timers.h>
+
+#define HOST_UART_NUM      2    /* 替身串口数量 */
+#define HOST_RX_FIFO_SIZE  4096 /* 接收FIFO大小, 必须是2的幂 */
+#define HOST_WIRE_SIZE     8192 /* 记录发送字节的缓冲区大小 */
+#define HOST_TIMER_NUM     16   /* 软件定时器数量 */
+#define HOST_TX_BUF_SIZE   256  /* 驱动发送双缓冲区大小, 与板上USART1相同 */
+
+/**
+ * @brief 替身串口的状态
+ */
+typedef struct {
+    UART_HandleTypeDef *huart; /*!< 串口句柄, NULL表示未使用 */
+    ring_fifo_t rx_cb;         /*!< 接收FIFO控制块 */
+    ring_fifo_t *rx;           /*!< 接收FIFO */
+    uint8_t rx_buf[HOST_RX_FIFO_SIZE];
+    uint8_t wire[HOST_WIRE_SIZE]; /*!< 发出的字节, 用于检查帧格式 */
+    uint32_t wire_len;            /*!< `wire`中的字节数 */
+    bool loopback;                /*!< 发送的数据是否环回到接收FIFO */
+    uint32_t loss;                /*!< 环回时丢弃一次发送的概率(千分之) */
+    uint32_t lost;                /*!< 丢弃的发送次数 */
+    const uart_stats_t *stats;    /*!< 不为NULL时作为驱动统计返回 */
+    UART_HandleTypeDef *peer;     /*!< 不为NULL时发送到对方的接收FIFO */
+    uint8_t tx_buf[2][HOST_TX_BUF_SIZE / 2]; /*!< 驱动的发送双缓冲区 */
+    uint32_t tx_fill;                        /*!< 正在填充的一半 */
+    uint32_t tx_head;                        /*!< 已填充的字节数 */
+} host_uart_t;
+
+/**
+ * @brief 替身软件定时器
+ */
+struct host_timer {
+    bool used;                        /*!< 是否已创建 */
+    bool active;                      /*!< 是否在计时 */
+    bool auto_reload;                 /*!< 到期后是否重新开始 */
+    TickType_t period;                /*!< 周期 */
+    uint32_t expiry;                  /*!< 到期时刻 */
+    void *id;                         /*!< 定时器ID */
+    TimerCallbackFunction_t callback; /*!< 回调函数 */
+};
+
+static int host_dma_dummy;
+UART_HandleTypeDef host_uart = {.Init = {.BaudRate = 115200},
+                                .hdmatx = &host_dma_dummy,
+                                .gState = HAL_UART_STATE_READY};
+UART_HandleTypeDef host_peer = {.Init = {.BaudRate = 115200},
+                                .hdmatx = &host_dma_dummy,
+                                .gState = HAL_UART_STATE_READY};
+
+host_dwt_t host_dwt;
+uint32_t SystemCoreClock = 180000000U;
+
+static uint32_t host_tick;
+static host_uart_t host_uarts[HOST_UART_NUM];
+static struct host_timer host_timers[HOST_TIMER_NUM];
+
+/**
+ * @brief 查找替身串口, 第一次使用时初始化
+ *
+ * @param huart 串口句柄
+ * @return 替身串口的状态
+ */
+static host_uart_t *host_uart_get(UART_HandleTypeDef *huart) {
+    for (uint32_t i = 0; i < HOST_UART_NUM; ++i) {
+        if (host_uarts[i].huart == huart) {
+            return &host_uarts[i];
+        }
+    }
+
+    for (uint32_t i = 0; i < HOST_UART_NUM; ++i) {
+        host_uart_t *port = &host_uarts[i];
+        if (port->huart == NULL) {
+            port->huart = huart;
+            port->rx = ring_fifo_init_static(&port->rx_cb, port->rx_buf,
+                                             HOST_RX_FIFO_SIZE,
+                                             RF_TYPE_STREAM);
+            port->loopback = true;
+            return port;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief 串口发出一段数据, 记录下来并环回
+ *
+ * @param huart 串口句柄
+ * @param data 数据
+ * @param len 长度
+ */
+static void host_uart_output(UART_HandleTypeDef *huart, const uint8_t *data,
+                             uint32_t len) {
+    host_uart_t *port = host_uart_get(huart);
+
+    if (port->wire_len + len <= HOST_WIRE_SIZE) {
+        memcpy(port->wire + port->wire_len, data, len);
+        port->wire_len += len;
+    }
+
+    if ((!port->loopback) && (port->peer == NULL)) {
+        return;
+    }
+    if ((port->loss != 0) && (test_rand() % 1000 < port->loss)) {
+        /* 整次发送丢失, 相当于一帧受到干扰被对方丢弃 */
+        ++port->lost;
+        return;
+    }
+
+    if (port->peer == NULL) {
+        ring_fifo_write(port->rx, data, len);
+    } else if (port->peer->Init.BaudRate == huart->Init.BaudRate) {
+        ring_fifo_write(host_uart_get(port->peer)->rx, data, len);
+    } else {
+        /* 波特率不同, 对方收不到完整的帧 */
+        ++port->lost;
+    }
+}
+
+/**
+ * @brief 完成正在进行的DMA发送, 相当于发送完成中断
+ *
+ * @param huart 串口句柄
+ * @return 是否有发送完成
+ */
+static bool host_uart_complete(UART_HandleTypeDef *huart) {
+    if (huart->gState != HAL_UART_STATE_BUSY_TX) {
+        return false;
+    }
+
+    host_uart_output(huart, huart->pTxBuffPtr, huart->TxXferSize);
+    huart->gState = HAL_UART_STATE_READY;
+    uart_dmatx_cplt_callback(huart);
+
+    return true;
+}
+
+/**
+ * @brief 正在进行的DMA发送出错, 相当于驱动在错误中断中调用
+ *        `uart_dmatx_cplt_callback`, 错误码含`HAL_UART_ERROR_DMA`
+ *
+ * @param huart 串口句柄
+ * @return 是否有发送被中止
+ * @note 出错的发送不输出任何字节
+ */
+bool host_uart_tx_error(UART_HandleTypeDef *huart) {
+    if (huart->gState != HAL_UART_STATE_BUSY_TX) {
+        return false;
+    }
+
+    huart->gState = HAL_UART_STATE_READY;
+    huart->ErrorCode = HAL_UART_ERROR_DMA;
+    uart_dmatx_cplt_callback(huart);
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+
+    return true;
+}
+
+/**
+ * @brief 完成所有发送并处理收到的数据, 直到串口空闲
+ */
+void host_flush(void) {
+    bool busy;
+
+    do {
+        busy = false;
+        for (uint32_t i = 0; i < HOST_UART_NUM; ++i) {
+            if ((host_uarts[i].huart != NULL) &&
+                host_uart_complete(host_uarts[i].huart)) {
+                busy = true;
+            }
+        }
+        while (message_polling_data()) {
+        }
+        /* 收到的帧可能被转发或应答, 新启动的发送也要完成 */
+        for (uint32_t i = 0; i < HOST_UART_NUM; ++i) {
+            if ((host_uarts[i].huart != NULL) &&
+                (host_uarts[i].huart->gState == HAL_UART_STATE_BUSY_TX)) {
+                busy = true;
+            }
+        }
+    } while (busy);
+}
+
+/**
+ * @brief 推进时间, 每毫秒处理到期的定时器并完成所有发送
+ *
+ * @param ms 推进的毫秒数
+ */
+void host_advance(uint32_t ms) {
+    host_flush();
+
+    while (ms-- != 0) {
+        ++host_tick;
+        host_dwt.CYCCNT += 180000U;
+
+        for (uint32_t i = 0; i < HOST_TIMER_NUM; ++i) {
+            struct host_timer *timer = &host_timers[i];
+            if ((!timer->active) || (timer->expiry != host_tick)) {
+                continue;
+            }
+
+            timer->active = timer->auto_reload;
+            timer->expiry = host_tick + timer->period;
+            timer->callback(timer);
+        }
+
+        host_flush();
+    }
+}
+
+/**
+ * @brief 向串口的接收FIFO写入数据, 相当于从线路上收到
+ *
+ * @param huart 串口句柄
+ * @param data 数据
+ * @param len 长度
+ */
+void host_uart_inject(UART_HandleTypeDef *huart, const void *data,
+                      uint32_t len) {
+    ring_fifo_write(host_uart_get(huart)->rx, data, len);
+}
+
+/**
+ * @brief 获取串口发出的字节
+ *
+ * @param huart 串口句柄
+ * @param[out] len 字节数
+ * @return 发出的字节
+ */
+const uint8_t *host_uart_wire(UART_HandleTypeDef *huart, uint32_t *len) {
+    host_uart_t *port = host_uart_get(huart);
+
+    *len = port->wire_len;
+    return port->wire;
+}
+
+/**
+ * @brief 清空记录的发送字节
+ *
+ * @param huart 串口句柄
+ */
+void host_uart_wire_clear(UART_HandleTypeDef *huart) {
+    host_uart_get(huart)->wire_len = 0;
+}
+
+/**
+ * @brief 设置发送的数据是否环回到接收FIFO
+ *
+ * @param huart 串口句柄
+ * @param loopback 是否环回
+ */
+void host_uart_set_loopback(UART_HandleTypeDef *huart, bool loopback) {
+    host_uart_get(huart)->loopback = loopback;
+}
+
+/**
+ * @brief 设置环回时每次发送丢失的概率
+ *
+ * @param huart 串口句柄
+ * @param permille 丢失概率(千分之), 为0时不丢失
+ * @return 设置之前丢失的发送次数
+ */
+uint32_t host_uart_set_loss(UART_HandleTypeDef *huart, uint32_t permille) {
+    host_uart_t *port = host_uart_get(huart);
+    uint32_t lost = port->lost;
+
+    port->loss = permille;
+    port->lost = 0;
+    return lost;
+}
+
+/**
+ * @brief 交叉连接两个串口, 一方发送的数据进入另一方的接收FIFO
+ *
+ * @param huart 串口句柄
+ * @param peer 对方串口, 为NULL时断开`huart`与原来的对方, 恢复环回设置
+ * @note 只有双方的波特率相同时对方才能收到
+ */
+void host_uart_connect(UART_HandleTypeDef *huart, UART_HandleTypeDef *peer) {
+    host_uart_t *port = host_uart_get(huart);
+
+    if (port->peer != NULL) {
+        host_uart_get(port->peer)->peer = NULL;
+    }
+    port->peer = peer;
+    if (peer != NULL) {
+        host_uart_get(peer)->peer = huart;
+    }
+}
+
+/**
+ * @brief 设置`uart_get_stats`返回的驱动统计
+ *
+ * @param huart 串口句柄
+ * @param stats 驱动统计, 调用者保持有效. 为NULL时恢复按替身串口统计
+ */
+void host_uart_set_stats(UART_HandleTypeDef *huart,
+                         const uart_stats_t *stats) {
+    host_uart_get(huart)->stats = stats;
+}
+
+/*****************************************************************************
+ * @defgroup HAL
+ * @{
+ */
+
+uint32_t HAL_GetTick(void) {
+    return host_tick;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart,
+                                    const uint8_t *pData, uint16_t Size,
+                                    uint32_t Timeout) {
+    UNUSED(Timeout);
+
+    if (huart->gState != HAL_UART_STATE_READY) {
+        return HAL_BUSY;
+    }
+
+    host_uart_output(huart, pData, Size);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart,
+                                        const uint8_t *pData, uint16_t Size) {
+    if (huart->gState != HAL_UART_STATE_READY) {
+        return HAL_BUSY;
+    }
+
+    huart->pTxBuffPtr = pData;
+    huart->TxXferSize = Size;
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    return HAL_OK;
+}
+
+uint32_t HAL_UART_GetError(UART_HandleTypeDef *huart) {
+    return huart->ErrorCode;
+}
+
+/**
+ * @}
+ */
+
+/*****************************************************************************
+ * @defgroup CSP串口驱动
+ * @{
+ */
+
+uint8_t uart_get_stats(UART_HandleTypeDef *huart, uart_stats_t *stats) {
+    host_uart_t *port = host_uart_get(huart);
+
+    if (port->stats != NULL) {
+        *stats = *port->stats;
+        return 0;
+    }
+
+    memset(stats, 0, sizeof(uart_stats_t));
+    stats->rx_dropped = ring_fifo_dropped(port->rx);
+    stats->tx_bytes = port->wire_len;
+    return 0;
+}
+
+uint8_t uart_check_baud_rate(UART_HandleTypeDef *huart, uint32_t baud_rate) {
+    UNUSED(huart);
+
+    return (baud_rate <= 4500000U) ? UART_BAUD_OK : UART_BAUD_FAIL;
+}
+
+uint8_t uart_set_baud_rate(UART_HandleTypeDef *huart, uint32_t baud_rate) {
+    if (huart->gState != HAL_UART_STATE_READY) {
+        return UART_BAUD_BUSY;
+    }
+
+    huart->Init.BaudRate = baud_rate;
+    return UART_BAUD_OK;
+}
+
+uint32_t uart_dmarx_peek(UART_HandleTypeDef *huart, ring_fifo_span_t span[2]) {
+    return ring_fifo_peek(host_uart_get(huart)->rx, span);
+}
+
+void uart_dmarx_consume(UART_HandleTypeDef *huart, uint32_t len) {
+    ring_fifo_consume(host_uart_get(huart)->rx, len);
+}
+
+/* 与驱动一样复制到正在填充的一半缓冲区, 超出的部分丢弃 */
+uint32_t uart_dmatx_write(UART_HandleTypeDef *huart, const void *data,
+                          size_t len) {
+    host_uart_t *port = host_uart_get(huart);
+    uint32_t remain = HOST_TX_BUF_SIZE / 2 - port->tx_head;
+
+    if (len > remain) {
+        len = remain;
+    }
+    memcpy(port->tx_buf[port->tx_fill] + port->tx_head, data, len);
+    port->tx_head += len;
+    return len;
+}
+
+/* 与驱动一样发送填充好的一半并切换到另一半. 串口忙时驱动等发送完成再启动,
+   这里不模拟, 由调用者等待发送完成 */
+uint32_t uart_dmatx_send(UART_HandleTypeDef *huart) {
+    host_uart_t *port = host_uart_get(huart);
+    uint32_t len = port->tx_head;
+
+    if ((len == 0) ||
+        (HAL_UART_Transmit_DMA(huart, port->tx_buf[port->tx_fill],
+                               (uint16_t)len) != HAL_OK)) {
+        return 0;
+    }
+    port->tx_fill ^= 1U;
+    port->tx_head = 0;
+    return len;
+}
+
+/**
+ * @}
+ */
+
+/*****************************************************************************
+ * @defgroup FreeRTOS软件定时器
+ * @{
+ */
+
+TimerHandle_t xTimerCreate(const char *pcTimerName,
+                           TickType_t xTimerPeriodInTicks,
+                           UBaseType_t uxAutoReload, void *pvTimerID,
+                           TimerCallbackFunction_t pxCallbackFunction) {
+    UNUSED(pcTimerName);
+
+    for (uint32_t i = 0; i < HOST_TIMER_NUM; ++i) {
+        struct host_timer *timer = &host_timers[i];
+        if (!timer->used) {
+            timer->used = true;
+            timer->active = false;
+            timer->auto_reload = (uxAutoReload != pdFALSE);
+            timer->period = xTimerPeriodInTicks;
+            timer->id = pvTimerID;
+            timer->callback = pxCallbackFunction;
+            return timer;
+        }
+    }
+
+    return NULL;
+}
+
+BaseType_t xTimerStart(TimerHandle_t xTimer, TickType_t xTicksToWait) {
+    UNUSED(xTicksToWait);
+
+    xTimer->active = true;
+    xTimer->expiry = host_tick + xTimer->period;
+    return pdPASS;
+}
+
+BaseType_t xTimerReset(TimerHandle_t xTimer, TickType_t xTicksToWait) {
+    return xTimerStart(xTimer, xTicksToWait);
+}
+
+BaseType_t xTimerStop(TimerHandle_t xTimer, TickType_t xTicksToWait) {
+    UNUSED(xTicksToWait);
+
+    xTimer->active = false;
+    return pdPASS;
+}
+
+void *pvTimerGetTimerID(TimerHandle_t xTimer) {
+    return xTimer->id;
+}
+
+/**
+ * @}
+ */
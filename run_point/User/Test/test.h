@@ -0,0 +1,131 @@
+/**
+ * @file    test.h
+ * @author  Deadline039
+ * @brief   msg_protocol, ring_fifo与串口驱动的主机测试
+ * @version 1.0
+ * @date    2026-10-17
+ * @note    不依赖硬件, HAL, CSP串口驱动与FreeRTOS定时器由`host`目录中的
+ *          替身代替, 串口发送的数据按帧环回到接收FIFO
+ *
+ *****************************************************************************
+ *                             ##### 如何使用 ####
+ * (#) 在run_point目录下编译运行, 全部通过时返回0, 否则打印失败的断言
+ *     cc -std=c11 -O2 -pthread -IUser/Test/host -IUser/Test -IUser/Utils
+ *        -IUser/Utils/ring_fifo -IUser/Application/Inc
+ *        User/Test/host_port.c User/Test/test_main.c
+ *        User/Test/test_msg_protocol.c User/Test/test_ring_fifo.c
+ *        User/Application/Src/msg_protocol.c User/Utils/crc16.c
+ *        User/Utils/ring_fifo/ring_fifo.c -o msg_test && ./msg_test
+ *
+ * (#) 帧格式相关的测试按`MSG_FRAME_VERSION`编译, 加`-DMSG_FRAME_VERSION=1`
+ *     或`-DMSG_FRAME_VERSION=3`测试其他帧格式. 各版本的发送与解析耗时
+ *     在各自的输出中, 对比即可看出CRC与COBS编解码的开销
+ *
+ * (#) 波特率协商默认不编译, 加`-DMSG_BAUD_ENABLE=1`测试协商. `host_uart`与
+ *     `host_peer`交叉连接, 双方波特率不同时收不到对方的数据
+ *
+ * (#) 新增测试: 在对应的`test_*.c`中添加`static void`函数, 用
+ *     `TEST_ASSERT`检查结果, 并在该文件的入口函数中调用
+ *
+ * (#) 串口驱动`UART_STM32F4xx.c`单独编译测试, HAL由`driver`目录与
+ *     `driver_port.c`中的替身代替. 默认测试复制模式, 再加
+ *     `-DUART_RX_DMA_DIRECT=1`测试直接模式
+ *     cc -std=c11 -O2 -DTEST_UART_DRIVER -IUser/Test/driver -IUser/Test
+ *        -IDrivers/CSP -IUser/Utils -IUser/Utils/ring_fifo
+ *        User/Test/test_main.c User/Test/test_uart.c User/Test/driver_port.c
+ *        Drivers/CSP/UART_STM32F4xx.c User/Utils/ring_fifo/ring_fifo.c
+ *        -o uart_test && ./uart_test
+ *****************************************************************************
+ */
+
+#ifndef __TEST_H
+#define __TEST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#ifdef TEST_UART_DRIVER
+#include <CSP_Config.h>
+#else /* TEST_UART_DRIVER */
+#include <bsp.h>
+#include <msg_protocol.h>
+#endif /* TEST_UART_DRIVER */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @brief 检查条件, 不成立时打印位置并计入失败数, 继续运行
+ */
+#define TEST_ASSERT(X) test_check((X), #X, __FILE__, __LINE__)
+
+void test_check(bool ok, const char *expr, const char *file, int line);
+uint32_t test_rand(void);
+uint64_t test_now_ns(void);
+void test_bench_print(const char *name, uint64_t ns, uint32_t n,
+                      uint32_t bytes);
+
+#ifdef TEST_UART_DRIVER
+
+/*****************************************************************************
+ * @defgroup 驱动测试的HAL替身
+ * @{
+ */
+
+void host_dma_receive(UART_HandleTypeDef *huart, const void *data,
+                      uint32_t len);
+void host_uart_idle(UART_HandleTypeDef *huart);
+void host_uart_rx_error(UART_HandleTypeDef *huart, uint32_t error_code);
+bool host_uart_tx_error(UART_HandleTypeDef *huart);
+bool host_uart_tx_complete(UART_HandleTypeDef *huart);
+const uint8_t *host_uart_wire(uint32_t *len);
+void host_uart_wire_clear(void);
+uint32_t host_uart_rx_lost(void);
+bool host_irq_is_enabled(IRQn_Type irqn);
+void USART1_IRQHandler(void);
+
+/**
+ * @}
+ */
+
+void test_uart(void);
+
+#else /* TEST_UART_DRIVER */
+
+/*****************************************************************************
+ * @defgroup 主机串口与时间
+ * @{
+ */
+
+extern UART_HandleTypeDef host_uart; /* 发送环回到自己的接收FIFO */
+extern UART_HandleTypeDef host_peer; /* 第二个串口, 用于多串口的测试 */
+
+void host_advance(uint32_t ms);
+void host_flush(void);
+bool host_uart_tx_error(UART_HandleTypeDef *huart);
+void host_uart_inject(UART_HandleTypeDef *huart, const void *data,
+                      uint32_t len);
+const uint8_t *host_uart_wire(UART_HandleTypeDef *huart, uint32_t *len);
+void host_uart_wire_clear(UART_HandleTypeDef *huart);
+void host_uart_set_loopback(UART_HandleTypeDef *huart, bool loopback);
+uint32_t host_uart_set_loss(UART_HandleTypeDef *huart, uint32_t permille);
+void host_uart_set_stats(UART_HandleTypeDef *huart,
+                         const uart_stats_t *stats);
+void host_uart_connect(UART_HandleTypeDef *huart, UART_HandleTypeDef *peer);
+
+/**
+ * @}
+ */
+
+void test_msg_protocol(void);
+void test_ring_fifo(void);
+
+#endif /* TEST_UART_DRIVER */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __TEST_H */
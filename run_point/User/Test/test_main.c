@@ -0,0 +1,91 @@
+/**
+ * @file    test_main.c
+ * @author  Deadline039
+ * @brief   主机测试入口
+ * @version 1.0
+ * @date    2026-10-17
+ */
+
+/* 严格的C标准模式下`clock_gettime`需要POSIX声明, 要在所有头文件之前定义 */
+#define _POSIX_C_SOURCE 199309L
+
+#include "test.h"
+
+#include <time.h>
+
+static uint32_t test_checks;
+static uint32_t test_failures;
+static uint32_t test_seed = 0x12345678U;
+
+/**
+ * @brief 记录一次检查的结果
+ *
+ * @param ok 检查是否通过
+ * @param expr 检查的表达式
+ * @param file 文件名
+ * @param line 行号
+ */
+void test_check(bool ok, const char *expr, const char *file, int line) {
+    ++test_checks;
+    if (!ok) {
+        ++test_failures;
+        printf("%s:%d: FAILED: %s\n", file, line, expr);
+    }
+}
+
+/**
+ * @brief 伪随机数, 种子固定, 每次运行结果相同
+ *
+ * @return 随机数, 低16位有效
+ */
+uint32_t test_rand(void) {
+    test_seed = test_seed * 1103515245U + 12345U;
+    return (test_seed >> 8) & 0xFFFFU;
+}
+
+/**
+ * @brief 读取时间戳
+ *
+ * @return 当前时间(ns)
+ */
+uint64_t test_now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief 输出一项性能测试的结果
+ *
+ * @param name 名称
+ * @param ns 总耗时(ns)
+ * @param n 操作次数
+ * @param bytes 每次操作处理的字节数, 为0时不输出吞吐量
+ */
+void test_bench_print(const char *name, uint64_t ns, uint32_t n,
+                      uint32_t bytes) {
+    uint64_t ns_x10 = ns * 10U / n;
+
+    printf("  %-28s %6lu.%lu ns/op", name, (unsigned long)(ns_x10 / 10U),
+           (unsigned long)(ns_x10 % 10U));
+    if ((bytes != 0) && (ns != 0)) {
+        printf(" %9lu KB/s",
+               (unsigned long)((uint64_t)bytes * n * 1000000000U / ns /
+                               1024U));
+    }
+    printf("\n");
+}
+
+int main(void) {
+#ifdef TEST_UART_DRIVER
+    test_uart();
+#else  /* TEST_UART_DRIVER */
+    test_msg_protocol();
+    test_ring_fifo();
+#endif /* TEST_UART_DRIVER */
+
+    printf("%lu checks, %lu failed\n", (unsigned long)test_checks,
+           (unsigned long)test_failures);
+    return (test_failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,1997 @@
+/**
+ * @file    test_msg_protocol.c
+ * @author  Deadline039
+ * @brief   msg_protocol的主机测试
+ * @version 1.0
+ * @date    2026-10-17
+ * @note    期望的帧由本文件独立组出(逐位CRC, 通用COBS), 与协议的实现对照.
+ *          msg_protocol的状态是静态的, 各测试共用`host_uart`,
+ *          统计按前后差值检查
+ */
+
+#include "test.h"
+
+#include <crc16.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_BENCH_FRAMES 100000 /* 性能测试的帧数 */
+#define TEST_STREAM_FRAMES 200   /* 随机拆分合并测试的帧数 */
+
+/**
+ * @brief 回调函数收到的一条消息
+ */
+typedef struct {
+    uint8_t len;                       /*!< 长度 */
+    uint8_t type;                      /*!< 数据类型 */
+    uint8_t data[MSG_MAX_DATA_LENGTH]; /*!< 数据 */
+} test_msg_t;
+
+static test_msg_t test_recv[TEST_STREAM_FRAMES];
+static uint32_t test_recv_num;
+
+static uint8_t test_large[MSG_MAX_FRAGMENT_LENGTH];
+static uint16_t test_large_len;
+static uint32_t test_large_num;
+
+/**
+ * @brief 逐位计算CRC-16/CCITT-FALSE, 与查表实现对照
+ *
+ * @param data 数据
+ * @param len 长度
+ * @return CRC
+ */
+static uint16_t test_crc16(const uint8_t *data, size_t len) {
+    uint16_t crc = 0xFFFF;
+
+    while (len-- != 0) {
+        crc ^= (uint16_t)(*data++ << 8);
+        for (uint32_t i = 0; i < 8; ++i) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021)
+                                 : (uint16_t)(crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+#if (MSG_FRAME_VERSION == 3)
+/**
+ * @brief COBS编码, 不限长度, 末尾补0x00分隔符
+ *
+ * @param[out] out 编码结果
+ * @param in 原始数据
+ * @param len 原始数据长度
+ * @return 编码后的长度, 含分隔符
+ */
+static size_t test_cobs_encode(uint8_t *out, const uint8_t *in, size_t len) {
+    size_t code_pos = 0;
+    size_t pos = 1;
+    uint8_t code = 1;
+
+    for (size_t i = 0; i < len; ++i) {
+        if (in[i] == 0x00) {
+            out[code_pos] = code;
+            code_pos = pos++;
+            code = 1;
+            continue;
+        }
+        out[pos++] = in[i];
+        if (++code == 0xFF) {
+            out[code_pos] = code;
+            code_pos = pos++;
+            code = 1;
+        }
+    }
+    out[code_pos] = code;
+    out[pos++] = 0x00;
+
+    return pos;
+}
+
+/**
+ * @brief COBS解码一帧
+ *
+ * @param[out] out 解码结果
+ * @param in 编码数据, 以0x00结束
+ * @param[out] used 消耗的字节数, 含分隔符
+ * @return 解码后的长度
+ */
+static size_t test_cobs_decode(uint8_t *out, const uint8_t *in, size_t *used) {
+    size_t pos = 0;
+    size_t len = 0;
+
+    while (in[pos] != 0x00) {
+        uint8_t code = in[pos++];
+        for (uint8_t i = 1; i < code; ++i) {
+            out[len++] = in[pos++];
+        }
+        if ((code != 0xFF) && (in[pos] != 0x00)) {
+            out[len++] = 0x00;
+        }
+    }
+    *used = pos + 1;
+
+    return len;
+}
+#endif /* MSG_FRAME_VERSION == 3 */
+
+/**
+ * @brief 按帧格式组出期望的一帧
+ *
+ * @param[out] out 帧
+ * @param mean 含义
+ * @param type 数据类型
+ * @param seq 序号, 版本1忽略
+ * @param data 数据
+ * @param len 数据长度
+ * @return 帧长度
+ */
+static size_t test_build_frame(uint8_t *out, uint8_t mean, uint8_t type,
+                               uint8_t seq, const void *data, size_t len) {
+#if (MSG_FRAME_VERSION == 1)
+    UNUSED(seq);
+    out[0] = (uint8_t)(mean << 4) | type;
+    out[1] = (uint8_t)len;
+    memcpy(out + 2, data, len);
+    out[len + 2] = 0xFF;
+    return len + 3;
+#else  /* MSG_FRAME_VERSION == 1 */
+    uint8_t body[300];
+
+    body[0] = (uint8_t)(MSG_FRAME_VERSION << 4);
+    body[1] = seq;
+    body[2] = (uint8_t)(mean << 4) | type;
+    body[3] = (uint8_t)len;
+    memcpy(body + 4, data, len);
+    uint16_t crc = test_crc16(body, len + 4);
+    body[len + 4] = (uint8_t)(crc >> 8);
+    body[len + 5] = (uint8_t)crc;
+
+#if (MSG_FRAME_VERSION == 2)
+    out[0] = 0xA5;
+    out[1] = 0x5A;
+    memcpy(out + 2, body, len + 6);
+    return len + 8;
+#else  /* MSG_FRAME_VERSION == 2 */
+    return test_cobs_encode(out, body, len + 6);
+#endif /* MSG_FRAME_VERSION == 2 */
+#endif /* MSG_FRAME_VERSION == 1 */
+}
+
+/**
+ * @brief 读出线路上一帧的序号
+ *
+ * @param frame 帧
+ * @return 序号, 版本1返回0
+ */
+static uint8_t test_frame_seq(const uint8_t *frame) {
+#if (MSG_FRAME_VERSION == 1)
+    UNUSED(frame);
+    return 0;
+#elif (MSG_FRAME_VERSION == 2)
+    return frame[3];
+#else  /* MSG_FRAME_VERSION */
+    uint8_t body[300];
+    size_t used;
+
+    test_cobs_decode(body, frame, &used);
+    return body[1];
+#endif /* MSG_FRAME_VERSION */
+}
+
+/**
+ * @brief 检查线路上的一帧与期望的帧相同
+ *
+ * @param wire 线路上的字节
+ * @param mean 含义
+ * @param type 数据类型
+ * @param data 数据
+ * @param len 数据长度
+ * @return 帧长度, 不相同时返回0
+ */
+static size_t test_expect_frame(const uint8_t *wire, uint8_t mean,
+                                uint8_t type, const void *data, size_t len) {
+    uint8_t expect[300];
+    size_t frame_len =
+        test_build_frame(expect, mean, type, test_frame_seq(wire), data, len);
+
+    return (memcmp(wire, expect, frame_len) == 0) ? frame_len : 0;
+}
+
+/**
+ * @brief 记录收到的消息
+ *
+ * @param msg_length 消息长度
+ * @param msg_type 数据类型
+ * @param msg_data 数据
+ */
+static void test_recv_callback(uint8_t msg_length, message_type_t msg_type,
+                               void *msg_data) {
+    if ((test_recv_num >= TEST_STREAM_FRAMES) ||
+        (msg_length > MSG_MAX_DATA_LENGTH)) {
+        return;
+    }
+
+    test_msg_t *msg = &test_recv[test_recv_num++];
+    msg->len = msg_length;
+    msg->type = msg_type;
+    memcpy(msg->data, msg_data, msg_length);
+}
+
+/**
+ * @brief 读取接收统计
+ *
+ * @return 接收统计
+ */
+static message_polling_stats_t test_polling_stats(void) {
+    message_polling_stats_t stats = {0};
+
+    message_get_polling_stats(&host_uart, &stats);
+    return stats;
+}
+
+/**
+ * @brief 生成一条随机消息并组帧
+ *
+ * @param[out] msg 消息
+ * @param[out] frame 帧
+ * @param seq 序号
+ * @return 帧长度
+ */
+static size_t test_random_frame(test_msg_t *msg, uint8_t *frame, uint8_t seq) {
+    msg->len = (uint8_t)(test_rand() % MSG_MAX_DATA_LENGTH + 1);
+    msg->type = (uint8_t)(test_rand() % (MSG_DATA_STRING + 1));
+    for (uint8_t i = 0; i < msg->len; ++i) {
+        msg->data[i] = (uint8_t)test_rand();
+    }
+
+    return test_build_frame(frame, MSG_CHASSIS, msg->type, seq, msg->data,
+                            msg->len);
+}
+
+/**
+ * @brief 生成一段不会被当作帧的随机字节, 以帧边界结束
+ *
+ * @param[out] buf 字节
+ * @return 长度
+ * @note 版本1不含有效的含义与0xFF, 以0xFF结束; 版本2不含同步字;
+ *       版本3不含0x00, 以0x00结束, 会被当作一个校验错误的帧
+ */
+static size_t test_random_garbage(uint8_t *buf) {
+    /* 至少2字节, 版本3中解码后不为空 */
+    size_t len = test_rand() % 24 + 2;
+
+    for (size_t i = 0; i < len; ++i) {
+#if (MSG_FRAME_VERSION == 1)
+        buf[i] = (uint8_t)(0x30 + test_rand() % 0x90);
+#elif (MSG_FRAME_VERSION == 2)
+        do {
+            buf[i] = (uint8_t)test_rand();
+        } while (buf[i] == MSG_FRAME_SYNC_0);
+#else  /* MSG_FRAME_VERSION */
+        buf[i] = (uint8_t)(test_rand() % 0xFF + 1);
+#endif /* MSG_FRAME_VERSION */
+    }
+
+#if (MSG_FRAME_VERSION == 1)
+    buf[len++] = 0xFF;
+#elif (MSG_FRAME_VERSION == 3)
+    buf[len++] = 0x00;
+#endif /* MSG_FRAME_VERSION */
+
+    return len;
+}
+
+/**
+ * @brief 按随机长度拆分注入字节流, 每段之后轮询一次
+ *
+ * @param stream 字节流
+ * @param len 长度
+ */
+static void test_inject_split(const uint8_t *stream, size_t len) {
+    size_t pos = 0;
+
+    while (pos < len) {
+        /* 从一个字节到几帧, 覆盖拆开与合并的帧 */
+        size_t chunk = test_rand() % 64 + 1;
+        if (chunk > len - pos) {
+            chunk = len - pos;
+        }
+        host_uart_inject(&host_uart, stream + pos, chunk);
+        while (message_polling_data()) {
+        }
+        pos += chunk;
+    }
+}
+
+/**
+ * @brief 检查收到的消息与发出的消息逐条相同
+ *
+ * @param sent 发出的消息
+ * @param num 条数
+ */
+static void test_expect_received(const test_msg_t *sent, uint32_t num) {
+    TEST_ASSERT(test_recv_num == num);
+
+    for (uint32_t i = 0; (i < num) && (i < test_recv_num); ++i) {
+        TEST_ASSERT((test_recv[i].len == sent[i].len) &&
+                    (test_recv[i].type == sent[i].type) &&
+                    (memcmp(test_recv[i].data, sent[i].data, sent[i].len) ==
+                     0));
+    }
+}
+
+/**
+ * @brief 帧被随机拆开或合并到达, 全部按顺序收到
+ * @param garbage 帧之间是否插入随机字节
+ */
+static void test_parse_stream(bool garbage) {
+    static test_msg_t sent[TEST_STREAM_FRAMES];
+    static uint8_t stream[TEST_STREAM_FRAMES * 64];
+    message_polling_stats_t before = test_polling_stats();
+    size_t len = 0;
+    uint32_t garbage_num = 0;
+
+    for (uint32_t i = 0; i < TEST_STREAM_FRAMES; ++i) {
+        if (garbage && (test_rand() % 2 == 0)) {
+            len += test_random_garbage(stream + len);
+            ++garbage_num;
+        }
+        len += test_random_frame(&sent[i], stream + len, (uint8_t)i);
+    }
+
+    test_recv_num = 0;
+    test_inject_split(stream, len);
+
+    message_polling_stats_t after = test_polling_stats();
+    test_expect_received(sent, TEST_STREAM_FRAMES);
+    TEST_ASSERT(after.frames - before.frames == TEST_STREAM_FRAMES);
+    TEST_ASSERT(after.bytes - before.bytes == len);
+    TEST_ASSERT(after.overflows == before.overflows);
+#if (MSG_FRAME_VERSION == 3)
+    TEST_ASSERT(after.verify_errors - before.verify_errors == garbage_num);
+#else  /* MSG_FRAME_VERSION == 3 */
+    UNUSED(garbage_num);
+    TEST_ASSERT(after.verify_errors == before.verify_errors);
+#endif /* MSG_FRAME_VERSION == 3 */
+}
+
+/**
+ * @brief 长度超过上限的帧被丢弃并计数, 紧随其后的帧正常收到
+ */
+static void test_parse_overflow(void) {
+    uint8_t data[MSG_MAX_DATA_LENGTH + 1];
+    uint8_t stream[128];
+    test_msg_t sent;
+    message_polling_stats_t before = test_polling_stats();
+
+    /* 不含0xFF, 版本1在帧尾重新同步 */
+    memset(data, 0x5A, sizeof(data));
+    size_t len = test_build_frame(stream, MSG_CHASSIS, MSG_DATA_UINT8, 0,
+                                  data, sizeof(data));
+    len += test_random_frame(&sent, stream + len, 1);
+
+    test_recv_num = 0;
+    test_inject_split(stream, len);
+
+    message_polling_stats_t after = test_polling_stats();
+    test_expect_received(&sent, 1);
+    TEST_ASSERT(after.frames - before.frames == 1);
+    TEST_ASSERT(after.errors - before.errors == 1);
+#if (MSG_FRAME_VERSION == 3)
+    /* COBS帧收完才检查长度, 算作校验错误 */
+    TEST_ASSERT(after.verify_errors - before.verify_errors == 1);
+#else  /* MSG_FRAME_VERSION == 3 */
+    TEST_ASSERT(after.overflows - before.overflows == 1);
+#endif /* MSG_FRAME_VERSION == 3 */
+}
+
+/**
+ * @brief 解析的吞吐量, 每次注入1KB后轮询
+ */
+static void test_parse_bench(void) {
+    static uint8_t stream[1024];
+    test_msg_t msg;
+    size_t len = 0;
+    uint32_t frames = 0;
+
+    while (len + MSG_MAX_DATA_LENGTH + MSG_FRAME_OVERHEAD <= sizeof(stream)) {
+        len += test_random_frame(&msg, stream + len, (uint8_t)frames);
+        ++frames;
+    }
+
+    message_register_recv_callback(MSG_CHASSIS, NULL);
+    uint64_t start = test_now_ns();
+    for (uint32_t i = 0; i < TEST_BENCH_FRAMES / frames; ++i) {
+        host_uart_inject(&host_uart, stream, len);
+        while (message_polling_data()) {
+        }
+    }
+    test_bench_print("message_polling_data (frame)", test_now_ns() - start,
+                     TEST_BENCH_FRAMES / frames * frames, len / frames);
+    message_register_recv_callback(MSG_CHASSIS, test_recv_callback);
+}
+
+/**
+ * @brief 查表CRC与标准校验值和逐位计算的结果一致
+ */
+static void test_crc16_table(void) {
+    uint8_t data[64];
+
+    /* CRC-16/CCITT-FALSE的标准校验值 */
+    TEST_ASSERT(crc16_calc("123456789", 9) == 0x29B1);
+    TEST_ASSERT(crc16_calc("", 0) == CRC16_INIT);
+
+    for (uint32_t n = 0; n < 100; ++n) {
+        size_t len = test_rand() % sizeof(data) + 1;
+        size_t split = test_rand() % len;
+
+        for (size_t i = 0; i < len; ++i) {
+            data[i] = (uint8_t)test_rand();
+        }
+        TEST_ASSERT(crc16_calc(data, len) == test_crc16(data, len));
+        /* 分段累加与一次计算相同 */
+        TEST_ASSERT(crc16_update(crc16_calc(data, split), data + split,
+                                 len - split) == test_crc16(data, len));
+    }
+}
+
+/**
+ * @brief 帧中任意一位翻转都不会交给回调函数
+ * @note 版本1只有帧尾能发现错误, 只检查帧尾
+ */
+static void test_parse_bit_flip(void) {
+    uint8_t data[8] = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77};
+    uint8_t frame[64];
+#if (MSG_FRAME_VERSION == 1)
+    /* 出错后在0xFF处重新同步 */
+    uint8_t pad[1] = {0xFF};
+#else  /* MSG_FRAME_VERSION == 1 */
+    /* 版本2补一段0x00, 结束长度字节被翻转后没收完的帧; 版本3为分隔符 */
+    uint8_t pad[MSG_MAX_BATCH_LENGTH + MSG_FRAME_OVERHEAD] = {0};
+#endif /* MSG_FRAME_VERSION == 1 */
+    test_msg_t clean;
+    uint8_t clean_frame[64];
+    size_t clean_len = test_random_frame(&clean, clean_frame, 0);
+    size_t len = test_build_frame(frame, MSG_CHASSIS, MSG_DATA_UINT8, 0x5A,
+                                  data, sizeof(data));
+
+#if (MSG_FRAME_VERSION == 1)
+    size_t first = len - 1;
+#else  /* MSG_FRAME_VERSION == 1 */
+    size_t first = 0;
+#endif /* MSG_FRAME_VERSION == 1 */
+#if (MSG_FRAME_VERSION == 3)
+    /* 分隔符被翻转时与下一帧合并, 属于丢失两帧的情况, 不在这里检查 */
+    size_t last = len - 1;
+#else  /* MSG_FRAME_VERSION == 3 */
+    size_t last = len;
+#endif /* MSG_FRAME_VERSION == 3 */
+
+    for (size_t pos = first; pos < last; ++pos) {
+        for (uint32_t bit = 0; bit < 8; ++bit) {
+            message_polling_stats_t before = test_polling_stats();
+
+            frame[pos] ^= (uint8_t)(1U << bit);
+            test_recv_num = 0;
+            host_uart_inject(&host_uart, frame, len);
+            host_uart_inject(&host_uart, pad, sizeof(pad));
+            host_uart_inject(&host_uart, clean_frame, clean_len);
+            while (message_polling_data()) {
+            }
+            frame[pos] ^= (uint8_t)(1U << bit);
+
+            message_polling_stats_t after = test_polling_stats();
+            /* 只收到后面完好的帧 */
+            test_expect_received(&clean, 1);
+#if (MSG_FRAME_VERSION == 2)
+            if (pos >= 6) {
+                /* 数据与CRC中的错误一定由CRC发现 */
+                TEST_ASSERT(after.verify_errors - before.verify_errors == 1);
+            }
+#else  /* MSG_FRAME_VERSION == 2 */
+            TEST_ASSERT(after.errors != before.errors);
+#endif /* MSG_FRAME_VERSION == 2 */
+        }
+    }
+}
+
+#if (MSG_FRAME_VERSION == 3)
+/**
+ * @brief 含0x00与0xFF的数据编码后帧内没有0x00, 环回后原样收到
+ */
+static void test_cobs_payload(void) {
+    static const uint8_t pattern[3] = {0x00, 0xFF, 0x01};
+    uint8_t data[MSG_MAX_DATA_LENGTH];
+    test_msg_t sent;
+    uint32_t len;
+
+    for (uint32_t p = 0; p < 4; ++p) {
+        for (size_t n = 1; n <= MSG_MAX_DATA_LENGTH; ++n) {
+            for (size_t i = 0; i < n; ++i) {
+                /* 全0x00, 全0xFF, 全0x01, 以及交替 */
+                data[i] = (p < 3) ? pattern[p] : pattern[i % 3];
+            }
+
+            sent.len = (uint8_t)n;
+            sent.type = MSG_DATA_FP32;
+            memcpy(sent.data, data, n);
+            test_recv_num = 0;
+            host_uart_wire_clear(&host_uart);
+            message_send_data(MSG_CHASSIS, MSG_DATA_FP32, data, n);
+            host_flush();
+
+            const uint8_t *wire = host_uart_wire(&host_uart, &len);
+            TEST_ASSERT(len == n + MSG_FRAME_OVERHEAD);
+            TEST_ASSERT(memchr(wire, 0x00, len - 1) == NULL);
+            TEST_ASSERT(wire[len - 1] == 0x00);
+            TEST_ASSERT(test_expect_frame(wire, MSG_CHASSIS, MSG_DATA_FP32,
+                                          data, n) == len);
+            test_expect_received(&sent, 1);
+        }
+    }
+}
+
+/**
+ * @brief 帧中丢失一个字节时只丢失这一帧, 从下一个分隔符开始正常接收
+ */
+static void test_cobs_resync(void) {
+    static test_msg_t sent[16];
+    static uint8_t stream[16 * 32];
+
+    for (uint32_t n = 0; n < 100; ++n) {
+        size_t start[16];
+        size_t len = 0;
+        uint32_t lost = test_rand() % 16;
+
+        for (uint32_t i = 0; i < 16; ++i) {
+            start[i] = len;
+            len += test_random_frame(&sent[i], stream + len, (uint8_t)i);
+        }
+
+        /* 删除丢失帧中分隔符以外的一个字节 */
+        size_t frame_len =
+            ((lost == 15) ? len : start[lost + 1]) - start[lost];
+        size_t pos = start[lost] + test_rand() % (frame_len - 1);
+        memmove(stream + pos, stream + pos + 1, len - pos - 1);
+        --len;
+        memmove(&sent[lost], &sent[lost + 1],
+                (15 - lost) * sizeof(test_msg_t));
+
+        message_polling_stats_t before = test_polling_stats();
+        test_recv_num = 0;
+        test_inject_split(stream, len);
+        message_polling_stats_t after = test_polling_stats();
+
+        test_expect_received(sent, 15);
+        TEST_ASSERT(after.errors - before.errors == 1);
+    }
+}
+#endif /* MSG_FRAME_VERSION == 3 */
+
+/**
+ * @brief 每帧CRC的耗时, 查表与逐位计算对比
+ */
+static void test_crc16_bench(void) {
+    uint8_t body[MSG_MAX_DATA_LENGTH + 4];
+    static volatile uint16_t sink;
+
+    for (uint32_t i = 0; i < sizeof(body); ++i) {
+        body[i] = (uint8_t)test_rand();
+    }
+
+    uint64_t start = test_now_ns();
+    for (uint32_t i = 0; i < TEST_BENCH_FRAMES; ++i) {
+        body[0] = (uint8_t)i;
+        sink = crc16_calc(body, sizeof(body));
+    }
+    test_bench_print("crc16_calc (table)", test_now_ns() - start,
+                     TEST_BENCH_FRAMES, sizeof(body));
+
+    start = test_now_ns();
+    for (uint32_t i = 0; i < TEST_BENCH_FRAMES; ++i) {
+        body[0] = (uint8_t)i;
+        sink = test_crc16(body, sizeof(body));
+    }
+    test_bench_print("crc16 (bitwise)", test_now_ns() - start,
+                     TEST_BENCH_FRAMES, sizeof(body));
+    UNUSED(sink);
+}
+
+/**
+ * @brief 读取普通通道的发送统计
+ *
+ * @param priority 优先级
+ * @return 发送统计
+ */
+static message_tx_stats_t test_tx_stats(message_priority_t priority) {
+    message_tx_stats_t stats = {0};
+
+    message_get_tx_stats(&host_uart, priority, &stats);
+    return stats;
+}
+
+/**
+ * @brief 发送一帧, 线路上的字节与独立组出的帧逐字节相同
+ */
+static void test_send_frame(void) {
+    uint8_t data[MSG_MAX_DATA_LENGTH];
+    uint32_t len;
+
+    for (uint32_t i = 0; i < sizeof(data); ++i) {
+        /* 包含0x00与0xFF, 覆盖COBS与版本1帧尾 */
+        data[i] = (uint8_t)(i * 0x11);
+    }
+
+    for (size_t n = 1; n <= MSG_MAX_DATA_LENGTH; ++n) {
+        host_uart_wire_clear(&host_uart);
+        message_send_data(MSG_CHASSIS, MSG_DATA_UINT8, data, n);
+        host_flush();
+
+        const uint8_t *wire = host_uart_wire(&host_uart, &len);
+        TEST_ASSERT(len == n + MSG_FRAME_OVERHEAD);
+        TEST_ASSERT(test_expect_frame(wire, MSG_CHASSIS, MSG_DATA_UINT8, data,
+                                      n) == len);
+    }
+
+    /* 超长与空数据不发送 */
+    host_uart_wire_clear(&host_uart);
+    message_send_data(MSG_CHASSIS, MSG_DATA_UINT8, data,
+                      MSG_MAX_DATA_LENGTH + 1);
+    message_send_data(MSG_CHASSIS, MSG_DATA_UINT8, data, 0);
+    host_flush();
+    host_uart_wire(&host_uart, &len);
+    TEST_ASSERT(len == 0);
+}
+
+/**
+ * @brief 组帧在入队时完成, DMA从发送队列的槽位发送,
+ *        之后修改调用者的缓冲区不影响已入队的帧
+ */
+static void test_send_in_place(void) {
+    uint8_t data[4] = {1, 2, 3, 4};
+    const uint8_t expect[4] = {1, 2, 3, 4};
+    uint32_t len;
+
+    host_uart_wire_clear(&host_uart);
+    message_send_data(MSG_CHASSIS, MSG_DATA_UINT8, data, sizeof(data));
+
+    /* 入队后立即启动DMA, 发送的是槽位中组好的帧, 不是调用者的缓冲区 */
+    TEST_ASSERT(host_uart.gState == HAL_UART_STATE_BUSY_TX);
+    TEST_ASSERT(host_uart.TxXferSize == sizeof(data) + MSG_FRAME_OVERHEAD);
+    TEST_ASSERT((host_uart.pTxBuffPtr < data) ||
+                (host_uart.pTxBuffPtr >= data + sizeof(data)));
+
+    /* 排队中的帧也已经组好 */
+    message_send_data(MSG_CHASSIS, MSG_DATA_UINT8, data, sizeof(data));
+    memset(data, 0xEE, sizeof(data));
+    host_flush();
+
+    const uint8_t *wire = host_uart_wire(&host_uart, &len);
+    size_t first =
+        test_expect_frame(wire, MSG_CHASSIS, MSG_DATA_UINT8, expect, 4);
+    TEST_ASSERT(first != 0);
+    TEST_ASSERT(test_expect_frame(wire + first, MSG_CHASSIS, MSG_DATA_UINT8,
+                                  expect, 4) == len - first);
+}
+
+/**
+ * @brief 高优先级的帧在正在发送的帧之后立即发送, 排在普通帧之前
+ */
+static void test_send_priority(void) {
+    uint8_t normal[3][2] = {{0x10, 0}, {0x11, 0}, {0x12, 0}};
+    uint8_t high[2] = {0x20, 0};
+    uint32_t len;
+
+    host_uart_wire_clear(&host_uart);
+    for (uint32_t i = 0; i < 3; ++i) {
+        message_send_data(MSG_CHASSIS, MSG_DATA_UINT8, normal[i], 2);
+    }
+    message_send_data_priority(MSG_PRIORITY_HIGH, MSG_CHASSIS, MSG_DATA_UINT8,
+                               high, 2);
+    host_flush();
+
+    const uint8_t *wire = host_uart_wire(&host_uart, &len);
+    const uint8_t *order[4] = {normal[0], high, normal[1], normal[2]};
+    size_t pos = 0;
+
+    TEST_ASSERT(len == 4 * (2 + MSG_FRAME_OVERHEAD));
+    for (uint32_t i = 0; (i < 4) && (pos < len); ++i) {
+        size_t frame_len = test_expect_frame(wire + pos, MSG_CHASSIS,
+                                             MSG_DATA_UINT8, order[i], 2);
+        TEST_ASSERT(frame_len != 0);
+        pos += frame_len;
+    }
+}
+
+/**
+ * @brief 通道满时丢弃新帧并计数, 从不等待
+ */
+static void test_send_lane_full(void) {
+    uint8_t data[2] = {0x55, 0xAA};
+    message_tx_stats_t before = test_tx_stats(MSG_PRIORITY_NORMAL);
+    uint32_t len;
+
+    host_uart_wire_clear(&host_uart);
+    /* 正在发送的帧占用槽位直到发送完成, 所以最多入队`MSG_TX_QUEUE_DEPTH`帧 */
+    for (uint32_t i = 0; i < MSG_TX_QUEUE_DEPTH + 3; ++i) {
+        message_send_data(MSG_CHASSIS, MSG_DATA_UINT8, data, 2);
+    }
+    message_tx_stats_t full = test_tx_stats(MSG_PRIORITY_NORMAL);
+    host_flush();
+    message_tx_stats_t after = test_tx_stats(MSG_PRIORITY_NORMAL);
+
+    host_uart_wire(&host_uart, &len);
+    TEST_ASSERT(full.depth == MSG_TX_QUEUE_DEPTH);
+    TEST_ASSERT(after.dropped - before.dropped == 3);
+    TEST_ASSERT(after.sent - before.sent == MSG_TX_QUEUE_DEPTH);
+    TEST_ASSERT(after.depth == 0);
+    TEST_ASSERT(len == MSG_TX_QUEUE_DEPTH * (2 + MSG_FRAME_OVERHEAD));
+}
+
+/**
+ * @brief 发送DMA出错时丢弃正在发送的帧并计数, 释放发送权后接着发送排队的帧
+ */
+static void test_send_dma_error(void) {
+    uint8_t data[3][2] = {{0x30, 0}, {0x31, 0}, {0x32, 0}};
+    message_tx_stats_t before = test_tx_stats(MSG_PRIORITY_NORMAL);
+    uint32_t len;
+
+    host_uart_wire_clear(&host_uart);
+    for (uint32_t i = 0; i < 3; ++i) {
+        message_send_data(MSG_CHASSIS, MSG_DATA_UINT8, data[i], 2);
+    }
+    const uint8_t *failed = host_uart.pTxBuffPtr;
+
+    /* 第一帧出错, 错误中断中立即启动第二帧 */
+    TEST_ASSERT(host_uart_tx_error(&host_uart));
+    TEST_ASSERT(host_uart.gState == HAL_UART_STATE_BUSY_TX);
+    TEST_ASSERT(host_uart.pTxBuffPtr != failed);
+    host_flush();
+
+    message_tx_stats_t after = test_tx_stats(MSG_PRIORITY_NORMAL);
+    const uint8_t *wire = host_uart_wire(&host_uart, &len);
+    TEST_ASSERT(after.failed - before.failed == 1);
+    TEST_ASSERT(after.sent - before.sent == 3);
+    TEST_ASSERT(after.depth == 0);
+    TEST_ASSERT(len == 2 * (2 + MSG_FRAME_OVERHEAD));
+    TEST_ASSERT(test_expect_frame(wire, MSG_CHASSIS, MSG_DATA_UINT8, data[1],
+                                  2) != 0);
+
+    /* 最后一帧也出错时队列为空, 之后的帧照常发送 */
+    message_send_data(MSG_CHASSIS, MSG_DATA_UINT8, data[2], 2);
+    TEST_ASSERT(host_uart_tx_error(&host_uart));
+    TEST_ASSERT(host_uart.gState == HAL_UART_STATE_READY);
+    host_uart_wire_clear(&host_uart);
+    message_send_data(MSG_CHASSIS, MSG_DATA_UINT8, data[0], 2);
+    host_flush();
+    wire = host_uart_wire(&host_uart, &len);
+    TEST_ASSERT(test_expect_frame(wire, MSG_CHASSIS, MSG_DATA_UINT8, data[0],
+                                  2) == len);
+    TEST_ASSERT(test_tx_stats(MSG_PRIORITY_NORMAL).failed - before.failed ==
+                2);
+}
+
+/**
+ * @brief 原来的发送方式: 申请内存组帧, 经驱动的双缓冲区发送后释放
+ *
+ * @param data 数据
+ * @param data_len 数据长度
+ * @note 帧格式与`message_send_data`相同(版本2以上同样查表计算CRC),
+ *       只是组在申请的内存中, 再由`uart_dmatx_write`复制到发送缓冲区
+ */
+static void test_send_malloc(const void *data, size_t data_len) {
+    uint8_t *frame = malloc(data_len + MSG_FRAME_OVERHEAD);
+    uint8_t *head = frame;
+
+#if (MSG_FRAME_VERSION == 2)
+    *head++ = MSG_FRAME_SYNC_0;
+    *head++ = MSG_FRAME_SYNC_1;
+#elif (MSG_FRAME_VERSION == 3)
+    ++head; /* 留给COBS编码字节 */
+#endif /* MSG_FRAME_VERSION == 2 */
+#if (MSG_FRAME_VERSION >= 2)
+    static uint8_t seq;
+    *head++ = (uint8_t)(MSG_FRAME_VERSION << 4);
+    *head++ = seq++;
+#endif /* MSG_FRAME_VERSION >= 2 */
+
+    head[0] = (uint8_t)(MSG_CHASSIS << 4) | MSG_DATA_UINT8;
+    head[1] = (uint8_t)data_len;
+    memcpy(head + 2, data, data_len);
+
+#if (MSG_FRAME_VERSION >= 2)
+    uint16_t crc = crc16_calc(head - 2, data_len + 4);
+    head[data_len + 2] = (uint8_t)(crc >> 8);
+    head[data_len + 3] = (uint8_t)crc;
+#else  /* MSG_FRAME_VERSION >= 2 */
+    head[data_len + 2] = 0xFF;
+#endif /* MSG_FRAME_VERSION >= 2 */
+
+#if (MSG_FRAME_VERSION == 3)
+    /* 原地COBS编码, 数据短于254字节, 不需要插入编码字节 */
+    uint8_t *code = frame;
+    uint8_t distance = 1;
+    for (size_t i = 1; i <= data_len + 6; ++i) {
+        if (frame[i] == 0x00) {
+            *code = distance;
+            code = &frame[i];
+            distance = 1;
+        } else {
+            ++distance;
+        }
+    }
+    *code = distance;
+    frame[data_len + 7] = 0x00;
+#endif /* MSG_FRAME_VERSION == 3 */
+
+    uart_dmatx_write(&host_uart, frame, data_len + MSG_FRAME_OVERHEAD);
+    uart_dmatx_send(&host_uart);
+    free(frame);
+}
+
+/**
+ * @brief 模拟发送完成中断, 相当于板上等待TC后进入中断
+ */
+static void test_send_complete(void) {
+    host_uart.gState = HAL_UART_STATE_READY;
+    uart_dmatx_cplt_callback(&host_uart);
+}
+
+/**
+ * @brief 发送路径的耗时, 与原来申请内存的方式对比
+ * @note 两种方式组同一版本的帧, 每帧之后都模拟一次发送完成, 不含串口
+ *       传输时间. 主机的malloc远快于板上的heap_4, 且耗时稳定, 对比结果
+ *       只作参考, 板上的周期数用`util_bench`测量
+ */
+static void test_send_bench(void) {
+    uint8_t data[MSG_MAX_DATA_LENGTH] = {0};
+    const uint8_t *wire;
+    uint32_t len;
+
+    /* 原来的方式组出的帧与协议实现相同 */
+    host_uart_wire_clear(&host_uart);
+    test_send_malloc(data, sizeof(data));
+    host_flush();
+    wire = host_uart_wire(&host_uart, &len);
+    TEST_ASSERT(test_expect_frame(wire, MSG_CHASSIS, MSG_DATA_UINT8, data,
+                                  sizeof(data)) == len);
+
+    uint64_t start = test_now_ns();
+    for (uint32_t i = 0; i < TEST_BENCH_FRAMES; ++i) {
+        data[0] = (uint8_t)i;
+        message_send_data(MSG_CHASSIS, MSG_DATA_UINT8, data, sizeof(data));
+        test_send_complete();
+    }
+    test_bench_print("message_send_data", test_now_ns() - start,
+                     TEST_BENCH_FRAMES, sizeof(data));
+
+    start = test_now_ns();
+    for (uint32_t i = 0; i < TEST_BENCH_FRAMES; ++i) {
+        data[0] = (uint8_t)i;
+        test_send_malloc(data, sizeof(data));
+        test_send_complete();
+    }
+    test_bench_print("malloc + uart_dmatx (old)", test_now_ns() - start,
+                     TEST_BENCH_FRAMES, sizeof(data));
+
+    host_flush();
+}
+
+/**
+ * @brief 记录重组完成的分片传输
+ *
+ * @param msg_length 总长度
+ * @param msg_type 数据类型
+ * @param msg_data 数据
+ */
+static void test_large_callback(uint16_t msg_length, message_type_t msg_type,
+                                void *msg_data) {
+    UNUSED(msg_type);
+
+    ++test_large_num;
+    test_large_len = msg_length;
+    memcpy(test_large, msg_data, msg_length);
+}
+
+/**
+ * @brief 分片传输的一帧在线路上的长度
+ *
+ * @param data_len 整个传输的长度
+ * @param index 分片序号
+ * @return 帧长度
+ */
+static size_t test_fragment_frame_len(size_t data_len, uint32_t index) {
+    size_t left = data_len - index * MSG_FRAGMENT_DATA_LENGTH;
+    size_t len = (left > MSG_FRAGMENT_DATA_LENGTH) ? MSG_FRAGMENT_DATA_LENGTH
+                                                   : left;
+
+    return len + MSG_FRAGMENT_HEAD_SIZE + MSG_FRAME_OVERHEAD;
+}
+
+/**
+ * @brief 各种长度的传输拆成分片后重组, 内容不变;
+ *        不超过`MSG_MAX_DATA_LENGTH`时按普通帧发送
+ */
+static void test_fragment_roundtrip(void) {
+    static uint8_t data[MSG_MAX_FRAGMENT_LENGTH];
+    uint32_t len;
+
+    for (uint32_t i = 0; i < sizeof(data); ++i) {
+        data[i] = (uint8_t)test_rand();
+    }
+
+    for (size_t n = 1; n <= MSG_MAX_FRAGMENT_LENGTH; ++n) {
+        uint32_t count = (n <= MSG_MAX_DATA_LENGTH)
+                             ? 1
+                             : (n + MSG_FRAGMENT_DATA_LENGTH - 1) /
+                                   MSG_FRAGMENT_DATA_LENGTH;
+
+        test_recv_num = 0;
+        test_large_num = 0;
+        host_uart_wire_clear(&host_uart);
+        TEST_ASSERT(message_send_large_data(MSG_CHASSIS, MSG_DATA_UINT8, data,
+                                            n) == MSG_FRAGMENT_OK);
+        host_flush();
+        host_uart_wire(&host_uart, &len);
+
+        if (n <= MSG_MAX_DATA_LENGTH) {
+            /* 普通帧, 没有额外开销 */
+            TEST_ASSERT(len == n + MSG_FRAME_OVERHEAD);
+            TEST_ASSERT((test_recv_num == 1) && (test_large_num == 0) &&
+                        (test_recv[0].len == n) &&
+                        (memcmp(test_recv[0].data, data, n) == 0));
+            continue;
+        }
+
+        size_t expect = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            expect += test_fragment_frame_len(n, i);
+        }
+        TEST_ASSERT(len == expect);
+        TEST_ASSERT((test_large_num == 1) && (test_recv_num == 0));
+        TEST_ASSERT((test_large_len == n) &&
+                    (memcmp(test_large, data, n) == 0));
+    }
+}
+
+/**
+ * @brief 参数错误与通道放不下全部分片时不发送任何分片
+ */
+static void test_fragment_busy(void) {
+    static uint8_t data[MSG_MAX_FRAGMENT_LENGTH + 1];
+    uint32_t count = (MSG_MAX_FRAGMENT_LENGTH + MSG_FRAGMENT_DATA_LENGTH - 1) /
+                     MSG_FRAGMENT_DATA_LENGTH;
+    uint32_t len;
+
+    TEST_ASSERT(message_send_large_data(MSG_CHASSIS, MSG_DATA_UINT8, data,
+                                        sizeof(data)) == MSG_FRAGMENT_ERROR);
+    TEST_ASSERT(message_send_large_data(MSG_CHASSIS, MSG_DATA_UINT8, NULL,
+                                        10) == MSG_FRAGMENT_ERROR);
+    /* 没有注册发送串口 */
+    TEST_ASSERT(message_send_large_data(MSG_REMOTE, MSG_DATA_UINT8, data,
+                                        100) == MSG_FRAGMENT_ERROR);
+
+    /* 第一次传输占用`count`个槽位, 剩余的放不下第二次 */
+    TEST_ASSERT(count * 2 > MSG_TX_QUEUE_DEPTH);
+    test_large_num = 0;
+    host_uart_wire_clear(&host_uart);
+    TEST_ASSERT(message_send_large_data(MSG_CHASSIS, MSG_DATA_UINT8, data,
+                                        MSG_MAX_FRAGMENT_LENGTH) ==
+                MSG_FRAGMENT_OK);
+    TEST_ASSERT(message_send_large_data(MSG_CHASSIS, MSG_DATA_UINT8, data,
+                                        MSG_MAX_FRAGMENT_LENGTH) ==
+                MSG_FRAGMENT_BUSY);
+    host_flush();
+
+    size_t expect = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        expect += test_fragment_frame_len(MSG_MAX_FRAGMENT_LENGTH, i);
+    }
+    host_uart_wire(&host_uart, &len);
+    TEST_ASSERT(len == expect);
+    TEST_ASSERT(test_large_num == 1);
+
+    /* 发送完成后可以重试 */
+    TEST_ASSERT(message_send_large_data(MSG_CHASSIS, MSG_DATA_UINT8, data,
+                                        MSG_MAX_FRAGMENT_LENGTH) ==
+                MSG_FRAGMENT_OK);
+    host_flush();
+    TEST_ASSERT(test_large_num == 2);
+}
+
+/**
+ * @brief 丢失一个分片时丢弃整个传输, 下一次传输正常重组
+ */
+static void test_fragment_loss(void) {
+    static uint8_t data[200];
+    static uint8_t wire[1024];
+    uint32_t count = (sizeof(data) + MSG_FRAGMENT_DATA_LENGTH - 1) /
+                     MSG_FRAGMENT_DATA_LENGTH;
+    uint32_t len;
+
+    for (uint32_t i = 0; i < sizeof(data); ++i) {
+        data[i] = (uint8_t)test_rand();
+    }
+
+    for (uint32_t lost = 0; lost < count; ++lost) {
+        /* 不环回, 取出两次传输的字节后去掉第一次的一个分片再注入 */
+        host_uart_set_loopback(&host_uart, false);
+        host_uart_wire_clear(&host_uart);
+        message_send_large_data(MSG_CHASSIS, MSG_DATA_UINT8, data,
+                                sizeof(data));
+        host_flush();
+        data[0] ^= 0xFF;
+        message_send_large_data(MSG_CHASSIS, MSG_DATA_UINT8, data,
+                                sizeof(data));
+        host_flush();
+        host_uart_set_loopback(&host_uart, true);
+
+        const uint8_t *sent = host_uart_wire(&host_uart, &len);
+        size_t pos = 0;
+        for (uint32_t i = 0; i < lost; ++i) {
+            pos += test_fragment_frame_len(sizeof(data), i);
+        }
+        size_t skip = test_fragment_frame_len(sizeof(data), lost);
+        memcpy(wire, sent, pos);
+        memcpy(wire + pos, sent + pos + skip, len - pos - skip);
+
+        test_large_num = 0;
+        host_uart_inject(&host_uart, wire, len - skip);
+        host_flush();
+
+        /* 只收到第二次传输 */
+        TEST_ASSERT(test_large_num == 1);
+        TEST_ASSERT((test_large_len == sizeof(data)) &&
+                    (memcmp(test_large, data, sizeof(data)) == 0));
+    }
+}
+
+#if (MSG_RELIABLE_ENABLE == 1)
+
+#define TEST_RELIABLE_MSGS 1000 /* 有损链路测试的消息数 */
+
+static uint32_t test_reliable_next;     /* 期望收到的下一条消息 */
+static uint32_t test_reliable_disorder; /* 乱序或重复的消息数 */
+static uint32_t test_reliable_sent_at[TEST_RELIABLE_MSGS];
+static uint32_t test_reliable_delay_max; /* 发送到收到的最长时间 */
+
+/**
+ * @brief 检查可靠传输收到的消息按顺序且不重复
+ *
+ * @param msg_length 消息长度
+ * @param msg_type 数据类型
+ * @param msg_data 数据, 前4字节为消息编号
+ */
+static void test_reliable_callback(uint8_t msg_length, message_type_t msg_type,
+                                   void *msg_data) {
+    uint32_t id;
+
+    UNUSED(msg_type);
+    if (msg_length < sizeof(id)) {
+        ++test_reliable_disorder;
+        return;
+    }
+
+    memcpy(&id, msg_data, sizeof(id));
+    if (id != test_reliable_next) {
+        ++test_reliable_disorder;
+        return;
+    }
+
+    if (id < TEST_RELIABLE_MSGS) {
+        uint32_t delay = HAL_GetTick() - test_reliable_sent_at[id];
+        if (delay > test_reliable_delay_max) {
+            test_reliable_delay_max = delay;
+        }
+    }
+    ++test_reliable_next;
+}
+
+/**
+ * @brief 读取可靠传输统计
+ *
+ * @return 可靠传输统计
+ */
+static message_reliable_stats_t test_reliable_stats(void) {
+    message_reliable_stats_t stats = {0};
+
+    message_get_reliable_stats(MSG_CHASSIS, &stats);
+    return stats;
+}
+
+/**
+ * @brief 可靠发送编号从`first`开始的`num`条消息, 窗口满时推进时间
+ *
+ * @param first 第一条消息的编号
+ * @param num 条数
+ */
+static void test_reliable_send(uint32_t first, uint32_t num) {
+    uint8_t data[MSG_MAX_RELIABLE_LENGTH];
+
+    for (uint32_t id = first; id < first + num;) {
+        memcpy(data, &id, sizeof(id));
+        for (uint32_t i = sizeof(id); i < sizeof(data); ++i) {
+            data[i] = (uint8_t)(id + i);
+        }
+
+        uint8_t res = message_send_reliable(MSG_PRIORITY_NORMAL, MSG_CHASSIS,
+                                            MSG_DATA_UINT8, data,
+                                            sizeof(data));
+        if (res == MSG_RELIABLE_OK) {
+            if (id < TEST_RELIABLE_MSGS) {
+                test_reliable_sent_at[id] = HAL_GetTick();
+            }
+            ++id;
+            host_flush();
+        } else {
+            TEST_ASSERT(res == MSG_RELIABLE_FULL);
+            host_advance(1);
+        }
+    }
+}
+
+/**
+ * @brief 等待发送窗口清空
+ *
+ * @param timeout 最长等待时间(ms)
+ * @return 是否清空
+ */
+static bool test_reliable_drain(uint32_t timeout) {
+    while (timeout-- != 0) {
+        if (test_reliable_stats().in_flight == 0) {
+            return true;
+        }
+        host_advance(1);
+    }
+
+    return (test_reliable_stats().in_flight == 0);
+}
+
+/**
+ * @brief 数据帧与确认帧都会丢失的链路上, 消息按顺序到达且不重复,
+ *        输出有效吞吐与最长恢复时间
+ */
+static void test_reliable_lossy(void) {
+    message_reliable_stats_t before = test_reliable_stats();
+
+    test_reliable_next = 0;
+    test_reliable_disorder = 0;
+    test_reliable_delay_max = 0;
+
+    /* 每次发送丢失的概率为20% */
+    host_uart_set_loss(&host_uart, 200);
+    uint32_t start = HAL_GetTick();
+    test_reliable_send(0, TEST_RELIABLE_MSGS);
+    TEST_ASSERT(test_reliable_drain(1000));
+    uint32_t elapsed = HAL_GetTick() - start;
+    uint32_t lost = host_uart_set_loss(&host_uart, 0);
+
+    message_reliable_stats_t after = test_reliable_stats();
+    TEST_ASSERT(lost != 0);
+    TEST_ASSERT(test_reliable_next == TEST_RELIABLE_MSGS);
+    TEST_ASSERT(test_reliable_disorder == 0);
+    TEST_ASSERT(after.sent - before.sent == TEST_RELIABLE_MSGS);
+    TEST_ASSERT(after.acked - before.acked == TEST_RELIABLE_MSGS);
+    TEST_ASSERT(after.retransmits != before.retransmits);
+    TEST_ASSERT(after.failed == before.failed);
+
+    /* 串口传输时间不计, 时间只由重传超时与窗口决定 */
+    printf("  reliable, 20%% loss: %lu msgs in %lu ms (%lu B/s), "
+           "%lu retransmits, %lu duplicates, max delay %lu ms\n",
+           (unsigned long)TEST_RELIABLE_MSGS, (unsigned long)elapsed,
+           (unsigned long)((uint64_t)TEST_RELIABLE_MSGS *
+                           MSG_MAX_RELIABLE_LENGTH * 1000U / elapsed),
+           (unsigned long)(after.retransmits - before.retransmits),
+           (unsigned long)(after.duplicates - before.duplicates),
+           (unsigned long)test_reliable_delay_max);
+}
+
+/**
+ * @brief 链路中断时超过重传次数放弃窗口内的帧, 恢复后重新同步
+ */
+static void test_reliable_outage(void) {
+    message_reliable_stats_t before = test_reliable_stats();
+
+    test_reliable_next = 0;
+    test_reliable_disorder = 0;
+
+    host_uart_set_loss(&host_uart, 1000);
+    test_reliable_send(TEST_RELIABLE_MSGS, MSG_RELIABLE_WINDOW);
+    TEST_ASSERT(test_reliable_drain((MSG_RELIABLE_MAX_RETRY + 2) *
+                                    MSG_RELIABLE_TIMEOUT_MS));
+    host_uart_set_loss(&host_uart, 0);
+
+    message_reliable_stats_t after = test_reliable_stats();
+    TEST_ASSERT(after.failed - before.failed == MSG_RELIABLE_WINDOW);
+    TEST_ASSERT(test_reliable_next == 0);
+
+    /* 下一条消息作为同步帧, 接收方从它开始接收 */
+    test_reliable_next = TEST_RELIABLE_MSGS + MSG_RELIABLE_WINDOW;
+    test_reliable_send(test_reliable_next, 10);
+    TEST_ASSERT(test_reliable_drain(100));
+    TEST_ASSERT(test_reliable_next == TEST_RELIABLE_MSGS +
+                                          MSG_RELIABLE_WINDOW + 10);
+    TEST_ASSERT(test_reliable_disorder == 0);
+}
+
+/**
+ * @brief 超过`MSG_MAX_RELIABLE_LENGTH`的消息发送方拒绝, 接收方也丢弃
+ */
+static void test_reliable_limit(void) {
+    uint8_t data[MSG_MAX_RELIABLE_LENGTH + 3] = {0};
+    uint8_t frame[64];
+
+    TEST_ASSERT(message_send_reliable(MSG_PRIORITY_NORMAL, MSG_CHASSIS,
+                                      MSG_DATA_UINT8, data,
+                                      MSG_MAX_RELIABLE_LENGTH + 1) ==
+                MSG_RELIABLE_ERROR);
+
+    /* 同步帧, | 含义/类型 | 序号 | 数据 |, 数据比上限多一个字节 */
+    data[0] = (uint8_t)(MSG_CHASSIS << 4) | MSG_DATA_UINT8;
+    data[1] = 0x80;
+    size_t len = test_build_frame(frame, MSG_RELIABLE_MEAN, 0x01, 0, data,
+                                  sizeof(data));
+
+    test_reliable_next = 0;
+    test_reliable_disorder = 0;
+    host_uart_inject(&host_uart, frame, len);
+    host_flush();
+    TEST_ASSERT((test_reliable_next == 0) && (test_reliable_disorder == 0));
+}
+
+#endif /* MSG_RELIABLE_ENABLE == 1 */
+
+/**
+ * @brief 记录遥控器含义收到的消息条数与最后一条的长度
+ */
+static uint32_t test_remote_num;
+static uint8_t test_remote_len;
+
+/**
+ * @brief 遥控器含义的回调, 与底盘含义的回调分开计数
+ *
+ * @param msg_length 消息长度
+ * @param msg_type 数据类型
+ * @param msg_data 数据
+ */
+static void test_remote_callback(uint8_t msg_length, message_type_t msg_type,
+                                 void *msg_data) {
+    UNUSED(msg_type);
+    UNUSED(msg_data);
+
+    ++test_remote_num;
+    test_remote_len = msg_length;
+}
+
+/**
+ * @brief 打包帧中的消息分别交给各自含义的回调, 空间恰好用完时仍能添加,
+ *        再多一个字节返回`MSG_BATCH_FULL`
+ */
+static void test_batch_roundtrip(void) {
+    uint8_t data[MSG_MAX_DATA_LENGTH];
+    message_batch_t batch;
+    test_msg_t sent[4];
+    uint32_t len;
+
+    for (uint32_t i = 0; i < sizeof(data); ++i) {
+        data[i] = (uint8_t)(0xA0 + i);
+    }
+
+    /* 3条满长度的消息后剩余`MSG_MAX_BATCH_LENGTH - 3 * (MAX + 2)`字节 */
+    size_t rest = MSG_MAX_BATCH_LENGTH - 3 * (MSG_MAX_DATA_LENGTH + 2) - 2;
+
+    message_batch_init(&batch);
+    for (uint32_t i = 0; i < 3; ++i) {
+        sent[i].len = MSG_MAX_DATA_LENGTH;
+        sent[i].type = (uint8_t)i;
+        memcpy(sent[i].data, data, MSG_MAX_DATA_LENGTH);
+        sent[i].data[0] = (uint8_t)i;
+        TEST_ASSERT(message_batch_add(&batch, MSG_CHASSIS, sent[i].type,
+                                      sent[i].data, sent[i].len) ==
+                    MSG_BATCH_OK);
+    }
+    TEST_ASSERT(message_batch_add(&batch, MSG_REMOTE, MSG_DATA_UINT8, data,
+                                  rest + 1) == MSG_BATCH_FULL);
+    TEST_ASSERT(message_batch_add(&batch, MSG_REMOTE, MSG_DATA_UINT8, data,
+                                  rest) == MSG_BATCH_OK);
+    TEST_ASSERT(batch.length == MSG_MAX_BATCH_LENGTH);
+    TEST_ASSERT(message_batch_add(&batch, MSG_CHASSIS, MSG_DATA_UINT8, data,
+                                  1) == MSG_BATCH_FULL);
+
+    test_recv_num = 0;
+    test_remote_num = 0;
+    host_uart_wire_clear(&host_uart);
+    message_batch_send(&batch);
+    TEST_ASSERT(batch.length == 0);
+    host_flush();
+
+    /* 整个打包帧只占一帧 */
+    host_uart_wire(&host_uart, &len);
+    TEST_ASSERT(len == MSG_MAX_BATCH_LENGTH + MSG_FRAME_OVERHEAD);
+    test_expect_received(sent, 3);
+    TEST_ASSERT((test_remote_num == 1) && (test_remote_len == rest));
+}
+
+/**
+ * @brief 发送串口与打包帧不同的含义, 未注册发送串口的含义,
+ *        以及空或超长的消息返回`MSG_BATCH_ERROR`, 不改变打包帧
+ */
+static void test_batch_error(void) {
+    uint8_t data[MSG_MAX_DATA_LENGTH + 1] = {0};
+    message_batch_t batch;
+
+    message_batch_init(&batch);
+    TEST_ASSERT(message_batch_add(&batch, MSG_CHASSIS, MSG_DATA_UINT8, data,
+                                  0) == MSG_BATCH_ERROR);
+    TEST_ASSERT(message_batch_add(&batch, MSG_CHASSIS, MSG_DATA_UINT8, data,
+                                  MSG_MAX_DATA_LENGTH + 1) == MSG_BATCH_ERROR);
+    TEST_ASSERT(message_batch_add(&batch, MSG_LINK_STATS, MSG_DATA_UINT8, data,
+                                  1) == MSG_BATCH_ERROR);
+    TEST_ASSERT(batch.length == 0);
+
+    /* 第一条消息决定发送串口 */
+    message_register_send_handle(MSG_REMOTE, &host_peer);
+    TEST_ASSERT(message_batch_add(&batch, MSG_CHASSIS, MSG_DATA_UINT8, data,
+                                  2) == MSG_BATCH_OK);
+    TEST_ASSERT(message_batch_add(&batch, MSG_REMOTE, MSG_DATA_UINT8, data,
+                                  2) == MSG_BATCH_ERROR);
+    TEST_ASSERT(batch.length == 4);
+    TEST_ASSERT(batch.send_handle == &host_uart);
+    message_register_send_handle(MSG_REMOTE, &host_uart);
+}
+
+/**
+ * @brief 打包帧中出现异常的消息时, 之前的消息正常分发, 从它开始的剩余部分丢弃
+ */
+static void test_batch_malformed(void) {
+    /* 每种异常放在一条正常消息之后: 保留的含义, 长度为0,
+     * 长度超过上限, 长度超出打包帧 */
+    static const uint8_t bad[4][2] = {
+        {(uint8_t)(MSG_MEAN_LENGTH_RESERVE << 4), 1},
+        {(uint8_t)(MSG_CHASSIS << 4), 0},
+        {(uint8_t)(MSG_CHASSIS << 4), MSG_MAX_DATA_LENGTH + 1},
+        {(uint8_t)(MSG_CHASSIS << 4), 3},
+    };
+    test_msg_t sent = {.len = 2, .type = MSG_DATA_UINT16, .data = {0x34, 0x12}};
+    uint8_t payload[8];
+    uint8_t frame[64];
+
+    for (uint32_t i = 0; i < 4; ++i) {
+        payload[0] = (uint8_t)(MSG_CHASSIS << 4) | MSG_DATA_UINT16;
+        payload[1] = 2;
+        payload[2] = 0x34;
+        payload[3] = 0x12;
+        payload[4] = bad[i][0];
+        payload[5] = bad[i][1];
+        payload[6] = 0x55;
+        payload[7] = 0x55;
+        size_t len = test_build_frame(frame, MSG_BATCH_MEAN, MSG_DATA_UINT8,
+                                      (uint8_t)i, payload, sizeof(payload));
+
+        test_recv_num = 0;
+        host_uart_inject(&host_uart, frame, len);
+        host_flush();
+        test_expect_received(&sent, 1);
+    }
+}
+
+/**
+ * @brief 一个串口持续收到大量数据时, 每次轮询只读取`MSG_POLLING_BUDGET`字节,
+ *        另一个串口的帧在同一次轮询中收到. 恰好读完预算时不再报告有数据
+ */
+static void test_polling_fair(void) {
+    static uint8_t flood[2048];
+    test_msg_t msg;
+    uint8_t frame[64];
+    message_polling_stats_t flood_before = test_polling_stats();
+    message_polling_stats_t peer_before = {0};
+    message_polling_stats_t flood_after = {0};
+    message_polling_stats_t peer_after = {0};
+    size_t len = 0;
+    uint32_t frames = 0;
+
+    message_get_polling_stats(&host_peer, &peer_before);
+    while (len + MSG_MAX_DATA_LENGTH + MSG_FRAME_OVERHEAD <= sizeof(flood)) {
+        len += test_random_frame(&msg, flood + len, (uint8_t)frames);
+        ++frames;
+    }
+    size_t peer_len = test_build_frame(frame, MSG_REMOTE, MSG_DATA_UINT8, 0,
+                                       "peer", 4);
+
+    test_recv_num = 0;
+    test_remote_num = 0;
+    host_uart_inject(&host_uart, flood, len);
+    host_uart_inject(&host_peer, frame, peer_len);
+
+    /* 第一次轮询: 泛洪的串口只读一份预算, 另一个串口的帧不用等它读完 */
+    TEST_ASSERT(message_polling_data());
+    message_get_polling_stats(&host_uart, &flood_after);
+    message_get_polling_stats(&host_peer, &peer_after);
+    TEST_ASSERT(flood_after.bytes - flood_before.bytes == MSG_POLLING_BUDGET);
+    TEST_ASSERT(peer_after.bytes - peer_before.bytes == peer_len);
+    TEST_ASSERT(peer_after.frames - peer_before.frames == 1);
+    TEST_ASSERT((test_remote_num == 1) && (test_remote_len == 4));
+
+    /* 最后一次轮询读到FIFO为空, 返回`false` */
+    uint32_t calls = 1;
+    do {
+        ++calls;
+    } while (message_polling_data());
+    message_get_polling_stats(&host_uart, &flood_after);
+    TEST_ASSERT(calls == (len - 1) / MSG_POLLING_BUDGET + 1);
+    TEST_ASSERT(flood_after.bytes - flood_before.bytes == len);
+    TEST_ASSERT(flood_after.frames - flood_before.frames == frames);
+    TEST_ASSERT(test_recv_num == frames);
+    TEST_ASSERT(test_remote_num == 1);
+
+    /* 恰好是预算长度的几帧一次读完, 不需要再轮询 */
+    memset(msg.data, 0x00, sizeof(msg.data));
+    len = 0;
+    frames = 0;
+    while (len < MSG_POLLING_BUDGET) {
+        size_t left = MSG_POLLING_BUDGET - len - MSG_FRAME_OVERHEAD;
+        size_t n = left;
+        if (n > MSG_MAX_DATA_LENGTH) {
+            /* 给最后一帧留下至少1字节的数据 */
+            n = (left - MSG_MAX_DATA_LENGTH < MSG_FRAME_OVERHEAD + 1)
+                    ? left - MSG_FRAME_OVERHEAD - 1
+                    : MSG_MAX_DATA_LENGTH;
+        }
+        len += test_build_frame(flood + len, MSG_CHASSIS, MSG_DATA_UINT8,
+                                (uint8_t)frames, msg.data, n);
+        ++frames;
+    }
+    TEST_ASSERT(len == MSG_POLLING_BUDGET);
+
+    test_recv_num = 0;
+    host_uart_inject(&host_uart, flood, MSG_POLLING_BUDGET);
+    TEST_ASSERT(!message_polling_data());
+    message_get_polling_stats(&host_uart, &flood_before);
+    TEST_ASSERT(flood_before.bytes - flood_after.bytes == MSG_POLLING_BUDGET);
+    TEST_ASSERT(test_recv_num == frames);
+}
+
+/**
+ * @brief 把一帧注入`host_uart`, 检查`host_peer`发出的字节
+ *
+ * @param frame 帧
+ * @param len 帧长度
+ * @param routed 是否应当被转发
+ * @return `host_peer`发出的字节与期望相同时返回`true`
+ */
+static bool test_route_inject(const uint8_t *frame, size_t len, bool routed) {
+    uint32_t wire_len;
+
+    host_uart_wire_clear(&host_peer);
+    host_uart_inject(&host_uart, frame, len);
+    host_flush();
+
+    const uint8_t *wire = host_uart_wire(&host_peer, &wire_len);
+    if (!routed) {
+        return (wire_len == 0);
+    }
+    return (wire_len == len) && (memcmp(wire, frame, len) == 0);
+}
+
+/**
+ * @brief 转发的帧在目的串口上与收到的字节完全相同(含序号与CRC),
+ *        没有转发的含义交给本机的回调. 分片帧与可靠传输帧按数据区中
+ *        原消息的含义转发. 目的串口有没有发送队列都要覆盖
+ */
+static void test_route(void) {
+    uint8_t data[MSG_MAX_DATA_LENGTH];
+    uint8_t payload[MSG_FRAGMENT_HEAD_SIZE + 8];
+    uint8_t frame[64];
+    void *hdmatx = host_peer.hdmatx;
+    uint32_t wire_len;
+    size_t len;
+
+    for (uint32_t i = 0; i < sizeof(data); ++i) {
+        /* 包含0x00, 转发时COBS要编码出相同的字节. 版本1的数据中不能有0xFF */
+        data[i] = (uint8_t)(i * 0x10);
+    }
+
+    host_uart_set_loopback(&host_peer, false);
+    TEST_ASSERT(message_add_route(&host_uart, MSG_REMOTE, &host_peer,
+                                  MSG_PRIORITY_NORMAL));
+    TEST_ASSERT(!message_add_route(&host_uart, MSG_REMOTE, &host_uart,
+                                   MSG_PRIORITY_NORMAL));
+
+    for (uint32_t dma = 0; dma < 2; ++dma) {
+        host_peer.hdmatx = (dma != 0) ? hdmatx : NULL;
+
+        /* 转发的含义, 本机的回调不被调用 */
+        test_remote_num = 0;
+        len = test_build_frame(frame, MSG_REMOTE, MSG_DATA_UINT8, 0xA5, data,
+                               sizeof(data));
+        TEST_ASSERT(test_route_inject(frame, len, true));
+        TEST_ASSERT(test_remote_num == 0);
+
+        /* 没有转发的含义在本机分发 */
+        test_msg_t sent = {.len = 3, .type = MSG_DATA_INT8, .data = {1, 2, 3}};
+        len = test_build_frame(frame, MSG_CHASSIS, sent.type, 0x5A, sent.data,
+                               sent.len);
+        test_recv_num = 0;
+        TEST_ASSERT(test_route_inject(frame, len, false));
+        test_expect_received(&sent, 1);
+
+        /* 只有一片的分片传输, 按原消息的含义决定转发或在本机重组 */
+        payload[1] = (uint8_t)dma;
+        payload[2] = 0;
+        payload[3] = 1;
+        memcpy(payload + MSG_FRAGMENT_HEAD_SIZE, data, 8);
+        payload[0] = (uint8_t)(MSG_REMOTE << 4) | MSG_DATA_UINT8;
+        len = test_build_frame(frame, MSG_FRAGMENT_MEAN, MSG_DATA_UINT8, 1,
+                               payload, sizeof(payload));
+        TEST_ASSERT(test_route_inject(frame, len, true));
+        TEST_ASSERT(test_remote_num == 0);
+
+        payload[0] = (uint8_t)(MSG_CHASSIS << 4) | MSG_DATA_UINT8;
+        len = test_build_frame(frame, MSG_FRAGMENT_MEAN, MSG_DATA_UINT8, 2,
+                               payload, sizeof(payload));
+        test_recv_num = 0;
+        TEST_ASSERT(test_route_inject(frame, len, false));
+        TEST_ASSERT((test_recv_num == 1) && (test_recv[0].len == 8) &&
+                    (memcmp(test_recv[0].data, data, 8) == 0));
+
+#if (MSG_RELIABLE_ENABLE == 1)
+        /* 可靠传输帧原样转发, 由最终的接收方确认, 本机不发确认帧 */
+        payload[0] = (uint8_t)(MSG_REMOTE << 4) | MSG_DATA_UINT8;
+        payload[1] = 0x80;
+        host_uart_wire_clear(&host_uart);
+        len = test_build_frame(frame, MSG_RELIABLE_MEAN, 0x01, 3, payload, 6);
+        TEST_ASSERT(test_route_inject(frame, len, true));
+        host_uart_wire(&host_uart, &wire_len);
+        TEST_ASSERT((wire_len == 0) && (test_remote_num == 0));
+#else  /* MSG_RELIABLE_ENABLE == 1 */
+        UNUSED(wire_len);
+#endif /* MSG_RELIABLE_ENABLE == 1 */
+    }
+    host_peer.hdmatx = hdmatx;
+
+    /* 删除转发后恢复在本机分发 */
+    message_remove_route(&host_uart, MSG_REMOTE);
+    len = test_build_frame(frame, MSG_REMOTE, MSG_DATA_UINT8, 4, data, 4);
+    TEST_ASSERT(test_route_inject(frame, len, false));
+    TEST_ASSERT((test_remote_num == 1) && (test_remote_len == 4));
+    host_uart_set_loopback(&host_peer, true);
+}
+
+#if (MSG_LINK_STATS_PERIOD_MS > 0)
+
+/**
+ * @brief 收到的链路统计报告, 按轮询表序号存放
+ */
+static uint8_t test_link[MSG_POLLING_HANDLE_NUM][MSG_LINK_STATS_LENGTH];
+static uint32_t test_link_num[MSG_POLLING_HANDLE_NUM];
+
+/**
+ * @brief 记录收到的链路统计报告
+ *
+ * @param msg_length 数据长度
+ * @param msg_type 数据类型
+ * @param msg_data 数据
+ */
+static void test_link_callback(uint16_t msg_length, message_type_t msg_type,
+                               void *msg_data) {
+    const uint8_t *report = msg_data;
+
+    UNUSED(msg_type);
+    TEST_ASSERT(msg_length == MSG_LINK_STATS_LENGTH);
+    if ((msg_length != MSG_LINK_STATS_LENGTH) ||
+        (report[0] >= MSG_POLLING_HANDLE_NUM)) {
+        return;
+    }
+
+    ++test_link_num[report[0]];
+    memcpy(test_link[report[0]], report, MSG_LINK_STATS_LENGTH);
+}
+
+/**
+ * @brief 按小端读出报告中的一个成员
+ *
+ * @param report 报告
+ * @param field 成员序号, 从序号后的第一个成员开始
+ * @return 成员的值
+ */
+static uint32_t test_link_field(const uint8_t *report, uint32_t field) {
+    const uint8_t *p = report + 1 + field * 4;
+
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+           ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief 报告的各成员是否与统计相同
+ *
+ * @param report 报告
+ * @param stats 报告时的统计
+ * @return 相同时返回`true`
+ */
+static bool test_link_match(const uint8_t *report,
+                            const message_link_stats_t *stats) {
+    const uint32_t expect[] = {
+        stats->polling.frames,     stats->polling.errors,
+        stats->polling.overflows,  stats->polling.verify_errors,
+        stats->polling.bytes,      stats->uart.rx_bytes,
+        stats->uart.tx_bytes,      stats->uart.ore,
+        stats->uart.fe,            stats->uart.ne,
+        stats->uart.pe,            stats->uart.dma_errors,
+        stats->uart.rx_dropped,    stats->uart.rx_high_water,
+        stats->uart.tx_dropped};
+
+    if (1 + sizeof(expect) != MSG_LINK_STATS_LENGTH) {
+        return false;
+    }
+    for (uint32_t i = 0; i < sizeof(expect) / sizeof(expect[0]); ++i) {
+        if (test_link_field(report, i) != expect[i]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief 定时报告各轮询串口的链路统计: 序号后按成员顺序每个4字节小端.
+ *        驱动统计的每个成员取不同的值, 错位或字节序错误都能发现
+ */
+static void test_link_stats(void) {
+    static const uart_stats_t uart = {.rx_bytes = 0x04030201,
+                                      .tx_bytes = 0x14131211,
+                                      .ore = 0x24232221,
+                                      .fe = 0x34333231,
+                                      .ne = 0x44434241,
+                                      .pe = 0x54535251,
+                                      .dma_errors = 0x64636261,
+                                      .rx_dropped = 0x74737271,
+                                      .rx_high_water = 0x84838281,
+                                      .tx_dropped = 0x94939291};
+    message_link_stats_t expect;
+    message_link_stats_t expect_peer;
+
+    host_uart_set_stats(&host_uart, &uart);
+    message_register_recv_large_callback(MSG_LINK_STATS, test_link_callback);
+    memset(test_link_num, 0, sizeof(test_link_num));
+    message_register_send_handle(MSG_LINK_STATS, &host_uart);
+
+    /* 每毫秒记下统计, 报告发出前的最后一次就是报告中的值 */
+    for (uint32_t ms = 0;
+         (ms <= MSG_LINK_STATS_PERIOD_MS) && (test_link_num[0] == 0); ++ms) {
+        TEST_ASSERT(message_get_link_stats(&host_uart, &expect));
+        TEST_ASSERT(message_get_link_stats(&host_peer, &expect_peer));
+        host_advance(1);
+    }
+
+    TEST_ASSERT(test_link_num[0] == 1);
+    TEST_ASSERT(test_link[0][0] == 0);
+    TEST_ASSERT(test_link_match(test_link[0], &expect));
+
+    /* 第一个成员紧跟序号, 低字节在前 */
+    const uint8_t rx_bytes[] = {0x01, 0x02, 0x03, 0x04};
+    TEST_ASSERT(memcmp(&test_link[0][1 + 5 * 4], rx_bytes, 4) == 0);
+    TEST_ASSERT(test_link_field(test_link[0], 0) == expect.polling.frames);
+
+    /* 第二个轮询串口的驱动统计来自替身串口 */
+    TEST_ASSERT(test_link_num[1] == 1);
+    TEST_ASSERT(test_link[1][0] == 1);
+    TEST_ASSERT(test_link_match(test_link[1], &expect_peer));
+
+    /* 取消发送串口后停止报告 */
+    message_register_send_handle(MSG_LINK_STATS, NULL);
+    host_advance(MSG_LINK_STATS_PERIOD_MS * 2);
+    TEST_ASSERT(test_link_num[0] == 1);
+
+    /* 不在轮询表中的串口没有统计 */
+    TEST_ASSERT(!message_get_link_stats(NULL, &expect));
+
+    message_register_recv_large_callback(MSG_LINK_STATS, NULL);
+    host_uart_set_stats(&host_uart, NULL);
+}
+
+#endif /* MSG_LINK_STATS_PERIOD_MS > 0 */
+
+#if (MSG_BAUD_ENABLE == 1)
+
+/* 错误突增测试中`host_uart`的驱动统计 */
+static uart_stats_t test_baud_uart;
+
+/**
+ * @brief 读取波特率协商统计
+ *
+ * @param huart 串口句柄
+ * @return 协商统计
+ */
+static message_baud_stats_t test_baud_stats(UART_HandleTypeDef *huart) {
+    message_baud_stats_t stats = {0};
+
+    TEST_ASSERT(message_get_baud_stats(huart, &stats));
+    return stats;
+}
+
+/**
+ * @brief 两个串口回到基础速率, 重新开启协商, `host_peer`是主动方.
+ *        轮询时应答方在前, 先于主动方切换
+ *
+ * @param max 主动方的最高波特率
+ * @param answer_max 应答方的最高波特率
+ */
+static void test_baud_start(uint32_t max, uint32_t answer_max) {
+    host_flush();
+    host_peer.Init.BaudRate = MSG_BAUD_BASE_RATE;
+    host_uart.Init.BaudRate = MSG_BAUD_BASE_RATE;
+    host_uart_set_loss(&host_peer, 0);
+    host_uart_set_loss(&host_uart, 0);
+    TEST_ASSERT(message_baud_enable(&host_peer, max, true));
+    TEST_ASSERT(message_baud_enable(&host_uart, answer_max, false));
+}
+
+/**
+ * @brief 推进时间, 直到主动方确认一次切换
+ *
+ * @param limit 最多推进的毫秒数
+ * @return 推进的毫秒数, 没有确认时返回`limit`
+ */
+static uint32_t test_baud_settle(uint32_t limit) {
+    uint32_t switches = test_baud_stats(&host_peer).switches;
+
+    for (uint32_t ms = 1; ms <= limit; ++ms) {
+        host_advance(1);
+        if (test_baud_stats(&host_peer).switches != switches) {
+            return ms;
+        }
+    }
+
+    return limit;
+}
+
+/**
+ * @brief 应答方接受提议, 双方切换后确认. 协商期间持续发送普通帧,
+ *        暂停期间入队的帧在切换后按新速率发出, 一帧不丢
+ */
+static void test_baud_accept(void) {
+    message_tx_stats_t before = {0};
+    message_tx_stats_t after = {0};
+    uint8_t seq = 0;
+
+    test_baud_start(921600, 4500000);
+    message_get_tx_stats(&host_peer, MSG_PRIORITY_NORMAL, &before);
+    test_recv_num = 0;
+    for (uint32_t ms = 0; ms < 200; ++ms) {
+        /* 提议时通道中还有几帧, 应答方切换前它们不能开始发送 */
+        uint32_t burst = (ms == 0) ? MSG_TX_QUEUE_DEPTH / 2 : (ms % 10 == 0);
+        for (uint32_t i = 0; i < burst; ++i) {
+            uint8_t data[2] = {seq++, 0xA5};
+            message_send_data(MSG_CHASSIS, MSG_DATA_UINT8, data, 2);
+        }
+        host_advance(1);
+    }
+
+    message_baud_stats_t stats = test_baud_stats(&host_peer);
+    message_baud_stats_t answer = test_baud_stats(&host_uart);
+    TEST_ASSERT((stats.baud_rate == 921600) && (answer.baud_rate == 921600));
+    TEST_ASSERT((stats.switches == 1) && (answer.switches == 1));
+    TEST_ASSERT((stats.failures == 0) && (stats.fallbacks == 0));
+
+    message_get_tx_stats(&host_peer, MSG_PRIORITY_NORMAL, &after);
+    TEST_ASSERT(after.dropped == before.dropped);
+    TEST_ASSERT(test_recv_num == seq);
+    for (uint32_t i = 0; i < test_recv_num; ++i) {
+        TEST_ASSERT((test_recv[i].len == 2) && (test_recv[i].data[0] == i));
+    }
+}
+
+/**
+ * @brief 应答方拒绝超过自己上限的提议并给出能接受的速率,
+ *        主动方降低上限后立即按这个速率重新提议
+ */
+static void test_baud_reject(void) {
+    test_baud_start(4500000, 460800);
+    test_baud_settle(200);
+
+    message_baud_stats_t stats = test_baud_stats(&host_peer);
+    TEST_ASSERT(stats.baud_rate == 460800);
+    TEST_ASSERT(host_uart.Init.BaudRate == 460800);
+    TEST_ASSERT((stats.failures == 1) && (stats.ceiling == 460800));
+    TEST_ASSERT(stats.switches == 1);
+}
+
+/**
+ * @brief 切换后收到`MSG_BAUD_PROBE_NUM`次探测回复才确认;
+ *        回复丢失时超时回到基础速率, 降低上限后再协商
+ */
+static void test_baud_probe(void) {
+    uint32_t ms;
+
+    test_baud_start(921600, 921600);
+    for (ms = 0; (ms < 100) && (host_peer.Init.BaudRate != 921600); ++ms) {
+        host_advance(1);
+    }
+    TEST_ASSERT(host_peer.Init.BaudRate == 921600);
+    TEST_ASSERT(test_baud_stats(&host_peer).switches == 0);
+
+    /* 每隔`MSG_BAUD_PROBE_MS`探测一次, 第一次在切换时.
+     * 切换可能发生在`host_advance`推进时间之前, 差1毫秒 */
+    ms = test_baud_settle(100);
+    TEST_ASSERT(ms + 1 >= (MSG_BAUD_PROBE_NUM - 1) * MSG_BAUD_PROBE_MS);
+    TEST_ASSERT(ms <= MSG_BAUD_TIMEOUT_MS + MSG_BAUD_PROBE_NUM *
+                                               MSG_BAUD_PROBE_MS);
+    TEST_ASSERT(test_baud_stats(&host_peer).switches == 1);
+
+    /* 应答方的回复全部丢失 */
+    test_baud_start(921600, 921600);
+    for (ms = 0; (ms < 100) && (host_peer.Init.BaudRate != 921600); ++ms) {
+        host_advance(1);
+    }
+    host_uart_set_loss(&host_uart, 1000);
+    host_advance(MSG_BAUD_TIMEOUT_MS + MSG_BAUD_PROBE_NUM * MSG_BAUD_PROBE_MS);
+
+    message_baud_stats_t stats = test_baud_stats(&host_peer);
+    TEST_ASSERT(stats.baud_rate == MSG_BAUD_BASE_RATE);
+    TEST_ASSERT(host_uart.Init.BaudRate == MSG_BAUD_BASE_RATE);
+    TEST_ASSERT((stats.switches == 0) && (stats.failures == 1));
+    TEST_ASSERT(stats.ceiling == 460800);
+
+    host_uart_set_loss(&host_uart, 0);
+    host_advance(MSG_BAUD_RETRY_MS);
+    test_baud_settle(100);
+    TEST_ASSERT(host_peer.Init.BaudRate == 460800);
+    TEST_ASSERT(host_uart.Init.BaudRate == 460800);
+}
+
+/**
+ * @brief 链路断开`MSG_BAUD_LINK_TIMEOUT_MS`后双方都回到基础速率
+ */
+static void test_baud_link_timeout(void) {
+    test_baud_start(921600, 921600);
+    test_baud_settle(200);
+    TEST_ASSERT(host_peer.Init.BaudRate == 921600);
+
+    /* 确认时双方刚收到协商帧 */
+    host_uart_set_loss(&host_peer, 1000);
+    host_uart_set_loss(&host_uart, 1000);
+    host_advance(MSG_BAUD_LINK_TIMEOUT_MS - 1);
+    TEST_ASSERT(host_peer.Init.BaudRate == 921600);
+    TEST_ASSERT(host_uart.Init.BaudRate == 921600);
+
+    host_advance(1);
+    message_baud_stats_t stats = test_baud_stats(&host_peer);
+    message_baud_stats_t answer = test_baud_stats(&host_uart);
+    TEST_ASSERT(stats.baud_rate == MSG_BAUD_BASE_RATE);
+    TEST_ASSERT(answer.baud_rate == MSG_BAUD_BASE_RATE);
+    TEST_ASSERT((stats.fallbacks == 1) && (answer.fallbacks == 1));
+    TEST_ASSERT(stats.ceiling == 460800);
+}
+
+/**
+ * @brief 一个检查周期内的接收错误超过`MSG_BAUD_ERROR_LIMIT`时回到基础速率,
+ *        主动方每次把上限降低一档后重新协商
+ */
+static void test_baud_error_spike(void) {
+    memset(&test_baud_uart, 0, sizeof(test_baud_uart));
+    host_uart_set_stats(&host_uart, &test_baud_uart);
+    test_baud_start(4500000, 4500000);
+    test_baud_settle(200);
+    TEST_ASSERT(host_peer.Init.BaudRate == 4500000);
+
+    /* 没有超过上限时保持 */
+    test_baud_uart.fe += MSG_BAUD_ERROR_LIMIT;
+    host_advance(MSG_BAUD_KEEPALIVE_MS);
+    TEST_ASSERT(host_uart.Init.BaudRate == 4500000);
+    TEST_ASSERT(test_baud_stats(&host_uart).fallbacks == 0);
+
+    const uint32_t steps[] = {3000000, 2250000};
+    for (uint32_t i = 0; i < sizeof(steps) / sizeof(steps[0]); ++i) {
+        /* 驱动的几种错误加起来计数 */
+        test_baud_uart.ore += MSG_BAUD_ERROR_LIMIT / 2;
+        test_baud_uart.ne += MSG_BAUD_ERROR_LIMIT / 2 + 1;
+        host_advance(MSG_BAUD_KEEPALIVE_MS);
+
+        message_baud_stats_t stats = test_baud_stats(&host_peer);
+        TEST_ASSERT(stats.baud_rate == MSG_BAUD_BASE_RATE);
+        TEST_ASSERT(host_uart.Init.BaudRate == MSG_BAUD_BASE_RATE);
+        TEST_ASSERT(test_baud_stats(&host_uart).fallbacks == i + 1);
+        TEST_ASSERT(stats.ceiling == steps[i]);
+
+        host_advance(MSG_BAUD_RETRY_MS);
+        test_baud_settle(200);
+        TEST_ASSERT(host_peer.Init.BaudRate == steps[i]);
+        TEST_ASSERT(host_uart.Init.BaudRate == steps[i]);
+    }
+
+    host_uart_set_stats(&host_uart, NULL);
+}
+
+/**
+ * @brief 波特率协商, `host_peer`与`host_uart`交叉连接, 波特率不同时收不到.
+ *        普通帧从主动方发出
+ */
+static void test_baud(void) {
+    host_uart_connect(&host_peer, &host_uart);
+    message_register_send_handle(MSG_CHASSIS, &host_peer);
+
+    test_baud_accept();
+    test_baud_reject();
+    test_baud_probe();
+    test_baud_link_timeout();
+    test_baud_error_spike();
+
+    test_baud_start(MSG_BAUD_BASE_RATE, MSG_BAUD_BASE_RATE);
+    host_uart_connect(&host_peer, NULL);
+    message_register_send_handle(MSG_CHASSIS, &host_uart);
+}
+
+#endif /* MSG_BAUD_ENABLE == 1 */
+
+/**
+ * @brief msg_protocol的所有测试
+ */
+void test_msg_protocol(void) {
+    printf("msg_protocol (frame version %d)\n", MSG_FRAME_VERSION);
+
+    /* 发送测试只看线路上的字节, 不环回 */
+    host_uart_set_loopback(&host_uart, false);
+    message_register_send_handle(MSG_CHASSIS, &host_uart);
+
+    test_send_frame();
+    test_send_in_place();
+    test_send_priority();
+    test_send_lane_full();
+    test_send_dma_error();
+    test_send_bench();
+
+    host_uart_set_loopback(&host_uart, true);
+    message_add_polling_handle(&host_uart);
+    message_register_recv_callback(MSG_CHASSIS, test_recv_callback);
+
+    test_parse_stream(false);
+    test_parse_stream(true);
+    test_parse_overflow();
+    test_parse_bench();
+
+    test_crc16_table();
+    test_parse_bit_flip();
+#if (MSG_FRAME_VERSION == 3)
+    test_cobs_payload();
+    test_cobs_resync();
+#endif /* MSG_FRAME_VERSION == 3 */
+    test_crc16_bench();
+
+    message_register_recv_large_callback(MSG_CHASSIS, test_large_callback);
+    test_fragment_roundtrip();
+    test_fragment_busy();
+    test_fragment_loss();
+    message_register_recv_large_callback(MSG_CHASSIS, NULL);
+
+    message_register_send_handle(MSG_REMOTE, &host_uart);
+    message_register_recv_callback(MSG_REMOTE, test_remote_callback);
+    test_batch_roundtrip();
+    test_batch_error();
+    test_batch_malformed();
+
+    message_add_polling_handle(&host_peer);
+    test_polling_fair();
+    test_route();
+#if (MSG_LINK_STATS_PERIOD_MS > 0)
+    test_link_stats();
+#endif /* MSG_LINK_STATS_PERIOD_MS > 0 */
+    message_register_send_handle(MSG_REMOTE, NULL);
+    message_register_recv_callback(MSG_REMOTE, NULL);
+
+#if (MSG_RELIABLE_ENABLE == 1)
+    /* 收发都在同一个串口上, 确认帧也经过环回 */
+    TEST_ASSERT(message_reliable_enable(MSG_CHASSIS));
+    message_register_recv_callback(MSG_CHASSIS, test_reliable_callback);
+    test_reliable_lossy();
+    test_reliable_outage();
+    test_reliable_limit();
+    message_register_recv_callback(MSG_CHASSIS, test_recv_callback);
+#endif /* MSG_RELIABLE_ENABLE == 1 */
+
+#if (MSG_BAUD_ENABLE == 1)
+    /* 开启后无法关闭, 放在最后 */
+    test_baud();
+#endif /* MSG_BAUD_ENABLE == 1 */
+}
@@ -0,0 +1,644 @@
+/**
+ * @file    test_ring_fifo.c
+ * @author  Deadline039
+ * @brief   ring_fifo的主机测试
+ * @version 1.0
+ * @date    2026-10-17
+ * @note    并发测试用两个线程模拟中断(生产者)与任务(消费者),
+ *          数据按位置生成, 消费者逐字节检查, 错位或读到写了一半的数据都会发现
+ */
+
+/* 严格的C标准模式下`sched_yield`需要POSIX声明, 要在所有头文件之前定义 */
+#define _POSIX_C_SOURCE 200112L
+
+#include "test.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#define TEST_SPSC_BYTES  (8U * 1024U * 1024U) /* 流模式并发测试的字节数 */
+#define TEST_SPSC_FRAMES 500000U /* 帧模式并发测试的帧数 */
+#define TEST_RING_SIZE   1024U   /* 并发测试的缓冲区大小 */
+#define TEST_OVERWRITE_FRAMES 200000U /* 覆盖模式并发测试的帧数 */
+
+/**
+ * @brief 并发测试的状态
+ */
+typedef struct {
+    ring_fifo_t *ring; /*!< 环形缓冲区 */
+    uint32_t total;    /*!< 流模式为字节数, 帧模式为帧数 */
+    uint32_t errors;   /*!< 消费者发现的错误数 */
+} test_spsc_t;
+
+/**
+ * @brief 流中某个位置的字节
+ *
+ * @param pos 位置
+ * @return 字节
+ */
+static inline uint8_t test_stream_byte(uint32_t pos) {
+    return (uint8_t)(pos ^ (pos >> 8) ^ (pos >> 16) ^ (pos >> 24));
+}
+
+/**
+ * @brief 线程内使用的伪随机数
+ *
+ * @param[in,out] seed 种子
+ * @return 随机数, 低16位有效
+ */
+static inline uint32_t test_spsc_rand(uint32_t *seed) {
+    *seed = *seed * 1103515245U + 12345U;
+    return (*seed >> 8) & 0xFFFFU;
+}
+
+/**
+ * @brief 帧模式中第`seq`帧的长度
+ *
+ * @param seq 帧序号
+ * @return 帧长, 4~67字节
+ */
+static inline uint32_t test_frame_len(uint32_t seq) {
+    return sizeof(seq) + (seq * 2654435761U >> 26);
+}
+
+/**
+ * @brief 组出第`seq`帧, 前4字节为序号
+ *
+ * @param[out] frame 帧
+ * @param seq 帧序号
+ * @return 帧长
+ */
+static uint32_t test_frame_fill(uint8_t *frame, uint32_t seq) {
+    uint32_t len = test_frame_len(seq);
+
+    memcpy(frame, &seq, sizeof(seq));
+    for (uint32_t i = sizeof(seq); i < len; ++i) {
+        frame[i] = test_stream_byte(seq + i);
+    }
+
+    return len;
+}
+
+/**
+ * @brief 流模式生产者, 每次写入随机长度, 写不下的部分稍后重试
+ *
+ * @param arg 并发测试的状态
+ * @return NULL
+ */
+static void *test_stream_producer(void *arg) {
+    test_spsc_t *spsc = arg;
+    uint8_t chunk[128];
+    uint32_t seed = 1;
+
+    for (uint32_t pos = 0; pos < spsc->total;) {
+        uint32_t len = test_spsc_rand(&seed) % sizeof(chunk) + 1;
+        if (len > spsc->total - pos) {
+            len = spsc->total - pos;
+        }
+        for (uint32_t i = 0; i < len; ++i) {
+            chunk[i] = test_stream_byte(pos + i);
+        }
+
+        uint32_t avail = ring_fifo_avail(spsc->ring);
+        if (avail == 0) {
+            sched_yield();
+            continue;
+        }
+        /* 只写放得下的部分, 不计入丢弃 */
+        pos += ring_fifo_write(spsc->ring, chunk, (len < avail) ? len : avail);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief 帧模式生产者, 缓冲区满时等待后重试同一帧
+ *
+ * @param arg 并发测试的状态
+ * @return NULL
+ */
+static void *test_frame_producer(void *arg) {
+    test_spsc_t *spsc = arg;
+    uint8_t frame[128];
+
+    for (uint32_t seq = 0; seq < spsc->total;) {
+        uint32_t len = test_frame_fill(frame, seq);
+
+        /* 帧头4字节, 回绕时最多再跳过3字节 */
+        if (ring_fifo_avail(spsc->ring) < len + 2 * sizeof(uint32_t)) {
+            sched_yield();
+            continue;
+        }
+        if (ring_fifo_write(spsc->ring, frame, len) == len) {
+            ++seq;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief 流模式消费者, 每次读出随机长度并逐字节检查
+ *
+ * @param spsc 并发测试的状态
+ */
+static void test_stream_consumer(test_spsc_t *spsc) {
+    uint8_t chunk[128];
+    uint32_t seed = 2;
+
+    for (uint32_t pos = 0; pos < spsc->total;) {
+        uint32_t len = ring_fifo_read(spsc->ring, chunk,
+                                      test_spsc_rand(&seed) % sizeof(chunk) +
+                                          1);
+        if (len == 0) {
+            sched_yield();
+            continue;
+        }
+        for (uint32_t i = 0; i < len; ++i) {
+            spsc->errors += (chunk[i] != test_stream_byte(pos + i));
+        }
+        pos += len;
+    }
+}
+
+/**
+ * @brief 帧模式消费者, 检查帧长, 序号与内容
+ *
+ * @param spsc 并发测试的状态
+ */
+static void test_frame_consumer(test_spsc_t *spsc) {
+    uint8_t frame[128];
+    uint8_t expect[128];
+
+    for (uint32_t seq = 0; seq < spsc->total;) {
+        uint32_t len = ring_fifo_read(spsc->ring, frame, sizeof(frame));
+        if (len == 0) {
+            sched_yield();
+            continue;
+        }
+        spsc->errors += (len != test_frame_fill(expect, seq)) ||
+                        (memcmp(frame, expect, len) != 0);
+        ++seq;
+    }
+}
+
+/**
+ * @brief 一个线程写入一个线程读出, 数据完整且按顺序, 输出吞吐量
+ *
+ * @param type fifo类型
+ */
+static void test_ring_spsc(enum ring_fifo_type type) {
+    static uint8_t buf[TEST_RING_SIZE];
+    ring_fifo_t ring_cb;
+    test_spsc_t spsc = {0};
+    pthread_t producer;
+    bool stream = (type == RF_TYPE_STREAM);
+
+    spsc.ring = ring_fifo_init_static(&ring_cb, buf, sizeof(buf), type);
+    spsc.total = stream ? TEST_SPSC_BYTES : TEST_SPSC_FRAMES;
+    TEST_ASSERT(spsc.ring != NULL);
+
+    uint64_t start = test_now_ns();
+    TEST_ASSERT(pthread_create(&producer, NULL,
+                               stream ? test_stream_producer
+                                      : test_frame_producer,
+                               &spsc) == 0);
+    if (stream) {
+        test_stream_consumer(&spsc);
+    } else {
+        test_frame_consumer(&spsc);
+    }
+    pthread_join(producer, NULL);
+    uint64_t ns = test_now_ns() - start;
+
+    TEST_ASSERT(spsc.errors == 0);
+    TEST_ASSERT(ring_fifo_is_empty(spsc.ring));
+    TEST_ASSERT(ring_fifo_dropped(spsc.ring) == 0);
+
+    if (stream) {
+        test_bench_print("spsc stream (byte)", ns, spsc.total, 1);
+    } else {
+        test_bench_print((type == RF_TYPE_FRAME) ? "spsc frame (frame)"
+                                                 : "spsc varint (frame)",
+                         ns, spsc.total, sizeof(uint32_t) + 32);
+    }
+}
+
+/**
+ * @brief 检查两段连续内存中的数据
+ *
+ * @param span 两段连续内存
+ * @param first 第一个字节在流中的位置
+ * @return 数据是否与流中的字节相同
+ */
+static bool test_span_equal(const ring_fifo_span_t span[2], uint32_t first) {
+    for (uint32_t s = 0; s < 2; ++s) {
+        for (uint32_t i = 0; i < span[s].len; ++i) {
+            if (span[s].buf[i] != test_stream_byte(first++)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief 把流中从`first`开始的`len`字节写入两段连续内存
+ *
+ * @param span 两段连续内存
+ * @param first 第一个字节在流中的位置
+ * @param len 长度
+ */
+static void test_span_fill(ring_fifo_span_t span[2], uint32_t first,
+                           uint32_t len) {
+    for (uint32_t s = 0; (s < 2) && (len > 0); ++s) {
+        uint32_t l = (span[s].len < len) ? span[s].len : len;
+        for (uint32_t i = 0; i < l; ++i) {
+            span[s].buf[i] = test_stream_byte(first++);
+        }
+        len -= l;
+    }
+}
+
+/**
+ * @brief 回绕时peek返回两段, consume后剩余部分不变
+ */
+static void test_ring_peek(void) {
+    uint8_t buf[64];
+    uint8_t tmp[64];
+    ring_fifo_t ring_cb;
+    ring_fifo_span_t span[2];
+    ring_fifo_t *ring =
+        ring_fifo_init_static(&ring_cb, buf, sizeof(buf), RF_TYPE_STREAM);
+
+    TEST_ASSERT(ring_fifo_peek(ring, span) == 0);
+    TEST_ASSERT((span[0].len == 0) && (span[1].len == 0));
+
+    /* 把指针移到距末尾8字节处 */
+    for (uint32_t i = 0; i < 56; ++i) {
+        tmp[i] = test_stream_byte(i);
+    }
+    ring_fifo_write(ring, tmp, 56);
+    ring_fifo_read(ring, tmp, 56);
+
+    for (uint32_t i = 0; i < 20; ++i) {
+        tmp[i] = test_stream_byte(56 + i);
+    }
+    TEST_ASSERT(ring_fifo_write(ring, tmp, 20) == 20);
+
+    TEST_ASSERT(ring_fifo_peek(ring, span) == 20);
+    TEST_ASSERT((span[0].buf == buf + 56) && (span[0].len == 8));
+    TEST_ASSERT((span[1].buf == buf) && (span[1].len == 12));
+    TEST_ASSERT(test_span_equal(span, 56));
+    /* peek不移动指针 */
+    TEST_ASSERT(ring_fifo_count(ring) == 20);
+
+    ring_fifo_consume(ring, 10);
+    TEST_ASSERT(ring_fifo_peek(ring, span) == 10);
+    TEST_ASSERT((span[0].buf == buf + 2) && (span[0].len == 10));
+    TEST_ASSERT(span[1].len == 0);
+    TEST_ASSERT(test_span_equal(span, 66));
+
+    ring_fifo_consume(ring, 10);
+    TEST_ASSERT(ring_fifo_is_empty(ring));
+
+    /* 帧模式与覆盖模式不支持 */
+    ring_fifo_write(ring, tmp, 4);
+    ring_fifo_set_policy(ring, RF_POLICY_OVERWRITE);
+    TEST_ASSERT(ring_fifo_peek(ring, span) == 0);
+    ring = ring_fifo_init_static(&ring_cb, buf, sizeof(buf), RF_TYPE_FRAME);
+    ring_fifo_write(ring, tmp, 4);
+    TEST_ASSERT(ring_fifo_peek(ring, span) == 0);
+    TEST_ASSERT(ring_fifo_reserve(ring, span) == 0);
+}
+
+/**
+ * @brief reserve返回全部空闲空间, 直接写入后commit, 读出的数据相同
+ */
+static void test_ring_reserve(void) {
+    uint8_t buf[64];
+    uint8_t tmp[64];
+    ring_fifo_t ring_cb;
+    ring_fifo_span_t span[2];
+    ring_fifo_t *ring =
+        ring_fifo_init_static(&ring_cb, buf, sizeof(buf), RF_TYPE_STREAM);
+
+    TEST_ASSERT(ring_fifo_reserve(ring, span) == sizeof(buf));
+    TEST_ASSERT((span[0].buf == buf) && (span[0].len == sizeof(buf)));
+    TEST_ASSERT(span[1].len == 0);
+
+    test_span_fill(span, 0, 40);
+    /* 发布前消费者看不到 */
+    TEST_ASSERT(ring_fifo_read(ring, tmp, sizeof(tmp)) == 0);
+    ring_fifo_commit(ring, 40);
+    TEST_ASSERT(ring_fifo_read(ring, tmp, 30) == 30);
+
+    /* 空闲空间从40回绕到29 */
+    TEST_ASSERT(ring_fifo_reserve(ring, span) == 54);
+    TEST_ASSERT((span[0].buf == buf + 40) && (span[0].len == 24));
+    TEST_ASSERT((span[1].buf == buf) && (span[1].len == 30));
+
+    test_span_fill(span, 40, 50);
+    ring_fifo_commit(ring, 50);
+    TEST_ASSERT(ring_fifo_count(ring) == 60);
+
+    TEST_ASSERT(ring_fifo_read(ring, tmp, sizeof(tmp)) == 60);
+    bool equal = true;
+    for (uint32_t i = 0; i < 60; ++i) {
+        equal = equal && (tmp[i] == test_stream_byte(30 + i));
+    }
+    TEST_ASSERT(equal);
+    TEST_ASSERT(ring_fifo_dropped(ring) == 0);
+}
+
+/**
+ * @brief 不经过reserve直接commit越过消费者时, 未读数据全部丢弃并计数
+ */
+static void test_ring_commit_overrun(void) {
+    uint8_t buf[64];
+    uint8_t tmp[64];
+    ring_fifo_t ring_cb;
+    ring_fifo_span_t span[2];
+    ring_fifo_t *ring =
+        ring_fifo_init_static(&ring_cb, buf, sizeof(buf), RF_TYPE_STREAM);
+
+    /* 相当于DMA在任务读取之前写满一圈多 */
+    ring_fifo_commit(ring, 50);
+    ring_fifo_commit(ring, 30);
+    TEST_ASSERT(ring_fifo_peek(ring, span) == 0);
+    TEST_ASSERT(ring_fifo_dropped(ring) == 80);
+
+    /* 之后的数据正常读取 */
+    ring_fifo_commit(ring, 5);
+    TEST_ASSERT(ring_fifo_read(ring, tmp, sizeof(tmp)) == 5);
+}
+
+/**
+ * @brief 变长帧头: 小于128字节的帧头占1字节, 否则2字节, 回绕时不跳过
+ */
+static void test_ring_varint(void) {
+    static uint8_t buf[256];
+    static uint8_t large_buf[0x8000];
+    static uint8_t frame[RF_VARINT_MAX_FRAME + 1];
+    static uint8_t tmp[RF_VARINT_MAX_FRAME + 1];
+    ring_fifo_t ring_cb;
+    ring_fifo_t *ring = ring_fifo_init_static(&ring_cb, buf, sizeof(buf),
+                                              RF_TYPE_FRAME_VARINT);
+
+    for (uint32_t i = 0; i < sizeof(frame); ++i) {
+        frame[i] = test_stream_byte(i);
+    }
+
+    /* 8字节的帧只多占1字节, 4字节帧头的帧模式要多占4字节 */
+    TEST_ASSERT(ring_fifo_write(ring, frame, 8) == 8);
+    TEST_ASSERT(ring_fifo_count(ring) == 9);
+    TEST_ASSERT(ring_fifo_read(ring, tmp, sizeof(tmp)) == 8);
+    TEST_ASSERT(memcmp(tmp, frame, 8) == 0);
+
+    TEST_ASSERT(ring_fifo_write(ring, frame, 127) == 127);
+    TEST_ASSERT(ring_fifo_count(ring) == 128);
+    TEST_ASSERT(ring_fifo_read(ring, tmp, sizeof(tmp)) == 127);
+    TEST_ASSERT(ring_fifo_write(ring, frame, 128) == 128);
+    TEST_ASSERT(ring_fifo_count(ring) == 130);
+    TEST_ASSERT(ring_fifo_read(ring, tmp, sizeof(tmp)) == 128);
+    TEST_ASSERT(memcmp(tmp, frame, 128) == 0);
+
+    /* 指针在11, 再前进244字节停在最后一个字节, 下一帧的2字节帧头跨过回绕处 */
+    TEST_ASSERT(ring_fifo_write(ring, frame, 242) == 242);
+    TEST_ASSERT(ring_fifo_read(ring, tmp, sizeof(tmp)) == 242);
+    TEST_ASSERT(ring_fifo_write(ring, frame + 1, 200) == 200);
+    TEST_ASSERT(ring_fifo_count(ring) == 202);
+    TEST_ASSERT(ring_fifo_read(ring, tmp, sizeof(tmp)) == 200);
+    TEST_ASSERT(memcmp(tmp, frame + 1, 200) == 0);
+
+    /* 放不下与空的帧整帧丢弃 */
+    uint32_t dropped = ring_fifo_dropped(ring);
+    TEST_ASSERT(ring_fifo_write(ring, frame, 255) == 0);
+    TEST_ASSERT(ring_fifo_write(ring, frame, 0) == 0);
+    TEST_ASSERT(ring_fifo_dropped(ring) - dropped == 2);
+    TEST_ASSERT(ring_fifo_is_empty(ring));
+
+    /* 帧长上限 */
+    ring = ring_fifo_init_static(&ring_cb, large_buf, sizeof(large_buf),
+                                 RF_TYPE_FRAME_VARINT);
+    TEST_ASSERT(ring_fifo_write(ring, frame, RF_VARINT_MAX_FRAME + 1) == 0);
+    TEST_ASSERT(ring_fifo_write(ring, frame, RF_VARINT_MAX_FRAME) ==
+                RF_VARINT_MAX_FRAME);
+    TEST_ASSERT(ring_fifo_count(ring) == RF_VARINT_MAX_FRAME + 2);
+    TEST_ASSERT(ring_fifo_read(ring, tmp, sizeof(tmp)) ==
+                RF_VARINT_MAX_FRAME);
+    TEST_ASSERT(memcmp(tmp, frame, RF_VARINT_MAX_FRAME) == 0);
+}
+
+/**
+ * @brief 静态初始化使用调用者的控制块, 参数错误返回NULL,
+ *        销毁时不释放调用者的内存
+ */
+static void test_ring_static(void) {
+    static ring_fifo_t ring_cb;
+    static uint8_t buf[64];
+    uint8_t tmp[4] = {1, 2, 3, 4};
+
+    TEST_ASSERT(ring_fifo_init_static(NULL, buf, sizeof(buf),
+                                      RF_TYPE_STREAM) == NULL);
+    TEST_ASSERT(ring_fifo_init_static(&ring_cb, NULL, sizeof(buf),
+                                      RF_TYPE_STREAM) == NULL);
+    TEST_ASSERT(ring_fifo_init_static(&ring_cb, buf, 48, RF_TYPE_STREAM) ==
+                NULL);
+
+    ring_fifo_t *ring =
+        ring_fifo_init_static(&ring_cb, buf, sizeof(buf), RF_TYPE_FRAME);
+    TEST_ASSERT(ring == &ring_cb);
+    TEST_ASSERT(ring_fifo_write(ring, tmp, sizeof(tmp)) == sizeof(tmp));
+    TEST_ASSERT(memcmp(buf + sizeof(uint32_t), tmp, sizeof(tmp)) == 0);
+
+    /* 释放静态内存会让程序崩溃, 能继续运行就说明没有释放 */
+    ring_fifo_destroy(ring);
+    ring = ring_fifo_init_static(&ring_cb, buf, sizeof(buf), RF_TYPE_STREAM);
+    TEST_ASSERT(ring_fifo_is_empty(ring));
+    TEST_ASSERT(ring_fifo_dropped(ring) == 0);
+}
+
+/**
+ * @brief 流模式覆盖最旧的数据, 保留最新的字节
+ */
+static void test_overwrite_stream(void) {
+    uint8_t buf[64];
+    uint8_t src[128];
+    uint8_t tmp[64];
+    ring_fifo_t ring_cb;
+    ring_fifo_t *ring =
+        ring_fifo_init_static(&ring_cb, buf, sizeof(buf), RF_TYPE_STREAM);
+
+    ring_fifo_set_policy(ring, RF_POLICY_OVERWRITE);
+    for (uint32_t i = 0; i < sizeof(src); ++i) {
+        src[i] = test_stream_byte(i);
+    }
+
+    TEST_ASSERT(ring_fifo_write(ring, src, 50) == 50);
+    TEST_ASSERT(ring_fifo_write(ring, src + 50, 30) == 30);
+    TEST_ASSERT(ring_fifo_is_full(ring));
+    TEST_ASSERT(ring_fifo_dropped(ring) == 16);
+    TEST_ASSERT(ring_fifo_read(ring, tmp, sizeof(tmp)) == 64);
+    TEST_ASSERT(memcmp(tmp, src + 16, 64) == 0);
+
+    /* 一次写入超过缓冲区大小, 只保留最后64字节 */
+    TEST_ASSERT(ring_fifo_write(ring, src, 10) == 10);
+    TEST_ASSERT(ring_fifo_write(ring, src, sizeof(src)) == 64);
+    TEST_ASSERT(ring_fifo_dropped(ring) == 16 + 10 + 64);
+    TEST_ASSERT(ring_fifo_read(ring, tmp, sizeof(tmp)) == 64);
+    TEST_ASSERT(memcmp(tmp, src + 64, 64) == 0);
+}
+
+/**
+ * @brief 帧模式覆盖时整帧丢弃最旧的帧, 读出的都是完整的最新帧
+ *
+ * @param type fifo类型
+ */
+static void test_overwrite_frame(enum ring_fifo_type type) {
+    uint8_t buf[64];
+    uint8_t frame[128];
+    uint8_t expect[128];
+    ring_fifo_t ring_cb;
+    ring_fifo_t *ring = ring_fifo_init_static(&ring_cb, buf, sizeof(buf), type);
+    uint32_t total = 40;
+
+    ring_fifo_set_policy(ring, RF_POLICY_OVERWRITE);
+    for (uint32_t seq = 0; seq < total; ++seq) {
+        /* 长度不同的帧, 回绕位置每次不同 */
+        uint32_t len = test_frame_fill(frame, seq);
+        if (len > 20) {
+            len = 20;
+        }
+        TEST_ASSERT(ring_fifo_write(ring, frame, len) == len);
+    }
+
+    uint32_t dropped = ring_fifo_dropped(ring);
+    uint32_t seq = dropped;
+    uint32_t len;
+    TEST_ASSERT(dropped != 0);
+    while ((len = ring_fifo_read(ring, frame, sizeof(frame))) != 0) {
+        uint32_t expect_len = test_frame_fill(expect, seq);
+        if (expect_len > 20) {
+            expect_len = 20;
+        }
+        TEST_ASSERT((len == expect_len) && (memcmp(frame, expect, len) == 0));
+        ++seq;
+    }
+    /* 丢弃的都是最旧的帧, 最新的帧都在 */
+    TEST_ASSERT(seq == total);
+
+    /* 比缓冲区还大的帧不能写入 */
+    TEST_ASSERT(ring_fifo_write(ring, frame, sizeof(buf)) == 0);
+    TEST_ASSERT(ring_fifo_dropped(ring) == dropped + 1);
+}
+
+/**
+ * @brief 覆盖模式并发测试的状态
+ */
+typedef struct {
+    ring_fifo_t *ring; /*!< 环形缓冲区 */
+    atomic_bool done;  /*!< 生产者是否写完 */
+} test_overwrite_t;
+
+/**
+ * @brief 覆盖模式生产者, 从不等待消费者
+ *
+ * @param arg 并发测试的状态
+ * @return NULL
+ */
+static void *test_overwrite_producer(void *arg) {
+    test_overwrite_t *state = arg;
+    uint8_t frame[128];
+
+    for (uint32_t seq = 0; seq < TEST_OVERWRITE_FRAMES; ++seq) {
+        uint32_t len = test_frame_fill(frame, seq);
+        ring_fifo_write(state->ring, frame, len);
+        if (seq % 64 == 0) {
+            /* 让消费者有机会在写入中途读取 */
+            sched_yield();
+        }
+    }
+    atomic_store(&state->done, true);
+
+    return NULL;
+}
+
+/**
+ * @brief 生产者持续覆盖时并发读取, 读到的帧完整且序号递增,
+ *        读出的帧数加丢弃的帧数等于写入的帧数
+ *
+ * @param type fifo类型
+ */
+static void test_overwrite_concurrent(enum ring_fifo_type type) {
+    static uint8_t buf[256];
+    uint8_t frame[128];
+    uint8_t expect[128];
+    ring_fifo_t ring_cb;
+    test_overwrite_t state;
+    pthread_t producer;
+    uint32_t errors = 0;
+    uint32_t received = 0;
+    uint32_t last = 0;
+
+    state.ring = ring_fifo_init_static(&ring_cb, buf, sizeof(buf), type);
+    ring_fifo_set_policy(state.ring, RF_POLICY_OVERWRITE);
+    atomic_init(&state.done, false);
+
+    TEST_ASSERT(pthread_create(&producer, NULL, test_overwrite_producer,
+                               &state) == 0);
+    while (1) {
+        /* 先看生产者是否写完, 再读, 保证最后一次读取之后没有新数据 */
+        bool done = atomic_load(&state.done);
+        uint32_t len = ring_fifo_read(state.ring, frame, sizeof(frame));
+
+        if (len == 0) {
+            if (done) {
+                break;
+            }
+            sched_yield();
+            continue;
+        }
+
+        uint32_t seq;
+        memcpy(&seq, frame, sizeof(seq));
+        errors += ((received != 0) && (seq <= last)) ||
+                  (seq >= TEST_OVERWRITE_FRAMES) ||
+                  (len != test_frame_fill(expect, seq)) ||
+                  (memcmp(frame, expect, len) != 0);
+        last = seq;
+        ++received;
+    }
+    pthread_join(producer, NULL);
+
+    TEST_ASSERT(errors == 0);
+    TEST_ASSERT(received + ring_fifo_dropped(state.ring) ==
+                TEST_OVERWRITE_FRAMES);
+    /* 最新的一帧一定在 */
+    TEST_ASSERT(last == TEST_OVERWRITE_FRAMES - 1);
+}
+
+/**
+ * @brief ring_fifo的所有测试
+ */
+void test_ring_fifo(void) {
+    printf("ring_fifo\n");
+
+    test_ring_peek();
+    test_ring_reserve();
+    test_ring_commit_overrun();
+    test_ring_varint();
+    test_ring_static();
+    test_overwrite_stream();
+    test_overwrite_frame(RF_TYPE_FRAME);
+    test_overwrite_frame(RF_TYPE_FRAME_VARINT);
+    test_overwrite_concurrent(RF_TYPE_FRAME);
+    test_overwrite_concurrent(RF_TYPE_FRAME_VARINT);
+
+    test_ring_spsc(RF_TYPE_STREAM);
+    test_ring_spsc(RF_TYPE_FRAME);
+    test_ring_spsc(RF_TYPE_FRAME_VARINT);
+}
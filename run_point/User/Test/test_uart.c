@@ -0,0 +1,518 @@
+/**
+ * @file    test_uart.c
+ * @author  Deadline039
+ * @brief   串口驱动UART_STM32F4xx.c的主机测试
+ * @version 1.0
+ * @date    2026-10-17
+ * @note    测试USART1, 收发都使用DMA. 覆盖驱动的两个弱函数记录回调,
+ *          `uart_dmatx_cplt_callback`中模拟消息队列这样自己启动DMA发送的用户
+ */
+
+#include "test.h"
+
+#include <string.h>
+
+/**
+ * @brief 自己启动DMA发送的用户, 与消息队列相同, 按`pTxBuffPtr`认出自己的帧
+ */
+typedef struct {
+    uint8_t frame[4];  /*!< 发送的帧 */
+    bool busy;         /*!< 帧在线路上 */
+    uint32_t queued;   /*!< 等待发送的帧数 */
+    uint32_t released; /*!< 完成或出错后释放的帧数 */
+    uint32_t failed;   /*!< 出错的帧数 */
+} test_user_t;
+
+static test_user_t test_user = {.frame = {'U', 'S', 'E', 'R'}};
+static uint32_t test_cplt_calls;
+static const uint8_t *test_cplt_ptr;
+static uint32_t test_cplt_error;
+static uint32_t test_notified;
+
+/**
+ * @brief 接收通知, 覆盖驱动中的弱定义
+ *
+ * @param huart 串口句柄
+ */
+void uart_dmarx_notify_callback(UART_HandleTypeDef *huart) {
+    UNUSED(huart);
+    ++test_notified;
+}
+
+/**
+ * @brief 用户空闲且有帧等待时启动发送
+ *
+ * @param huart 串口句柄
+ */
+static void test_user_kick(UART_HandleTypeDef *huart) {
+    if ((test_user.busy) || (test_user.queued == 0)) {
+        return;
+    }
+
+    if (HAL_UART_Transmit_DMA(huart, test_user.frame,
+                              sizeof(test_user.frame)) == HAL_OK) {
+        test_user.busy = true;
+        --test_user.queued;
+    }
+}
+
+/**
+ * @brief 发送完成, 覆盖驱动中的弱定义
+ *
+ * @param huart 串口句柄
+ */
+void uart_dmatx_cplt_callback(UART_HandleTypeDef *huart) {
+    ++test_cplt_calls;
+    test_cplt_ptr = huart->pTxBuffPtr;
+    test_cplt_error = HAL_UART_GetError(huart);
+
+    if ((test_user.busy) && (huart->pTxBuffPtr == test_user.frame)) {
+        test_user.busy = false;
+        ++test_user.released;
+        if ((test_cplt_error & HAL_UART_ERROR_DMA) != 0U) {
+            ++test_user.failed;
+        }
+    }
+
+    test_user_kick(huart);
+}
+
+/**
+ * @brief 重新初始化USART1, 清空记录
+ */
+static void test_uart_reset(void) {
+    usart1_deinit();
+    TEST_ASSERT(usart1_init(115200) == UART_INIT_OK);
+    uart_clear_stats(&usart1_handle);
+    host_uart_wire_clear();
+
+    test_user = (test_user_t){.frame = {'U', 'S', 'E', 'R'}};
+    test_cplt_calls = 0;
+    test_cplt_ptr = NULL;
+    test_cplt_error = HAL_UART_ERROR_NONE;
+    test_notified = 0;
+}
+
+/**
+ * @brief 线路上的字节是否与期望相同
+ *
+ * @param expect 期望的字节, 以'\0'结尾
+ * @return 相同时返回true
+ */
+static bool test_wire_is(const char *expect) {
+    uint32_t len;
+    const uint8_t *wire = host_uart_wire(&len);
+
+    return (len == strlen(expect)) && (memcmp(wire, expect, len) == 0);
+}
+
+/**
+ * @brief 接收, 收到的字节经过空闲中断进入FIFO
+ */
+static void test_uart_rx(void) {
+    test_uart_reset();
+
+    uint8_t buf[16];
+    host_dma_receive(&usart1_handle, "hello", 5);
+    TEST_ASSERT(uart_dmarx_read(&usart1_handle, buf, sizeof(buf)) == 0);
+
+    host_uart_idle(&usart1_handle);
+    TEST_ASSERT(test_notified == 1);
+    TEST_ASSERT(uart_dmarx_read(&usart1_handle, buf, sizeof(buf)) == 5);
+    TEST_ASSERT(memcmp(buf, "hello", 5) == 0);
+}
+
+/**
+ * @brief 双缓冲区的发送DMA出错: 这次的数据丢弃, `busy`清除,
+ *        出错前请求发送的另一半接着发出, 之后的发送不受影响
+ */
+static void test_uart_tx_error_buf(void) {
+    test_uart_reset();
+
+    TEST_ASSERT(uart_dmatx_write(&usart1_handle, "abc", 3) == 3);
+    TEST_ASSERT(uart_dmatx_send(&usart1_handle) == 3);
+    TEST_ASSERT(uart_dmatx_write(&usart1_handle, "def", 3) == 3);
+    TEST_ASSERT(uart_dmatx_send(&usart1_handle) == 3);
+
+    TEST_ASSERT(host_uart_tx_error(&usart1_handle));
+    /* 用户回调看到出错的发送 */
+    TEST_ASSERT(test_cplt_calls == 1);
+    TEST_ASSERT((test_cplt_error & HAL_UART_ERROR_DMA) != 0U);
+    TEST_ASSERT(usart1_handle.hdmatx->ErrorCode == HAL_DMA_ERROR_NONE);
+
+    /* 等待的一半已经启动 */
+    TEST_ASSERT(usart1_handle.gState == HAL_UART_STATE_BUSY_TX);
+    TEST_ASSERT(host_uart_tx_complete(&usart1_handle));
+    TEST_ASSERT(test_wire_is("def"));
+
+    TEST_ASSERT(uart_dmatx_write(&usart1_handle, "ghi", 3) == 3);
+    TEST_ASSERT(uart_dmatx_send(&usart1_handle) == 3);
+    TEST_ASSERT(host_uart_tx_complete(&usart1_handle));
+    TEST_ASSERT(test_wire_is("defghi"));
+
+    uart_stats_t stats;
+    uart_get_stats(&usart1_handle, &stats);
+    TEST_ASSERT(stats.dma_errors == 1);
+    TEST_ASSERT(stats.tx_bytes == 6);
+}
+
+/**
+ * @brief 其他用户的发送DMA出错: 用户回调按`pTxBuffPtr`认出自己的帧并释放,
+ *        等待的帧接着发出
+ */
+static void test_uart_tx_error_user(void) {
+    test_uart_reset();
+
+    test_user.queued = 2;
+    test_user_kick(&usart1_handle);
+    TEST_ASSERT(test_user.busy);
+
+    TEST_ASSERT(host_uart_tx_error(&usart1_handle));
+    TEST_ASSERT(test_user.released == 1);
+    TEST_ASSERT(test_user.failed == 1);
+    TEST_ASSERT(test_user.busy);
+
+    TEST_ASSERT(host_uart_tx_complete(&usart1_handle));
+    TEST_ASSERT(test_user.released == 2);
+    TEST_ASSERT(test_user.failed == 1);
+    TEST_ASSERT(test_wire_is("USER"));
+
+    TEST_ASSERT(uart_dmatx_write(&usart1_handle, "abc", 3) == 3);
+    TEST_ASSERT(uart_dmatx_send(&usart1_handle) == 3);
+    TEST_ASSERT(host_uart_tx_complete(&usart1_handle));
+    TEST_ASSERT(test_wire_is("USERabc"));
+}
+
+/**
+ * @brief 用户的帧在线路上时双缓冲区请求发送: 完成时用户回调先看到自己的帧,
+ *        双缓冲区在线路空闲后发出, 不会改写用户认帧用的`pTxBuffPtr`
+ */
+static void test_uart_tx_order(void) {
+    test_uart_reset();
+
+    test_user.queued = 2;
+    test_user_kick(&usart1_handle);
+    TEST_ASSERT(uart_dmatx_write(&usart1_handle, "xyz", 3) == 3);
+    TEST_ASSERT(uart_dmatx_send(&usart1_handle) == 0);
+
+    TEST_ASSERT(host_uart_tx_complete(&usart1_handle));
+    TEST_ASSERT(test_cplt_ptr == test_user.frame);
+    TEST_ASSERT(test_user.released == 1);
+    TEST_ASSERT(test_user.busy);
+
+    TEST_ASSERT(host_uart_tx_complete(&usart1_handle));
+    TEST_ASSERT(test_user.released == 2);
+    TEST_ASSERT(!test_user.busy);
+
+    /* 线路空闲后双缓冲区接着发送 */
+    TEST_ASSERT(host_uart_tx_complete(&usart1_handle));
+    TEST_ASSERT(test_wire_is("USERUSERxyz"));
+    TEST_ASSERT(!host_uart_tx_complete(&usart1_handle));
+}
+
+/**
+ * @brief 发送DMA出错时HAL结束了接收但没有停止接收DMA, 驱动要停止它再从头
+ *        启动, 出错前收到的数据不丢, 之后收到的数据不重复
+ */
+static void test_uart_tx_error_rx(void) {
+    test_uart_reset();
+
+    uint8_t buf[16];
+    host_dma_receive(&usart1_handle, "12345", 5);
+    TEST_ASSERT(uart_dmatx_write(&usart1_handle, "abc", 3) == 3);
+    TEST_ASSERT(uart_dmatx_send(&usart1_handle) == 3);
+    TEST_ASSERT(host_uart_tx_error(&usart1_handle));
+
+    TEST_ASSERT(usart1_handle.RxState == HAL_UART_STATE_BUSY_RX);
+    TEST_ASSERT(usart1_handle.hdmarx->Instance->NDTR ==
+                USART1_RX_DMA_BUF_SIZE);
+    TEST_ASSERT(uart_dmarx_read(&usart1_handle, buf, sizeof(buf)) == 5);
+    TEST_ASSERT(memcmp(buf, "12345", 5) == 0);
+
+    host_dma_receive(&usart1_handle, "6789", 4);
+    host_uart_idle(&usart1_handle);
+    TEST_ASSERT(uart_dmarx_read(&usart1_handle, buf, sizeof(buf)) == 4);
+    TEST_ASSERT(memcmp(buf, "6789", 4) == 0);
+    TEST_ASSERT(host_uart_rx_lost() == 0);
+}
+
+/**
+ * @brief 收到的字节流与读出的字节流
+ */
+static uint8_t test_rx_sent[256];
+static uint32_t test_rx_sent_len;
+static uint8_t test_rx_got[256];
+static uint32_t test_rx_got_len;
+
+/**
+ * @brief DMA接收一段字节流, 每个字节由它在流中的位置决定
+ *
+ * @param len 字节数
+ */
+static void test_rx_send(uint32_t len) {
+    uint8_t *data = &test_rx_sent[test_rx_sent_len];
+
+    for (uint32_t i = 0; i < len; ++i) {
+        data[i] = (uint8_t)(test_rx_sent_len * 7U + 1U);
+        ++test_rx_sent_len;
+    }
+    host_dma_receive(&usart1_handle, data, len);
+}
+
+/**
+ * @brief 读出接收FIFO中的所有数据
+ */
+static void test_rx_drain(void) {
+    uint32_t len;
+
+    do {
+        len = uart_dmarx_read(&usart1_handle, &test_rx_got[test_rx_got_len],
+                              sizeof(test_rx_got) - test_rx_got_len);
+        test_rx_got_len += len;
+    } while (len != 0);
+}
+
+/**
+ * @brief 读出的字节是否都是收到的, 并且顺序不变, 不重复
+ *
+ * @return 读出的字节流是收到的字节流的子序列时返回true
+ */
+static bool test_rx_in_order(void) {
+    uint32_t sent = 0;
+
+    for (uint32_t i = 0; i < test_rx_got_len; ++i) {
+        while ((sent < test_rx_sent_len) &&
+               (test_rx_sent[sent] != test_rx_got[i])) {
+            ++sent;
+        }
+        if (sent == test_rx_sent_len) {
+            return false;
+        }
+        ++sent;
+    }
+
+    return true;
+}
+
+/**
+ * @brief 读出的字节流是否与收到的完全相同
+ *
+ * @return 相同时返回true
+ */
+static bool test_rx_all_read(void) {
+    return (test_rx_got_len == test_rx_sent_len) &&
+           (memcmp(test_rx_got, test_rx_sent, test_rx_sent_len) == 0);
+}
+
+/**
+ * @brief 清空字节流, 重新初始化USART1
+ */
+static void test_rx_reset(void) {
+    test_uart_reset();
+    test_rx_sent_len = 0;
+    test_rx_got_len = 0;
+}
+
+/**
+ * @brief 读者跟不上, 收到的数据超过FIFO: 读出的字节顺序不变,
+ *        读出与丢弃的字节数之和等于收到的字节数, 之后的接收不受影响
+ */
+static void test_uart_rx_overrun(void) {
+    test_rx_reset();
+
+    test_rx_send(100);
+    host_uart_idle(&usart1_handle);
+    test_rx_drain();
+    TEST_ASSERT(test_rx_in_order());
+
+    uart_stats_t stats;
+    uart_get_stats(&usart1_handle, &stats);
+    TEST_ASSERT(test_rx_got_len + stats.rx_dropped == 100);
+#if UART_RX_DMA_DIRECT
+    /* DMA不等读者, 被覆盖的一圈整个丢弃 */
+    TEST_ASSERT(test_rx_got_len == 0);
+#else  /* UART_RX_DMA_DIRECT */
+    /* FIFO满后丢弃新数据, 先收到的数据完整 */
+    TEST_ASSERT(test_rx_got_len == USART1_RX_DMA_FIFO_SIZE);
+    TEST_ASSERT(stats.rx_high_water == USART1_RX_DMA_FIFO_SIZE);
+#endif /* UART_RX_DMA_DIRECT */
+
+    test_rx_got_len = 0;
+    test_rx_sent_len = 0;
+    test_rx_send(5);
+    host_uart_idle(&usart1_handle);
+    test_rx_drain();
+    TEST_ASSERT(test_rx_all_read());
+    TEST_ASSERT(host_uart_rx_lost() == 0);
+}
+
+/**
+ * @brief 一圈中途接收出错: DMA从头开始, 出错前后的数据都按顺序读出,
+ *        不重复, 也不读到DMA没有写过的字节
+ */
+static void test_uart_rx_error_mid_lap(void) {
+    test_rx_reset();
+
+    test_rx_send(10);
+    host_uart_idle(&usart1_handle);
+    TEST_ASSERT(uart_dmarx_read(&usart1_handle, test_rx_got, 4) == 4);
+    test_rx_got_len = 4;
+
+    host_uart_rx_error(&usart1_handle, HAL_UART_ERROR_FE);
+    TEST_ASSERT(usart1_handle.RxState == HAL_UART_STATE_BUSY_RX);
+    test_rx_drain();
+    TEST_ASSERT(test_rx_all_read());
+
+    test_rx_send(5);
+    host_uart_idle(&usart1_handle);
+    test_rx_drain();
+    TEST_ASSERT(test_rx_all_read());
+
+    /* 再收满几圈, 确认接收位置与DMA对齐 */
+    for (uint32_t i = 0; i < 3; ++i) {
+        test_rx_send(USART1_RX_DMA_BUF_SIZE / 2U + 3U);
+        host_uart_idle(&usart1_handle);
+        test_rx_drain();
+    }
+    TEST_ASSERT(test_rx_all_read());
+
+    uart_stats_t stats;
+    uart_get_stats(&usart1_handle, &stats);
+    TEST_ASSERT(stats.fe == 1);
+    TEST_ASSERT(stats.rx_dropped == 0);
+    TEST_ASSERT(host_uart_rx_lost() == 0);
+}
+
+/**
+ * @brief 读者还没读到第一次出错跳过的位置又出错一次
+ */
+static void test_uart_rx_error_twice(void) {
+    test_rx_reset();
+
+    test_rx_send(6);
+    host_uart_idle(&usart1_handle);
+    TEST_ASSERT(uart_dmarx_read(&usart1_handle, test_rx_got, 2) == 2);
+    test_rx_got_len = 2;
+
+    host_uart_rx_error(&usart1_handle, HAL_UART_ERROR_NE);
+    test_rx_send(3);
+    host_uart_rx_error(&usart1_handle, HAL_UART_ERROR_PE);
+    test_rx_send(2);
+    host_uart_idle(&usart1_handle);
+    test_rx_drain();
+
+    TEST_ASSERT(test_rx_in_order());
+#if UART_RX_DMA_DIRECT
+    /* DMA从头开始后覆盖了没读的数据, 只能丢弃 */
+    uart_stats_t stats;
+    uart_get_stats(&usart1_handle, &stats);
+    TEST_ASSERT(stats.rx_dropped != 0);
+    test_rx_got_len = 0;
+    test_rx_sent_len = 0;
+#endif /* UART_RX_DMA_DIRECT */
+    TEST_ASSERT(test_rx_all_read());
+
+    for (uint32_t i = 0; i < 3; ++i) {
+        test_rx_send(USART1_RX_DMA_BUF_SIZE / 2U + 5U);
+        host_uart_idle(&usart1_handle);
+        test_rx_drain();
+    }
+    TEST_ASSERT(test_rx_all_read());
+    TEST_ASSERT(host_uart_rx_lost() == 0);
+}
+
+/**
+ * @brief 切换波特率时取走旧波特率下收到的数据, 接收从头开始,
+ *        中断重新打开, 之后收到的数据正常读出
+ */
+static void test_uart_rx_baud_switch(void) {
+    test_rx_reset();
+
+    test_rx_send(7);
+    TEST_ASSERT(uart_set_baud_rate(&usart1_handle, 921600) == UART_BAUD_OK);
+    TEST_ASSERT(usart1_handle.Init.BaudRate == 921600);
+    TEST_ASSERT(usart1_handle.RxState == HAL_UART_STATE_BUSY_RX);
+    TEST_ASSERT(usart1_handle.hdmarx->Instance->NDTR ==
+                USART1_RX_DMA_BUF_SIZE);
+    TEST_ASSERT(host_irq_is_enabled(USART1_IRQn));
+    TEST_ASSERT(host_irq_is_enabled(DMA2_Stream2_IRQn));
+
+    /* 任务中切换, 不通知读者, 数据留给下次读取 */
+    TEST_ASSERT(test_notified == 0);
+    test_rx_drain();
+    TEST_ASSERT(test_rx_all_read());
+
+    for (uint32_t i = 0; i < 3; ++i) {
+        test_rx_send(USART1_RX_DMA_BUF_SIZE / 2U + 9U);
+        host_uart_idle(&usart1_handle);
+        test_rx_drain();
+    }
+    TEST_ASSERT(test_rx_all_read());
+
+    /* 发送中不能切换, 接收不受影响 */
+    TEST_ASSERT(uart_dmatx_write(&usart1_handle, "abc", 3) == 3);
+    TEST_ASSERT(uart_dmatx_send(&usart1_handle) == 3);
+    test_rx_send(4);
+    TEST_ASSERT(uart_set_baud_rate(&usart1_handle, 115200) ==
+                UART_BAUD_BUSY);
+    TEST_ASSERT(usart1_handle.Init.BaudRate == 921600);
+    host_uart_idle(&usart1_handle);
+    test_rx_drain();
+    TEST_ASSERT(test_rx_all_read());
+    TEST_ASSERT(host_uart_rx_lost() == 0);
+}
+
+/**
+ * @brief 同时报告的几个错误各自计数, 标志都被清除, 接收重新启动
+ */
+static void test_uart_error_stats(void) {
+    test_uart_reset();
+
+    uart_stats_t stats;
+    host_uart_rx_error(&usart1_handle,
+                       HAL_UART_ERROR_PE | HAL_UART_ERROR_NE |
+                           HAL_UART_ERROR_FE | HAL_UART_ERROR_ORE |
+                           HAL_UART_ERROR_DMA);
+    uart_get_stats(&usart1_handle, &stats);
+    TEST_ASSERT(stats.pe == 1);
+    TEST_ASSERT(stats.ne == 1);
+    TEST_ASSERT(stats.fe == 1);
+    TEST_ASSERT(stats.ore == 1);
+    TEST_ASSERT(stats.dma_errors == 1);
+    TEST_ASSERT((usart1_handle.Instance->SR &
+                 (UART_FLAG_PE | UART_FLAG_NE | UART_FLAG_FE |
+                  UART_FLAG_ORE)) == 0);
+    TEST_ASSERT(usart1_handle.RxState == HAL_UART_STATE_BUSY_RX);
+
+    /* 只有报告的错误增加 */
+    host_uart_rx_error(&usart1_handle, HAL_UART_ERROR_PE | HAL_UART_ERROR_ORE);
+    uart_get_stats(&usart1_handle, &stats);
+    TEST_ASSERT(stats.pe == 2);
+    TEST_ASSERT(stats.ne == 1);
+    TEST_ASSERT(stats.fe == 1);
+    TEST_ASSERT(stats.ore == 2);
+    TEST_ASSERT(stats.dma_errors == 1);
+
+    uart_clear_stats(&usart1_handle);
+    uart_get_stats(&usart1_handle, &stats);
+    TEST_ASSERT((stats.pe == 0) && (stats.ore == 0) &&
+                (stats.dma_errors == 0));
+}
+
+/**
+ * @brief 串口驱动的所有测试
+ */
+void test_uart(void) {
+    printf("uart (UART_RX_DMA_DIRECT=%d)\n", UART_RX_DMA_DIRECT);
+
+    test_uart_rx();
+    test_uart_tx_error_buf();
+    test_uart_tx_error_user();
+    test_uart_tx_order();
+    test_uart_tx_error_rx();
+    test_uart_rx_overrun();
+    test_uart_rx_error_mid_lap();
+    test_uart_rx_error_twice();
+    test_uart_rx_baud_switch();
+    test_uart_error_stats();
+}
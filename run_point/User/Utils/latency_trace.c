@@ -0,0 +1,183 @@
+/**
+ * @file    latency_trace.c
+ * @author  Deadline039
+ * @brief   按键到电机电流指令的延迟跟踪
+ * @version 1.0
+ * @date    2026-10-16
+ */
+
+#include "latency_trace.h"
+
+#if (LATENCY_TRACE_ENABLE == 1)
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @brief 当前正在跟踪的按键
+ * @note 同一时刻只跟踪一次按键, 各阶段按顺序在不同上下文中打点,
+ *       前一阶段完成后下一阶段才会发生, 所以不需要加锁
+ */
+static struct {
+    volatile uint32_t rx_stamp; /*!< 最近一次串口空闲中断的时间戳 */
+    uint32_t start_stamp;       /*!< 本次跟踪的起点(串口空闲中断) */
+    uint32_t last_stamp;        /*!< 上一阶段的时间戳 */
+    trace_stage_t last_stage;   /*!< 上一阶段 */
+    uint8_t seq;                /*!< 遥控器帧序号 */
+    bool active;                /*!< 是否正在跟踪 */
+} trace_ctx;
+
+static trace_histogram_t trace_histogram[TRACE_STAGE_NUM];
+
+static const char *const trace_stage_name[TRACE_STAGE_NUM] = {
+    "remote", "dispatch", "motor_task", "queue_recv", "can_tx", "total"};
+
+/**
+ * @brief 周期数转换为us
+ *
+ * @param cycles 周期数
+ * @return 时间(us)
+ */
+static inline uint32_t latency_trace_cycles_to_us(uint32_t cycles) {
+    return cycles / (SystemCoreClock / 1000000U);
+}
+
+/**
+ * @brief 向直方图中添加一个样本
+ *
+ * @param stage 阶段
+ * @param us 耗时(us)
+ */
+static void latency_trace_record(trace_stage_t stage, uint32_t us) {
+    trace_histogram_t *hist = &trace_histogram[stage];
+    /* 0us放在第0个桶, 其余按最高位分桶 */
+    uint32_t index = (us == 0) ? 0 : (32U - __CLZ(us));
+
+    if (index >= LATENCY_TRACE_BUCKET_NUM) {
+        index = LATENCY_TRACE_BUCKET_NUM - 1;
+    }
+
+    if ((hist->count == 0) || (us < hist->min)) {
+        hist->min = us;
+    }
+    if (us > hist->max) {
+        hist->max = us;
+    }
+    ++hist->count;
+    hist->sum += us;
+    ++hist->bucket[index];
+}
+
+/**
+ * @brief 开启DWT周期计数器, 清空统计数据
+ */
+void latency_trace_init(void) {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    latency_trace_reset();
+}
+
+/**
+ * @brief 串口接收中断中打点, 作为每次跟踪的起点
+ * @note 每一帧都会打点, 只有按键帧会调用`latency_trace_begin`开始跟踪
+ */
+void latency_trace_rx_stamp(void) {
+    trace_ctx.rx_stamp = latency_trace_now();
+}
+
+/**
+ * @brief 开始跟踪一次按键, 在分发按键时调用
+ *
+ * @param seq 遥控器帧序号
+ * @param remote_us 遥控器上报的自身耗时(us)
+ */
+void latency_trace_begin(uint8_t seq, uint32_t remote_us) {
+    uint32_t now = latency_trace_now();
+
+    trace_ctx.seq = seq;
+    trace_ctx.start_stamp = trace_ctx.rx_stamp;
+    trace_ctx.last_stamp = now;
+    trace_ctx.last_stage = TRACE_STAGE_DISPATCH;
+    trace_ctx.active = true;
+
+    latency_trace_record(TRACE_STAGE_REMOTE, remote_us);
+    latency_trace_record(
+        TRACE_STAGE_DISPATCH,
+        latency_trace_cycles_to_us(now - trace_ctx.start_stamp));
+}
+
+/**
+ * @brief 记录一个阶段完成
+ *
+ * @param stage 完成的阶段, 必须紧接上一阶段, 否则忽略
+ * @note 没有正在跟踪的按键时直接返回, 可以放在周期执行的代码中
+ */
+void latency_trace_mark(trace_stage_t stage) {
+    if ((!trace_ctx.active) || (stage != trace_ctx.last_stage + 1) ||
+        (stage >= TRACE_STAGE_TOTAL)) {
+        return;
+    }
+
+    uint32_t now = latency_trace_now();
+    uint32_t cycles = now - trace_ctx.last_stamp;
+    latency_trace_record(stage, latency_trace_cycles_to_us(cycles));
+    trace_ctx.last_stamp = now;
+    trace_ctx.last_stage = stage;
+
+    if (stage == TRACE_STAGE_CAN_TX) {
+        latency_trace_record(
+            TRACE_STAGE_TOTAL,
+            latency_trace_cycles_to_us(now - trace_ctx.start_stamp));
+        trace_ctx.active = false;
+    }
+}
+
+/**
+ * @brief 获取某个阶段的统计数据
+ *
+ * @param stage 阶段
+ * @return 统计数据, 阶段不合法返回`NULL`
+ */
+const trace_histogram_t *latency_trace_get(trace_stage_t stage) {
+    if (stage >= TRACE_STAGE_NUM) {
+        return NULL;
+    }
+
+    return &trace_histogram[stage];
+}
+
+/**
+ * @brief 清空统计数据
+ */
+void latency_trace_reset(void) {
+    trace_ctx.active = false;
+    memset(trace_histogram, 0, sizeof(trace_histogram));
+}
+
+/**
+ * @brief 通过`printf`输出各阶段统计数据
+ */
+void latency_trace_dump(void) {
+    for (uint32_t i = 0; i < TRACE_STAGE_NUM; ++i) {
+        const trace_histogram_t *hist = &trace_histogram[i];
+
+        printf("%-10s n=%lu min=%luus max=%luus avg=%luus\r\n",
+               trace_stage_name[i], (unsigned long)hist->count,
+               (unsigned long)hist->min, (unsigned long)hist->max,
+               (unsigned long)((hist->count == 0) ? 0
+                                                  : (hist->sum / hist->count)));
+
+        for (uint32_t j = 0; j < LATENCY_TRACE_BUCKET_NUM; ++j) {
+            if (hist->bucket[j] == 0) {
+                continue;
+            }
+            printf("    <%6luus: %lu\r\n", 1UL << j,
+                   (unsigned long)hist->bucket[j]);
+        }
+    }
+}
+
+#endif /* LATENCY_TRACE_ENABLE == 1 */
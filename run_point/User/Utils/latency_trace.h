@@ -0,0 +1,108 @@
+/**
+ * @file    latency_trace.h
+ * @author  Deadline039
+ * @brief   按键到电机电流指令的延迟跟踪
+ * @version 1.0
+ * @date    2026-10-16
+ * @note    使用DWT周期计数器打时间戳, 统计各阶段耗时的直方图.
+ *          `LATENCY_TRACE_ENABLE`为0时所有接口均为空, 不占用资源.
+ *
+ *****************************************************************************
+ *                             ##### 阶段划分 ####
+ * TRACE_STAGE_REMOTE     遥控器扫描到按键 -> 交给DMA发送(遥控器上测量)
+ * TRACE_STAGE_DISPATCH   串口空闲中断 -> 遥控器回调分发按键
+ * TRACE_STAGE_MOTOR_TASK 分发按键 -> `motor_task`写入消息队列
+ * TRACE_STAGE_QUEUE_RECV 写入消息队列 -> task6中`xQueueReceive`返回
+ * TRACE_STAGE_CAN_TX     `xQueueReceive`返回 -> CAN发送电流指令
+ * TRACE_STAGE_TOTAL      串口空闲中断 -> CAN发送电流指令
+ *
+ * 两块板子的DWT时钟不同步, 所以遥控器只上报自身的耗时, 串口线上的传输时间
+ * (帧长 * 10 / 波特率)是固定值, 不做统计.
+ *****************************************************************************
+ */
+
+#ifndef __LATENCY_TRACE_H
+#define __LATENCY_TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <CSP_Config.h>
+
+#define LATENCY_TRACE_ENABLE     0  /* 是否开启延迟跟踪 */
+#define LATENCY_TRACE_BUCKET_NUM 16 /* 直方图桶数, 第n个桶为[2^(n-1), 2^n)us */
+
+/**
+ * @brief 跟踪阶段
+ */
+typedef enum {
+    TRACE_STAGE_REMOTE = 0x00U,
+    TRACE_STAGE_DISPATCH,
+    TRACE_STAGE_MOTOR_TASK,
+    TRACE_STAGE_QUEUE_RECV,
+    TRACE_STAGE_CAN_TX,
+    TRACE_STAGE_TOTAL,
+    TRACE_STAGE_NUM
+} trace_stage_t;
+
+/**
+ * @brief 单个阶段的统计数据, 单位us
+ */
+typedef struct {
+    uint32_t count;                            /*!< 样本数 */
+    uint32_t min;                              /*!< 最小值 */
+    uint32_t max;                              /*!< 最大值 */
+    uint32_t sum;                              /*!< 总和 */
+    uint32_t bucket[LATENCY_TRACE_BUCKET_NUM]; /*!< 直方图 */
+} trace_histogram_t;
+
+/**
+ * @brief 读取DWT周期计数器
+ *
+ * @return 当前周期数
+ */
+static inline uint32_t latency_trace_now(void) {
+    return DWT->CYCCNT;
+}
+
+#if (LATENCY_TRACE_ENABLE == 1)
+
+void latency_trace_init(void);
+void latency_trace_rx_stamp(void);
+void latency_trace_begin(uint8_t seq, uint32_t remote_us);
+void latency_trace_mark(trace_stage_t stage);
+const trace_histogram_t *latency_trace_get(trace_stage_t stage);
+void latency_trace_reset(void);
+void latency_trace_dump(void);
+
+#else /* LATENCY_TRACE_ENABLE == 1 */
+
+#define latency_trace_init()                                                   \
+    do {                                                                       \
+    } while (0)
+#define latency_trace_rx_stamp()                                               \
+    do {                                                                       \
+    } while (0)
+#define latency_trace_begin(seq, remote_us)                                    \
+    do {                                                                       \
+        (void)(seq);                                                           \
+        (void)(remote_us);                                                     \
+    } while (0)
+#define latency_trace_mark(stage)                                              \
+    do {                                                                       \
+    } while (0)
+#define latency_trace_reset()                                                  \
+    do {                                                                       \
+    } while (0)
+#define latency_trace_dump()                                                   \
+    do {                                                                       \
+    } while (0)
+
+#endif /* LATENCY_TRACE_ENABLE == 1 */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __LATENCY_TRACE_H */
@@ -0,0 +1,425 @@
+/**
+ * @file    util_bench.c
+ * @author  Deadline039
+ * @brief   ring_fifo, buffer_append与消息发送的性能测试
+ * @version 1.0
+ * @date    2026-10-17
+ */
+
+#if defined(UTIL_BENCH_HOST)
+/* 严格的C标准模式下`clock_gettime`需要POSIX声明, 要在所有头文件之前定义 */
+#define _POSIX_C_SOURCE 199309L
+#endif /* UTIL_BENCH_HOST */
+
+#include "util_bench.h"
+
+#if (UTIL_BENCH_ENABLE == 1)
+
+#include "buffer_append.h"
+#include "./ring_fifo/ring_fifo.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(UTIL_BENCH_HOST)
+
+#include <time.h>
+
+#define UTIL_BENCH_ITERATIONS 1000000 /* 每一项的操作次数 */
+
+typedef uint64_t bench_tick_t;
+
+/**
+ * @brief 读取时间戳
+ *
+ * @return 当前时间(ns)
+ */
+static inline bench_tick_t bench_now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (bench_tick_t)ts.tv_sec * 1000000000U + (bench_tick_t)ts.tv_nsec;
+}
+
+/**
+ * @brief 时间戳差值转换为ns
+ *
+ * @param ticks 时间戳差值
+ * @return 时间(ns)
+ */
+static inline uint64_t bench_ticks_to_ns(bench_tick_t ticks) {
+    return ticks;
+}
+
+#else /* UTIL_BENCH_HOST */
+
+#include <CSP_Config.h>
+
+#include "FreeRTOS.h"
+#include "crc16.h"
+#include "msg_protocol.h"
+
+#define UTIL_BENCH_MSG_UART usart1_handle /* 消息发送测试的串口, 需开发送DMA */
+
+/* DWT计数器为32位, 180MHz下约23s溢出一次, 单项耗时远小于此 */
+#define UTIL_BENCH_ITERATIONS 2000 /* 每一项的操作次数 */
+
+typedef uint32_t bench_tick_t;
+
+/**
+ * @brief 读取DWT周期计数器
+ *
+ * @return 当前周期数
+ */
+static inline bench_tick_t bench_now(void) {
+    return DWT->CYCCNT;
+}
+
+/**
+ * @brief 周期数转换为ns
+ *
+ * @param ticks 周期数
+ * @return 时间(ns)
+ */
+static inline uint64_t bench_ticks_to_ns(bench_tick_t ticks) {
+    return (uint64_t)ticks * 1000U / (SystemCoreClock / 1000000U);
+}
+
+#endif /* UTIL_BENCH_HOST */
+
+/**
+ * @brief 一项测试
+ */
+typedef struct {
+    const char *name;                /*!< 名称 */
+    void (*run)(uint32_t, uint32_t); /*!< 测试函数(参数, 次数) */
+    uint32_t arg;                    /*!< 测试参数 */
+    uint32_t bytes;                  /*!< 每次操作处理的字节数 */
+} bench_case_t;
+
+static ring_fifo_t bench_ring;
+static uint8_t bench_mem[1024];
+static uint8_t bench_src[256];
+static uint8_t bench_dst[256];
+/* 防止测试结果被编译器优化掉 */
+static volatile uint32_t bench_sink;
+/* 测试中等待串口发送完成的时间, 不计入结果 */
+static bench_tick_t bench_idle;
+
+/**
+ * @brief 流模式写入后读出, 每次`arg`字节
+ *
+ * @param arg 每次读写的字节数
+ * @param n 次数
+ */
+static void bench_stream_rw(uint32_t arg, uint32_t n) {
+    ring_fifo_init_static(&bench_ring, bench_mem, sizeof(bench_mem),
+                          RF_TYPE_STREAM);
+
+    for (uint32_t i = 0; i < n; ++i) {
+        ring_fifo_write(&bench_ring, bench_src, arg);
+        bench_sink += ring_fifo_read(&bench_ring, bench_dst, arg);
+    }
+}
+
+/**
+ * @brief 流模式在64字节的缓冲区上读写48字节, 几乎每次都回绕
+ *
+ * @param arg 每次读写的字节数
+ * @param n 次数
+ */
+static void bench_stream_wrap(uint32_t arg, uint32_t n) {
+    ring_fifo_init_static(&bench_ring, bench_mem, 64, RF_TYPE_STREAM);
+
+    for (uint32_t i = 0; i < n; ++i) {
+        ring_fifo_write(&bench_ring, bench_src, arg);
+        bench_sink += ring_fifo_read(&bench_ring, bench_dst, arg);
+    }
+}
+
+/**
+ * @brief 流模式写入后用peek/consume原地读取
+ *
+ * @param arg 每次读写的字节数
+ * @param n 次数
+ */
+static void bench_stream_peek(uint32_t arg, uint32_t n) {
+    ring_fifo_span_t span[2];
+
+    ring_fifo_init_static(&bench_ring, bench_mem, sizeof(bench_mem),
+                          RF_TYPE_STREAM);
+
+    for (uint32_t i = 0; i < n; ++i) {
+        ring_fifo_write(&bench_ring, bench_src, arg);
+        uint32_t len = ring_fifo_peek(&bench_ring, span);
+        bench_sink += span[0].buf[0];
+        ring_fifo_consume(&bench_ring, len);
+    }
+}
+
+/**
+ * @brief 帧模式(4字节帧长)写入一帧后读出
+ *
+ * @param arg 帧长
+ * @param n 次数
+ */
+static void bench_frame_rw(uint32_t arg, uint32_t n) {
+    ring_fifo_init_static(&bench_ring, bench_mem, sizeof(bench_mem),
+                          RF_TYPE_FRAME);
+
+    for (uint32_t i = 0; i < n; ++i) {
+        ring_fifo_write(&bench_ring, bench_src, arg);
+        bench_sink += ring_fifo_read(&bench_ring, bench_dst, sizeof(bench_dst));
+    }
+}
+
+/**
+ * @brief 帧模式(1~2字节帧长)写入一帧后读出
+ *
+ * @param arg 帧长
+ * @param n 次数
+ */
+static void bench_varint_rw(uint32_t arg, uint32_t n) {
+    ring_fifo_init_static(&bench_ring, bench_mem, sizeof(bench_mem),
+                          RF_TYPE_FRAME_VARINT);
+
+    for (uint32_t i = 0; i < n; ++i) {
+        ring_fifo_write(&bench_ring, bench_src, arg);
+        bench_sink += ring_fifo_read(&bench_ring, bench_dst, sizeof(bench_dst));
+    }
+}
+
+/**
+ * @brief 覆盖模式下持续写入帧, 不读取, 每次写入都要丢弃旧帧
+ *
+ * @param arg 帧长
+ * @param n 次数
+ */
+static void bench_overwrite(uint32_t arg, uint32_t n) {
+    ring_fifo_init_static(&bench_ring, bench_mem, sizeof(bench_mem),
+                          RF_TYPE_FRAME_VARINT);
+    ring_fifo_set_policy(&bench_ring, RF_POLICY_OVERWRITE);
+
+    for (uint32_t i = 0; i < n; ++i) {
+        bench_sink += ring_fifo_write(&bench_ring, bench_src, arg);
+    }
+}
+
+/**
+ * @brief 编码一组常用类型, 共22字节
+ *
+ * @param arg 未使用
+ * @param n 次数
+ */
+static void bench_append(uint32_t arg, uint32_t n) {
+    (void)arg;
+
+    for (uint32_t i = 0; i < n; ++i) {
+        int32_t index = 0;
+        buffer_append_int16(bench_dst, (int16_t)i, &index);
+        buffer_append_int32(bench_dst, (int32_t)i, &index);
+        buffer_append_float32(bench_dst, (float)i, 1000.0f, &index);
+        buffer_append_float32_auto(bench_dst, (float)i * 0.5f, &index);
+        buffer_append_double64(bench_dst, (double)i, 1000.0, &index);
+        bench_sink += (uint32_t)index;
+    }
+}
+
+/**
+ * @brief 解码`bench_append`编码的一组数据
+ *
+ * @param arg 未使用
+ * @param n 次数
+ */
+static void bench_get(uint32_t arg, uint32_t n) {
+    (void)arg;
+
+    for (uint32_t i = 0; i < n; ++i) {
+        int32_t index = 0;
+        bench_sink += (uint32_t)buffer_get_int16(bench_dst, &index);
+        bench_sink += (uint32_t)buffer_get_int32(bench_dst, &index);
+        bench_sink += (uint32_t)buffer_get_float32(bench_dst, 1000.0f, &index);
+        bench_sink += (uint32_t)buffer_get_float32_auto(bench_dst, &index);
+        bench_sink += (uint32_t)buffer_get_double64(bench_dst, 1000.0, &index);
+    }
+}
+
+#if !defined(UTIL_BENCH_HOST)
+
+/**
+ * @brief 等待串口发送完成, 等待的时间不计入结果
+ *
+ * @note 发送完成中断中释放缓冲区或槽位, 下一帧的状态与这一帧相同
+ */
+static void bench_msg_wait(void) {
+    bench_tick_t start = bench_now();
+
+    while (UTIL_BENCH_MSG_UART.gState != HAL_UART_STATE_READY) {
+    }
+    bench_idle += bench_now() - start;
+}
+
+/**
+ * @brief 按`MSG_FRAME_VERSION`的帧格式组帧, 与`msg_protocol.c`相同
+ *
+ * @param[out] frame 帧缓冲区, 长度为`data_len + MSG_FRAME_OVERHEAD`
+ * @param data 数据
+ * @param data_len 数据长度, 小于254
+ */
+static void bench_msg_fill(uint8_t *frame, const uint8_t *data,
+                           uint32_t data_len) {
+    uint8_t *head = frame;
+
+#if (MSG_FRAME_VERSION == 2)
+    *head++ = MSG_FRAME_SYNC_0;
+    *head++ = MSG_FRAME_SYNC_1;
+#elif (MSG_FRAME_VERSION == 3)
+    ++head; /* 留给COBS编码字节 */
+#endif /* MSG_FRAME_VERSION == 2 */
+#if (MSG_FRAME_VERSION >= 2)
+    static uint8_t seq;
+    *head++ = (uint8_t)(MSG_FRAME_VERSION << 4);
+    *head++ = seq++;
+#endif /* MSG_FRAME_VERSION >= 2 */
+
+    head[0] = (uint8_t)(MSG_CHASSIS << 4) | MSG_DATA_UINT8;
+    head[1] = (uint8_t)data_len;
+    memcpy(head + 2, data, data_len);
+
+#if (MSG_FRAME_VERSION >= 2)
+    uint16_t crc = crc16_calc(head - 2, data_len + 4);
+    head[data_len + 2] = (uint8_t)(crc >> 8);
+    head[data_len + 3] = (uint8_t)crc;
+#else  /* MSG_FRAME_VERSION >= 2 */
+    head[data_len + 2] = 0xFF;
+#endif /* MSG_FRAME_VERSION >= 2 */
+
+#if (MSG_FRAME_VERSION == 3)
+    uint8_t *code = frame;
+    uint8_t distance = 1;
+    for (uint32_t i = 1; i <= data_len + 6; ++i) {
+        if (frame[i] == 0x00) {
+            *code = distance;
+            code = &frame[i];
+            distance = 1;
+        } else {
+            ++distance;
+        }
+    }
+    *code = distance;
+    frame[data_len + 7] = 0x00;
+#endif /* MSG_FRAME_VERSION == 3 */
+}
+
+/**
+ * @brief `message_send_data`在发送队列中原地组帧并启动DMA
+ *
+ * @param arg 数据长度
+ * @param n 次数
+ */
+static void bench_msg_send(uint32_t arg, uint32_t n) {
+    message_register_send_handle(MSG_CHASSIS, &UTIL_BENCH_MSG_UART);
+
+    for (uint32_t i = 0; i < n; ++i) {
+        bench_src[0] = (uint8_t)i;
+        message_send_data(MSG_CHASSIS, MSG_DATA_UINT8, bench_src, arg);
+        bench_msg_wait();
+    }
+
+    message_register_send_handle(MSG_CHASSIS, NULL);
+}
+
+/**
+ * @brief 原来的发送方式: 申请内存组帧, 经驱动的双缓冲区发送后释放
+ *
+ * @param arg 数据长度
+ * @param n 次数
+ */
+static void bench_msg_malloc(uint32_t arg, uint32_t n) {
+    for (uint32_t i = 0; i < n; ++i) {
+        bench_src[0] = (uint8_t)i;
+        uint8_t *frame = (uint8_t *)pvPortMalloc(arg + MSG_FRAME_OVERHEAD);
+        bench_msg_fill(frame, bench_src, arg);
+        uart_dmatx_write(&UTIL_BENCH_MSG_UART, frame, arg + MSG_FRAME_OVERHEAD);
+        uart_dmatx_send(&UTIL_BENCH_MSG_UART);
+        vPortFree(frame);
+        bench_msg_wait();
+    }
+}
+
+#endif /* UTIL_BENCH_HOST */
+
+static const bench_case_t bench_cases[] = {
+    {"stream rw 8B", bench_stream_rw, 8, 8},
+    {"stream rw 64B", bench_stream_rw, 64, 64},
+    {"stream rw 256B", bench_stream_rw, 256, 256},
+    {"stream rw 61B (odd)", bench_stream_rw, 61, 61},
+    {"stream wrap 48B/64B", bench_stream_wrap, 48, 48},
+    {"stream peek 64B", bench_stream_peek, 64, 64},
+    {"frame u32 8B", bench_frame_rw, 8, 8},
+    {"frame u32 19B", bench_frame_rw, 19, 19},
+    {"frame u32 64B", bench_frame_rw, 64, 64},
+    {"frame varint 8B", bench_varint_rw, 8, 8},
+    {"frame varint 19B", bench_varint_rw, 19, 19},
+    {"frame varint 200B", bench_varint_rw, 200, 200},
+    {"overwrite 19B", bench_overwrite, 19, 19},
+    {"buffer_append x5", bench_append, 0, 22},
+    {"buffer_get x5", bench_get, 0, 22},
+#if !defined(UTIL_BENCH_HOST)
+    {"msg send 8B", bench_msg_send, 8, 8},
+    {"msg malloc+dmatx 8B", bench_msg_malloc, 8, 8},
+#endif /* UTIL_BENCH_HOST */
+};
+
+/**
+ * @brief 运行所有测试并输出结果
+ */
+void util_bench_run(void) {
+#if !defined(UTIL_BENCH_HOST)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif /* UTIL_BENCH_HOST */
+
+    for (uint32_t i = 0; i < sizeof(bench_src); ++i) {
+        bench_src[i] = (uint8_t)i;
+    }
+
+    for (uint32_t i = 0; i < sizeof(bench_cases) / sizeof(bench_cases[0]);
+         ++i) {
+        const bench_case_t *bench = &bench_cases[i];
+
+        /* 先跑一遍预热缓存 */
+        bench->run(bench->arg, UTIL_BENCH_ITERATIONS / 10);
+
+        bench_idle = 0;
+        bench_tick_t start = bench_now();
+        bench->run(bench->arg, UTIL_BENCH_ITERATIONS);
+        bench_tick_t ticks = bench_now() - start - bench_idle;
+
+        uint64_t ns = bench_ticks_to_ns(ticks);
+        uint64_t ns_x10 = ns * 10U / UTIL_BENCH_ITERATIONS;
+        uint64_t kbps = (ns == 0) ? 0
+                                  : ((uint64_t)bench->bytes *
+                                     UTIL_BENCH_ITERATIONS * 1000000000U /
+                                     ns / 1024U);
+
+        printf("%-20s %6lu.%lu ns/op %9lu KB/s", bench->name,
+               (unsigned long)(ns_x10 / 10U), (unsigned long)(ns_x10 % 10U),
+               (unsigned long)kbps);
+#if !defined(UTIL_BENCH_HOST)
+        printf(" %6lu cycles/op",
+               (unsigned long)(ticks / UTIL_BENCH_ITERATIONS));
+#endif /* UTIL_BENCH_HOST */
+        printf("\r\n");
+    }
+}
+
+#if defined(UTIL_BENCH_HOST)
+int main(void) {
+    util_bench_run();
+    return 0;
+}
+#endif /* UTIL_BENCH_HOST */
+
+#endif /* UTIL_BENCH_ENABLE == 1 */
@@ -0,0 +1,56 @@
+/**
+ * @file    util_bench.h
+ * @author  Deadline039
+ * @brief   ring_fifo, buffer_append与消息发送的性能测试
+ * @version 1.0
+ * @date    2026-10-17
+ * @note    `UTIL_BENCH_ENABLE`为0时接口为空, 不占用资源.
+ *
+ *****************************************************************************
+ *                             ##### 如何使用 ####
+ * (#) 板上: 编译选项定义`UTIL_BENCH_ENABLE=1`, 启动时在`start_task`中运行一次,
+ *     用DWT周期计数器计时, 结果通过`printf`输出, 同时给出每次操作的周期数.
+ *     板上还对比`message_send_data`与原来申请内存后经`uart_dmatx_write`
+ *     发送的方式, 两者组同一版本的帧, 使用`UTIL_BENCH_MSG_UART`发送,
+ *     每帧等待发送完成, 等待的时间不计入结果
+ *
+ * (#) 主机: 不依赖硬件, 在run_point目录下编译运行, 用`clock_gettime`计时
+ *     cc -std=c11 -O2 -DUTIL_BENCH_HOST -IUser/Utils -IUser/Utils/ring_fifo
+ *        User/Utils/util_bench.c User/Utils/buffer_append.c
+ *        User/Utils/ring_fifo/ring_fifo.c -lm -o util_bench
+ *
+ * (#) 每一项输出每次操作的耗时(ns/op)与吞吐量(KB/s), 优化前后用同一份
+ *     代码在两边各跑一次对比
+ *****************************************************************************
+ */
+
+#ifndef __UTIL_BENCH_H
+#define __UTIL_BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#if defined(UTIL_BENCH_HOST)
+#define UTIL_BENCH_ENABLE 1
+#elif !defined(UTIL_BENCH_ENABLE)
+#define UTIL_BENCH_ENABLE 0 /* 是否在板上运行性能测试, 默认关闭 */
+#endif /* UTIL_BENCH_HOST */
+
+#if (UTIL_BENCH_ENABLE == 1)
+
+void util_bench_run(void);
+
+#else /* UTIL_BENCH_ENABLE == 1 */
+
+#define util_bench_run()                                                       \
+    do {                                                                       \
+    } while (0)
+
+#endif /* UTIL_BENCH_ENABLE == 1 */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __UTIL_BENCH_H */